@@ -6,7 +6,6 @@
 
 #include <zephyr.h>
 #include <zephyr/types.h>
-#include <sys/ring_buffer.h>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/uuid.h>
@@ -28,22 +27,10 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_BLE_LOG_LEVEL);
 #define BLE_RX_BUF_COUNT 4
 #define BLE_SLAB_ALIGNMENT 4
 
-#define BLE_TX_BUF_SIZE (CONFIG_BRIDGE_BUF_SIZE * 2)
-
-#define ATT_MIN_PAYLOAD 20 /* Minimum L2CAP MTU minus ATT header */
-
-static void bt_send_work_handler(struct k_work *work);
-
 K_MEM_SLAB_DEFINE(ble_rx_slab, BLE_RX_BLOCK_SIZE, BLE_RX_BUF_COUNT, BLE_SLAB_ALIGNMENT);
-RING_BUF_DECLARE(ble_tx_ring_buf, BLE_TX_BUF_SIZE);
-
-static K_SEM_DEFINE(ble_tx_sem, 0, 1);
-
-static K_WORK_DEFINE(bt_send_work, bt_send_work_handler);
 
 static struct bt_conn *current_conn;
 static struct bt_gatt_exchange_params exchange_params;
-static u32_t nus_max_send_len;
 static atomic_t ready;
 static atomic_t active;
 
@@ -59,8 +46,8 @@ static const struct bt_data sd[] = {
 static void exchange_func(struct bt_conn *conn, u8_t err,
 			  struct bt_gatt_exchange_params *params)
 {
-	if (!err) {
-		nus_max_send_len = bt_gatt_nus_max_send(conn);
+	if (err) {
+		LOG_WRN("MTU exchange failed (err %u)", err);
 	}
 }
 
@@ -84,8 +71,6 @@ static void connected(struct bt_conn *conn, u8_t err)
 		LOG_WRN("bt_gatt_exchange_mtu: %d", err);
 	}
 
-	ring_buf_reset(&ble_tx_ring_buf);
-
 	struct peer_conn_event *event = new_peer_conn_event();
 
 	event->peer_id = PEER_ID_BLE;
@@ -121,37 +106,6 @@ static struct bt_conn_cb conn_callbacks = {
 	.disconnected = disconnected,
 };
 
-static void bt_send_work_handler(struct k_work *work)
-{
-	u16_t len;
-	u8_t *buf;
-	int err;
-	bool notif_disabled = false;
-
-	do {
-		len = ring_buf_get_claim(&ble_tx_ring_buf, &buf, nus_max_send_len);
-
-		err = bt_gatt_nus_send(current_conn, buf, len);
-		if (err == -EINVAL) {
-			notif_disabled = true;
-			len = 0;
-		} else if (err) {
-			len = 0;
-		}
-
-		err = ring_buf_get_finish(&ble_tx_ring_buf, len);
-		if (err) {
-			LOG_ERR("ring_buf_get_finish: %d", err);
-			break;
-		}
-	} while (len != 0 && !ring_buf_is_empty(&ble_tx_ring_buf));
-
-	if (notif_disabled) {
-		/* Peer has not enabled notifications: don't accumulate data */
-		ring_buf_reset(&ble_tx_ring_buf);
-	}
-}
-
 static void bt_receive_cb(struct bt_conn *conn, const u8_t *const data,
 			  u16_t len)
 {
@@ -183,18 +137,8 @@ static void bt_receive_cb(struct bt_conn *conn, const u8_t *const data,
 	} while (remainder);
 }
 
-static void bt_sent_cb(struct bt_conn *conn)
-{
-	if (ring_buf_is_empty(&ble_tx_ring_buf)) {
-		return;
-	}
-
-	k_work_submit(&bt_send_work);
-}
-
 static struct bt_gatt_nus_cb nus_cb = {
 	.received_cb = bt_receive_cb,
-	.sent_cb = bt_sent_cb,
 };
 
 static void adv_start(void)
@@ -271,24 +215,21 @@ static bool event_handler(const struct event_header *eh)
 			return false;
 		}
 
-		u32_t written = ring_buf_put(
-			&ble_tx_ring_buf,
-			event->buf,
-			event->len);
-		if (written != event->len) {
+		/* Data is coalesced into notifications by the NUS TX queue. */
+		int written = bt_gatt_nus_tx_queue_put(current_conn,
+						       event->buf,
+						       event->len,
+						       K_NO_WAIT);
+		if (written == -EINVAL) {
+			/* The peer has not enabled notifications yet. */
+			LOG_DBG("UART_%d -> BLE dropped", event->dev_idx);
+		} else if (written < 0) {
+			LOG_WRN("UART_%d -> BLE failed: %d", event->dev_idx,
+				written);
+		} else if ((size_t)written != event->len) {
 			LOG_WRN("UART_%d -> BLE overflow", event->dev_idx);
 		}
 
-		u32_t buf_utilization =
-			(ring_buf_capacity_get(&ble_tx_ring_buf) -
-			ring_buf_space_get(&ble_tx_ring_buf));
-
-		/* Simple check to start transmission. */
-		/* If bt_send_work is already running, this has no effect */
-		if (buf_utilization == written) {
-			k_work_submit(&bt_send_work);
-		}
-
 		return false;
 	}
 
@@ -335,8 +276,6 @@ static bool event_handler(const struct event_header *eh)
 
 			atomic_set(&active, false);
 
-			nus_max_send_len = ATT_MIN_PAYLOAD;
-
 			err = bt_enable(bt_ready);
 			if (err) {
 				LOG_ERR("bt_enable: %d", err);
@@ -98,6 +98,7 @@ enum config_status {
 	CONFIG_STATUS_REJECT,
 	CONFIG_STATUS_WRITE_ERROR,
 	CONFIG_STATUS_DISCONNECTED_ERROR,
+	CONFIG_STATUS_STREAM,
 };
 
 /** @brief Configuration channel forward event.
@@ -132,6 +132,40 @@ EVENT_TYPE_DEFINE(hid_report_sent_event,
 		  log_hid_report_sent_event,
 		  &hid_report_sent_event_info);
 
+static int log_hid_report_sync_event(const struct event_header *eh,
+				     char *buf, size_t buf_len)
+{
+	const struct hid_report_sync_event *event =
+		cast_hid_report_sync_event(eh);
+
+	return snprintf(buf, buf_len,
+			"report 0x%x sync for %p (latency %u us)",
+			event->report_id,
+			event->subscriber,
+			event->latency_us);
+}
+
+static void profile_hid_report_sync_event(struct log_event_buf *buf,
+					  const struct event_header *eh)
+{
+	const struct hid_report_sync_event *event =
+		cast_hid_report_sync_event(eh);
+
+	profiler_log_encode_u32(buf, (u32_t)event->subscriber);
+	profiler_log_encode_u32(buf, event->report_id);
+	profiler_log_encode_u32(buf, event->latency_us);
+}
+
+EVENT_INFO_DEFINE(hid_report_sync_event,
+		  ENCODE(PROFILER_ARG_U32, PROFILER_ARG_U8, PROFILER_ARG_U16),
+		  ENCODE("subscriber", "report_id", "latency_us"),
+		  profile_hid_report_sync_event);
+
+EVENT_TYPE_DEFINE(hid_report_sync_event,
+		  IS_ENABLED(CONFIG_DESKTOP_INIT_LOG_HID_REPORT_SYNC_EVENT),
+		  log_hid_report_sync_event,
+		  &hid_report_sync_event_info);
+
 static int log_hid_report_subscription_event(const struct event_header *eh,
 						char *buf, size_t buf_len)
 {
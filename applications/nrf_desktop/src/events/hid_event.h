@@ -61,6 +61,25 @@ struct hid_report_sent_event {
 EVENT_TYPE_DECLARE(hid_report_sent_event);
 
 
+/** @brief Report sync event.
+ *
+ * Submitted when input data for the next report should be sampled, so that
+ * the report is ready right before the upcoming transmission opportunity.
+ */
+struct hid_report_sync_event {
+	struct event_header header; /**< Event header. */
+
+	const void *subscriber; /**< Id of the report subscriber. */
+	u8_t report_id; /**< Report id. */
+	u16_t latency_us; /**< Time between the previous sync and the
+			    *  transmission opportunity that followed it.
+			    *  Zero if unknown.
+			    */
+};
+
+EVENT_TYPE_DECLARE(hid_report_sync_event);
+
+
 /** @brief Report subscription event. */
 struct hid_report_subscription_event {
 	struct event_header header; /**< Event header. */
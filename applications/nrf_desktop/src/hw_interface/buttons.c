@@ -28,6 +28,15 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_BUTTONS_LOG_LEVEL);
 
 #define SCAN_INTERVAL CONFIG_DESKTOP_BUTTONS_SCAN_INTERVAL
 #define DEBOUNCE_INTERVAL CONFIG_DESKTOP_BUTTONS_DEBOUNCE_INTERVAL
+#define DEBOUNCE_SCANS CONFIG_DESKTOP_BUTTONS_DEBOUNCE_SCANS
+
+#ifdef CONFIG_DESKTOP_BUTTONS_ADAPTIVE_SCAN
+ #define SCAN_INTERVAL_HELD CONFIG_DESKTOP_BUTTONS_SCAN_INTERVAL_HELD
+ #define SCAN_SLOWDOWN_COUNT CONFIG_DESKTOP_BUTTONS_SCAN_SLOWDOWN_COUNT
+#else
+ #define SCAN_INTERVAL_HELD SCAN_INTERVAL
+ #define SCAN_SLOWDOWN_COUNT 0
+#endif
 
 /* For directly connected GPIO, scan rows once. */
 #define COLUMNS MAX(ARRAY_SIZE(col), 1)
@@ -246,13 +255,36 @@ static void scan_fn(struct k_work *work)
 
 	static u32_t settled_state[COLUMNS];
 
-	/* Prevent bouncing */
+	/* Prevent bouncing - key state is accepted once it is the same
+	 * in DEBOUNCE_SCANS subsequent scans.
+	 */
 	static u32_t prev_state[COLUMNS];
+	static u8_t stable_cnt[COLUMNS][ARRAY_SIZE(row)];
+	bool bouncing = false;
+
 	for (size_t i = 0; i < COLUMNS; i++) {
 		u32_t bounce_mask = prev_state[i] ^ raw_state[i];
+		u32_t unstable_mask = 0;
+
 		prev_state[i] = raw_state[i];
-		raw_state[i] &= ~bounce_mask;
-		raw_state[i] |= settled_state[i] & bounce_mask;
+
+		for (size_t j = 0; j < ARRAY_SIZE(row); j++) {
+			if (bounce_mask & BIT(j)) {
+				stable_cnt[i][j] = 0;
+			} else if (stable_cnt[i][j] < UINT8_MAX) {
+				stable_cnt[i][j]++;
+			}
+
+			if (stable_cnt[i][j] < DEBOUNCE_SCANS - 1) {
+				unstable_mask |= BIT(j);
+			}
+		}
+
+		bouncing = bouncing ||
+			   ((raw_state[i] ^ settled_state[i]) & unstable_mask);
+
+		raw_state[i] &= ~unstable_mask;
+		raw_state[i] |= settled_state[i] & unstable_mask;
 	}
 
 	/* Prevent ghosting */
@@ -302,12 +334,31 @@ static void scan_fn(struct k_work *work)
 			      (prev_state[i] != 0) ||
 			      (settled_state[i] != 0) ||
 			      (cur_state[i] != 0);
+
+		/* Changes above the event limit are reported in next scan. */
+		bouncing = bouncing || (cur_state[i] != settled_state[i]);
+	}
+
+	/* Scan rate adapts to the activity. Keys that are held without
+	 * any change are scanned with a longer interval.
+	 */
+	static size_t idle_scans;
+
+	if ((evt_limit > 0) || bouncing) {
+		idle_scans = 0;
+	} else if (idle_scans < SCAN_SLOWDOWN_COUNT) {
+		idle_scans++;
 	}
 
 	if (any_pressed) {
 		/* Schedule next scan */
-		k_delayed_work_submit(&matrix_scan, K_MSEC(SCAN_INTERVAL));
+		s32_t interval = (idle_scans < SCAN_SLOWDOWN_COUNT) ?
+				 (SCAN_INTERVAL) : (SCAN_INTERVAL_HELD);
+
+		k_delayed_work_submit(&matrix_scan, K_MSEC(interval));
 	} else {
+		idle_scans = 0;
+
 		/* If no button is pressed module can switch to callbacks */
 
 		int err = 0;
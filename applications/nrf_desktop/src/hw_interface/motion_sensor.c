@@ -528,20 +528,36 @@ static bool handle_usb_state_event(const struct usb_state_event *event)
 	return false;
 }
 
+static void sample_request(u8_t report_id)
+{
+	if (report_id == REPORT_ID_MOUSE) {
+		k_spinlock_key_t key = k_spin_lock(&state.lock);
+		if (state.state == STATE_FETCHING) {
+			state.sample = true;
+			k_sem_give(&sem);
+		}
+		k_spin_unlock(&state.lock, key);
+	}
+}
+
 static bool event_handler(const struct event_header *eh)
 {
-	if (is_hid_report_sent_event(eh)) {
+	if (!IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_SYNC_ENABLE) &&
+	    is_hid_report_sent_event(eh)) {
 		const struct hid_report_sent_event *event =
 			cast_hid_report_sent_event(eh);
 
-		if (event->report_id == REPORT_ID_MOUSE) {
-			k_spinlock_key_t key = k_spin_lock(&state.lock);
-			if (state.state == STATE_FETCHING) {
-				state.sample = true;
-				k_sem_give(&sem);
-			}
-			k_spin_unlock(&state.lock, key);
-		}
+		sample_request(event->report_id);
+
+		return false;
+	}
+
+	if (IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_SYNC_ENABLE) &&
+	    is_hid_report_sync_event(eh)) {
+		const struct hid_report_sync_event *event =
+			cast_hid_report_sync_event(eh);
+
+		sample_request(event->report_id);
 
 		return false;
 	}
@@ -706,7 +722,11 @@ static bool event_handler(const struct event_header *eh)
 EVENT_LISTENER(MODULE, event_handler);
 EVENT_SUBSCRIBE(MODULE, module_state_event);
 EVENT_SUBSCRIBE(MODULE, wake_up_event);
+#if CONFIG_DESKTOP_HID_REPORT_SYNC_ENABLE
+EVENT_SUBSCRIBE(MODULE, hid_report_sync_event);
+#else
 EVENT_SUBSCRIBE(MODULE, hid_report_sent_event);
+#endif
 EVENT_SUBSCRIBE(MODULE, hid_report_subscription_event);
 #if CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE
 EVENT_SUBSCRIBE(MODULE, config_event);
@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <zephyr.h>
 #include <zephyr/types.h>
 #include <device.h>
@@ -20,6 +21,7 @@
 #include "ble_controller_hci_vs.h"
 
 #include "chmap_filter.h"
+#include "chmap_estimator.h"
 
 #define MODULE ble_qos
 #include "module_state_event.h"
@@ -61,6 +63,15 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_BLE_QOS_LOG_LEVEL);
 
 #define MAX_KEY_LEN 20
 
+#define HISTORY_KEY "history"
+
+#define ERR_RATE_FROM_PERCENT(_p) \
+	((_p) * CHMAP_ESTIMATOR_ERR_RATE_MAX / 100)
+
+#define WIFI_CHN_HALF_WIDTH_MHZ (CHMAP_WLAN_802_11GN_CHANNEL_WIDTH_MHz / 2)
+#define STORE_INTERVAL_MS \
+	(CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_STORE_INTERVAL * MSEC_PER_SEC)
+
 static K_THREAD_STACK_DEFINE(thread_stack, THREAD_STACK_SIZE);
 static struct k_thread thread;
 
@@ -99,12 +110,36 @@ static atomic_t params_updated;
 static struct chmap_filter_params filter_params;
 static struct k_mutex data_access_mutex;
 
+static const struct chmap_estimator_params estimator_params = {
+	.eval_sample_count = CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_EVAL_SAMPLE_COUNT,
+	.chn_sample_count_min =
+		CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_CHN_SAMPLE_COUNT_MIN,
+	.ewma_shift = CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_EWMA_SHIFT,
+	.decay_shift = CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_DECAY_SHIFT,
+	.block_threshold = ERR_RATE_FROM_PERCENT(
+		CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_BLOCK_THRESHOLD),
+	.unblock_threshold = ERR_RATE_FROM_PERCENT(
+		CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_UNBLOCK_THRESHOLD),
+	.min_channel_count = CONFIG_DESKTOP_BLE_QOS_ESTIMATOR_MIN_CHANNEL_COUNT,
+};
+
+static struct chmap_estimator estimator;
+static struct k_spinlock estimator_lock;
+static K_SEM_DEFINE(estimator_sem, 0, 1);
+static struct chmap_estimator_history loaded_history;
+static atomic_t history_loaded;
+static atomic_t process_requested;
+static atomic_t wifi_blacklist;
+
 BUILD_ASSERT(sizeof(struct bt_hci_cp_le_set_host_chan_classif) ==
 	     sizeof(struct params_chmap));
 BUILD_ASSERT(sizeof(current_chmap) == sizeof(struct params_chmap));
 BUILD_ASSERT(THREAD_PRIORITY >= CONFIG_BT_HCI_TX_PRIO);
+BUILD_ASSERT(CHMAP_ESTIMATOR_CHANNEL_COUNT == CHMAP_BLE_CHANNEL_COUNT);
+BUILD_ASSERT(CHMAP_ESTIMATOR_BITMASK_SIZE == CHMAP_BLE_BITMASK_SIZE);
 
 static void ble_qos_thread_fn(void);
+static void estimator_thread_fn(void);
 
 static struct device *cdc_dev;
 static u32_t cdc_dtr;
@@ -129,6 +164,20 @@ static const char * const opt_descr[] = {
 static void update_blacklist(const u8_t *blacklist)
 {
 	atomic_set(&new_blacklist, sys_get_le16(blacklist));
+
+	if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+		k_sem_give(&estimator_sem);
+	}
+}
+
+static void update_history(const struct chmap_estimator_history *history)
+{
+	k_mutex_lock(&data_access_mutex, K_FOREVER);
+	loaded_history = *history;
+	atomic_set(&history_loaded, true);
+	k_mutex_unlock(&data_access_mutex);
+
+	k_sem_give(&estimator_sem);
 }
 
 static void update_parameters(const u8_t *qos_ble_params,
@@ -241,6 +290,19 @@ static int settings_set(const char *key, size_t len_rd,
 		}
 
 		update_parameters(NULL, data);
+
+	} else if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR) &&
+		   !strcmp(key, HISTORY_KEY)) {
+		struct chmap_estimator_history history;
+
+		ssize_t len = read_cb(cb_arg, &history, sizeof(history));
+
+		if ((len != sizeof(history)) || (len != len_rd)) {
+			LOG_ERR("Can't read %s from storage", HISTORY_KEY);
+			return len;
+		}
+
+		update_history(&history);
 	}
 
 	return 0;
@@ -268,6 +330,36 @@ static void send_uart_data(struct device *cdc_dev, const u8_t *str, int str_len)
 #endif /* CONFIG_UART_INTERRUPT_DRIVEN */
 }
 
+static u8_t ble_chn_freq_get(u8_t chn_idx)
+{
+	/* Data channels 0-10 occupy 2404-2424 MHz, channels 11-36 occupy
+	 * 2428-2478 MHz. Advertising channel 38 (2426 MHz) is in between.
+	 */
+	return (chn_idx <= 10) ? (4 + 2 * chn_idx) : (6 + 2 * chn_idx);
+}
+
+static void chn_info_get(u8_t chn_idx, u8_t *state, s16_t *rating,
+			 u8_t *freq)
+{
+	if (!IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+		chmap_filter_chn_info_get(chmap_inst, chn_idx, state, rating,
+					  freq);
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&estimator_lock);
+	u32_t err_rate = chmap_estimator_err_rate_get(&estimator, chn_idx);
+
+	*state = chmap_estimator_chn_used(&estimator, chn_idx);
+
+	k_spin_unlock(&estimator_lock, key);
+
+	/* Rating is the CRC OK rate in percent. */
+	*rating = 100 - ROUNDED_DIV(err_rate * 100,
+				    CHMAP_ESTIMATOR_ERR_RATE_MAX);
+	*freq = ble_chn_freq_get(chn_idx);
+}
+
 static void ble_chn_stats_print(bool update_channel_map)
 {
 	char str[64];
@@ -325,12 +417,7 @@ static void ble_chn_stats_print(bool update_channel_map)
 
 	str_len = 0;
 	for (u8_t i = 0; i < CHMAP_BLE_CHANNEL_COUNT; i++) {
-		chmap_filter_chn_info_get(
-			chmap_inst,
-			i,
-			&chn_state,
-			&chn_rating,
-			&chn_freq);
+		chn_info_get(i, &chn_state, &chn_rating, &chn_freq);
 		part_len = snprintf(
 			&str[str_len],
 			sizeof(str) - str_len,
@@ -405,6 +492,18 @@ static void hid_pkt_stats_print(u32_t ble_recv)
 	send_uart_data(cdc_dev, str, str_len);
 }
 
+static void estimator_crc_update(u8_t chn_idx, u16_t crc_ok, u16_t crc_error)
+{
+	k_spinlock_key_t key = k_spin_lock(&estimator_lock);
+	bool process = chmap_estimator_crc_update(&estimator, chn_idx,
+						  crc_ok, crc_error);
+	k_spin_unlock(&estimator_lock, key);
+
+	if (process && !atomic_set(&process_requested, true)) {
+		k_sem_give(&estimator_sem);
+	}
+}
+
 static bool on_vs_evt(struct net_buf_simple *buf)
 {
 	u8_t *subevent_code;
@@ -416,6 +515,14 @@ static bool on_vs_evt(struct net_buf_simple *buf)
 
 	switch (*subevent_code) {
 	case HCI_VS_SUBEVENT_CODE_QOS_CONN_EVENT_REPORT:
+		if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+			evt = (void *)buf->data;
+			estimator_crc_update(evt->channel_index,
+					     evt->crc_ok_count,
+					     evt->crc_error_count);
+			return true;
+		}
+
 		if (atomic_get(&processing)) {
 			/* Cheaper to skip this update */
 			/* instead of using locks */
@@ -507,7 +614,9 @@ static void update_config(const u8_t opt_id, const u8_t *data,
 		break;
 
 	case BLE_QOS_OPT_PARAM_BLE:
-		if (size != sizeof(struct params_ble)) {
+		if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+			LOG_WRN("Not supported");
+		} else if (size != sizeof(struct params_ble)) {
 			LOG_WRN("Invalid size");
 		} else {
 			update_parameters(data, NULL);
@@ -516,7 +625,9 @@ static void update_config(const u8_t opt_id, const u8_t *data,
 		break;
 
 	case BLE_QOS_OPT_PARAM_WIFI:
-		if (size != sizeof(struct params_wifi)) {
+		if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+			LOG_WRN("Not supported");
+		} else if (size != sizeof(struct params_wifi)) {
 			LOG_WRN("Invalid size");
 		} else {
 			update_parameters(NULL, data);
@@ -599,7 +710,11 @@ static void fill_qos_channel_map(u8_t *data, size_t *size)
 
 static void fill_qos_blacklist(u8_t *data, size_t *size)
 {
-	sys_put_le16(chmap_filter_wifi_blacklist_get(), data);
+	if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+		sys_put_le16(atomic_get(&wifi_blacklist), data);
+	} else {
+		sys_put_le16(chmap_filter_wifi_blacklist_get(), data);
+	}
 
 	*size = sizeof(struct params_blacklist);
 }
@@ -616,11 +731,21 @@ static void fetch_config(const u8_t opt_id, u8_t *data, size_t *size)
 		break;
 
 	case BLE_QOS_OPT_PARAM_BLE:
-		fill_qos_ble_params(data, size);
+		if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+			LOG_WRN("Not supported");
+			*size = 0;
+		} else {
+			fill_qos_ble_params(data, size);
+		}
 		break;
 
 	case BLE_QOS_OPT_PARAM_WIFI:
-		fill_qos_wifi_params(data, size);
+		if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+			LOG_WRN("Not supported");
+			*size = 0;
+		} else {
+			fill_qos_wifi_params(data, size);
+		}
 		break;
 
 	default:
@@ -666,24 +791,35 @@ static bool event_handler(const struct event_header *eh)
 
 			initialized = true;
 
-			chmap_filter_init();
-
-			chmap_inst =
-				(struct chmap_instance *) chmap_instance_buf;
-			err = chmap_filter_instance_init(
-				chmap_inst,
-				sizeof(chmap_instance_buf));
-			if (err) {
-				LOG_ERR("Failed to initialize filter");
-				module_set_state(MODULE_STATE_ERROR);
-				return false;
+			if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR)) {
+				k_spinlock_key_t key =
+					k_spin_lock(&estimator_lock);
+
+				chmap_estimator_init(&estimator,
+						     &estimator_params);
+
+				k_spin_unlock(&estimator_lock, key);
+			} else {
+				chmap_filter_init();
+
+				chmap_inst = (struct chmap_instance *)
+					chmap_instance_buf;
+				err = chmap_filter_instance_init(
+					chmap_inst,
+					sizeof(chmap_instance_buf));
+				if (err) {
+					LOG_ERR("Failed to initialize filter");
+					module_set_state(MODULE_STATE_ERROR);
+					return false;
+				}
+
+				LOG_DBG("Chmap lib version: %s",
+					chmap_filter_version());
+
+				chmap_filter_params_get(chmap_inst,
+							&filter_params);
 			}
 
-			LOG_DBG("Chmap lib version: %s",
-				chmap_filter_version());
-
-			chmap_filter_params_get(chmap_inst, &filter_params);
-
 			k_mutex_init(&data_access_mutex);
 			new_blacklist = INVALID_BLACKLIST;
 			atomic_set(&params_updated, false);
@@ -698,6 +834,8 @@ static bool event_handler(const struct event_header *eh)
 
 			k_thread_create(&thread, thread_stack,
 					THREAD_STACK_SIZE,
+					IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_ALGORITHM_ESTIMATOR) ?
+					(k_thread_entry_t)estimator_thread_fn :
 					(k_thread_entry_t)ble_qos_thread_fn,
 					NULL, NULL, NULL,
 					THREAD_PRIORITY, 0, K_NO_WAIT);
@@ -794,6 +932,148 @@ static void ble_qos_thread_fn(void)
 	}
 }
 
+static void wifi_blacklist_to_chmap(u16_t wifi_chn_bitmask, u8_t *blacklist)
+{
+	static const u8_t wifi_freq[] = CHMAP_WLAN_802_11GN_CENTER_FREQS;
+
+	memset(blacklist, 0, CHMAP_BLE_BITMASK_SIZE);
+
+	/* Wi-Fi channel numbering starts from 1. */
+	for (size_t i = 0; i < ARRAY_SIZE(wifi_freq); i++) {
+		if (!(wifi_chn_bitmask & BIT(i + 1))) {
+			continue;
+		}
+
+		for (u8_t chn = 0; chn < CHMAP_BLE_CHANNEL_COUNT; chn++) {
+			int distance = ble_chn_freq_get(chn) - wifi_freq[i];
+
+			if (abs(distance) <= WIFI_CHN_HALF_WIDTH_MHZ) {
+				blacklist[chn / 8] |= BIT(chn % 8);
+			}
+		}
+	}
+}
+
+static void store_history(void)
+{
+	if (IS_ENABLED(CONFIG_SETTINGS)) {
+		struct chmap_estimator_history history;
+		k_spinlock_key_t key = k_spin_lock(&estimator_lock);
+
+		chmap_estimator_history_get(&estimator, &history);
+
+		k_spin_unlock(&estimator_lock, key);
+
+		int err = settings_save_one(MODULE_NAME "/" HISTORY_KEY,
+					    &history, sizeof(history));
+
+		if (err) {
+			LOG_ERR("Problem storing %s (err = %d)", HISTORY_KEY,
+				err);
+		}
+	}
+}
+
+static void estimator_thread_fn(void)
+{
+	u8_t applied_chmap[CHMAP_BLE_BITMASK_SIZE] = CHMAP_BLE_BITMASK_DEFAULT;
+	bool store_pending = false;
+	s64_t store_time = -STORE_INTERVAL_MS;
+
+	while (true) {
+		k_timeout_t timeout = K_FOREVER;
+
+		if (store_pending) {
+			s64_t wait = store_time + STORE_INTERVAL_MS -
+				     k_uptime_get();
+
+			timeout = (wait > 0) ? K_MSEC(wait) : K_NO_WAIT;
+		}
+
+		/* Processing is triggered by collected CRC statistics or
+		 * configuration updates, there is no periodic wake up.
+		 */
+		k_sem_take(&estimator_sem, timeout);
+
+		u8_t chmap[CHMAP_BLE_BITMASK_SIZE];
+		struct chmap_estimator_history history;
+		bool history_update = atomic_set(&history_loaded, false);
+
+		if (history_update) {
+			k_mutex_lock(&data_access_mutex, K_FOREVER);
+			history = loaded_history;
+			k_mutex_unlock(&data_access_mutex);
+		}
+
+		u16_t blacklist_update =
+			(u16_t) atomic_set(&new_blacklist, INVALID_BLACKLIST);
+		u8_t blacklist[CHMAP_BLE_BITMASK_SIZE];
+
+		if (blacklist_update != INVALID_BLACKLIST) {
+			wifi_blacklist_to_chmap(blacklist_update, blacklist);
+			atomic_set(&wifi_blacklist, blacklist_update);
+		}
+
+		k_spinlock_key_t key = k_spin_lock(&estimator_lock);
+
+		if (history_update) {
+			chmap_estimator_history_set(&estimator, &history);
+		}
+
+		if (blacklist_update != INVALID_BLACKLIST) {
+			chmap_estimator_blacklist_set(&estimator, blacklist);
+		}
+
+		if (atomic_set(&process_requested, false)) {
+			chmap_estimator_process(&estimator);
+		}
+
+		memcpy(chmap, chmap_estimator_map_get(&estimator),
+		       sizeof(chmap));
+
+		k_spin_unlock(&estimator_lock, key);
+
+		bool update_channel_map = memcmp(chmap, applied_chmap,
+						 sizeof(chmap));
+
+		if (update_channel_map) {
+			/* On failure, the update is retried on the next
+			 * processing.
+			 */
+			int err = bt_le_set_chan_map(chmap);
+
+			if (err) {
+				LOG_WRN("bt_le_set_chan_map: %d", err);
+				update_channel_map = false;
+			} else {
+				LOG_DBG("Channel map update");
+				memcpy(applied_chmap, chmap,
+				       sizeof(applied_chmap));
+
+				k_mutex_lock(&data_access_mutex, K_FOREVER);
+				memcpy(current_chmap, chmap,
+				       sizeof(current_chmap));
+				k_mutex_unlock(&data_access_mutex);
+
+				/* Restored history does not need storing. */
+				if (IS_ENABLED(CONFIG_SETTINGS) &&
+				    !history_update) {
+					store_pending = true;
+				}
+			}
+		}
+
+		ble_chn_stats_print(update_channel_map);
+
+		if (store_pending &&
+		    (k_uptime_get() - store_time >= STORE_INTERVAL_MS)) {
+			store_history();
+			store_pending = false;
+			store_time = k_uptime_get();
+		}
+	}
+}
+
 EVENT_LISTENER(MODULE, event_handler);
 EVENT_SUBSCRIBE(MODULE, module_state_event);
 #if CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE
@@ -5,7 +5,6 @@
  */
 
 #include <zephyr/types.h>
-#include <sys/slist.h>
 
 #include <bluetooth/services/hids_c.h>
 #include <sys/byteorder.h>
@@ -24,16 +23,37 @@
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_HID_FORWARD_LOG_LEVEL);
 
-#define MAX_ENQUEUED_ITEMS	5
+#define REPORT_DATA_SIZE_MAX	MAX(MAX(REPORT_SIZE_MOUSE,			\
+					REPORT_SIZE_KEYBOARD_KEYS),		\
+				    MAX(REPORT_SIZE_SYSTEM_CTRL,		\
+					REPORT_SIZE_CONSUMER_CTRL))
 
-struct enqueued_event_item {
-	sys_snode_t node;
-	struct hid_report_event *event;
+/**@brief Report waiting for the USB endpoint. */
+struct enqueued_report {
+	u8_t report_id;
+	u8_t size;
+	u8_t data[REPORT_DATA_SIZE_MAX];
+};
+
+/**@brief Ring buffer of reports received from a peripheral. */
+struct report_queue {
+	struct enqueued_report reports[CONFIG_DESKTOP_HID_FORWARD_QUEUE_SIZE];
+	u8_t head;
+	u8_t len;
+};
+
+/**@brief Forwarding statistics of a peripheral. */
+struct forward_stats {
+	u32_t forwarded; /**< Number of reports forwarded to USB. */
+	u32_t dropped; /**< Number of reports dropped on queue overflow. */
+	u8_t len_max; /**< Maximal number of enqueued reports. */
 };
 
 struct hids_subscriber {
 	struct bt_gatt_hids_c hidc;
 	u16_t pid;
+	struct report_queue queue;
+	struct forward_stats stats;
 };
 
 static struct hids_subscriber subscribers[CONFIG_BT_MAX_CONN];
@@ -42,63 +62,134 @@ static bool usb_ready;
 static bool usb_busy;
 static bool forward_pending;
 static void *channel_id;
-
-static sys_slist_t enqueued_event_list;
-static size_t enqueued_event_count;
+static size_t next_subscriber;
 
 static struct k_spinlock lock;
 
 
-static void enqueue_hid_event(struct hid_report_event *event)
+static struct enqueued_report *queue_peek(struct report_queue *queue,
+					  size_t pos)
 {
-	struct enqueued_event_item *item;
+	size_t idx = queue->head + pos;
 
-	if (enqueued_event_count < MAX_ENQUEUED_ITEMS) {
-		item = k_malloc(sizeof(*item));
-		enqueued_event_count++;
-	} else {
-		LOG_WRN("Enqueue dropped the oldest event");
-		item = CONTAINER_OF(sys_slist_get(&enqueued_event_list),
-				    __typeof__(*item),
-				    node);
-		k_free(item->event);
+	__ASSERT_NO_MSG(pos < queue->len);
+
+	if (idx >= ARRAY_SIZE(queue->reports)) {
+		idx -= ARRAY_SIZE(queue->reports);
 	}
 
-	if (!item) {
-		LOG_ERR("OOM error");
-		module_set_state(MODULE_STATE_ERROR);
-	} else {
-		item->event = event;
-		sys_slist_append(&enqueued_event_list, &item->node);
+	return &queue->reports[idx];
+}
+
+static void queue_drop(struct report_queue *queue)
+{
+	__ASSERT_NO_MSG(queue->len > 0);
+
+	queue->head++;
+	if (queue->head >= ARRAY_SIZE(queue->reports)) {
+		queue->head = 0;
 	}
+	queue->len--;
 }
 
-static void forward_hid_report(u8_t report_id, const u8_t *data, size_t size)
+static void queue_reset(struct report_queue *queue)
 {
-	struct hid_report_event *event = new_hid_report_event(size + sizeof(report_id));
+	queue->head = 0;
+	queue->len = 0;
+}
 
-	k_spinlock_key_t key = k_spin_lock(&lock);
+static void enqueue_hid_report(struct hids_subscriber *subscriber,
+			       u8_t report_id, const u8_t *data, size_t size)
+{
+	struct report_queue *queue = &subscriber->queue;
 
-	if (!usb_ready) {
-		k_spin_unlock(&lock, key);
-		k_free(event);
-		return;
+	if (queue->len >= ARRAY_SIZE(queue->reports)) {
+		queue_drop(queue);
+		subscriber->stats.dropped++;
+		LOG_WRN("Enqueue dropped the oldest report of %" PRIx16
+			" (%" PRIu32 " dropped)",
+			subscriber->pid, subscriber->stats.dropped);
 	}
 
+	queue->len++;
+
+	struct enqueued_report *report = queue_peek(queue, queue->len - 1);
+
+	report->report_id = report_id;
+	report->size = size;
+	memcpy(report->data, data, size);
+
+	if (queue->len > subscriber->stats.len_max) {
+		subscriber->stats.len_max = queue->len;
+	}
+}
+
+/**@brief Take the next enqueued report. Peripherals are served in turns,
+ *	  so one peripheral cannot starve the others.
+ */
+static bool dequeue_hid_report(struct enqueued_report *report)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
+		size_t idx = (next_subscriber + i) % ARRAY_SIZE(subscribers);
+		struct hids_subscriber *subscriber = &subscribers[idx];
+
+		if (subscriber->queue.len > 0) {
+			*report = *queue_peek(&subscriber->queue, 0);
+			queue_drop(&subscriber->queue);
+			subscriber->stats.forwarded++;
+			next_subscriber = idx + 1;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void submit_hid_report(u8_t report_id, const u8_t *data, size_t size)
+{
+	struct hid_report_event *event = new_hid_report_event(size + sizeof(report_id));
+
 	event->subscriber = usb_id;
 
 	/* Forward report as is adding report id on the front. */
 	event->dyndata.data[0] = report_id;
 	memcpy(&event->dyndata.data[1], data, size);
 
-	if (!usb_busy) {
-		EVENT_SUBMIT(event);
-		usb_busy = true;
-	} else {
-		enqueue_hid_event(event);
+	EVENT_SUBMIT(event);
+}
+
+static void forward_hid_report(struct hids_subscriber *subscriber,
+			       u8_t report_id, const u8_t *data, size_t size)
+{
+	if (size > REPORT_DATA_SIZE_MAX) {
+		LOG_WRN("Report 0x%" PRIx8 " too big (%u bytes)",
+			report_id, (unsigned int)size);
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (!usb_ready) {
+		k_spin_unlock(&lock, key);
+		return;
 	}
 
+	if (usb_busy) {
+		/* Report data is stored in the preallocated queue of the
+		 * peripheral. Event is allocated once the USB is free.
+		 */
+		enqueue_hid_report(subscriber, report_id, data, size);
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	usb_busy = true;
+	subscriber->stats.forwarded++;
+
 	k_spin_unlock(&lock, key);
+
+	submit_hid_report(report_id, data, size);
 }
 
 static u8_t hidc_read(struct bt_gatt_hids_c *hids_c,
@@ -120,7 +211,8 @@ static u8_t hidc_read(struct bt_gatt_hids_c *hids_c,
 	__ASSERT_NO_MSG((report_id != REPORT_ID_RESERVED) &&
 			(report_id < REPORT_ID_COUNT));
 
-	forward_hid_report(report_id, data, size);
+	forward_hid_report(CONTAINER_OF(hids_c, struct hids_subscriber, hidc),
+			   report_id, data, size);
 
 	return BT_GATT_ITER_CONTINUE;
 }
@@ -170,7 +262,6 @@ static void init(void)
 	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
 		bt_gatt_hids_c_init(&subscribers[i].hidc, &params);
 	}
-	sys_slist_init(&enqueued_event_list);
 }
 
 static int register_subscriber(struct bt_gatt_dm *dm, u16_t pid)
@@ -184,6 +275,8 @@ static int register_subscriber(struct bt_gatt_dm *dm, u16_t pid)
 	__ASSERT_NO_MSG(i < ARRAY_SIZE(subscribers));
 
 	subscribers[i].pid = pid;
+	memset(&subscribers[i].stats, 0, sizeof(subscribers[i].stats));
+
 	int err = bt_gatt_hids_c_handles_assign(dm, &subscribers[i].hidc);
 
 	if (err) {
@@ -413,10 +506,16 @@ static void disconnect_subscriber(struct hids_subscriber *subscriber)
 
 			memset(empty_data, 0, sizeof(empty_data));
 
-			forward_hid_report(report_id, empty_data, size);
+			forward_hid_report(subscriber, report_id, empty_data,
+					   size);
 		}
 	}
 
+	LOG_INF("Peer %" PRIx16 " forwarded %" PRIu32 " reports, dropped %"
+		PRIu32 ", max queue depth %" PRIu8,
+		subscriber->pid, subscriber->stats.forwarded,
+		subscriber->stats.dropped, subscriber->stats.len_max);
+
 	bt_gatt_hids_c_release(&subscriber->hidc);
 	subscriber->pid = 0;
 }
@@ -430,50 +529,33 @@ static void clear_state(void)
 	usb_busy = false;
 
 	/* Clear all the reports. */
-	while (!sys_slist_is_empty(&enqueued_event_list)) {
-		struct enqueued_event_item *item;;
-
-		item = CONTAINER_OF(sys_slist_get(&enqueued_event_list),
-				     __typeof__(*item),
-				    node);
-		enqueued_event_count--;
-
-		k_spin_unlock(&lock, key);
-
-		k_free(item->event);
-		k_free(item);
-
-		key = k_spin_lock(&lock);
+	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
+		queue_reset(&subscribers[i].queue);
 	}
 
-	__ASSERT_NO_MSG(enqueued_event_count == 0);
-
 	k_spin_unlock(&lock, key);
 }
 
 static bool event_handler(const struct event_header *eh)
 {
 	if (is_hid_report_sent_event(eh)) {
+		struct enqueued_report report;
 		k_spinlock_key_t key = k_spin_lock(&lock);
 
 		__ASSERT_NO_MSG(usb_ready);
 
-		struct enqueued_event_item *item = NULL;
+		bool dequeued = dequeue_hid_report(&report);
 
-		if (!sys_slist_is_empty(&enqueued_event_list)) {
-			item = CONTAINER_OF(sys_slist_get(&enqueued_event_list),
-					    __typeof__(*item),
-					    node);
-			enqueued_event_count--;
-
-			EVENT_SUBMIT(item->event);
-		} else {
+		if (!dequeued) {
 			usb_busy = false;
 		}
 
 		k_spin_unlock(&lock, key);
 
-		k_free(item);
+		if (dequeued) {
+			submit_hid_report(report.report_id, report.data,
+					  report.size);
+		}
 
 		return false;
 	}
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+#include <spinlock.h>
+
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/hci.h>
+
+#include "ble_controller_hci_vs.h"
+
+#define MODULE hid_report_sync
+#include "module_state_event.h"
+#include "ble_event.h"
+#include "hid_event.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_HID_REPORT_SYNC_LOG_LEVEL);
+
+#define REG_CONN_INTERVAL_LLPM_MASK	0x0d00
+#define REG_CONN_INTERVAL_UNIT_US	1250
+
+#define SYNC_LEAD_US			CONFIG_DESKTOP_HID_REPORT_SYNC_LEAD_US
+
+
+struct sync_state {
+	struct k_spinlock lock;
+
+	struct bt_conn *conn;
+	u16_t conn_handle;
+	u32_t interval_us;
+
+	u32_t sync_stamp;
+	bool measure_pending;
+	u16_t latency_us;
+};
+
+static struct sync_state state;
+static struct k_timer sync_timer;
+static atomic_t sync_armed;
+
+
+static u32_t interval_reg_to_us(u16_t interval)
+{
+	if (interval & REG_CONN_INTERVAL_LLPM_MASK) {
+		return (interval & ~REG_CONN_INTERVAL_LLPM_MASK) *
+			USEC_PER_MSEC;
+	}
+
+	return interval * REG_CONN_INTERVAL_UNIT_US;
+}
+
+static void sync_event_submit(const void *subscriber, u16_t latency_us)
+{
+	struct hid_report_sync_event *event = new_hid_report_sync_event();
+
+	event->subscriber = subscriber;
+	event->report_id = REPORT_ID_MOUSE;
+	event->latency_us = latency_us;
+
+	EVENT_SUBMIT(event);
+}
+
+static void sync_trigger(void)
+{
+	if (!atomic_cas(&sync_armed, true, false)) {
+		/* No report was sent since the previous sync. */
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	const void *subscriber = state.conn;
+	u16_t latency_us = state.latency_us;
+
+	state.sync_stamp = k_cycle_get_32();
+	state.measure_pending = true;
+
+	k_spin_unlock(&state.lock, key);
+
+	sync_event_submit(subscriber, latency_us);
+}
+
+static void sync_timer_handler(struct k_timer *timer)
+{
+	sync_trigger();
+}
+
+static void conn_event_handle(u16_t conn_handle, u32_t stamp)
+{
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	if (!state.conn || (state.conn_handle != conn_handle) ||
+	    !state.interval_us) {
+		k_spin_unlock(&state.lock, key);
+		return;
+	}
+
+	if (state.measure_pending) {
+		u32_t latency = k_cyc_to_us_floor32(stamp - state.sync_stamp);
+
+		state.latency_us = MIN(latency, UINT16_MAX);
+		state.measure_pending = false;
+	}
+
+	/* Connection event has just ended. Sample the data so that it is
+	 * ready SYNC_LEAD_US before the upcoming connection event. The timer
+	 * period keeps the sync running if a report is missed.
+	 */
+	u32_t lead = SYNC_LEAD_US % state.interval_us;
+	u32_t delay = (lead == 0) ? (0) : (state.interval_us - lead);
+	u32_t interval_us = state.interval_us;
+
+	k_spin_unlock(&state.lock, key);
+
+	if (delay == 0) {
+		k_timer_start(&sync_timer, K_USEC(interval_us),
+			      K_USEC(interval_us));
+		sync_trigger();
+	} else {
+		k_timer_start(&sync_timer, K_USEC(delay), K_USEC(interval_us));
+	}
+}
+
+static bool on_vs_evt(struct net_buf_simple *buf)
+{
+	u8_t *subevent_code = net_buf_simple_pull_mem(buf,
+						      sizeof(*subevent_code));
+
+	if (*subevent_code != HCI_VS_SUBEVENT_CODE_QOS_CONN_EVENT_REPORT) {
+		return false;
+	}
+
+	const hci_vs_evt_qos_conn_event_report_t *evt = (void *)buf->data;
+
+	conn_event_handle(evt->conn_handle, k_cycle_get_32());
+
+	return true;
+}
+
+static int enable_conn_event_reports(void)
+{
+	int err = bt_hci_register_vnd_evt_cb(on_vs_evt);
+
+	if (err) {
+		LOG_ERR("Failed to register HCI VS callback (err:%d)", err);
+		return err;
+	}
+
+	hci_vs_cmd_qos_conn_event_report_enable_t *cmd_enable;
+	struct net_buf *buf = bt_hci_cmd_create(
+		HCI_VS_OPCODE_CMD_QOS_CONN_EVENT_REPORT_ENABLE,
+		sizeof(*cmd_enable));
+
+	if (!buf) {
+		LOG_ERR("Failed to create HCI VS command");
+		return -ENOBUFS;
+	}
+
+	cmd_enable = net_buf_add(buf, sizeof(*cmd_enable));
+	cmd_enable->enable = 1;
+
+	err = bt_hci_cmd_send_sync(
+		HCI_VS_OPCODE_CMD_QOS_CONN_EVENT_REPORT_ENABLE, buf, NULL);
+	if (err) {
+		LOG_ERR("Failed to enable connection event reports (err:%d)",
+			err);
+	}
+
+	return err;
+}
+
+static void sync_conn_set(struct bt_conn *conn)
+{
+	struct bt_conn_info info;
+	u16_t conn_handle;
+	int err = bt_conn_get_info(conn, &info);
+
+	if (!err) {
+		err = bt_hci_get_conn_handle(conn, &conn_handle);
+	}
+
+	if (err) {
+		LOG_ERR("Cannot get connection info (err:%d)", err);
+		return;
+	}
+
+	u32_t interval_us = interval_reg_to_us(info.le.interval);
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	state.conn = conn;
+	state.conn_handle = conn_handle;
+	state.interval_us = interval_us;
+	state.measure_pending = false;
+	state.latency_us = 0;
+
+	k_spin_unlock(&state.lock, key);
+
+	/* Keep sampling going until the first connection event report
+	 * aligns the timer.
+	 */
+	k_timer_start(&sync_timer, K_USEC(interval_us), K_USEC(interval_us));
+
+	LOG_INF("Sync to connection events every %" PRIu32 " us",
+		interval_us);
+}
+
+static void sync_conn_clear(struct bt_conn *conn)
+{
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	if (state.conn != conn) {
+		k_spin_unlock(&state.lock, key);
+		return;
+	}
+
+	state.conn = NULL;
+	state.interval_us = 0;
+	state.measure_pending = false;
+
+	k_spin_unlock(&state.lock, key);
+
+	k_timer_stop(&sync_timer);
+	atomic_set(&sync_armed, false);
+}
+
+static bool handle_hid_report_sent_event(
+		const struct hid_report_sent_event *event)
+{
+	if (event->report_id != REPORT_ID_MOUSE) {
+		return false;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+	bool synced = (event->subscriber == state.conn) && state.interval_us;
+	k_spin_unlock(&state.lock, key);
+
+	if (synced) {
+		/* Wait for the sampling point of the connection event. */
+		atomic_set(&sync_armed, true);
+	} else {
+		/* Timing of the transport is unknown, sample right away. */
+		sync_event_submit(event->subscriber, 0);
+	}
+
+	return false;
+}
+
+static bool handle_ble_peer_event(const struct ble_peer_event *event)
+{
+	switch (event->state) {
+	case PEER_STATE_CONNECTED:
+		if (!state.conn) {
+			sync_conn_set(event->id);
+		}
+		break;
+
+	case PEER_STATE_DISCONNECTED:
+		sync_conn_clear(event->id);
+		break;
+
+	default:
+		/* Ignore. */
+		break;
+	}
+
+	return false;
+}
+
+static bool handle_ble_peer_conn_params_event(
+		const struct ble_peer_conn_params_event *event)
+{
+	if (!event->updated || (event->id != state.conn)) {
+		return false;
+	}
+
+	u32_t interval_us = interval_reg_to_us(event->interval_min);
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	state.interval_us = interval_us;
+	state.measure_pending = false;
+
+	k_spin_unlock(&state.lock, key);
+
+	k_timer_start(&sync_timer, K_USEC(interval_us), K_USEC(interval_us));
+
+	LOG_INF("Sync to connection events every %" PRIu32 " us",
+		interval_us);
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_hid_report_sent_event(eh)) {
+		return handle_hid_report_sent_event(
+			cast_hid_report_sent_event(eh));
+	}
+
+	if (is_ble_peer_event(eh)) {
+		return handle_ble_peer_event(cast_ble_peer_event(eh));
+	}
+
+	if (is_ble_peer_conn_params_event(eh)) {
+		return handle_ble_peer_conn_params_event(
+			cast_ble_peer_conn_params_event(eh));
+	}
+
+	if (is_module_state_event(eh)) {
+		const struct module_state_event *event =
+			cast_module_state_event(eh);
+
+		if (check_state(event, MODULE_ID(main), MODULE_STATE_READY)) {
+			k_timer_init(&sync_timer, sync_timer_handler, NULL);
+		} else if (check_state(event, MODULE_ID(ble_state),
+				       MODULE_STATE_READY)) {
+			if (enable_conn_event_reports()) {
+				module_set_state(MODULE_STATE_ERROR);
+			} else {
+				module_set_state(MODULE_STATE_READY);
+			}
+		}
+
+		return false;
+	}
+
+	/* If event is unhandled, unsubscribe. */
+	__ASSERT_NO_MSG(false);
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, module_state_event);
+EVENT_SUBSCRIBE(MODULE, ble_peer_event);
+EVENT_SUBSCRIBE(MODULE, ble_peer_conn_params_event);
+EVENT_SUBSCRIBE(MODULE, hid_report_sent_event);
@@ -14,7 +14,6 @@
 #include <sys/types.h>
 
 #include <zephyr/types.h>
-#include <sys/slist.h>
 #include <sys/util.h>
 #include <sys/byteorder.h>
 
@@ -24,10 +23,12 @@
 #include "hid_event.h"
 #include "ble_event.h"
 #include "usb_event.h"
+#include "config_event.h"
 
 #include "hid_keymap.h"
 #include "hid_keymap_def.h"
 #include "hid_report_desc.h"
+#include "hid_items.h"
 
 #define MODULE hid_state
 #include "module_state_event.h"
@@ -46,6 +47,11 @@ enum state {
 #define SUBSCRIBER_COUNT (IS_ENABLED(CONFIG_DESKTOP_HIDS_ENABLE) + \
 			  IS_ENABLED(CONFIG_DESKTOP_USB_ENABLE))
 
+/* In multi-host mode USB and Bluetooth subscribers use separate pipelines. */
+#define PIPELINE_COUNT (IS_ENABLED(CONFIG_DESKTOP_HID_STATE_MULTI_HOST) ? 2 : 1)
+#define PIPELINE_USB 0
+#define PIPELINE_BLE (PIPELINE_COUNT - 1)
+
 #define INPUT_REPORT_DATA_COUNT (IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT) +		\
 				 IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_KEYBOARD_SUPPORT) +	\
 				 IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_SYSTEM_CTRL_SUPPORT) +	\
@@ -66,30 +72,37 @@ enum state {
 #define AXIS_COUNT (IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT) * MOUSE_REPORT_AXIS_COUNT)
 
 
-/**@brief HID state item. */
-struct item {
-	u16_t usage_id; /**< HID usage ID. */
-	s16_t value; /**< HID value. */
-};
-
 /**@brief Structure keeping state for a single target HID report. */
 struct items {
 	u8_t item_count_max; /**< Maximal numer of items in this set. */
 	u8_t item_count; /**< Current number of items in this set. */
-	struct item item[ITEM_COUNT]; /**< Items set. Browse from the end. */
+	struct hid_item item[ITEM_COUNT]; /**< Items set. Browse from the end. */
 };
 
 /**@brief Enqueued HID state item. */
 struct item_event {
-	sys_snode_t node; /**< Event queue linked list node. */
-	struct item item; /**< HID state item which has been enqueued. */
+	struct hid_item item; /**< HID state item which has been enqueued. */
 	u32_t timestamp; /**< HID event timestamp. */
 };
 
-/**@brief Event queue. */
+/**@brief Event queue statistics. */
+struct eventq_stats {
+	u32_t overflow_cnt; /**< Number of times the queue had to be dropped. */
+	u32_t dropped_cnt; /**< Number of events dropped on overflow. */
+	u32_t expired_cnt; /**< Number of expired events removed. */
+	u8_t len_max; /**< Maximal number of enqueued events. */
+};
+
+/**@brief Event queue.
+ *
+ * Events are kept in a ring buffer of fixed size. The oldest event is
+ * at the head position.
+ */
 struct eventq {
-	sys_slist_t root;
-	size_t len;
+	struct item_event events[CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE];
+	u8_t head;
+	u8_t len;
+	struct eventq_stats stats;
 };
 
 /**@brief Axis data. */
@@ -117,17 +130,38 @@ struct report_state {
 struct subscriber {
 	const void *id;
 	bool is_usb;
+	struct pipeline *pipeline;
 	struct report_state state[INPUT_REPORT_STATE_COUNT];
 };
 
+/**@brief Report pipeline.
+ *
+ * Report data of a pipeline is routed to the selected subscriber.
+ */
+struct pipeline {
+	struct report_data report_data[INPUT_REPORT_DATA_COUNT];
+	struct subscriber *selected;
+};
+
 /**@brief HID state structure. */
 struct hid_state {
-	struct report_data report_data[INPUT_REPORT_DATA_COUNT];
+	struct pipeline pipeline[PIPELINE_COUNT];
 	struct subscriber subscriber[SUBSCRIBER_COUNT];
-	struct subscriber *selected;
 };
 
 
+/* Keymap index is an open addressing hash table holding positions of
+ * the hid_keymap entries. It is at most half full, so a lookup usually
+ * ends on the first slot.
+ */
+#define KEYMAP_INDEX_SIZE	(2 * ARRAY_SIZE(hid_keymap) + 1)
+#define KEYMAP_INDEX_EMPTY	UINT8_MAX
+#define KEYMAP_INDEX_HASH_MUL	0x9E3779B1ul
+
+BUILD_ASSERT(ARRAY_SIZE(hid_keymap) < KEYMAP_INDEX_EMPTY,
+	     "hid_keymap has too many entries for the keymap index");
+
+static u8_t keymap_index[KEYMAP_INDEX_SIZE];
 static u8_t report_data_index[REPORT_ID_COUNT];
 static u8_t report_state_index[REPORT_ID_COUNT];
 static struct hid_state state;
@@ -136,36 +170,34 @@ static struct hid_state state;
 static void report_send(struct report_data *rd, bool check_state, bool send_always);
 
 
-/**@brief Binary search. Input array must be already sorted.
- *
- * bsearch is also available from newlib libc, but including
- * the library takes around 10K of FLASH.
- */
-static void *bsearch(const void *key, const u8_t *base,
-			 size_t elem_num, size_t elem_size,
-			 int (*compare)(const void *, const void *))
-{
-	__ASSERT_NO_MSG(base);
-	__ASSERT_NO_MSG(compare);
-	__ASSERT_NO_MSG(elem_num <= SSIZE_MAX);
+enum config_hid_state_opt {
+	HID_STATE_OPT_EVENTQ_STATS,
 
-	if (!elem_num) {
-		return NULL;
-	}
+	HID_STATE_OPT_COUNT
+};
 
-	ssize_t lower = 0;
-	ssize_t upper = elem_num - 1;
+static const char * const opt_descr[] = {
+	[HID_STATE_OPT_EVENTQ_STATS] = "eventq_stats"
+};
 
-	while (upper >= lower) {
-		ssize_t m = (lower + upper) / 2;
-		int cmp = compare(key, base + (elem_size * m));
 
-		if (cmp == 0) {
-			return (void *)(base + (elem_size * m));
-		} else if (cmp < 0) {
-			upper = m - 1;
-		} else {
-			lower = m + 1;
+/**@brief Find position of the Key ID in the keymap index. */
+static size_t keymap_index_pos(u16_t key_id)
+{
+	return ((u32_t)key_id * KEYMAP_INDEX_HASH_MUL) % KEYMAP_INDEX_SIZE;
+}
+
+/**@brief Translate Key ID to HID Usage ID and target report. */
+static const struct hid_keymap *hid_keymap_get(u16_t key_id)
+{
+	/* The index is never full, so the loop always terminates. */
+	for (size_t pos = keymap_index_pos(key_id);
+	     keymap_index[pos] != KEYMAP_INDEX_EMPTY;
+	     pos = (pos + 1) % KEYMAP_INDEX_SIZE) {
+		const struct hid_keymap *map = &hid_keymap[keymap_index[pos]];
+
+		if (map->key_id == key_id) {
+			return map;
 		}
 	}
 
@@ -173,121 +205,113 @@ static void *bsearch(const void *key, const u8_t *base,
 	return NULL;
 }
 
-/**@brief Compare Key ID in HID Keymap entries. */
-static int hid_keymap_compare(const void *a, const void *b)
+static int keymap_index_init(void)
 {
-	const struct hid_keymap *p_a = a;
-	const struct hid_keymap *p_b = b;
+	int err = 0;
 
-	return (p_a->key_id - p_b->key_id);
-}
+	memset(keymap_index, KEYMAP_INDEX_EMPTY, sizeof(keymap_index));
 
-/**@brief Translate Key ID to HID Usage ID and target report. */
-static struct hid_keymap *hid_keymap_get(u16_t key_id)
-{
-	struct hid_keymap key = {
-		.key_id = key_id
-	};
+	for (size_t i = 0; i < ARRAY_SIZE(hid_keymap); i++) {
+		size_t pos = keymap_index_pos(hid_keymap[i].key_id);
 
-	struct hid_keymap *map = bsearch(&key,
-					 (u8_t *)hid_keymap,
-					 ARRAY_SIZE(hid_keymap),
-					 sizeof(key),
-					 hid_keymap_compare);
+		while ((keymap_index[pos] != KEYMAP_INDEX_EMPTY) &&
+		       (hid_keymap[keymap_index[pos]].key_id !=
+			hid_keymap[i].key_id)) {
+			pos = (pos + 1) % KEYMAP_INDEX_SIZE;
+		}
 
-	return map;
-}
+		if (keymap_index[pos] != KEYMAP_INDEX_EMPTY) {
+			LOG_ERR("Key ID 0x%x used twice in hid_keymap",
+				hid_keymap[i].key_id);
+			err = -EINVAL;
+			continue;
+		}
 
-/**@brief Compare two usage values. */
-static int usage_id_compare(const void *a, const void *b)
-{
-	const struct item *p_a = a;
-	const struct item *p_b = b;
+		keymap_index[pos] = i;
+	}
 
-	return (p_a->usage_id - p_b->usage_id);
+	return err;
 }
 
 static void eventq_reset(struct eventq *eventq)
 {
-	struct item_event *event;
-	struct item_event *tmp;
-
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&eventq->root, event, tmp, node) {
-		sys_slist_remove(&eventq->root, NULL, &event->node);
-
-		k_free(event);
-	}
-
-	sys_slist_init(&eventq->root);
+	eventq->head = 0;
 	eventq->len = 0;
 }
 
 static bool eventq_is_full(const struct eventq *eventq)
 {
-	return (eventq->len >= CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE);
+	return (eventq->len >= ARRAY_SIZE(eventq->events));
 }
 
 
-static bool eventq_is_empty(struct eventq *eventq)
+static bool eventq_is_empty(const struct eventq *eventq)
 {
-	bool empty = sys_slist_is_empty(&eventq->root);
-
-	__ASSERT_NO_MSG(!empty == (eventq->len != 0));
-
-	return empty;
+	return (eventq->len == 0);
 }
 
-static struct item_event *eventq_get(struct eventq *eventq)
+/**@brief Get event at the given position counted from the queue head. */
+static struct item_event *eventq_peek(struct eventq *eventq, size_t pos)
 {
-	sys_snode_t *node = sys_slist_get(&eventq->root);
+	__ASSERT_NO_MSG(pos < eventq->len);
 
-	if (!node) {
-		return NULL;
-	}
+	size_t idx = eventq->head + pos;
 
-	eventq->len--;
+	if (idx >= ARRAY_SIZE(eventq->events)) {
+		idx -= ARRAY_SIZE(eventq->events);
+	}
 
-	return CONTAINER_OF(node, struct item_event, node);
+	return &eventq->events[idx];
 }
 
-static void eventq_append(struct eventq *eventq, u16_t usage_id, s16_t value)
+/**@brief Remove the given number of events from the queue head. */
+static void eventq_drop(struct eventq *eventq, size_t cnt)
 {
-	struct item_event *hid_event = k_malloc(sizeof(*hid_event));
+	__ASSERT_NO_MSG(cnt <= eventq->len);
 
-	if (!hid_event) {
-		LOG_WRN("Failed to allocate HID event");
-		return;
+	size_t head = eventq->head + cnt;
+
+	if (head >= ARRAY_SIZE(eventq->events)) {
+		head -= ARRAY_SIZE(eventq->events);
 	}
 
-	hid_event->item.usage_id = usage_id;
-	hid_event->item.value = value;
-	hid_event->timestamp = k_uptime_get_32();
+	eventq->head = head;
+	eventq->len -= cnt;
+}
 
-	/* Add a new event to the queue. */
-	sys_slist_append(&eventq->root, &hid_event->node);
+static bool eventq_get(struct eventq *eventq, struct item_event *event)
+{
+	if (eventq_is_empty(eventq)) {
+		return false;
+	}
 
-	eventq->len++;
+	*event = *eventq_peek(eventq, 0);
+	eventq_drop(eventq, 1);
+
+	return true;
 }
 
-static void eventq_region_purge(struct eventq *eventq,
-				sys_snode_t *last_to_purge)
+static void eventq_append(struct eventq *eventq, u16_t usage_id, s16_t value)
 {
-	sys_snode_t *tmp;
-	sys_snode_t *tmp_safe;
-	size_t cnt = 0;
+	__ASSERT_NO_MSG(!eventq_is_full(eventq));
 
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, tmp, tmp_safe) {
-		sys_slist_remove(&eventq->root, NULL, tmp);
+	eventq->len++;
 
-		k_free(CONTAINER_OF(tmp, struct item_event, node));
-		cnt++;
+	struct item_event *hid_event = eventq_peek(eventq, eventq->len - 1);
 
-		if (tmp == last_to_purge) {
-			break;
-		}
+	hid_event->item.usage_id = usage_id;
+	hid_event->item.value = value;
+	hid_event->timestamp = k_uptime_get_32();
+
+	if (eventq->len > eventq->stats.len_max) {
+		eventq->stats.len_max = eventq->len;
 	}
+}
 
-	eventq->len -= cnt;
+static void eventq_region_purge(struct eventq *eventq, size_t cnt)
+{
+	eventq_drop(eventq, cnt);
+	eventq->stats.expired_cnt += cnt;
 
 	LOG_WRN("%u stale events removed from the queue!", cnt);
 }
@@ -295,13 +319,22 @@ static void eventq_region_purge(struct eventq *eventq,
 
 static void eventq_cleanup(struct eventq *eventq, u32_t timestamp)
 {
+	/* Events are stored in order of arrival. If the oldest event did not
+	 * expire, there is nothing to clean up.
+	 */
+	if (eventq_is_empty(eventq) ||
+	    ((timestamp - eventq_peek(eventq, 0)->timestamp) <
+	     CONFIG_DESKTOP_HID_REPORT_EXPIRATION)) {
+		return;
+	}
+
 	/* Find timed out events. */
 
-	sys_snode_t *first_valid;
+	size_t first_valid;
 
-	SYS_SLIST_FOR_EACH_NODE(&eventq->root, first_valid) {
-		u32_t diff = timestamp - CONTAINER_OF(
-			first_valid, struct item_event, node)->timestamp;
+	for (first_valid = 0; first_valid < eventq->len; first_valid++) {
+		u32_t diff = timestamp -
+			eventq_peek(eventq, first_valid)->timestamp;
 
 		if (diff < CONFIG_DESKTOP_HID_REPORT_EXPIRATION) {
 			break;
@@ -309,20 +342,16 @@ static void eventq_cleanup(struct eventq *eventq, u32_t timestamp)
 	}
 
 	/* Remove events but only if key up was generated for each removed
-	 * key down.
+	 * key down. Positions are counted from the queue head as it was
+	 * before the first purge.
 	 */
 
-	sys_snode_t *maxfound = sys_slist_peek_head(&eventq->root);
 	size_t maxfound_pos = 0;
+	size_t purged = 0;
 
-	sys_snode_t *cur;
-	size_t cur_pos = 0;
-
-	sys_snode_t *tmp_safe;
-
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, cur, tmp_safe) {
-		const struct item cur_item =
-			CONTAINER_OF(cur, struct item_event, node)->item;
+	for (size_t cur_pos = 0; cur_pos < first_valid; cur_pos++) {
+		const struct hid_item cur_item =
+			eventq_peek(eventq, cur_pos - purged)->item;
 
 		if (cur_item.value > 0) {
 			/* Every key down must be paired with key up.
@@ -331,19 +360,11 @@ static void eventq_cleanup(struct eventq *eventq, u32_t timestamp)
 			 */
 
 			unsigned int hit_count = cur_item.value;
-			sys_snode_t *j = cur;
-			size_t j_pos = cur_pos;
-
-			SYS_SLIST_ITERATE_FROM_NODE(&eventq->root, j) {
-				j_pos++;
-				if (j == first_valid) {
-					break;
-				}
+			size_t j_pos;
 
-				const struct item item =
-					CONTAINER_OF(j,
-						     struct item_event,
-						     node)->item;
+			for (j_pos = cur_pos + 1; j_pos < first_valid; j_pos++) {
+				const struct hid_item item =
+					eventq_peek(eventq, j_pos - purged)->item;
 
 				if (cur_item.usage_id == item.usage_id) {
 					hit_count += item.value;
@@ -357,48 +378,22 @@ static void eventq_cleanup(struct eventq *eventq, u32_t timestamp)
 				}
 			}
 
-			if (j == first_valid) {
+			if (j_pos == first_valid) {
 				/* Pair not found. */
 				break;
 			}
 
 			if (j_pos > maxfound_pos) {
-				maxfound = j;
 				maxfound_pos = j_pos;
 			}
 		}
 
-
-		if (cur == first_valid) {
-			break;
-		}
-
-		if (cur == maxfound) {
+		if (cur_pos == maxfound_pos) {
 			/* All events up to this point have pairs and can
 			 * be deleted.
 			 */
-			eventq_region_purge(eventq, maxfound);
-		}
-
-		cur_pos++;
-	}
-}
-
-static void sort_by_usage_id(struct item items[], size_t array_size)
-{
-	for (size_t k = 0; k < array_size; k++) {
-		size_t id = k;
-
-		for (size_t l = k + 1; l < array_size; l++) {
-			if (items[l].usage_id < items[id].usage_id) {
-				id = l;
-			}
-		}
-		if (id != k) {
-			struct item tmp = items[k];
-
-			items[k] = items[id];
-			items[id] = tmp;
+			eventq_region_purge(eventq, maxfound_pos + 1 - purged);
+			purged = maxfound_pos + 1;
 		}
 	}
 }
@@ -439,13 +434,19 @@ static struct report_state *get_report_state(struct subscriber *subscriber,
 	return NULL;
 }
 
-static struct report_data *get_report_data(u8_t report_id)
+static struct report_data *get_report_data(struct pipeline *pl,
+					   u8_t report_id)
 {
 	size_t pos = report_data_index[report_id];
 
-	__ASSERT_NO_MSG(pos < ARRAY_SIZE(state.report_data));
+	__ASSERT_NO_MSG(pos < ARRAY_SIZE(pl->report_data));
 
-	return &state.report_data[pos];
+	return &pl->report_data[pos];
+}
+
+static struct pipeline *get_pipeline(bool is_usb)
+{
+	return &state.pipeline[(is_usb) ? (PIPELINE_USB) : (PIPELINE_BLE)];
 }
 
 static struct subscriber *get_subscriber(const void *subscriber_id)
@@ -459,6 +460,25 @@ static struct subscriber *get_subscriber(const void *subscriber_id)
 	return NULL;
 }
 
+static struct subscriber *select_subscriber(const struct pipeline *pl)
+{
+	/* USB has priority. */
+	for (size_t i = 0; i < ARRAY_SIZE(state.subscriber); i++) {
+		if (state.subscriber[i].id && state.subscriber[i].is_usb &&
+		    (state.subscriber[i].pipeline == pl)) {
+			return &state.subscriber[i];
+		}
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(state.subscriber); i++) {
+		if (state.subscriber[i].id && !state.subscriber[i].is_usb &&
+		    (state.subscriber[i].pipeline == pl)) {
+			return &state.subscriber[i];
+		}
+	}
+
+	return NULL;
+}
+
 static struct subscriber *get_subscriber_by_type(bool is_usb)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(state.subscriber); i++) {
@@ -473,28 +493,31 @@ static struct subscriber *get_subscriber_by_type(bool is_usb)
 
 static void connect_subscriber(const void *subscriber_id, bool is_usb)
 {
+	struct pipeline *pl = get_pipeline(is_usb);
+
 	for (size_t i = 0; i < ARRAY_SIZE(state.subscriber); i++) {
 		if (!state.subscriber[i].id) {
 			state.subscriber[i].id = subscriber_id;
 			state.subscriber[i].is_usb = is_usb;
+			state.subscriber[i].pipeline = pl;
 			LOG_INF("Subscriber %p connected", subscriber_id);
 
-			if (state.selected && is_usb) {
+			if (pl->selected && is_usb) {
 				/* If USB is connected force disconnect report
 				 * data from the connected report states. */
-				for (size_t j = 0; j < ARRAY_SIZE(state.report_data); j++) {
-					struct report_data *rd = &state.report_data[j];
+				for (size_t j = 0; j < ARRAY_SIZE(pl->report_data); j++) {
+					struct report_data *rd = &pl->report_data[j];
 
 					rd->linked_rs = NULL;
 					clear_report_data(rd);
 				}
-				state.selected = NULL;
+				pl->selected = NULL;
 			}
 
-			if (!state.selected) {
-				state.selected = &state.subscriber[i];
+			if (!pl->selected) {
+				pl->selected = &state.subscriber[i];
 				LOG_INF("Active subscriber %p",
-					state.selected->id);
+					pl->selected->id);
 			}
 			return;
 		}
@@ -518,7 +541,9 @@ static void disconnect_subscriber(const void *subscriber_id)
 		return;
 	}
 
-	if (s == state.selected) {
+	struct pipeline *pl = s->pipeline;
+
+	if (s == pl->selected) {
 		for (size_t i = 0; i < ARRAY_SIZE(s->state); i++) {
 			struct report_state *rs = &s->state[i];
 
@@ -541,22 +566,19 @@ static void disconnect_subscriber(const void *subscriber_id)
 
 	LOG_INF("Subscriber %p disconnected", subscriber_id);
 
-	if (s == state.selected) {
+	if (s == pl->selected) {
 
 		/* Select subscriber - USB has priority. */
-		state.selected = get_subscriber_by_type(true);
-		if (!state.selected) {
-			state.selected = get_subscriber_by_type(false);
-		}
+		pl->selected = select_subscriber(pl);
 
-		if (!state.selected) {
+		if (!pl->selected) {
 			LOG_INF("No active subscriber");
 		} else {
-			LOG_INF("Active subscriber %p", state.selected->id);
+			LOG_INF("Active subscriber %p", pl->selected->id);
 
 			/* Route report data to subscriber report states. */
-			for (size_t i = 0; i < ARRAY_SIZE(state.selected->state); i++) {
-				struct report_state *rs = &state.selected->state[i];
+			for (size_t i = 0; i < ARRAY_SIZE(pl->selected->state); i++) {
+				struct report_state *rs = &pl->selected->state[i];
 
 				if (rs->linked_rd) {
 					LOG_INF("Report data %p routed to report state %p",
@@ -573,10 +595,7 @@ static void disconnect_subscriber(const void *subscriber_id)
 
 static bool key_value_set(struct items *items, u16_t usage_id, s16_t value)
 {
-	const u8_t prev_item_count = items->item_count;
-
 	bool update_needed = false;
-	struct item *p_item;
 
 	__ASSERT_NO_MSG(usage_id != 0);
 	__ASSERT_NO_MSG(items->item_count_max > 0);
@@ -584,19 +603,19 @@ static bool key_value_set(struct items *items, u16_t usage_id, s16_t value)
 	/* Report equal to zero brings no change. This should never happen. */
 	__ASSERT_NO_MSG(value != 0);
 
-	p_item = bsearch(&usage_id,
-			 (u8_t *)items->item,
-			 ARRAY_SIZE(items->item),
-			 sizeof(items->item[0]),
-			 usage_id_compare);
+	int idx = hid_items_find(items->item, ARRAY_SIZE(items->item),
+				 items->item_count, usage_id);
 
-	if (p_item) {
+	if (idx >= 0) {
 		/* Item is present in the array - update its value. */
+		struct hid_item *p_item = &items->item[idx];
+
 		p_item->value += value;
 		if (p_item->value == 0) {
 			__ASSERT_NO_MSG(items->item_count != 0);
+			hid_items_remove(items->item, ARRAY_SIZE(items->item),
+					 items->item_count, idx);
 			items->item_count -= 1;
-			p_item->usage_id = 0;
 		}
 
 		update_needed = true;
@@ -606,35 +625,23 @@ static bool key_value_set(struct items *items, u16_t usage_id, s16_t value)
 		 * could happen if a key up event is lost and the state
 		 * receives an unpaired key down event.
 		 */
-	} else if (prev_item_count >= items->item_count_max) {
+	} else if (items->item_count >= items->item_count_max) {
 		/* Configuration should allow the HID module to hold data
 		 * about the maximum number of simultaneously pressed keys.
 		 * Generate a warning if an item cannot be recorded.
 		 */
 		LOG_WRN("No place on the list to store HID item!");
 	} else {
-		/* After sort operation, free slots (zeros) are stored
-		 * at the beginning of the array.
+		/* Record this value change. The set is kept sorted, free
+		 * slots (zeros) are stored at the beginning of the array.
 		 */
-		size_t const idx = ARRAY_SIZE(items->item) - prev_item_count - 1;
-
-		__ASSERT_NO_MSG(items->item[idx].usage_id == 0);
-
-		/* Record this value change. */
-		items->item[idx].usage_id = usage_id;
-		items->item[idx].value = value;
+		hid_items_insert(items->item, ARRAY_SIZE(items->item),
+				 items->item_count, usage_id, value);
 		items->item_count += 1;
 
 		update_needed = true;
 	}
 
-	if (prev_item_count != items->item_count) {
-		/* Sort elements on the list. Use simple algorithm
-		 * with small footprint.
-		 */
-		sort_by_usage_id(items->item, ARRAY_SIZE(items->item));
-	}
-
 	return update_needed;
 }
 
@@ -662,7 +669,7 @@ static void send_report_keyboard(u8_t report_id, struct report_data *rd)
 
 	struct hid_report_event *event = new_hid_report_event(sizeof(report_id) + REPORT_SIZE_KEYBOARD_KEYS);
 
-	event->subscriber = state.selected->id;
+	event->subscriber = rd->linked_rs->subscriber->id;
 
 	event->dyndata.data[0] = report_id;
 	event->dyndata.data[2] = 0; /* Reserved byte */
@@ -673,7 +680,7 @@ static void send_report_keyboard(u8_t report_id, struct report_data *rd)
 	const size_t max = ARRAY_SIZE(rd->items.item);
 	size_t cnt = 0;
 	for (size_t i = 0; (i < max) && (cnt < KEYBOARD_REPORT_KEY_COUNT_MAX); i++) {
-		struct item item = rd->items.item[max - i - 1];
+		struct hid_item item = rd->items.item[max - i - 1];
 
 		if (item.usage_id) {
 			__ASSERT_NO_MSG(item.value > 0);
@@ -732,7 +739,7 @@ static void send_report_mouse(u8_t report_id, struct report_data *rd)
 	/* Traverse pressed keys and build mouse buttons bitmask */
 	u8_t button_bm = 0;
 	for (size_t i = 0; i < ARRAY_SIZE(rd->items.item); i++) {
-		struct item item = rd->items.item[i];
+		struct hid_item item = rd->items.item[i];
 
 		if (item.usage_id) {
 			__ASSERT_NO_MSG(item.usage_id <= 8);
@@ -750,7 +757,7 @@ static void send_report_mouse(u8_t report_id, struct report_data *rd)
 
 	struct hid_report_event *event = new_hid_report_event(sizeof(report_id) + REPORT_SIZE_MOUSE);
 
-	event->subscriber = state.selected->id;
+	event->subscriber = rd->linked_rs->subscriber->id;
 
 	/* Convert to little-endian. */
 	u8_t x_buff[sizeof(dx)];
@@ -800,7 +807,7 @@ static void send_report_boot_mouse(u8_t report_id, struct report_data *rd)
 	/* Traverse pressed keys and build mouse buttons bitmask */
 	u8_t button_bm = 0;
 	for (size_t i = 0; i < ARRAY_SIZE(rd->items.item); i++) {
-		struct item item = rd->items.item[i];
+		struct hid_item item = rd->items.item[i];
 
 		if (item.usage_id) {
 			__ASSERT_NO_MSG(item.usage_id <= 8);
@@ -817,7 +824,7 @@ static void send_report_boot_mouse(u8_t report_id, struct report_data *rd)
 			     sizeof(button_bm);
 	struct hid_report_event *event = new_hid_report_event(report_size);
 
-	event->subscriber = state.selected->id;
+	event->subscriber = rd->linked_rs->subscriber->id;
 
 	event->dyndata.data[0] = report_id;
 	event->dyndata.data[1] = button_bm;
@@ -853,7 +860,7 @@ static void send_report_ctrl(u8_t report_id, struct report_data *rd)
 
 	struct hid_report_event *event = new_hid_report_event(report_size);
 
-	event->subscriber = state.selected->id;
+	event->subscriber = rd->linked_rs->subscriber->id;
 
 	/* Only one item can fit in the consumer control report. */
 	__ASSERT_NO_MSG(report_size == sizeof(report_id) +
@@ -874,21 +881,16 @@ static bool update_report(struct report_data *rd)
 {
 	bool update_needed = false;
 
-	while (!update_needed && !eventq_is_empty(&rd->eventq)) {
-		/* There are enqueued events to handle. */
-		struct item_event *event = eventq_get(&rd->eventq);
-
-		__ASSERT_NO_MSG(event);
+	struct item_event event;
 
+	while (!update_needed && eventq_get(&rd->eventq, &event)) {
+		/* There are enqueued events to handle. */
 		update_needed = key_value_set(&rd->items,
-					      event->item.usage_id,
-					      event->item.value);
+					      event.item.usage_id,
+					      event.item.value);
 
 		rd->update_needed = rd->update_needed || update_needed;
 
-
-		k_free(event);
-
 		/* If no item was changed, try next event. */
 	}
 
@@ -907,8 +909,8 @@ static void report_send(struct report_data *rd, bool check_state, bool send_alwa
 	}
 
 	struct report_state *rs = rd->linked_rs;
-	__ASSERT_NO_MSG(rs->subscriber == state.selected);
-	__ASSERT_NO_MSG(state.selected);
+	__ASSERT_NO_MSG(rs->subscriber);
+	__ASSERT_NO_MSG(rs->subscriber == rs->subscriber->pipeline->selected);
 
 	if (!check_state || (rs->state != STATE_DISCONNECTED)) {
 		unsigned int pipeline_depth;
@@ -988,7 +990,7 @@ static void report_issued(const void *subscriber_id, u8_t report_id, bool error)
 	rs->cnt--;
 
 	if (rs->linked_rd->linked_rs != rs) {
-		__ASSERT_NO_MSG(state.selected != subscriber);
+		__ASSERT_NO_MSG(subscriber->pipeline->selected != subscriber);
 
 		LOG_INF("Subscriber %p not active", subscriber_id);
 		if (rs->cnt == 0) {
@@ -996,7 +998,7 @@ static void report_issued(const void *subscriber_id, u8_t report_id, bool error)
 		}
 		return;
 	}
-	__ASSERT_NO_MSG(state.selected == subscriber);
+	__ASSERT_NO_MSG(subscriber->pipeline->selected == subscriber);
 
 	if (error) {
 		/* To maintain the sanity of HID state, clear
@@ -1048,11 +1050,12 @@ static void connect(const void *subscriber_id, u8_t report_id)
 		break;
 	}
 
-	struct report_data *rd = get_report_data(report_data_id);
+	struct report_data *rd = get_report_data(subscriber->pipeline,
+						 report_data_id);
 
 	rs->linked_rd = rd;
 
-	if (state.selected == subscriber) {
+	if (subscriber->pipeline->selected == subscriber) {
 		/* Route report data to report state. */
 		if (rd->linked_rs) {
 			LOG_WRN("Force report data unlink");
@@ -1108,16 +1111,12 @@ static void enqueue(struct report_data *rd, u16_t usage_id, s16_t value,
 			 * Try to remove queued items starting from the
 			 * oldest one.
 			 */
-			sys_snode_t *i;
-
-			SYS_SLIST_FOR_EACH_NODE(&rd->eventq.root, i) {
+			for (size_t i = 0; i < rd->eventq.len; i++) {
 				/* Initial cleanup was done above. Queue will
 				 * not contain events with expired timestamp.
 				 */
 				u32_t timestamp =
-					CONTAINER_OF(i,
-						     struct item_event,
-						     node)->timestamp +
+					eventq_peek(&rd->eventq, i)->timestamp +
 					CONFIG_DESKTOP_HID_REPORT_EXPIRATION;
 
 				eventq_cleanup(&rd->eventq, timestamp);
@@ -1125,7 +1124,7 @@ static void enqueue(struct report_data *rd, u16_t usage_id, s16_t value,
 				if (!eventq_is_full(&rd->eventq)) {
 					/* At least one element was removed
 					 * from the queue. Do not continue
-					 * list traverse, content was modified!
+					 * queue traverse, content was modified!
 					 */
 					break;
 				}
@@ -1137,6 +1136,8 @@ static void enqueue(struct report_data *rd, u16_t usage_id, s16_t value,
 			 * all recorded events and items.
 			 */
 			LOG_WRN("Queue is full, all events are dropped!");
+			rd->eventq.stats.overflow_cnt++;
+			rd->eventq.stats.dropped_cnt += rd->eventq.len;
 			clear_report_data(rd);
 		}
 	}
@@ -1145,16 +1146,17 @@ static void enqueue(struct report_data *rd, u16_t usage_id, s16_t value,
 }
 
 /**@brief Function for updating the value linked to the HID usage. */
-static void update_key(const struct hid_keymap *map, s16_t value)
+static void update_key(struct pipeline *pl, const struct hid_keymap *map,
+		       s16_t value)
 {
 	u8_t report_id = map->report_id;
 
-	struct report_data *rd = get_report_data(report_id);
+	struct report_data *rd = get_report_data(pl, report_id);
 
 	bool connected = false;
 
-	if (state.selected) {
-		struct report_state *rs = get_report_state(state.selected, report_id);
+	if (pl->selected) {
+		struct report_state *rs = get_report_state(pl->selected, report_id);
 
 		connected = (rs->state != STATE_DISCONNECTED);
 	}
@@ -1171,14 +1173,14 @@ static void update_key(const struct hid_keymap *map, s16_t value)
 	}
 }
 
-static void init(void)
+static int init(void)
 {
+	/* Duplicated key IDs are reported while building the index. Only
+	 * the first entry of a duplicated key ID is used.
+	 */
+	int err = keymap_index_init();
+
 	if (IS_ENABLED(CONFIG_ASSERT)) {
-		/* Validate the order of key IDs on the key map array. */
-		for (size_t i = 1; i < ARRAY_SIZE(hid_keymap); i++) {
-			__ASSERT(hid_keymap[i - 1].key_id < hid_keymap[i].key_id,
-				 "The hid_keymap array must be sorted by key_id!");
-		}
 		/* Validate if report IDs are correct. */
 		for (size_t i = 0; i < ARRAY_SIZE(hid_keymap); i++) {
 			__ASSERT((hid_keymap[i].report_id != REPORT_ID_RESERVED) &&
@@ -1202,8 +1204,12 @@ static void init(void)
 		report_data_index[REPORT_ID_MOUSE] = data_id;
 		report_state_index[REPORT_ID_MOUSE] = state_id;
 
-		state.report_data[data_id].items.item_count_max = MOUSE_REPORT_BUTTON_COUNT_MAX;
-		state.report_data[data_id].axes.axis_count = MOUSE_REPORT_AXIS_COUNT;
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			struct report_data *rd = &state.pipeline[i].report_data[data_id];
+
+			rd->items.item_count_max = MOUSE_REPORT_BUTTON_COUNT_MAX;
+			rd->axes.axis_count = MOUSE_REPORT_AXIS_COUNT;
+		}
 
 		data_id++;
 		state_id++;
@@ -1212,7 +1218,10 @@ static void init(void)
 		report_data_index[REPORT_ID_KEYBOARD_KEYS] = data_id;
 		report_state_index[REPORT_ID_KEYBOARD_KEYS] = state_id;
 
-		state.report_data[data_id].items.item_count_max = KEYBOARD_REPORT_KEY_COUNT_MAX;
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			state.pipeline[i].report_data[data_id].items.item_count_max =
+				KEYBOARD_REPORT_KEY_COUNT_MAX;
+		}
 
 		data_id++;
 		state_id++;
@@ -1221,7 +1230,10 @@ static void init(void)
 		report_data_index[REPORT_ID_SYSTEM_CTRL] = data_id;
 		report_state_index[REPORT_ID_SYSTEM_CTRL] = state_id;
 
-		state.report_data[data_id].items.item_count_max = SYSTEM_CTRL_REPORT_KEY_COUNT_MAX;
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			state.pipeline[i].report_data[data_id].items.item_count_max =
+				SYSTEM_CTRL_REPORT_KEY_COUNT_MAX;
+		}
 
 		data_id++;
 		state_id++;
@@ -1230,7 +1242,10 @@ static void init(void)
 		report_data_index[REPORT_ID_CONSUMER_CTRL] = data_id;
 		report_state_index[REPORT_ID_CONSUMER_CTRL] = state_id;
 
-		state.report_data[data_id].items.item_count_max = CONSUMER_CTRL_REPORT_KEY_COUNT_MAX;
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			state.pipeline[i].report_data[data_id].items.item_count_max =
+				CONSUMER_CTRL_REPORT_KEY_COUNT_MAX;
+		}
 
 		data_id++;
 		state_id++;
@@ -1248,6 +1263,8 @@ static void init(void)
 
 	__ASSERT_NO_MSG(data_id == INPUT_REPORT_DATA_COUNT);
 	__ASSERT_NO_MSG(state_id == INPUT_REPORT_STATE_COUNT);
+
+	return err;
 }
 
 static bool handle_motion_event(const struct motion_event *event)
@@ -1256,12 +1273,15 @@ static bool handle_motion_event(const struct motion_event *event)
 		return false;
 	}
 
-	struct report_data *rd = get_report_data(REPORT_ID_MOUSE);
+	for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+		struct report_data *rd = get_report_data(&state.pipeline[i],
+							 REPORT_ID_MOUSE);
 
-	rd->axes.axis[MOUSE_REPORT_AXIS_X] += event->dx;
-	rd->axes.axis[MOUSE_REPORT_AXIS_Y] += event->dy;
+		rd->axes.axis[MOUSE_REPORT_AXIS_X] += event->dx;
+		rd->axes.axis[MOUSE_REPORT_AXIS_Y] += event->dy;
 
-	report_send(rd, true, true);
+		report_send(rd, true, true);
+	}
 
 	return false;
 }
@@ -1272,11 +1292,14 @@ static bool handle_wheel_event(const struct wheel_event *event)
 		return false;
 	}
 
-	struct report_data *rd = get_report_data(REPORT_ID_MOUSE);
+	for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+		struct report_data *rd = get_report_data(&state.pipeline[i],
+							 REPORT_ID_MOUSE);
 
-	rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL] += event->wheel;
+		rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL] += event->wheel;
 
-	report_send(rd, true, true);
+		report_send(rd, true, true);
+	}
 
 	return false;
 }
@@ -1284,14 +1307,17 @@ static bool handle_wheel_event(const struct wheel_event *event)
 static bool handle_button_event(const struct button_event *event)
 {
 	/* Get usage ID and target report from HID Keymap */
-	struct hid_keymap *map = hid_keymap_get(event->key_id);
+	const struct hid_keymap *map = hid_keymap_get(event->key_id);
 
 	if (!map || !map->usage_id) {
 		LOG_WRN("No mapping, button ignored");
 	} else {
 		/* Keydown increases ref counter, keyup decreases it. */
 		s16_t value = (event->pressed != false) ? (1) : (-1);
-		update_key(map, value);
+
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			update_key(&state.pipeline[i], map, value);
+		}
 	}
 
 	return false;
@@ -1372,12 +1398,80 @@ static bool handle_module_state_event(const struct module_state_event *event)
 		initialized = true;
 
 		LOG_INF("Init HID state!");
-		init();
+		if (init()) {
+			module_set_state(MODULE_STATE_ERROR);
+		}
 	}
 
 	return false;
 }
 
+static void fetch_config(const u8_t opt_id, u8_t *data, size_t *size)
+{
+	switch (opt_id) {
+	case HID_STATE_OPT_EVENTQ_STATS:
+	{
+		struct eventq_stats total = {0};
+
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			const struct pipeline *pl = &state.pipeline[i];
+
+			for (size_t j = 0; j < ARRAY_SIZE(pl->report_data); j++) {
+				const struct eventq_stats *stats =
+					&pl->report_data[j].eventq.stats;
+
+				total.overflow_cnt += stats->overflow_cnt;
+				total.dropped_cnt += stats->dropped_cnt;
+				total.expired_cnt += stats->expired_cnt;
+				total.len_max = MAX(total.len_max,
+						    stats->len_max);
+			}
+		}
+
+		size_t pos = 0;
+
+		sys_put_le32(total.overflow_cnt, &data[pos]);
+		pos += sizeof(total.overflow_cnt);
+		sys_put_le32(total.dropped_cnt, &data[pos]);
+		pos += sizeof(total.dropped_cnt);
+		sys_put_le32(total.expired_cnt, &data[pos]);
+		pos += sizeof(total.expired_cnt);
+		data[pos] = total.len_max;
+		pos += sizeof(total.len_max);
+
+		__ASSERT_NO_MSG(pos <= CONFIG_CHANNEL_FETCHED_DATA_MAX_SIZE);
+		*size = pos;
+		break;
+	}
+	default:
+		LOG_WRN("Unknown config fetch option ID %" PRIu8, opt_id);
+		break;
+	}
+}
+
+static void update_config(const u8_t opt_id, const u8_t *data,
+			  const size_t size)
+{
+	switch (opt_id) {
+	case HID_STATE_OPT_EVENTQ_STATS:
+		/* Any write resets the statistics. */
+		for (size_t i = 0; i < ARRAY_SIZE(state.pipeline); i++) {
+			struct pipeline *pl = &state.pipeline[i];
+
+			for (size_t j = 0; j < ARRAY_SIZE(pl->report_data); j++) {
+				struct eventq *eventq = &pl->report_data[j].eventq;
+
+				memset(&eventq->stats, 0, sizeof(eventq->stats));
+				eventq->stats.len_max = eventq->len;
+			}
+		}
+		break;
+	default:
+		LOG_WRN("Unknown config set option ID %" PRIu8, opt_id);
+		break;
+	}
+}
+
 static bool event_handler(const struct event_header *eh)
 {
 	if (!IS_ENABLED(CONFIG_DESKTOP_MOTION_NONE) &&
@@ -1418,6 +1512,9 @@ static bool event_handler(const struct event_header *eh)
 		return handle_module_state_event(cast_module_state_event(eh));
 	}
 
+	GEN_CONFIG_EVENT_HANDLERS(STRINGIFY(MODULE), opt_descr, update_config,
+				  fetch_config, false);
+
 	/* If event is unhandled, unsubscribe. */
 	__ASSERT_NO_MSG(false);
 
@@ -1433,3 +1530,5 @@ EVENT_SUBSCRIBE(MODULE, module_state_event);
 EVENT_SUBSCRIBE_FINAL(MODULE, button_event);
 EVENT_SUBSCRIBE(MODULE, motion_event);
 EVENT_SUBSCRIBE(MODULE, wheel_event);
+EVENT_SUBSCRIBE(MODULE, config_event);
+EVENT_SUBSCRIBE(MODULE, config_fetch_request_event);
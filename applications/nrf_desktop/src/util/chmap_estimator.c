@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <sys/util.h>
+#include <sys/__assert.h>
+
+#include "chmap_estimator.h"
+
+
+static bool chn_bit_get(const u8_t *mask, u8_t chn_idx)
+{
+	return (mask[chn_idx / 8] & BIT(chn_idx % 8)) != 0;
+}
+
+static void chn_bit_set(u8_t *mask, u8_t chn_idx)
+{
+	mask[chn_idx / 8] |= BIT(chn_idx % 8);
+}
+
+static void err_rate_update(struct chmap_estimator *est, u8_t chn_idx)
+{
+	struct chmap_estimator_chn *chn = &est->chn[chn_idx];
+	u32_t samples = chn->crc_ok + chn->crc_error;
+
+	if (!chn_bit_get(est->chmap, chn_idx)) {
+		/* Channel is not used, the collected samples are outdated.
+		 * Let the error rate decay, so that the channel is evaluated
+		 * again after some time.
+		 */
+		chn->err_rate -= chn->err_rate >> est->params.decay_shift;
+		chn->crc_ok = 0;
+		chn->crc_error = 0;
+		return;
+	}
+
+	if ((samples == 0) || (samples < est->params.chn_sample_count_min)) {
+		/* Keep collecting samples. */
+		return;
+	}
+
+	s32_t sample_rate = ((u32_t)chn->crc_error *
+			     CHMAP_ESTIMATOR_ERR_RATE_MAX) / samples;
+	s32_t diff = sample_rate - chn->err_rate;
+
+	chn->err_rate += diff / (1 << est->params.ewma_shift);
+	chn->crc_ok = 0;
+	chn->crc_error = 0;
+}
+
+static size_t chmap_count(const u8_t *chmap)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+		if (chn_bit_get(chmap, i)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static bool chn_is_better(const struct chmap_estimator *est, u8_t chn_idx,
+			  u8_t ref_idx)
+{
+	bool blacklisted = chn_bit_get(est->blacklist, chn_idx);
+	bool ref_blacklisted = chn_bit_get(est->blacklist, ref_idx);
+
+	if (blacklisted != ref_blacklisted) {
+		return !blacklisted;
+	}
+
+	return est->chn[chn_idx].err_rate < est->chn[ref_idx].err_rate;
+}
+
+static bool chmap_update(struct chmap_estimator *est)
+{
+	u8_t chmap[CHMAP_ESTIMATOR_BITMASK_SIZE] = {0};
+
+	for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+		if (chn_bit_get(est->blacklist, i)) {
+			continue;
+		}
+
+		/* Use hysteresis to avoid toggling channels that are close
+		 * to the threshold.
+		 */
+		u16_t threshold = chn_bit_get(est->chmap, i) ?
+				  est->params.block_threshold :
+				  est->params.unblock_threshold;
+
+		if (est->chn[i].err_rate <= threshold) {
+			chn_bit_set(chmap, i);
+		}
+	}
+
+	/* Bring back the best channels to keep the minimal channel count. */
+	for (size_t count = chmap_count(chmap);
+	     count < est->params.min_channel_count;
+	     count++) {
+		int best = -1;
+
+		for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+			if (chn_bit_get(chmap, i)) {
+				continue;
+			}
+
+			if ((best < 0) || chn_is_better(est, i, best)) {
+				best = i;
+			}
+		}
+
+		__ASSERT_NO_MSG(best >= 0);
+		chn_bit_set(chmap, best);
+	}
+
+	if (!memcmp(chmap, est->chmap, sizeof(chmap))) {
+		return false;
+	}
+
+	memcpy(est->chmap, chmap, sizeof(chmap));
+
+	return true;
+}
+
+void chmap_estimator_init(struct chmap_estimator *est,
+			  const struct chmap_estimator_params *params)
+{
+	__ASSERT_NO_MSG(params->unblock_threshold <= params->block_threshold);
+	__ASSERT_NO_MSG((params->min_channel_count >= 2) &&
+			(params->min_channel_count <=
+			 CHMAP_ESTIMATOR_CHANNEL_COUNT));
+	__ASSERT_NO_MSG(params->decay_shift > 0);
+
+	memset(est, 0, sizeof(*est));
+	est->params = *params;
+
+	for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+		chn_bit_set(est->chmap, i);
+	}
+}
+
+bool chmap_estimator_crc_update(struct chmap_estimator *est, u8_t chn_idx,
+				u16_t crc_ok, u16_t crc_error)
+{
+	if (chn_idx >= CHMAP_ESTIMATOR_CHANNEL_COUNT) {
+		return false;
+	}
+
+	struct chmap_estimator_chn *chn = &est->chn[chn_idx];
+
+	/* Scale down the counters on overflow to keep the error ratio. */
+	while ((crc_ok > UINT16_MAX - chn->crc_ok) ||
+	       (crc_error > UINT16_MAX - chn->crc_error)) {
+		chn->crc_ok /= 2;
+		chn->crc_error /= 2;
+		crc_ok /= 2;
+		crc_error /= 2;
+	}
+
+	chn->crc_ok += crc_ok;
+	chn->crc_error += crc_error;
+	est->pending_samples += crc_ok + crc_error;
+
+	return est->pending_samples >= est->params.eval_sample_count;
+}
+
+bool chmap_estimator_process(struct chmap_estimator *est)
+{
+	for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+		err_rate_update(est, i);
+	}
+
+	est->pending_samples = 0;
+
+	return chmap_update(est);
+}
+
+bool chmap_estimator_blacklist_set(struct chmap_estimator *est,
+				   const u8_t *blacklist)
+{
+	memcpy(est->blacklist, blacklist, sizeof(est->blacklist));
+
+	return chmap_update(est);
+}
+
+const u8_t *chmap_estimator_map_get(const struct chmap_estimator *est)
+{
+	return est->chmap;
+}
+
+bool chmap_estimator_chn_used(const struct chmap_estimator *est,
+			      u8_t chn_idx)
+{
+	__ASSERT_NO_MSG(chn_idx < CHMAP_ESTIMATOR_CHANNEL_COUNT);
+
+	return chn_bit_get(est->chmap, chn_idx);
+}
+
+u16_t chmap_estimator_err_rate_get(const struct chmap_estimator *est,
+				   u8_t chn_idx)
+{
+	__ASSERT_NO_MSG(chn_idx < CHMAP_ESTIMATOR_CHANNEL_COUNT);
+
+	return est->chn[chn_idx].err_rate;
+}
+
+void chmap_estimator_history_get(const struct chmap_estimator *est,
+				 struct chmap_estimator_history *history)
+{
+	for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+		history->err_rate[i] = est->chn[i].err_rate;
+	}
+
+	memcpy(history->chmap, est->chmap, sizeof(history->chmap));
+}
+
+void chmap_estimator_history_set(struct chmap_estimator *est,
+				 const struct chmap_estimator_history *history)
+{
+	for (size_t i = 0; i < CHMAP_ESTIMATOR_CHANNEL_COUNT; i++) {
+		est->chn[i].err_rate = history->err_rate[i];
+		est->chn[i].crc_ok = 0;
+		est->chn[i].crc_error = 0;
+	}
+
+	memcpy(est->chmap, history->chmap, sizeof(est->chmap));
+	est->pending_samples = 0;
+
+	/* Stored map could be created with a different blacklist. */
+	chmap_update(est);
+}
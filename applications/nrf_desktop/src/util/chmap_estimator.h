@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _CHMAP_ESTIMATOR_H_
+#define _CHMAP_ESTIMATOR_H_
+
+/**
+ * @file
+ * @defgroup chmap_estimator Channel quality estimator
+ * @{
+ * @brief Bluetooth LE channel quality estimator used by the QoS module.
+ *
+ * The estimator tracks an exponentially weighted moving average (EWMA) of
+ * the CRC error rate of every Bluetooth LE data channel. Channels with
+ * the error rate above the block threshold are removed from the suggested
+ * channel map. The error rate of a removed channel slowly decays, so the
+ * channel is evaluated again after some time.
+ *
+ * The estimator is not thread-safe. The user must make sure that
+ * @ref chmap_estimator_crc_update is not called while other functions are
+ * running.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <zephyr/types.h>
+#include <toolchain.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of Bluetooth LE data channels. */
+#define CHMAP_ESTIMATOR_CHANNEL_COUNT	37
+
+/** Size of the Bluetooth LE channel map bitmask. */
+#define CHMAP_ESTIMATOR_BITMASK_SIZE	5
+
+/** Error rate that represents all packets received with CRC error. */
+#define CHMAP_ESTIMATOR_ERR_RATE_MAX	UINT16_MAX
+
+/** @brief Estimator parameters. */
+struct chmap_estimator_params {
+	/** Number of samples that triggers processing. */
+	u16_t eval_sample_count;
+
+	/** Minimal number of samples used to update a channel. */
+	u16_t chn_sample_count_min;
+
+	/** EWMA smoothing factor, equal to 1 / 2^ewma_shift. */
+	u8_t ewma_shift;
+
+	/** Error rate decay of unused channels, equal to 1 / 2^decay_shift
+	 *  per processing.
+	 */
+	u8_t decay_shift;
+
+	/** Error rate above which a used channel is blocked. */
+	u16_t block_threshold;
+
+	/** Error rate below which a blocked channel is used again. */
+	u16_t unblock_threshold;
+
+	/** Minimal number of channels in the channel map. */
+	u8_t min_channel_count;
+};
+
+/** @brief Channel state. */
+struct chmap_estimator_chn {
+	u16_t crc_ok; /**< CRC OK count since the last update. */
+	u16_t crc_error; /**< CRC error count since the last update. */
+	u16_t err_rate; /**< Smoothed CRC error rate. */
+};
+
+/** @brief Estimator instance. */
+struct chmap_estimator {
+	struct chmap_estimator_params params;
+	struct chmap_estimator_chn chn[CHMAP_ESTIMATOR_CHANNEL_COUNT];
+	u8_t chmap[CHMAP_ESTIMATOR_BITMASK_SIZE];
+	u8_t blacklist[CHMAP_ESTIMATOR_BITMASK_SIZE];
+	u32_t pending_samples;
+};
+
+/** @brief Learned channel quality that can be stored and restored. */
+struct chmap_estimator_history {
+	u16_t err_rate[CHMAP_ESTIMATOR_CHANNEL_COUNT];
+	u8_t chmap[CHMAP_ESTIMATOR_BITMASK_SIZE];
+} __packed;
+
+/** @brief Initialize the estimator.
+ *
+ * All channels are initially used and have zero error rate.
+ *
+ * @param[out] est	Estimator instance.
+ * @param[in] params	Estimator parameters.
+ */
+void chmap_estimator_init(struct chmap_estimator *est,
+			  const struct chmap_estimator_params *params);
+
+/** @brief Record CRC statistics of a connection event.
+ *
+ * @param[in,out] est	Estimator instance.
+ * @param[in] chn_idx	Bluetooth LE channel index (0-36).
+ * @param[in] crc_ok	Number of packets received with correct CRC.
+ * @param[in] crc_error	Number of packets received with CRC error.
+ *
+ * @return True if enough samples were collected to run processing.
+ */
+bool chmap_estimator_crc_update(struct chmap_estimator *est, u8_t chn_idx,
+				u16_t crc_ok, u16_t crc_error);
+
+/** @brief Update channel error rates and the suggested channel map.
+ *
+ * @param[in,out] est	Estimator instance.
+ *
+ * @return True if the suggested channel map has changed.
+ */
+bool chmap_estimator_process(struct chmap_estimator *est);
+
+/** @brief Exclude channels from the suggested channel map.
+ *
+ * The minimal channel count takes precedence over the blacklist.
+ *
+ * @param[in,out] est	Estimator instance.
+ * @param[in] blacklist	Bitmask of excluded Bluetooth LE channels.
+ *
+ * @return True if the suggested channel map has changed.
+ */
+bool chmap_estimator_blacklist_set(struct chmap_estimator *est,
+				   const u8_t *blacklist);
+
+/** @brief Get the suggested channel map.
+ *
+ * @param[in] est	Estimator instance.
+ *
+ * @return Pointer to the channel map bitmask.
+ */
+const u8_t *chmap_estimator_map_get(const struct chmap_estimator *est);
+
+/** @brief Check if a channel is used in the suggested channel map.
+ *
+ * @param[in] est	Estimator instance.
+ * @param[in] chn_idx	Bluetooth LE channel index (0-36).
+ *
+ * @return True if the channel is used.
+ */
+bool chmap_estimator_chn_used(const struct chmap_estimator *est,
+			      u8_t chn_idx);
+
+/** @brief Get the smoothed CRC error rate of a channel.
+ *
+ * @param[in] est	Estimator instance.
+ * @param[in] chn_idx	Bluetooth LE channel index (0-36).
+ *
+ * @return Error rate, where @ref CHMAP_ESTIMATOR_ERR_RATE_MAX means that
+ *	   all packets were received with CRC error.
+ */
+u16_t chmap_estimator_err_rate_get(const struct chmap_estimator *est,
+				   u8_t chn_idx);
+
+/** @brief Get the learned channel quality.
+ *
+ * @param[in] est	Estimator instance.
+ * @param[out] history	Learned channel quality.
+ */
+void chmap_estimator_history_get(const struct chmap_estimator *est,
+				 struct chmap_estimator_history *history);
+
+/** @brief Restore the learned channel quality.
+ *
+ * The suggested channel map is updated to match the restored error rates.
+ *
+ * @param[in,out] est	Estimator instance.
+ * @param[in] history	Learned channel quality.
+ */
+void chmap_estimator_history_set(struct chmap_estimator *est,
+				 const struct chmap_estimator_history *history);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _CHMAP_ESTIMATOR_H_ */
@@ -15,6 +15,14 @@
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_CONFIG_CHANNEL_LOG_LEVEL);
 
+/* Stream frame data starts with the sequence number. */
+#define STREAM_HEADER_SIZE	1
+
+/* Stream status returned on get: next expected sequence number and
+ * number of frames in flight.
+ */
+#define STREAM_STATUS_SIZE	2
+
 static int frame_size_check(const struct config_channel_frame *frame,
 			    const size_t length, bool usb)
 {
@@ -151,6 +159,82 @@ int config_channel_report_fill(u8_t *buffer, const size_t length,
 	return pos;
 }
 
+static void stream_status_get(struct config_channel_state *cfg_chan)
+{
+	struct stream *stream = &cfg_chan->stream;
+	atomic_val_t count = atomic_get(&stream->count);
+
+	BUILD_ASSERT(STREAM_STATUS_SIZE <= sizeof(cfg_chan->fetch.data), "");
+
+	cfg_chan->fetch.data[0] = stream->next_seq;
+	cfg_chan->fetch.data[1] = count;
+
+	cfg_chan->frame.event_data_len = STREAM_STATUS_SIZE;
+	cfg_chan->frame.event_data = cfg_chan->fetch.data;
+	cfg_chan->frame.status = (count > 0) ? (CONFIG_STATUS_PENDING) :
+					       (CONFIG_STATUS_SUCCESS);
+}
+
+static int stream_frame_handle(struct config_channel_state *cfg_chan,
+			       const u8_t *data, u16_t local_product_id)
+{
+	struct stream *stream = &cfg_chan->stream;
+	u8_t data_len = cfg_chan->frame.event_data_len;
+
+	if (cfg_chan->frame.recipient != local_product_id) {
+		LOG_WRN("Stream cannot be forwarded");
+		return -ENOTSUP;
+	}
+
+	if (data_len < STREAM_HEADER_SIZE) {
+		LOG_WRN("Missing stream sequence number");
+		return -EINVAL;
+	}
+
+	u8_t seq = data[0];
+	atomic_val_t count = atomic_get(&stream->count);
+
+	/* Sequence number zero restarts the stream once all frames
+	 * in flight are processed.
+	 */
+	if ((seq == 0) && (count == 0)) {
+		stream->next_seq = 0;
+	}
+
+	if (seq != stream->next_seq) {
+		LOG_WRN("Stream frame %" PRIu8 " dropped, expected %" PRIu8,
+			seq, stream->next_seq);
+		return -EINVAL;
+	}
+
+	if (count >= ARRAY_SIZE(stream->event)) {
+		LOG_DBG("Stream window full");
+		return -EBUSY;
+	}
+
+	data_len -= STREAM_HEADER_SIZE;
+
+	struct config_event *event = new_config_event(data_len);
+
+	memcpy(event->dyndata.data, &data[STREAM_HEADER_SIZE], data_len);
+	event->id = cfg_chan->frame.event_id;
+
+	/* Store the event before it can be confirmed as processed. */
+	stream->event[stream->head] = event;
+	stream->head = (stream->head + 1) % ARRAY_SIZE(stream->event);
+	atomic_inc(&stream->count);
+	stream->next_seq++;
+
+	cfg_chan->is_stream = true;
+	cfg_chan->is_fetch = false;
+	cfg_chan->disconnected = false;
+	atomic_set(&cfg_chan->status, CONFIG_STATUS_SUCCESS);
+
+	EVENT_SUBMIT(event);
+
+	return 0;
+}
+
 int config_channel_report_get(struct config_channel_state *cfg_chan,
 			      u8_t *buffer, size_t length, bool usb,
 			      u16_t local_product_id)
@@ -173,7 +257,10 @@ int config_channel_report_get(struct config_channel_state *cfg_chan,
 		return -EIO;
 	}
 
-	if (cfg_chan->is_fetch) {
+	if (IS_ENABLED(CONFIG_DESKTOP_CONFIG_CHANNEL_STREAM) &&
+	    cfg_chan->is_stream) {
+		stream_status_get(cfg_chan);
+	} else if (cfg_chan->is_fetch) {
 		__ASSERT_NO_MSG(cfg_chan->frame.event_data_len == 0);
 
 		if (cfg_chan->disconnected) {
@@ -239,26 +326,45 @@ int config_channel_report_set(struct config_channel_state *cfg_chan,
 		return -EBUSY;
 	}
 
+	/* Feature report set */
+	struct config_channel_frame frame;
+	int pos = config_channel_report_parse(buffer, length, &frame, usb);
+
 	if (cfg_chan->transaction_active) {
+		if ((pos >= 0) && (frame.status == CONFIG_STATUS_STREAM)) {
+			/* Leave the active transaction's state untouched. */
+			LOG_WRN("Stream frame during transaction");
+			return -EBUSY;
+		}
+
 		LOG_WRN("Transaction already in progress");
 
 		atomic_set(&cfg_chan->status, CONFIG_STATUS_REJECT);
 		return -EALREADY;
 	}
 
-	/* Feature report set */
-	int pos = config_channel_report_parse(buffer, length,
-					      &cfg_chan->frame, usb);
 	if (pos < 0) {
 		LOG_WRN("Could not parse report");
 		return pos;
 	}
 
+	cfg_chan->frame = frame;
+
 	if (usb && (cfg_chan->frame.report_id != REPORT_ID_USER_CONFIG)) {
 		LOG_WRN("Unsupported report ID %" PRIu8, cfg_chan->frame.report_id);
 		return -ENOTSUP;
 	}
 
+	if (cfg_chan->frame.status == CONFIG_STATUS_STREAM) {
+		if (!IS_ENABLED(CONFIG_DESKTOP_CONFIG_CHANNEL_STREAM)) {
+			LOG_WRN("Stream is not supported");
+			return -ENOTSUP;
+		}
+
+		return stream_frame_handle(cfg_chan, &buffer[pos],
+					   local_product_id);
+	}
+
 	/* Start transaction timeout. */
 	k_delayed_work_submit(&cfg_chan->timeout,
 			      K_SECONDS(CONFIG_DESKTOP_CONFIG_CHANNEL_TIMEOUT));
@@ -266,6 +372,7 @@ int config_channel_report_set(struct config_channel_state *cfg_chan,
 	cfg_chan->transaction_active = true;
 	cfg_chan->disconnected = false;
 	cfg_chan->is_fetch = (cfg_chan->frame.status == CONFIG_STATUS_FETCH);
+	cfg_chan->is_stream = false;
 
 	atomic_set(&cfg_chan->fetch.done, false);
 
@@ -367,6 +474,18 @@ void config_channel_forwarded_receive(struct config_channel_state *cfg_chan,
 void config_channel_event_done(struct config_channel_state *cfg_chan,
 			       const struct config_event *event)
 {
+	struct stream *stream = &cfg_chan->stream;
+
+	if (IS_ENABLED(CONFIG_DESKTOP_CONFIG_CHANNEL_STREAM) &&
+	    (atomic_get(&stream->count) > 0) &&
+	    (event == stream->event[stream->tail])) {
+		/* Events are processed in order of submission. */
+		stream->tail = (stream->tail + 1) % ARRAY_SIZE(stream->event);
+		atomic_dec(&stream->count);
+
+		return;
+	}
+
 	if (event == cfg_chan->pending_config_event) {
 		atomic_set(&cfg_chan->status, CONFIG_STATUS_SUCCESS);
 
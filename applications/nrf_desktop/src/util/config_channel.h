@@ -16,6 +16,12 @@
 
 #include "config_event.h"
 
+#ifdef CONFIG_DESKTOP_CONFIG_CHANNEL_STREAM
+#define CONFIG_CHANNEL_STREAM_WINDOW CONFIG_DESKTOP_CONFIG_CHANNEL_STREAM_WINDOW
+#else
+#define CONFIG_CHANNEL_STREAM_WINDOW 1
+#endif
+
 /** @brief Configuration channel data frame.
  */
 struct config_channel_frame {
@@ -49,6 +55,28 @@ struct fetch {
 	u16_t recipient;
 };
 
+/** @brief Configuration channel stream state.
+ *
+ * Stream frames are submitted as config events right away. Events are
+ * processed in order, so only the oldest one can be confirmed as done.
+ */
+struct stream {
+	/** Submitted config events that are not yet processed. */
+	const void *event[CONFIG_CHANNEL_STREAM_WINDOW];
+
+	/** Position of the next submitted event. */
+	u8_t head;
+
+	/** Position of the oldest event. */
+	u8_t tail;
+
+	/** Number of events in flight. */
+	atomic_t count;
+
+	/** Sequence number expected in the next stream frame. */
+	u8_t next_seq;
+};
+
 /** @brief Configuration channel instance.
  */
 struct config_channel_state {
@@ -64,6 +92,9 @@ struct config_channel_state {
 	/** @c true if the current transaction is a fetch request. */
 	bool is_fetch;
 
+	/** @c true if the last request was a stream frame. */
+	bool is_stream;
+
 	/** Work handling transaction timeout. */
 	struct k_delayed_work timeout;
 
@@ -75,6 +106,9 @@ struct config_channel_state {
 
 	/** Currently processed config event. */
 	void *pending_config_event;
+
+	/** State of the stream. */
+	struct stream stream;
 };
 
 /** @brief Initialize the configuration channel instance.
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/__assert.h>
+
+#include "hid_items.h"
+
+
+/**@brief Find position of the first recorded item with usage ID that is not
+ *	  lower than the given one.
+ */
+static size_t lower_bound(const struct hid_item *item, size_t size,
+			  size_t count, u16_t usage_id)
+{
+	size_t lower = size - count;
+	size_t upper = size;
+
+	while (lower < upper) {
+		size_t m = lower + (upper - lower) / 2;
+
+		if (item[m].usage_id < usage_id) {
+			lower = m + 1;
+		} else {
+			upper = m;
+		}
+	}
+
+	return lower;
+}
+
+int hid_items_find(const struct hid_item *item, size_t size, size_t count,
+		   u16_t usage_id)
+{
+	__ASSERT_NO_MSG(count <= size);
+
+	size_t pos = lower_bound(item, size, count, usage_id);
+
+	if ((pos < size) && (item[pos].usage_id == usage_id)) {
+		return pos;
+	}
+
+	return -ENOENT;
+}
+
+void hid_items_insert(struct hid_item *item, size_t size, size_t count,
+		      u16_t usage_id, s16_t value)
+{
+	__ASSERT_NO_MSG(count < size);
+	__ASSERT_NO_MSG(usage_id != 0);
+
+	size_t first = size - count;
+	size_t pos = lower_bound(item, size, count, usage_id);
+
+	__ASSERT_NO_MSG((pos == size) || (item[pos].usage_id != usage_id));
+	__ASSERT_NO_MSG(item[first - 1].usage_id == 0);
+
+	/* Move lower items one slot towards the free area. */
+	memmove(&item[first - 1], &item[first],
+		(pos - first) * sizeof(item[0]));
+
+	item[pos - 1].usage_id = usage_id;
+	item[pos - 1].value = value;
+}
+
+void hid_items_remove(struct hid_item *item, size_t size, size_t count,
+		      size_t idx)
+{
+	__ASSERT_NO_MSG((count > 0) && (count <= size));
+
+	size_t first = size - count;
+
+	__ASSERT_NO_MSG((idx >= first) && (idx < size));
+
+	/* Move lower items one slot towards the removed one. */
+	memmove(&item[first + 1], &item[first],
+		(idx - first) * sizeof(item[0]));
+
+	item[first].usage_id = 0;
+	item[first].value = 0;
+}
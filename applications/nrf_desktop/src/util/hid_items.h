@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _HID_ITEMS_H_
+#define _HID_ITEMS_H_
+
+/**
+ * @file
+ * @defgroup hid_items HID items set
+ * @{
+ * @brief Sorted set of HID items used by the HID state.
+ *
+ * Items are stored in an array sorted by the HID usage ID. Free slots
+ * (items with usage ID equal to zero) are kept at the beginning of the
+ * array, so the set can be browsed from the end to get the recorded items.
+ * Only the used part of the array is searched and modified.
+ */
+
+#include <stddef.h>
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief HID state item. */
+struct hid_item {
+	u16_t usage_id; /**< HID usage ID. */
+	s16_t value; /**< HID value. */
+};
+
+/** @brief Find an item with the given usage ID.
+ *
+ * @param[in] item	Array of items.
+ * @param[in] size	Number of elements in the array.
+ * @param[in] count	Number of recorded items.
+ * @param[in] usage_id	HID usage ID.
+ *
+ * @return Index of the item in the array, or a negative value if
+ *	   the item is not recorded.
+ */
+int hid_items_find(const struct hid_item *item, size_t size, size_t count,
+		   u16_t usage_id);
+
+/** @brief Insert a new item keeping the array sorted.
+ *
+ * The item with the given usage ID must not be recorded yet and there
+ * must be a free slot in the array.
+ *
+ * @param[in,out] item	Array of items.
+ * @param[in] size	Number of elements in the array.
+ * @param[in] count	Number of recorded items.
+ * @param[in] usage_id	HID usage ID. Must not be zero.
+ * @param[in] value	HID value.
+ */
+void hid_items_insert(struct hid_item *item, size_t size, size_t count,
+		      u16_t usage_id, s16_t value);
+
+/** @brief Remove an item keeping the array sorted.
+ *
+ * @param[in,out] item	Array of items.
+ * @param[in] size	Number of elements in the array.
+ * @param[in] count	Number of recorded items.
+ * @param[in] idx	Index of the item returned by @ref hid_items_find.
+ */
+void hid_items_remove(struct hid_item *item, size_t size, size_t count,
+		      size_t idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _HID_ITEMS_H_ */
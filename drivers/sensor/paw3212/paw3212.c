@@ -99,6 +99,9 @@ LOG_MODULE_REGISTER(paw3212, CONFIG_PAW3212_LOG_LEVEL);
 /* Write protect magic */
 #define PAW3212_WPMAGIC			0x5A
 
+/* Delay before retrying a failed motion read */
+#define PAW3212_MOTION_RETRY_MS		100
+
 #define SPI_WRITE_BIT			BIT(7)
 
 
@@ -116,10 +119,14 @@ struct paw3212_data {
 	struct device                *spi_dev;
 	struct gpio_callback         irq_gpio_cb;
 	struct k_spinlock            lock;
+	struct k_mutex               spi_mutex;
 	s16_t                        x;
 	s16_t                        y;
+	s16_t                        acc_x;
+	s16_t                        acc_y;
 	sensor_trigger_handler_t     data_ready_handler;
 	struct k_work                trigger_handler_work;
+	struct k_delayed_work        motion_retry_work;
 	struct k_delayed_work        init_work;
 	enum async_init_step         async_init_step;
 	int                          err;
@@ -536,6 +543,102 @@ static int toggle_sleep_modes(struct paw3212_data *dev_data, u8_t reg_addr1, u8_
 	return err;
 }
 
+static int motion_read(struct paw3212_data *dev_data, s16_t *x, s16_t *y)
+{
+	u8_t motion_status;
+	int err;
+
+	err = reg_read(dev_data, PAW3212_REG_MOTION, &motion_status);
+	if (err) {
+		LOG_ERR("Cannot read motion");
+		return err;
+	}
+
+	if ((motion_status & PAW3212_MOTION_STATUS_MOTION) != 0) {
+		u8_t x_low;
+		u8_t y_low;
+
+		if ((motion_status & PAW3212_MOTION_STATUS_DXOVF) != 0) {
+			LOG_WRN("X delta overflowed");
+		}
+		if ((motion_status & PAW3212_MOTION_STATUS_DYOVF) != 0) {
+			LOG_WRN("Y delta overflowed");
+		}
+
+		err = reg_read(dev_data, PAW3212_REG_DELTA_X_LOW, &x_low);
+		if (err) {
+			LOG_ERR("Cannot read X delta");
+			return err;
+		}
+
+		err = reg_read(dev_data, PAW3212_REG_DELTA_Y_LOW, &y_low);
+		if (err) {
+			LOG_ERR("Cannot read Y delta");
+			return err;
+		}
+
+		if (IS_ENABLED(CONFIG_PAW3212_12_BIT_MODE)) {
+			u8_t xy_high;
+
+			err = reg_read(dev_data, PAW3212_REG_DELTA_XY_HIGH,
+				       &xy_high);
+			if (err) {
+				LOG_ERR("Cannot read XY delta high");
+				return err;
+			}
+
+			*x = PAW3212_DELTA_X(xy_high, x_low);
+			*y = PAW3212_DELTA_Y(xy_high, y_low);
+		} else {
+			*x = (s8_t)x_low;
+			*y = (s8_t)y_low;
+		}
+	} else {
+		*x = 0;
+		*y = 0;
+	}
+
+	return err;
+}
+
+static s16_t accumulated_add(s16_t acc, s16_t delta)
+{
+	/* Motion beyond what a single sample can report is dropped, so that
+	 * it is not replayed long after it happened.
+	 */
+	return MAX(MIN((s32_t)acc + delta, INT16_MAX), INT16_MIN);
+}
+
+static int motion_accumulate(struct paw3212_data *dev_data)
+{
+	s16_t x;
+	s16_t y;
+
+	k_mutex_lock(&dev_data->spi_mutex, K_FOREVER);
+	int err = motion_read(dev_data, &x, &y);
+	k_mutex_unlock(&dev_data->spi_mutex);
+
+	if (!err) {
+		k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
+
+		dev_data->acc_x = accumulated_add(dev_data->acc_x, x);
+		dev_data->acc_y = accumulated_add(dev_data->acc_y, y);
+
+		k_spin_unlock(&dev_data->lock, key);
+	}
+
+	return err;
+}
+
+static s16_t accumulated_take(s16_t *acc)
+{
+	s16_t val = *acc;
+
+	*acc = 0;
+
+	return val;
+}
+
 static void irq_handler(struct device *gpiob, struct gpio_callback *cb,
 			u32_t pins)
 {
@@ -557,23 +660,44 @@ static void trigger_handler(struct k_work *work)
 	sensor_trigger_handler_t handler;
 	int err = 0;
 
+	if (IS_ENABLED(CONFIG_PAW3212_MOTION_ACCUMULATE)) {
+		/* Read motion right away. Reading the deltas releases
+		 * the motion pin, so the next IRQ comes with the new motion.
+		 */
+		err = motion_accumulate(&paw3212_data);
+		if (err) {
+			/* The level IRQ would fire again right away if
+			 * re-armed, so the read is retried later with the
+			 * IRQ disabled.
+			 */
+			LOG_ERR("Cannot read motion");
+			k_delayed_work_submit(&paw3212_data.motion_retry_work,
+					      K_MSEC(PAW3212_MOTION_RETRY_MS));
+			return;
+		}
+	}
+
 	k_spinlock_key_t key = k_spin_lock(&paw3212_data.lock);
 	handler = paw3212_data.data_ready_handler;
 	k_spin_unlock(&paw3212_data.lock, key);
 
-	if (!handler) {
+	if (!handler && !IS_ENABLED(CONFIG_PAW3212_MOTION_ACCUMULATE)) {
 		return;
 	}
 
-	struct sensor_trigger trig = {
-		.type = SENSOR_TRIG_DATA_READY,
-		.chan = SENSOR_CHAN_ALL,
-	};
+	if (handler && !err) {
+		struct sensor_trigger trig = {
+			.type = SENSOR_TRIG_DATA_READY,
+			.chan = SENSOR_CHAN_ALL,
+		};
 
-	handler(DEVICE_GET(paw3212), &trig);
+		handler(DEVICE_GET(paw3212), &trig);
+	}
 
+	err = 0;
 	key = k_spin_lock(&paw3212_data.lock);
-	if (paw3212_data.data_ready_handler) {
+	if (IS_ENABLED(CONFIG_PAW3212_MOTION_ACCUMULATE) ||
+	    paw3212_data.data_ready_handler) {
 		err = gpio_pin_interrupt_configure(paw3212_data.irq_gpio_dev,
 						   PAW3212_IRQ_GPIO_PIN,
 						   GPIO_INT_LEVEL_LOW);
@@ -660,8 +784,22 @@ static void paw3212_async_init(struct k_work *work)
 		dev_data->async_init_step++;
 
 		if (dev_data->async_init_step == ASYNC_INIT_STEP_COUNT) {
-			dev_data->ready = true;
-			LOG_INF("PAW3212 initialized");
+			if (IS_ENABLED(CONFIG_PAW3212_MOTION_ACCUMULATE)) {
+				/* Motion is read on every IRQ, regardless
+				 * of the data ready trigger.
+				 */
+				dev_data->err = gpio_pin_interrupt_configure(
+						dev_data->irq_gpio_dev,
+						PAW3212_IRQ_GPIO_PIN,
+						GPIO_INT_LEVEL_LOW);
+			}
+
+			if (dev_data->err) {
+				LOG_ERR("Cannot enable IRQ");
+			} else {
+				dev_data->ready = true;
+				LOG_INF("PAW3212 initialized");
+			}
 		} else {
 			k_delayed_work_submit(&dev_data->init_work,
 					      K_MSEC(async_init_delay[
@@ -745,7 +883,9 @@ static int paw3212_init(struct device *dev)
 	/* Assert that negative numbers are processed as expected */
 	__ASSERT_NO_MSG(-1 == expand_s12(0xFFF));
 
+	k_mutex_init(&dev_data->spi_mutex);
 	k_work_init(&dev_data->trigger_handler_work, trigger_handler);
+	k_delayed_work_init(&dev_data->motion_retry_work, trigger_handler);
 
 	err = paw3212_init_cs(dev_data);
 	if (err) {
@@ -774,8 +914,6 @@ static int paw3212_init(struct device *dev)
 static int paw3212_sample_fetch(struct device *dev, enum sensor_channel chan)
 {
 	struct paw3212_data *dev_data = &paw3212_data;
-	u8_t motion_status;
-	int err;
 
 	ARG_UNUSED(dev);
 
@@ -788,56 +926,22 @@ static int paw3212_sample_fetch(struct device *dev, enum sensor_channel chan)
 		return -EBUSY;
 	}
 
-	err = reg_read(dev_data, PAW3212_REG_MOTION, &motion_status);
-	if (err) {
-		LOG_ERR("Cannot read motion");
-		return err;
-	}
+	if (IS_ENABLED(CONFIG_PAW3212_MOTION_ACCUMULATE)) {
+		/* Motion was already read on IRQ, no SPI transfer needed. */
+		k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
 
-	if ((motion_status & PAW3212_MOTION_STATUS_MOTION) != 0) {
-		u8_t x_low;
-		u8_t y_low;
+		dev_data->x = accumulated_take(&dev_data->acc_x);
+		dev_data->y = accumulated_take(&dev_data->acc_y);
 
-		if ((motion_status & PAW3212_MOTION_STATUS_DXOVF) != 0) {
-			LOG_WRN("X delta overflowed");
-		}
-		if ((motion_status & PAW3212_MOTION_STATUS_DYOVF) != 0) {
-			LOG_WRN("Y delta overflowed");
-		}
-
-		err = reg_read(dev_data, PAW3212_REG_DELTA_X_LOW, &x_low);
-		if (err) {
-			LOG_ERR("Cannot read X delta");
-			return err;
-		}
-
-		err = reg_read(dev_data, PAW3212_REG_DELTA_Y_LOW, &y_low);
-		if (err) {
-			LOG_ERR("Cannot read Y delta");
-			return err;
-		}
-
-		if (IS_ENABLED(CONFIG_PAW3212_12_BIT_MODE)) {
-			u8_t xy_high;
+		k_spin_unlock(&dev_data->lock, key);
 
-			err = reg_read(dev_data, PAW3212_REG_DELTA_XY_HIGH,
-				       &xy_high);
-			if (err) {
-				LOG_ERR("Cannot read XY delta high");
-				return err;
-			}
-
-			dev_data->x = PAW3212_DELTA_X(xy_high, x_low);
-			dev_data->y = PAW3212_DELTA_Y(xy_high, y_low);
-		} else {
-			dev_data->x = (s8_t)x_low;
-			dev_data->y = (s8_t)y_low;
-		}
-	} else {
-		dev_data->x = 0;
-		dev_data->y = 0;
+		return 0;
 	}
 
+	k_mutex_lock(&dev_data->spi_mutex, K_FOREVER);
+	int err = motion_read(dev_data, &dev_data->x, &dev_data->y);
+	k_mutex_unlock(&dev_data->spi_mutex);
+
 	return err;
 }
 
@@ -895,7 +999,10 @@ static int paw3212_trigger_set(struct device *dev,
 
 	k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
 
-	if (handler) {
+	if (IS_ENABLED(CONFIG_PAW3212_MOTION_ACCUMULATE)) {
+		/* IRQ stays enabled to keep accumulating motion. */
+		err = 0;
+	} else if (handler) {
 		err = gpio_pin_interrupt_configure(dev_data->irq_gpio_dev,
 						   PAW3212_IRQ_GPIO_PIN,
 						   GPIO_INT_LEVEL_LOW);
@@ -932,6 +1039,8 @@ static int paw3212_attr_set(struct device *dev, enum sensor_channel chan,
 		return -EBUSY;
 	}
 
+	k_mutex_lock(&dev_data->spi_mutex, K_FOREVER);
+
 	switch ((u32_t)attr) {
 	case PAW3212_ATTR_CPI:
 		err = update_cpi(dev_data, PAW3212_SVALUE_TO_CPI(*val));
@@ -982,9 +1091,12 @@ static int paw3212_attr_set(struct device *dev, enum sensor_channel chan,
 
 	default:
 		LOG_ERR("Unknown attribute");
-		return -ENOTSUP;
+		err = -ENOTSUP;
+		break;
 	}
 
+	k_mutex_unlock(&dev_data->spi_mutex);
+
 	return err;
 }
 
@@ -110,6 +110,9 @@ LOG_MODULE_REGISTER(pmw3360, CONFIG_PMW3360_LOG_LEVEL);
 #define PMW3360_MAX_CPI				12000
 #define PMW3360_MIN_CPI				100
 
+/* Delay before retrying a failed motion burst read */
+#define PMW3360_MOTION_RETRY_MS			100
+
 
 #define SPI_WRITE_BIT				BIT(7)
 
@@ -134,10 +137,14 @@ struct pmw3360_data {
 	struct device                *spi_dev;
 	struct gpio_callback         irq_gpio_cb;
 	struct k_spinlock            lock;
+	struct k_mutex               spi_mutex;
 	s16_t                        x;
 	s16_t                        y;
+	s16_t                        acc_x;
+	s16_t                        acc_y;
 	sensor_trigger_handler_t     data_ready_handler;
 	struct k_work                trigger_handler_work;
+	struct k_delayed_work        motion_retry_work;
 	struct k_delayed_work        init_work;
 	enum async_init_step         async_init_step;
 	int                          err;
@@ -677,6 +684,74 @@ static int pmw3360_async_init_fw_load_verify(struct pmw3360_data *dev_data)
 	return err;
 }
 
+static int motion_read(struct pmw3360_data *dev_data, s16_t *x, s16_t *y)
+{
+	u8_t data[PMW3360_BURST_SIZE];
+
+	int err = motion_burst_read(dev_data, data, sizeof(data));
+
+	if (err) {
+		return err;
+	}
+
+	s16_t raw_x = sys_get_le16(&data[PMW3360_DX_POS]);
+	s16_t raw_y = sys_get_le16(&data[PMW3360_DY_POS]);
+
+	if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_0)) {
+		*x = -raw_x;
+		*y = raw_y;
+	} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_90)) {
+		*x = raw_y;
+		*y = raw_x;
+	} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_180)) {
+		*x = raw_x;
+		*y = -raw_y;
+	} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_270)) {
+		*x = -raw_y;
+		*y = -raw_x;
+	}
+
+	return 0;
+}
+
+static s16_t accumulated_add(s16_t acc, s16_t delta)
+{
+	/* Motion beyond what a single sample can report is dropped, so that
+	 * it is not replayed long after it happened.
+	 */
+	return MAX(MIN((s32_t)acc + delta, INT16_MAX), INT16_MIN);
+}
+
+static int motion_accumulate(struct pmw3360_data *dev_data)
+{
+	s16_t x;
+	s16_t y;
+
+	k_mutex_lock(&dev_data->spi_mutex, K_FOREVER);
+	int err = motion_read(dev_data, &x, &y);
+	k_mutex_unlock(&dev_data->spi_mutex);
+
+	if (!err) {
+		k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
+
+		dev_data->acc_x = accumulated_add(dev_data->acc_x, x);
+		dev_data->acc_y = accumulated_add(dev_data->acc_y, y);
+
+		k_spin_unlock(&dev_data->lock, key);
+	}
+
+	return err;
+}
+
+static s16_t accumulated_take(s16_t *acc)
+{
+	s16_t val = *acc;
+
+	*acc = 0;
+
+	return val;
+}
+
 static void irq_handler(struct device *gpiob, struct gpio_callback *cb,
 			u32_t pins)
 {
@@ -698,23 +773,44 @@ static void trigger_handler(struct k_work *work)
 	sensor_trigger_handler_t handler;
 	int err = 0;
 
+	if (IS_ENABLED(CONFIG_PMW3360_MOTION_ACCUMULATE)) {
+		/* Read motion right away. Reading the burst releases
+		 * the motion pin, so the next IRQ comes with the next frame.
+		 */
+		err = motion_accumulate(&pmw3360_data);
+		if (err) {
+			/* The level IRQ would fire again right away if
+			 * re-armed, so the read is retried later with the
+			 * IRQ disabled.
+			 */
+			LOG_ERR("Cannot read motion burst");
+			k_delayed_work_submit(&pmw3360_data.motion_retry_work,
+					      K_MSEC(PMW3360_MOTION_RETRY_MS));
+			return;
+		}
+	}
+
 	k_spinlock_key_t key = k_spin_lock(&pmw3360_data.lock);
 	handler = pmw3360_data.data_ready_handler;
 	k_spin_unlock(&pmw3360_data.lock, key);
 
-	if (!handler) {
+	if (!handler && !IS_ENABLED(CONFIG_PMW3360_MOTION_ACCUMULATE)) {
 		return;
 	}
 
-	struct sensor_trigger trig = {
-		.type = SENSOR_TRIG_DATA_READY,
-		.chan = SENSOR_CHAN_ALL,
-	};
+	if (handler && !err) {
+		struct sensor_trigger trig = {
+			.type = SENSOR_TRIG_DATA_READY,
+			.chan = SENSOR_CHAN_ALL,
+		};
 
-	handler(DEVICE_GET(pmw3360), &trig);
+		handler(DEVICE_GET(pmw3360), &trig);
+	}
 
+	err = 0;
 	key = k_spin_lock(&pmw3360_data.lock);
-	if (pmw3360_data.data_ready_handler) {
+	if (IS_ENABLED(CONFIG_PMW3360_MOTION_ACCUMULATE) ||
+	    pmw3360_data.data_ready_handler) {
 		err = gpio_pin_interrupt_configure(pmw3360_data.irq_gpio_dev,
 						   PMW3360_IRQ_GPIO_PIN,
 						   GPIO_INT_LEVEL_LOW);
@@ -776,8 +872,22 @@ static void pmw3360_async_init(struct k_work *work)
 		dev_data->async_init_step++;
 
 		if (dev_data->async_init_step == ASYNC_INIT_STEP_COUNT) {
-			dev_data->ready = true;
-			LOG_INF("PMW3360 initialized");
+			if (IS_ENABLED(CONFIG_PMW3360_MOTION_ACCUMULATE)) {
+				/* Motion is read on every IRQ, regardless
+				 * of the data ready trigger.
+				 */
+				dev_data->err = gpio_pin_interrupt_configure(
+						dev_data->irq_gpio_dev,
+						PMW3360_IRQ_GPIO_PIN,
+						GPIO_INT_LEVEL_LOW);
+			}
+
+			if (dev_data->err) {
+				LOG_ERR("Cannot enable IRQ");
+			} else {
+				dev_data->ready = true;
+				LOG_INF("PMW3360 initialized");
+			}
 		} else {
 			k_delayed_work_submit(&dev_data->init_work,
 					      K_MSEC(async_init_delay[
@@ -856,7 +966,9 @@ static int pmw3360_init(struct device *dev)
 
 	ARG_UNUSED(dev);
 
+	k_mutex_init(&dev_data->spi_mutex);
 	k_work_init(&dev_data->trigger_handler_work, trigger_handler);
+	k_delayed_work_init(&dev_data->motion_retry_work, trigger_handler);
 
 	err = pmw3360_init_cs(dev_data);
 	if (err) {
@@ -885,7 +997,6 @@ static int pmw3360_init(struct device *dev)
 static int pmw3360_sample_fetch(struct device *dev, enum sensor_channel chan)
 {
 	struct pmw3360_data *dev_data = &pmw3360_data;
-	u8_t data[PMW3360_BURST_SIZE];
 
 	ARG_UNUSED(dev);
 
@@ -894,27 +1005,22 @@ static int pmw3360_sample_fetch(struct device *dev, enum sensor_channel chan)
 		return -EBUSY;
 	}
 
-	int err = motion_burst_read(dev_data, data, sizeof(data));
+	if (IS_ENABLED(CONFIG_PMW3360_MOTION_ACCUMULATE)) {
+		/* Motion was already read on IRQ, no SPI transfer needed. */
+		k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
 
-	if (!err) {
-		s16_t x = sys_get_le16(&data[PMW3360_DX_POS]);
-		s16_t y = sys_get_le16(&data[PMW3360_DY_POS]);
-
-		if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_0)) {
-			dev_data->x = -x;
-			dev_data->y = y;
-		} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_90)) {
-			dev_data->x = y;
-			dev_data->y = x;
-		} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_180)) {
-			dev_data->x = x;
-			dev_data->y = -y;
-		} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_270)) {
-			dev_data->x = -y;
-			dev_data->y = -x;
-		}
+		dev_data->x = accumulated_take(&dev_data->acc_x);
+		dev_data->y = accumulated_take(&dev_data->acc_y);
+
+		k_spin_unlock(&dev_data->lock, key);
+
+		return 0;
 	}
 
+	k_mutex_lock(&dev_data->spi_mutex, K_FOREVER);
+	int err = motion_read(dev_data, &dev_data->x, &dev_data->y);
+	k_mutex_unlock(&dev_data->spi_mutex);
+
 	return err;
 }
 
@@ -972,7 +1078,10 @@ static int pmw3360_trigger_set(struct device *dev,
 
 	k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
 
-	if (handler) {
+	if (IS_ENABLED(CONFIG_PMW3360_MOTION_ACCUMULATE)) {
+		/* IRQ stays enabled to keep accumulating motion. */
+		err = 0;
+	} else if (handler) {
 		err = gpio_pin_interrupt_configure(dev_data->irq_gpio_dev,
 						   PMW3360_IRQ_GPIO_PIN,
 						   GPIO_INT_LEVEL_LOW);
@@ -1009,6 +1118,8 @@ static int pmw3360_attr_set(struct device *dev, enum sensor_channel chan,
 		return -EBUSY;
 	}
 
+	k_mutex_lock(&dev_data->spi_mutex, K_FOREVER);
+
 	switch ((u32_t)attr) {
 	case PMW3360_ATTR_CPI:
 		err = update_cpi(dev_data, PMW3360_SVALUE_TO_CPI(*val));
@@ -1061,9 +1172,12 @@ static int pmw3360_attr_set(struct device *dev, enum sensor_channel chan,
 
 	default:
 		LOG_ERR("Unknown attribute");
-		return -ENOTSUP;
+		err = -ENOTSUP;
+		break;
 	}
 
+	k_mutex_unlock(&dev_data->spi_mutex);
+
 	return err;
 }
 
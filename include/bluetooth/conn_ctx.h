@@ -28,6 +28,21 @@ extern "C" {
  * @param  _max_clients	Maximum number of clients connected at a time.
  * @param  _ctx_sz	Context size in bytes for a single connection.
  */
+#if defined(CONFIG_BT_CONN_CTX_INDEXED_LOOKUP)
+#define BT_CONN_CTX_DEF(_name, _max_clients, _ctx_sz)                          \
+	K_MEM_SLAB_DEFINE(_name##_mem_slab,                                    \
+			  ROUND_UP(_ctx_sz, CONFIG_BT_CONN_CTX_MEM_BUF_ALIGN), \
+			  (_max_clients),                                      \
+			  CONFIG_BT_CONN_CTX_MEM_BUF_ALIGN);                   \
+	K_MUTEX_DEFINE(_name##_mutex);                                         \
+	static u8_t _name##_block_slot[_max_clients];                          \
+	static struct bt_conn_ctx_lib CONCAT(_name, _ctx_lib) =                \
+	{                                                                      \
+		.mem_slab = &CONCAT(_name, _mem_slab),                         \
+		.mutex = &_name##_mutex,                                       \
+		.block_slot = _name##_block_slot                               \
+	}
+#else
 #define BT_CONN_CTX_DEF(_name, _max_clients, _ctx_sz)                          \
 	K_MEM_SLAB_DEFINE(_name##_mem_slab,                                    \
 			  ROUND_UP(_ctx_sz, CONFIG_BT_CONN_CTX_MEM_BUF_ALIGN), \
@@ -39,6 +54,7 @@ extern "C" {
 		.mem_slab = &CONCAT(_name, _mem_slab),                         \
 		.mutex = &_name##_mutex                                        \
 	}
+#endif
 
 /** @brief Context data for a connection. */
 struct bt_conn_ctx {
@@ -47,6 +63,13 @@ struct bt_conn_ctx {
 
 	 /** The connection that the data is associated with. */
 	struct bt_conn *conn;
+
+#if defined(CONFIG_BT_CONN_CTX_INDEXED_LOOKUP)
+	/** Number of users of the context. The most significant bit is set
+	 *  once the context has been freed and is waiting for the last user.
+	 */
+	atomic_t ref;
+#endif
 };
 
 /** @brief Bluetooth connection context library structure. */
@@ -60,6 +83,13 @@ struct bt_conn_ctx_lib {
 
 	/** Memory slab instance where the memory is allocated. */
 	struct k_mem_slab * const mem_slab;
+
+#if defined(CONFIG_BT_CONN_CTX_INDEXED_LOOKUP)
+	/** Context slot that owns each memory slab block, used to find the
+	 *  context from its data in @ref bt_conn_ctx_release.
+	 */
+	u8_t * const block_slot;
+#endif
 };
 
 /**
@@ -129,6 +159,13 @@ void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib);
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
  *
+ * By default, the library mutex is held until @ref bt_conn_ctx_release is
+ * called, so only one user accesses context data at a time. When
+ * CONFIG_BT_CONN_CTX_INDEXED_LOOKUP is enabled, the returned context only
+ * holds a reference that keeps the memory allocated. Several users can then
+ * access the same context data concurrently, and the caller must
+ * synchronize this access itself.
+ *
  * @param ctx_lib	Bluetooth connection context library instance.
  * @param conn		Bluetooth connection.
  *
@@ -142,7 +179,10 @@ void *bt_conn_ctx_get(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn);
  *
  * This function finds the connection context and the associated connection
  * object in the memory pool. The link to find is identified
- * by its index in the connection context array.
+ * by its index in the connection context array. When
+ * CONFIG_BT_CONN_CTX_INDEXED_LOOKUP is enabled, this index is equal to
+ * the index returned by bt_conn_index() for the connection, and access to
+ * the context is not serialized, as described for @ref bt_conn_ctx_get.
  *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
@@ -42,6 +42,17 @@ struct bt_enocean_sensor_data {
 	u8_t *energy_lvl; /**< Energy level (percent). */
 };
 
+/** EnOcean device packet statistics. */
+struct bt_enocean_device_stats {
+	u32_t rx; /**< Authenticated packets passed to the callbacks. */
+	/** Repeated or old packets that were ignored. Updated both from the
+	 *  scanner and from the system workqueue, read it with atomic_get().
+	 */
+	atomic_t duplicates;
+	u32_t auth_failures; /**< Packets that failed authentication. */
+	u32_t dropped; /**< Packets dropped because the RX queue was full. */
+};
+
 /** EnOcean device representation. */
 struct bt_enocean_device {
 	u32_t seq;  /**< Most recent sequence number. */
@@ -49,6 +60,8 @@ struct bt_enocean_device {
 	s8_t rssi; /**< Most recent RSSI measurement. */
 	bt_addr_le_t addr; /**< Device address. */
 	u8_t key[16]; /**< Device key. */
+	/** Packet statistics since the device was commissioned or loaded. */
+	struct bt_enocean_device_stats stats;
 };
 
 /** Type of button event */
@@ -57,7 +70,11 @@ enum bt_enocean_button_action {
 	BT_ENOCEAN_BUTTON_PRESS, /**< Buttons were pressed. */
 };
 
-/** EnOcean callback functions. All callbacks are optional. */
+/** @brief EnOcean callback functions. All callbacks are optional.
+ *
+ *  The button and sensor callbacks are called from the system workqueue, as
+ *  the packets are authenticated outside of the Bluetooth scanner callback.
+ */
 struct bt_enocean_callbacks {
 	/** @brief Callback for EnOcean Switch button presses.
 	 *
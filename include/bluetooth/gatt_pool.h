@@ -187,6 +187,37 @@ int bt_gatt_pool_ccc_alloc(struct bt_gatt_pool *gp,
 void bt_gatt_pool_free(struct bt_gatt_pool *gp);
 
 #if CONFIG_BT_GATT_POOL_STATS != 0
+/** @brief Usage of a single element pool. */
+struct bt_gatt_pool_usage {
+	/** Number of elements in the pool. */
+	size_t size;
+	/** Number of elements currently taken. */
+	size_t used;
+	/** Highest number of elements taken at the same time. */
+	size_t max_used;
+};
+
+/** @brief Usage of all element pools used by the module. */
+struct bt_gatt_pool_stats {
+	/** 16-bit UUID pool usage. */
+	struct bt_gatt_pool_usage uuid_16;
+	/** 32-bit UUID pool usage. */
+	struct bt_gatt_pool_usage uuid_32;
+	/** 128-bit UUID pool usage. */
+	struct bt_gatt_pool_usage uuid_128;
+	/** Characteristic declaration pool usage. */
+	struct bt_gatt_pool_usage chrc;
+};
+
+/** @brief Get the current and maximum usage of the element pools.
+ *
+ *  The maximum usage can be used to right-size the
+ *  CONFIG_BT_GATT_*_POOL_SIZE options for a given application.
+ *
+ *  @param stats Structure to be filled with the pool statistics.
+ */
+void bt_gatt_pool_stats_get(struct bt_gatt_pool_stats *stats);
+
 /** @brief Print basic module statistics (containing pool size usage).
  */
 void bt_gatt_pool_stats_print(void);
@@ -158,6 +158,8 @@ struct bt_mesh_plvl_srv {
 	u16_t last;
 	/** Whether the Power is on. */
 	bool is_on;
+	/** Deferred storage context. */
+	struct bt_mesh_model_store_ctx store;
 };
 
 /** @brief Publish the current Power state.
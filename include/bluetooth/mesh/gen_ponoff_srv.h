@@ -103,6 +103,8 @@ struct bt_mesh_ponoff_srv {
 
 	/** Current OnPowerUp state. */
 	enum bt_mesh_on_power_up on_power_up;
+	/** Deferred storage context. */
+	struct bt_mesh_model_store_ctx store;
 };
 
 /** @brief Set the OnPowerUp state of a Power OnOff server.
@@ -170,6 +170,18 @@ struct bt_mesh_prop_srv {
 	/** Number of properties supported by the server. */
 	const u32_t property_count;
 
+	/* Internal lookup state, built when the model is initialized. */
+	struct {
+		/** Property indices, sorted by Property ID. */
+		u8_t order[CONFIG_BT_MESH_PROP_MAXCOUNT];
+		/** Encoded Property ID list, in ascending order. */
+		u8_t list[BT_MESH_PROP_MSG_MAXLEN_PROPS_STATUS];
+		/** Number of Property IDs in the list. */
+		u8_t list_count;
+		/** Whether the list is up to date. */
+		bool list_valid;
+	} cache;
+
 	/** @brief Set a property value.
 	 *
 	 * The handler may reject the value change with two levels of severity:
@@ -125,6 +125,8 @@ struct bt_mesh_light_ctrl_srv_reg {
 	struct k_delayed_work timer;
 	/** Internal integral sum. */
 	u16_t i;
+	/** Time the error has been within the dead zone (in milliseconds). */
+	u32_t stable_time;
 	/** Regulator configuration */
 	struct bt_mesh_light_ctrl_srv_reg_cfg cfg;
 };
@@ -152,10 +154,10 @@ struct bt_mesh_light_ctrl_srv {
 	/** State timer */
 	struct k_delayed_work timer;
 
-#if CONFIG_BT_SETTINGS
-	/** Storage timer */
-	struct k_delayed_work store_timer;
-#endif
+	/** Deferred storage context for the state */
+	struct bt_mesh_model_store_ctx store_state;
+	/** Deferred storage context for the configuration */
+	struct bt_mesh_model_store_ctx store_cfg;
 	/** Timer for delayed action */
 	struct k_delayed_work action_delay;
 	/** Configuration parameters */
@@ -159,6 +159,8 @@ struct bt_mesh_lightness_srv {
 	u16_t last;
 	/** Internal flag state. */
 	atomic_t flags;
+	/** Deferred storage context. */
+	struct bt_mesh_model_store_ctx store;
 };
 
 /** @brief Publish the current Light state.
@@ -50,6 +50,21 @@ struct bt_mesh_model_ack_ctx {
 	void *user_data; /**< User specific parameter. */
 };
 
+/**
+ * Deferred storage context, coalescing frequent changes to the persistent
+ * state of a model into a single write.
+ */
+struct bt_mesh_model_store_ctx {
+	/** Store callback, writing the current state of the model. */
+	int (*store)(struct bt_mesh_model_store_ctx *ctx);
+	/** Time to wait for further changes before storing, in milliseconds. */
+	u32_t timeout;
+	sys_snode_t node; /**< Linked list node. */
+	u32_t first; /**< Uptime of the first change since the last write. */
+	u32_t due; /**< Uptime when the state should be written. */
+	bool pending; /**< Whether there are changes waiting to be written. */
+};
+
 /** Model status values. */
 enum bt_mesh_model_status {
 	/** Command successfully processed. */
@@ -10,6 +10,7 @@
 #include <bluetooth/mesh.h>
 
 #include <bluetooth/mesh/model_types.h>
+#include <bluetooth/mesh/transition.h>
 
 /* Foundation models */
 #include <bluetooth/mesh/cfg_cli.h>
@@ -54,6 +55,28 @@
  */
 bool bt_mesh_model_pub_is_unicast(const struct bt_mesh_model *mod);
 
+/** Model storage statistics. */
+struct bt_mesh_model_store_stats {
+	/** Number of state changes the models have requested to store. */
+	u32_t requests;
+	/** Number of writes to persistent storage. */
+	u32_t writes;
+};
+
+/** @brief Store all pending model state changes immediately.
+ *
+ * The models delay writing their state to persistent storage after it
+ * changes, to coalesce frequent changes into a single write. Call this before
+ * powering down the device to avoid losing the most recent changes.
+ */
+void bt_mesh_model_store_flush(void);
+
+/** @brief Get the model storage statistics.
+ *
+ * @param[out] stats Statistics since boot.
+ */
+void bt_mesh_model_store_stats_get(struct bt_mesh_model_store_stats *stats);
+
 /** Shorthand macro for defining a model list directly in the element. */
 #define BT_MESH_MODEL_LIST(...) ((struct bt_mesh_model[]){ __VA_ARGS__ })
 
@@ -321,6 +321,31 @@ struct bt_mesh_sensor_series {
 	int (*get)(struct bt_mesh_sensor *sensor, struct bt_mesh_msg_ctx *ctx,
 		   const struct bt_mesh_sensor_column *column,
 		   struct sensor_value *value);
+
+	/** @brief Batch getter for the series values.
+	 *
+	 *  Optional replacement for the @c get callback. Instead of being
+	 *  called once per column, the batch getter is called for groups of up
+	 *  to @ref CONFIG_BT_MESH_SENSOR_SRV_SERIES_BATCH_SIZE columns. If both
+	 *  callbacks are set, the batch getter is used.
+	 *
+	 *  @param[in]  sensor  Sensor pointer.
+	 *  @param[in]  ctx     Message context pointer, or NULL if this call
+	 *                      didn't originate from a mesh message.
+	 *  @param[in]  columns List of requested sensor columns. Every entry
+	 *                      points to a column in the @c columns array.
+	 *  @param[in]  count   Number of requested columns.
+	 *  @param[out] values  Sensor value response buffers, one per requested
+	 *                      column. All channels must be filled.
+	 *
+	 *  @return 0 on success, or (negative) error code otherwise.
+	 */
+	int (*get_batch)(struct bt_mesh_sensor *sensor,
+			 struct bt_mesh_msg_ctx *ctx,
+			 const struct bt_mesh_sensor_column **columns,
+			 u32_t count,
+			 struct sensor_value
+				 (*values)[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX]);
 };
 
 /** Sensor instance. */
@@ -345,7 +370,8 @@ struct bt_mesh_sensor {
 	 *
 	 *  Only sensors whose type have the @ref
 	 *  BT_MESH_SENSOR_TYPE_FLAG_SERIES flag set, a non-empty list of
-	 *  columns and a defined series getter will accept series messages.
+	 *  columns and a defined series getter or batch getter will accept
+	 *  series messages.
 	 */
 	const struct bt_mesh_sensor_series series;
 
@@ -379,6 +405,9 @@ struct bt_mesh_sensor {
 		/** Sequence number of the previous publication. */
 		u16_t seq;
 
+		/** Uptime of the previous publication, in milliseconds. */
+		u32_t pub_time;
+
 		/** Minimum possible interval for fast cadence value publishing
 		 *  in seconds.
 		 *
@@ -393,6 +422,11 @@ struct bt_mesh_sensor {
 		/** Flag indicating whether the sensor is in fast cadence mode.
 		 */
 		u8_t fast_pub : 1;
+
+		/** Flag indicating whether the sensor is waiting for a batched
+		 *  publication.
+		 */
+		u8_t pub_pending : 1;
 	} state;
 };
 
@@ -449,6 +483,61 @@ bool bt_mesh_sensor_value_in_column(const struct sensor_value *value,
 const struct bt_mesh_sensor_format *
 bt_mesh_sensor_column_format_get(const struct bt_mesh_sensor_type *type);
 
+/** @brief Convert a channel value to its raw encoded integer.
+ *
+ *  The raw value is the integer that represents the channel value in mesh
+ *  messages, in units of the format's resolution. Unsigned 32-bit values are
+ *  passed as the u32_t value cast to s32_t.
+ *
+ *  @param[in]  format Channel format.
+ *  @param[in]  val    Channel value.
+ *  @param[out] raw    Raw encoded value.
+ *
+ *  @return 0 on success, or (negative) error code otherwise.
+ */
+int bt_mesh_sensor_ch_to_raw(const struct bt_mesh_sensor_format *format,
+			     const struct sensor_value *val, s32_t *raw);
+
+/** @brief Convert a raw encoded integer to a channel value.
+ *
+ *  @param[in]  format Channel format.
+ *  @param[in]  raw    Raw encoded value.
+ *  @param[out] val    Channel value.
+ *
+ *  @return 0 on success, or (negative) error code otherwise.
+ */
+int bt_mesh_sensor_ch_from_raw(const struct bt_mesh_sensor_format *format,
+			       s32_t raw, struct sensor_value *val);
+
+/** @brief Encode raw channel values of a sensor type.
+ *
+ *  Fast path for sensors that measure in the units of the sensor type's
+ *  resolution. The raw values are written to the message without converting
+ *  them to and from @c sensor_value. Raw values outside the range of a
+ *  channel are encoded the same way as out of range channel values.
+ *
+ *  @param[in,out] buf  Buffer to encode the values in.
+ *  @param[in]     type Sensor type.
+ *  @param[in]     raw  Raw encoded value of every channel in the sensor type.
+ *
+ *  @return 0 on success, or (negative) error code otherwise.
+ */
+int bt_mesh_sensor_raw_encode(struct net_buf_simple *buf,
+			      const struct bt_mesh_sensor_type *type,
+			      const s32_t *raw);
+
+/** @brief Decode raw channel values of a sensor type.
+ *
+ *  @param[in,out] buf  Buffer to decode the values from.
+ *  @param[in]     type Sensor type.
+ *  @param[out]    raw  Raw encoded value of every channel in the sensor type.
+ *
+ *  @return 0 on success, or (negative) error code otherwise.
+ */
+int bt_mesh_sensor_raw_decode(struct net_buf_simple *buf,
+			      const struct bt_mesh_sensor_type *type,
+			      s32_t *raw);
+
 /** @brief Get a human readable representation of a single sensor channel.
  *
  *  @param[in]  ch  Sensor channel to represent.
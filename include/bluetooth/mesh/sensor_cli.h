@@ -212,7 +212,9 @@ struct bt_mesh_sensor_cli_handlers {
 	 *
 	 *  If the received series entry message contains several entries, this
 	 *  callback is called once per entry, with the @c index and @c count
-	 *  parameters indicating the progress.
+	 *  parameters indicating the progress. Large series may be split into
+	 *  several messages by the server, in which case @c index and @c count
+	 *  refer to the entries of the current message.
 	 *
 	 *  @note The @c index and @c count parameters does not necessarily
 	 *        match the total number of series entries of the sensor, as the
@@ -222,8 +224,8 @@ struct bt_mesh_sensor_cli_handlers {
 	 *  @param[in] ctx    Message context.
 	 *  @param[in] sensor Sensor instance.
 	 *  @param[in] index  Index of this entry in the list of entries
-	 *                    received.
-	 *  @param[in] count  Total number of entries received.
+	 *                    received in the message.
+	 *  @param[in] count  Total number of entries received in the message.
 	 *  @param[in] entry  Single sensor series entry.
 	 */
 	void (*series_entry)(struct bt_mesh_sensor_cli *cli,
@@ -577,6 +579,12 @@ int bt_mesh_sensor_cli_series_entry_get(
  *  the buffer isn't big enough. If the call fails in a way that results in no
  *  response, @c count is set to 0.
  *
+ *  Series that don't fit in a single message are split into several Series
+ *  Status messages by the server, and the response ends with an empty Series
+ *  Status message. The client collects the entries of all messages until the
+ *  empty message is received, and fails if no new message is received within
+ *  @ref CONFIG_BT_MESH_SENSOR_CLI_SERIES_PAGE_TIMEOUT milliseconds.
+ *
  *  This call is blocking if the @c rsp buffer is non-NULL. Otherwise, this
  *  function will return, and the response will be passed to the
  *  @ref bt_mesh_sensor_cli_handlers::series_entries callback as a list of
@@ -606,6 +614,9 @@ int bt_mesh_sensor_cli_series_entry_get(
  *  @retval -EADDRNOTAVAIL A message context was not provided and publishing is
  *                         not configured.
  *  @retval -EAGAIN        The device has not been provisioned.
+ *  @retval -ETIMEDOUT     The end of the response wasn't received in time.
+ *                         The @c rsp array and @c count reflect the entries
+ *                         received so far.
  */
 int bt_mesh_sensor_cli_series_entries_get(
 	struct bt_mesh_sensor_cli *cli, struct bt_mesh_msg_ctx *ctx,
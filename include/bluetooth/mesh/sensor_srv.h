@@ -81,6 +81,39 @@ struct bt_mesh_sensor_srv {
 	struct bt_mesh_model_pub setup_pub;
 	/** Composition data model pointer. */
 	struct bt_mesh_model *model;
+	/** Unprompted publication batch timer. */
+	struct k_delayed_work pub_batch;
+
+	/** Paginated Series Status response in progress. */
+	struct {
+		/** Sensor being reported, or NULL if no response is pending. */
+		struct bt_mesh_sensor *sensor;
+		/** Context of the Series Get message. */
+		struct bt_mesh_msg_ctx ctx;
+		/** Requested column range. */
+		struct bt_mesh_sensor_column range;
+		/** Index of the next column to report. */
+		u32_t next;
+		/** Whether the range was requested. */
+		bool ranged;
+		/** Series Get waiting to replace the response in progress. */
+		struct {
+			/** Requested sensor, or NULL if none is pending. */
+			struct bt_mesh_sensor *sensor;
+			/** Context of the Series Get message. */
+			struct bt_mesh_msg_ctx ctx;
+			/** Requested column range. */
+			struct bt_mesh_sensor_column range;
+			/** Whether the range was requested. */
+			bool ranged;
+		} pending;
+		/** Protects the pending request. */
+		struct k_spinlock lock;
+		/** Whether a page is being transmitted. */
+		atomic_t in_flight;
+		/** Work item building the pages. */
+		struct k_work work;
+	} series;
 };
 
 /** @brief Publish a sensor value.
@@ -115,10 +148,17 @@ int bt_mesh_sensor_srv_pub(struct bt_mesh_sensor_srv *srv,
  *  previous publication and the sensor's threshold parameters. Only single
  *  channel sensor values will be considered.
  *
+ *  If @ref CONFIG_BT_MESH_SENSOR_SRV_PUB_BATCH_WINDOW is non-zero, the
+ *  publication is deferred by the batching window, and combined with the
+ *  publications of other sensors in the same server that are sampled in the
+ *  meantime. The sensor is sampled again when the batch is published, and is
+ *  held back until its minimum publication interval has expired.
+ *
  *  @param[in] srv    Sensor server instance.
  *  @param[in] sensor Sensor instance to sample.
  *
- *  @retval 0              The sensor value was published.
+ *  @retval 0              The sensor value was published, or scheduled for
+ *                         publication.
  *  @retval -EBUSY         Failed sampling the sensor value.
  *  @retval -EALREADY      The sensor value has not changed sufficiently to
  *                         require a publication.
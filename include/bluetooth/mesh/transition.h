@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file
+ * @defgroup bt_mesh_transition Shared transition engine
+ * @{
+ * @brief Common driver for the state transitions of mesh models.
+ */
+
+#ifndef BT_MESH_TRANSITION_H__
+#define BT_MESH_TRANSITION_H__
+
+#include <bluetooth/mesh/model_types.h>
+#include <sys/slist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct bt_mesh_transition;
+
+/** @brief Transition step callback.
+ *
+ *  Called with the interpolated value on every step of the transition. All
+ *  transitions that are in progress are stepped in the same pass, so the
+ *  callbacks of all transitions sharing a step are called back to back.
+ *  The callback may start or stop transitions.
+ *
+ *  @param[in] transition Transition that stepped.
+ *  @param[in] value      New value of the transitioning state.
+ *  @param[in] done       Whether this is the last step of the transition.
+ *                        The value is always the target value on the last
+ *                        step.
+ */
+typedef void (*bt_mesh_transition_step_t)(struct bt_mesh_transition *transition,
+					  s32_t value, bool done);
+
+/** Transition instance. */
+struct bt_mesh_transition {
+	/** Step callback. */
+	bt_mesh_transition_step_t step;
+
+	/* Internal state, overwritten when the transition starts. Should only
+	 * be written to by the transition engine.
+	 */
+	struct {
+		/** Linked list node. */
+		sys_snode_t node;
+		/** Uptime when the state starts moving, in milliseconds. */
+		u32_t start_time;
+		/** Duration of the transition, in milliseconds. */
+		u32_t duration;
+		/** Start value. */
+		s32_t start;
+		/** Target value. */
+		s32_t target;
+		/** The previously reported value. */
+		s32_t value;
+		/** The last step pass that processed the transition. */
+		u32_t pass;
+		/** Whether the transition is in progress. */
+		bool active;
+	} state;
+};
+
+/** @brief Start a transition.
+ *
+ *  Moves the state linearly from @p start to @p target according to the
+ *  given transition parameters. If the transition is already in progress,
+ *  it is restarted with the new parameters.
+ *
+ *  The transition is stepped every
+ *  @ref CONFIG_BT_MESH_TRANSITION_STEP_INTERVAL milliseconds, aligned to a
+ *  step grid that is common for all transitions, so that a single timer
+ *  serves every transition in the device. The final step may therefore come
+ *  up to one step interval after the transition time has passed.
+ *
+ *  If the transition parameters have neither a delay nor a transition time,
+ *  the step callback is called with the target value before this function
+ *  returns.
+ *
+ *  The transition engine is protected by a mutex, so this function must not
+ *  be called from an interrupt.
+ *
+ *  @param[in] transition Transition instance. The step callback must be
+ *                        set.
+ *  @param[in] start      Start value.
+ *  @param[in] target     Target value.
+ *  @param[in] params     Transition parameters, or NULL to jump to the target
+ *                        value immediately.
+ */
+void bt_mesh_transition_start(struct bt_mesh_transition *transition,
+			      s32_t start, s32_t target,
+			      const struct bt_mesh_model_transition *params);
+
+/** @brief Stop a transition.
+ *
+ *  Stops the transition at its current value, without calling the step
+ *  callback.
+ *
+ *  @param[in] transition Transition instance.
+ */
+void bt_mesh_transition_stop(struct bt_mesh_transition *transition);
+
+/** @brief Check whether a transition is in progress.
+ *
+ *  @param[in] transition Transition instance.
+ *
+ *  @return true if the transition is in progress or delayed, false otherwise.
+ */
+bool bt_mesh_transition_in_progress(
+	const struct bt_mesh_transition *transition);
+
+/** @brief Get the remaining time of a transition.
+ *
+ *  Includes any remaining delay, and can be used directly as the remaining
+ *  time in the model status messages.
+ *
+ *  @param[in] transition Transition instance.
+ *
+ *  @return The remaining time of the transition in milliseconds, or 0 if the
+ *          transition is not in progress.
+ */
+u32_t bt_mesh_transition_remaining(const struct bt_mesh_transition *transition);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* BT_MESH_TRANSITION_H__ */
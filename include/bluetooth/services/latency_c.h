@@ -38,6 +38,38 @@ struct bt_gatt_latency_c_cb {
 	void (*latency_response)(const void *buf, u16_t len);
 };
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+/** @brief Round-trip latency statistics of a connection. */
+struct bt_gatt_latency_c_stats {
+	/** Histogram of the round-trip latency. Each bucket is
+	 *  CONFIG_BT_GATT_LATENCY_C_STATS_BUCKET_US wide.
+	 */
+	u32_t hist[CONFIG_BT_GATT_LATENCY_C_STATS_BUCKETS];
+
+	/** Number of measurements. */
+	u32_t count;
+
+	/** Last round-trip latency in microseconds. */
+	u32_t last;
+
+	/** Maximum round-trip latency in microseconds. */
+	u32_t max;
+
+	/** Connection event counter when the last request was sent. */
+	u16_t last_event;
+
+	/** Number of connection events between the last request
+	 *  and its response.
+	 */
+	u16_t last_event_span;
+
+	/** Maximum number of connection events between a request
+	 *  and its response.
+	 */
+	u16_t max_event_span;
+};
+#endif
+
 /** @brief Latency client structure. */
 struct bt_gatt_latency_c {
 	/** Characteristic handle. */
@@ -51,6 +83,29 @@ struct bt_gatt_latency_c {
 
 	/** Internal state. */
 	atomic_t state;
+
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+	/** Round-trip latency statistics. */
+	struct bt_gatt_latency_c_stats stats;
+
+	/** Work used to send the periodic requests. */
+	struct k_delayed_work measure_work;
+
+	/** Time between a response and the next request in milliseconds. */
+	u32_t measure_period;
+
+	/** Cycle count when the pending request was sent. */
+	u32_t req_stamp;
+
+	/** Latest connection event counter reported by the application. */
+	u16_t event_counter;
+
+	/** Connection event counter when the pending request was sent. */
+	u16_t req_event;
+
+	/** Node in the list of initialized clients. */
+	sys_snode_t node;
+#endif
 };
 
 /** @brief Initialize the GATT latency client.
@@ -103,6 +158,74 @@ int bt_gatt_latency_c_handles_assign(struct bt_gatt_dm *dm,
 int bt_gatt_latency_c_request(struct bt_gatt_latency_c *latency,
 			      const void *data, u16_t len);
 
+/** @brief Start the continuous latency measurement.
+ *
+ *  The client sends a Latency request @p period milliseconds after
+ *  receiving the response to the previous one, and records the
+ *  round-trip latency in the statistics of the instance.
+ *
+ *  The client holds a reference to its connection while measuring.
+ *  The measurement is stopped and the reference is released when
+ *  the connection is disconnected.
+ *
+ *  @note Available only if CONFIG_BT_GATT_LATENCY_C_STATS is enabled.
+ *
+ *  @param[in] latency Latency client instance.
+ *  @param[in] period Time between a response and the next request
+ *             in milliseconds.
+ *
+ *  @retval 0 If the operation was successful.
+ *            Otherwise, a negative error code is returned.
+ */
+int bt_gatt_latency_c_measure_start(struct bt_gatt_latency_c *latency,
+				    u32_t period);
+
+/** @brief Stop the continuous latency measurement.
+ *
+ *  @note Available only if CONFIG_BT_GATT_LATENCY_C_STATS is enabled.
+ *
+ *  @param[in] latency Latency client instance.
+ */
+void bt_gatt_latency_c_measure_stop(struct bt_gatt_latency_c *latency);
+
+/** @brief Reset the latency statistics.
+ *
+ *  @note Available only if CONFIG_BT_GATT_LATENCY_C_STATS is enabled.
+ *
+ *  @param[in] latency Latency client instance.
+ */
+void bt_gatt_latency_c_stats_reset(struct bt_gatt_latency_c *latency);
+
+/** @brief Get a percentile of the round-trip latency.
+ *
+ *  The value is the upper bound of the histogram bucket that contains
+ *  the percentile, limited to the maximum measured latency.
+ *
+ *  @note Available only if CONFIG_BT_GATT_LATENCY_C_STATS is enabled.
+ *
+ *  @param[in] latency Latency client instance.
+ *  @param[in] percent Percentile, from 1 to 100.
+ *
+ *  @return Round-trip latency in microseconds, or 0 if nothing has been
+ *          measured.
+ */
+u32_t bt_gatt_latency_c_percentile_get(const struct bt_gatt_latency_c *latency,
+				       u8_t percent);
+
+/** @brief Report the current connection event counter.
+ *
+ *  Latency samples are correlated with the connection event counter
+ *  reported by the application, for example from the connection event
+ *  reports of the controller.
+ *
+ *  @note Available only if CONFIG_BT_GATT_LATENCY_C_STATS is enabled.
+ *
+ *  @param[in] latency Latency client instance.
+ *  @param[in] event_counter Connection event counter.
+ */
+void bt_gatt_latency_c_conn_event_update(struct bt_gatt_latency_c *latency,
+					 u16_t event_counter);
+
 #ifdef __cplusplus
 }
 #endif
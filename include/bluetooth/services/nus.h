@@ -87,6 +87,43 @@ int bt_gatt_nus_init(struct bt_gatt_nus_cb *callbacks);
  */
 int bt_gatt_nus_send(struct bt_conn *conn, const u8_t *data, u16_t len);
 
+/**@brief Queue data for sending.
+ *
+ * @details This function appends data to the TX queue. Queued data is sent
+ *          in notifications of up to @ref bt_gatt_nus_max_send bytes.
+ *          Small writes are coalesced while previous notifications are
+ *          still in flight, and up to
+ *          CONFIG_BT_GATT_NUS_TX_QUEUE_MAX_IN_FLIGHT notifications are
+ *          handed over to the Bluetooth stack at a time.
+ *
+ *          The queue serves one connection at a time. It is released when
+ *          the connection is lost.
+ *
+ * @note Available only if CONFIG_BT_GATT_NUS_TX_QUEUE is enabled.
+ *
+ * @param[in] conn    Pointer to connection Object.
+ * @param[in] data    Pointer to a data buffer.
+ * @param[in] len     Length of the data in the buffer.
+ * @param[in] timeout Maximum time to wait for free space each time the
+ *                    queue gets full. Use K_NO_WAIT to return immediately.
+ *
+ * @retval -EINVAL If the parameters are invalid or the peer has not enabled
+ *                 notifications.
+ * @retval -EBUSY  If the queue is in use by another connection.
+ * @return Number of bytes queued, which is lower than @p len if the queue
+ *         did not get enough free space before the timeout.
+ */
+int bt_gatt_nus_tx_queue_put(struct bt_conn *conn, const u8_t *data,
+			     u16_t len, k_timeout_t timeout);
+
+/**@brief Get free space in the TX queue.
+ *
+ * @note Available only if CONFIG_BT_GATT_NUS_TX_QUEUE is enabled.
+ *
+ * @return Number of bytes that can be queued without blocking.
+ */
+u32_t bt_gatt_nus_tx_queue_space_get(void);
+
 /**@brief Get maximum data length that can be used for @ref bt_gatt_nus_send.
  *
  * @param[in] conn Pointer to connection Object.
@@ -35,6 +35,28 @@ struct bt_gatt_throughput_metrics {
 	u32_t write_rate;
 };
 
+/** @brief TX latency statistics.
+ *
+ * Latency is measured from handing a packet to the Bluetooth stack until
+ * the stack reports it as sent. All values are in microseconds.
+ */
+struct bt_gatt_throughput_latency {
+	/** Number of measured packets. */
+	u32_t count;
+
+	/** Median latency. */
+	u32_t p50;
+
+	/** 90th percentile latency. */
+	u32_t p90;
+
+	/** 99th percentile latency. */
+	u32_t p99;
+
+	/** Maximum latency. */
+	u32_t max;
+};
+
 /** @brief Throughput callback structure. */
 struct bt_gatt_throughput_cb {
 	/** @brief Data read callback.
@@ -66,6 +88,25 @@ struct bt_gatt_throughput_cb {
 	 * @param[in] met Throughput metrics.
 	 */
 	void (*data_send)(const struct bt_gatt_throughput_metrics *met);
+
+	/** @brief Notification received callback.
+	 *
+	 * This function is called when a notification has been received
+	 * from the Throughput Notification Characteristic.
+	 *
+	 * @param[in] met Metrics of the received notifications.
+	 */
+	void (*notif_received)(const struct bt_gatt_throughput_metrics *met);
+
+	/** @brief Notification stream request callback.
+	 *
+	 * This function is called when the peer requests the server to
+	 * send notifications for the given time.
+	 *
+	 * @param[in] conn Connection object.
+	 * @param[in] duration Stream duration in milliseconds.
+	 */
+	void (*stream_request)(struct bt_conn *conn, u32_t duration);
 };
 
 /** @brief Throughput structure. */
@@ -81,11 +122,29 @@ struct bt_gatt_throughput {
 
 	/** Connection object. */
 	struct bt_conn *conn;
+
+	/** Throughput Notification Characteristic handle. */
+	u16_t notif_handle;
+
+	/** Throughput Notification Characteristic CCC handle. */
+	u16_t ccc_handle;
+
+	/** GATT subscribe parameters for the notifications. */
+	struct bt_gatt_subscribe_params sub_params;
+
+	/** Metrics of the received notifications. */
+	struct bt_gatt_throughput_metrics notif_met;
+
+	/** Cycle count at the start of the notification measurement. */
+	u32_t notif_start;
 };
 
 /** @brief Throughput Characteristic UUID. */
 #define BT_UUID_THROUGHPUT_CHAR BT_UUID_DECLARE_16(0x1524)
 
+/** @brief Throughput Notification Characteristic UUID. */
+#define BT_UUID_THROUGHPUT_NOTIF_CHAR BT_UUID_DECLARE_16(0x1525)
+
 /** @brief Throughput Service UUID. */
 #define BT_UUID_THROUGHPUT                                                     \
 	BT_UUID_DECLARE_128(0xBB, 0x4A, 0xFF, 0x4F, 0xAD, 0x03, 0x41, 0x5D,    \
@@ -144,6 +203,65 @@ int bt_gatt_throughput_read(struct bt_gatt_throughput *throughput);
 int bt_gatt_throughput_write(struct bt_gatt_throughput *throughput,
 			     const u8_t *data, u16_t len);
 
+/** @brief Subscribe to notifications from the server.
+ *
+ *  Received notifications are counted in @c notif_met of the instance
+ *  and reported through the notif_received callback. A notification
+ *  with a length of 1 byte resets the metrics.
+ *
+ *  @param[in] throughput Throughput Service instance.
+ *
+ *  @retval 0 If the operation was successful.
+ *            Otherwise, a negative error code is returned.
+ *  @retval (-ENOTSUP) If the server does not support notifications.
+ */
+int bt_gatt_throughput_subscribe(struct bt_gatt_throughput *throughput);
+
+/** @brief Request the server to send notifications.
+ *
+ *  The request is written to the Throughput Notification Characteristic,
+ *  and passed to the stream_request callback on the server.
+ *
+ *  @param[in] throughput Throughput Service instance.
+ *  @param[in] duration Stream duration in milliseconds.
+ *
+ *  @retval 0 If the operation was successful.
+ *            Otherwise, a negative error code is returned.
+ *  @retval (-ENOTSUP) If the server does not support notifications.
+ */
+int bt_gatt_throughput_stream_request(struct bt_gatt_throughput *throughput,
+				      u32_t duration);
+
+/** @brief Send a notification to the client.
+ *
+ *  @param[in] conn Connection object.
+ *  @param[in] data Data.
+ *  @param[in] len Data length.
+ *
+ *  @retval 0 If the operation was successful.
+ *            Otherwise, a negative error code is returned.
+ *  @retval (-EINVAL) If the client has not enabled notifications.
+ */
+int bt_gatt_throughput_notify(struct bt_conn *conn, const u8_t *data,
+			      u16_t len);
+
+/** @brief Get the TX latency statistics.
+ *
+ *  Both writes sent with @ref bt_gatt_throughput_write and notifications
+ *  sent with @ref bt_gatt_throughput_notify are included.
+ *
+ *  @note Available only if CONFIG_BT_GATT_THROUGHPUT_LATENCY is enabled.
+ *
+ *  @param[out] lat Latency statistics.
+ */
+void bt_gatt_throughput_latency_get(struct bt_gatt_throughput_latency *lat);
+
+/** @brief Reset the TX latency statistics.
+ *
+ *  @note Available only if CONFIG_BT_GATT_THROUGHPUT_LATENCY is enabled.
+ */
+void bt_gatt_throughput_latency_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@
 #define INTERVAL_MAX    0x50     /* 80 units,  100 ms */
 #define INTERVAL_LLPM   0x0D01   /* Proprietary  1 ms */
 #define INTERVAL_LLPM_US 1000
+#define MEASURE_PERIOD_MS 10
 
 static volatile bool test_ready;
 static struct bt_conn *default_conn;
@@ -291,6 +292,11 @@ static bool on_vs_evt(struct net_buf_simple *buf)
 	evt = (void *)buf->data;
 	llpm_latency.crc_errors += evt->crc_error_count;
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+	bt_gatt_latency_c_conn_event_update(&gatt_latency_client,
+					    evt->event_counter);
+#endif
+
 	return true;
 }
 
@@ -371,6 +377,28 @@ static void test_run(void)
 	printk("Press any key to start measuring transmission latency\n");
 	console_getchar();
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+	err = bt_gatt_latency_c_measure_start(&gatt_latency_client,
+					      MEASURE_PERIOD_MS);
+	if (err) {
+		printk("Latency measurement failed to start (err %d)\n", err);
+		return;
+	}
+
+	/* The measurement is stopped by the client on disconnection */
+	while (default_conn) {
+		k_sleep(K_SECONDS(1));
+
+		printk("Round-trip latency: p50 %u p99 %u max %u (us), "
+		       "CRC errors %u\n",
+		       bt_gatt_latency_c_percentile_get(&gatt_latency_client,
+							50),
+		       bt_gatt_latency_c_percentile_get(&gatt_latency_client,
+							99),
+		       gatt_latency_client.stats.max,
+		       llpm_latency.crc_errors);
+	}
+#else
 	/* Start sending the timestamp to its peer */
 	while (default_conn) {
 		u32_t time = k_cycle_get_32();
@@ -392,6 +420,7 @@ static void test_run(void)
 
 		memset(&llpm_latency, 0, sizeof(llpm_latency));
 	}
+#endif
 }
 
 void main(void)
@@ -21,35 +21,31 @@ static const struct bt_mesh_onoff_srv_handlers onoff_handlers = {
 	.get = led_get,
 };
 
+/* The LEDs are driven by the shared transition engine, moving between these
+ * levels. As long as the transition is in progress, the LED is on.
+ */
+#define LED_LEVEL_OFF 0
+#define LED_LEVEL_ON 100
+
 struct led_ctx {
 	struct bt_mesh_onoff_srv srv;
-	struct k_delayed_work work;
-	u32_t remaining;
+	struct bt_mesh_transition transition;
 	bool value;
 };
 
+static void led_step(struct bt_mesh_transition *transition, s32_t level,
+		     bool done);
+
 static struct led_ctx led_ctx[4] = {
 	[0 ... 3] = {
 		.srv = BT_MESH_ONOFF_SRV_INIT(&onoff_handlers),
+		.transition = { .step = led_step },
 	}
 };
 
-static void led_transition_start(struct led_ctx *led)
-{
-	int led_idx = led - &led_ctx[0];
-
-	/* As long as the transition is in progress, the onoff
-	 * state is "on":
-	 */
-	dk_set_led(led_idx, true);
-	k_delayed_work_submit(&led->work, K_MSEC(led->remaining));
-	led->remaining = 0;
-}
-
 static void led_status(struct led_ctx *led, struct bt_mesh_onoff_status *status)
 {
-	status->remaining_time =
-		k_delayed_work_remaining_get(&led->work) + led->remaining;
+	status->remaining_time = bt_mesh_transition_remaining(&led->transition);
 	status->target_on_off = led->value;
 	/* As long as the transition is in progress, the onoff state is "on": */
 	status->present_on_off = led->value || status->remaining_time;
@@ -67,14 +63,16 @@ static void led_set(struct bt_mesh_onoff_srv *srv, struct bt_mesh_msg_ctx *ctx,
 	}
 
 	led->value = set->on_off;
-	led->remaining = set->transition->time;
 
-	if (set->transition->delay > 0) {
-		k_delayed_work_submit(&led->work,
-				      K_MSEC(set->transition->delay));
-	} else if (set->transition->time > 0) {
-		led_transition_start(led);
+	if (set->transition->time > 0 || set->transition->delay > 0) {
+		bt_mesh_transition_start(&led->transition,
+					 set->on_off ? LED_LEVEL_OFF :
+						       LED_LEVEL_ON,
+					 set->on_off ? LED_LEVEL_ON :
+						       LED_LEVEL_OFF,
+					 set->transition);
 	} else {
+		bt_mesh_transition_stop(&led->transition);
 		dk_set_led(led_idx, set->on_off);
 	}
 
@@ -92,22 +90,25 @@ static void led_get(struct bt_mesh_onoff_srv *srv, struct bt_mesh_msg_ctx *ctx,
 	led_status(led, rsp);
 }
 
-static void led_work(struct k_work *work)
+static void led_step(struct bt_mesh_transition *transition, s32_t level,
+		     bool done)
 {
-	struct led_ctx *led = CONTAINER_OF(work, struct led_ctx, work.work);
+	struct led_ctx *led = CONTAINER_OF(transition, struct led_ctx,
+					   transition);
 	int led_idx = led - &led_ctx[0];
 
-	if (led->remaining) {
-		led_transition_start(led);
-	} else {
-		dk_set_led(led_idx, led->value);
+	if (!done) {
+		dk_set_led(led_idx, true);
+		return;
+	}
 
-		/* Publish the new value at the end of the transition */
-		struct bt_mesh_onoff_status status;
+	dk_set_led(led_idx, led->value);
 
-		led_status(led, &status);
-		bt_mesh_onoff_srv_pub(&led->srv, NULL, &status);
-	}
+	/* Publish the new value at the end of the transition */
+	struct bt_mesh_onoff_status status;
+
+	led_status(led, &status);
+	bt_mesh_onoff_srv_pub(&led->srv, NULL, &status);
 }
 
 /** Configuration server definition */
@@ -191,9 +192,5 @@ const struct bt_mesh_comp *model_handler_init(void)
 {
 	k_delayed_work_init(&attention_blink_work, attention_blink);
 
-	for (int i = 0; i < ARRAY_SIZE(led_ctx); ++i) {
-		k_delayed_work_init(&led_ctx[i].work, led_work);
-	}
-
 	return &comp;
 }
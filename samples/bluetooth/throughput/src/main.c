@@ -25,8 +25,16 @@
 #define DEVICE_NAME_LEN (sizeof(DEVICE_NAME) - 1)
 #define INTERVAL_MIN	0x140	/* 320 units, 400 ms */
 #define INTERVAL_MAX	0x140	/* 320 units, 400 ms */
+#define SUPERVISION_TIMEOUT 400 /* 4 s */
+#define UPDATE_TIMEOUT	K_SECONDS(5)
+#define READ_TIMEOUT	K_SECONDS(5)
 
 static volatile bool test_ready;
+static K_SEM_DEFINE(read_sem, 0, 1);
+static K_SEM_DEFINE(stream_sem, 0, 1);
+static K_SEM_DEFINE(update_sem, 0, 1);
+static struct bt_gatt_throughput_metrics peer_met;
+static u32_t stream_duration;
 static struct bt_conn *default_conn;
 static struct bt_gatt_throughput gatt_throughput;
 static struct bt_uuid *uuid128 = BT_UUID_THROUGHPUT;
@@ -275,12 +283,8 @@ static void disconnected(struct bt_conn *conn, u8_t reason)
 
 static u8_t throughput_read(const struct bt_gatt_throughput_metrics *met)
 {
-	printk("[peer] received %u bytes (%u KB)"
-	       " in %u GATT writes at %u bps\n",
-	       met->write_len, met->write_len / 1024, met->write_count,
-	       met->write_rate);
-
-	test_ready = true;
+	peer_met = *met;
+	k_sem_give(&read_sem);
 
 	return BT_GATT_ITER_STOP;
 }
@@ -310,12 +314,261 @@ static void throughput_send(const struct bt_gatt_throughput_metrics *met)
 		met->write_count, met->write_rate);
 }
 
+static void throughput_stream_request(struct bt_conn *conn, u32_t duration)
+{
+	stream_duration = duration;
+	k_sem_give(&stream_sem);
+}
+
 static const struct bt_gatt_throughput_cb throughput_cb = {
 	.data_read = throughput_read,
 	.data_received = throughput_received,
-	.data_send = throughput_send
+	.data_send = throughput_send,
+	.stream_request = throughput_stream_request,
+};
+
+static int peer_metrics_read(void)
+{
+	int err;
+
+	k_sem_reset(&read_sem);
+
+	err = bt_gatt_throughput_read(&gatt_throughput);
+	if (err) {
+		printk("GATT read failed (err %d)\n", err);
+		return err;
+	}
+
+	return k_sem_take(&read_sem, READ_TIMEOUT);
+}
+
+static void stream_run(void)
+{
+	static u8_t dummy[256];
+	u32_t len = MIN(bt_gatt_get_mtu(default_conn) - 3, sizeof(dummy));
+	s64_t end = k_uptime_get() + stream_duration;
+	int err;
+
+	/* reset peer metrics */
+	err = bt_gatt_throughput_notify(default_conn, dummy, 1);
+	if (err) {
+		printk("Notification stream not started (err %d)\n", err);
+		return;
+	}
+
+	while (k_uptime_get() < end) {
+		err = bt_gatt_throughput_notify(default_conn, dummy, len);
+		if (err) {
+			printk("GATT notification failed (err %d)\n", err);
+			break;
+		}
+	}
+}
+
+#if defined(CONFIG_THROUGHPUT_MATRIX)
+enum test_mode {
+	TEST_MODE_WRITE,
+	TEST_MODE_NOTIFY,
+	TEST_MODE_BIDIR,
+};
+
+static const char * const test_mode_str[] = {
+	[TEST_MODE_WRITE] = "write",
+	[TEST_MODE_NOTIFY] = "notify",
+	[TEST_MODE_BIDIR] = "bidir",
 };
 
+static const u8_t matrix_phy[] = { BT_GAP_LE_PHY_1M, BT_GAP_LE_PHY_2M };
+static const u16_t matrix_data_len[] = { 27, 251 };
+static const u16_t matrix_interval[] = { 6, 40, 320 };
+static const u16_t matrix_payload[] = { 20, 244 };
+
+static void phy_set(u8_t phy)
+{
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+	const struct bt_conn_le_phy_param param = {
+		.options = BT_CONN_LE_PHY_OPT_NONE,
+		.pref_tx_phy = phy,
+		.pref_rx_phy = phy,
+	};
+	int err;
+
+	k_sem_reset(&update_sem);
+
+	err = bt_conn_le_phy_update(default_conn, &param);
+	if (err) {
+		printk("PHY update failed (err %d)\n", err);
+		return;
+	}
+
+	k_sem_take(&update_sem, UPDATE_TIMEOUT);
+#endif
+}
+
+static void data_len_set(u16_t data_len)
+{
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+	const struct bt_conn_le_data_len_param param = {
+		.tx_max_len = data_len,
+		.tx_max_time = BT_GAP_DATA_TIME_MAX,
+	};
+	int err;
+
+	k_sem_reset(&update_sem);
+
+	err = bt_conn_le_data_len_update(default_conn, &param);
+	if (err) {
+		printk("Data length update failed (err %d)\n", err);
+		return;
+	}
+
+	/* No event is reported if the data length does not change. */
+	k_sem_take(&update_sem, UPDATE_TIMEOUT);
+#endif
+}
+
+static void interval_set(u16_t interval)
+{
+	struct bt_le_conn_param *param =
+		BT_LE_CONN_PARAM(interval, interval, 0, SUPERVISION_TIMEOUT);
+	int err;
+
+	k_sem_reset(&update_sem);
+
+	err = bt_conn_le_param_update(default_conn, param);
+	if (err) {
+		printk("Connection parameters update failed (err %d)\n", err);
+		return;
+	}
+
+	/* No event is reported if the parameters do not change. */
+	k_sem_take(&update_sem, UPDATE_TIMEOUT);
+}
+
+static int matrix_test_run(enum test_mode mode, u8_t phy, u16_t data_len,
+			   u16_t interval, u16_t payload)
+{
+	static u8_t dummy[256];
+	u32_t duration = CONFIG_THROUGHPUT_MATRIX_TEST_DURATION;
+	u32_t sent = 0;
+	s64_t stamp;
+	s64_t delta;
+	int err;
+
+	/* reset peer metrics */
+	err = bt_gatt_throughput_write(&gatt_throughput, dummy, 1);
+	if (err) {
+		return err;
+	}
+
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+	bt_gatt_throughput_latency_reset();
+#endif
+
+	if (mode != TEST_MODE_WRITE) {
+		err = bt_gatt_throughput_subscribe(&gatt_throughput);
+		if (!err) {
+			err = bt_gatt_throughput_stream_request(
+				&gatt_throughput, duration);
+		}
+		if (err) {
+			return err;
+		}
+	}
+
+	stamp = k_uptime_get();
+
+	if (mode == TEST_MODE_NOTIFY) {
+		k_sleep(K_MSEC(duration));
+	} else {
+		while (k_uptime_get() - stamp < duration) {
+			err = bt_gatt_throughput_write(&gatt_throughput,
+						       dummy, payload);
+			if (err) {
+				return err;
+			}
+			sent += payload;
+		}
+	}
+
+	delta = k_uptime_delta(&stamp);
+
+	/* Let the peer finish sending the packets in flight, which takes
+	 * a few connection intervals (1.25 ms units).
+	 */
+	k_sleep(K_MSEC(interval * 5 + 100));
+
+	err = peer_metrics_read();
+	if (err) {
+		return err;
+	}
+
+	printk("{\"mode\":\"%s\",\"phy\":%u,\"data_len\":%u,"
+	       "\"interval\":%u,\"payload\":%u,\"duration_ms\":%lld,"
+	       "\"tx_bytes\":%u,\"peer_rx_bytes\":%u,\"peer_rx_bps\":%u,"
+	       "\"rx_bytes\":%u,\"rx_bps\":%u",
+	       test_mode_str[mode], phy, data_len, interval, payload, delta,
+	       sent, peer_met.write_len, peer_met.write_rate,
+	       (mode != TEST_MODE_WRITE) ? gatt_throughput.notif_met.write_len : 0,
+	       (mode != TEST_MODE_WRITE) ? gatt_throughput.notif_met.write_rate : 0);
+
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+	struct bt_gatt_throughput_latency lat;
+
+	bt_gatt_throughput_latency_get(&lat);
+	printk(",\"tx_lat_count\":%u,\"tx_lat_p50_us\":%u,"
+	       "\"tx_lat_p90_us\":%u,\"tx_lat_p99_us\":%u,"
+	       "\"tx_lat_max_us\":%u",
+	       lat.count, lat.p50, lat.p90, lat.p99, lat.max);
+#endif
+
+	printk("}\n");
+
+	return 0;
+}
+
+static void matrix_run(void)
+{
+	int err;
+
+	printk("Running test matrix\n");
+
+	for (size_t p = 0; p < ARRAY_SIZE(matrix_phy); p++) {
+		phy_set(matrix_phy[p]);
+
+		for (size_t d = 0; d < ARRAY_SIZE(matrix_data_len); d++) {
+			data_len_set(matrix_data_len[d]);
+
+			for (size_t i = 0; i < ARRAY_SIZE(matrix_interval); i++) {
+				interval_set(matrix_interval[i]);
+
+				for (size_t l = 0; l < ARRAY_SIZE(matrix_payload); l++) {
+					for (size_t m = 0; m < ARRAY_SIZE(test_mode_str); m++) {
+						if (!default_conn) {
+							return;
+						}
+
+						err = matrix_test_run(m,
+							matrix_phy[p],
+							matrix_data_len[d],
+							matrix_interval[i],
+							matrix_payload[l]);
+						if (err) {
+							printk("Test failed (err %d)\n", err);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/* Restore the default connection interval. */
+	interval_set(INTERVAL_MIN);
+
+	printk("Test matrix done\n");
+}
+#endif /* CONFIG_THROUGHPUT_MATRIX */
+
 static void test_run(void)
 {
 	int err;
@@ -328,9 +581,21 @@ static void test_run(void)
 	static char dummy[256];
 
 
+#if defined(CONFIG_THROUGHPUT_MATRIX_AUTO_RUN)
+	test_ready = false;
+	matrix_run();
+	return;
+#endif
+
 	/* wait for user input to continue */
+#if defined(CONFIG_THROUGHPUT_MATRIX)
+	printk("Ready, press any key to start"
+	       " or type a to run the test matrix\n");
+#else
 	printk("Ready, press any key to start\n");
-	console_getchar();
+#endif
+
+	char key = console_getchar();
 
 	if (!test_ready) {
 		/* disconnected while blocking inside _getchar() */
@@ -339,6 +604,16 @@ static void test_run(void)
 
 	test_ready = false;
 
+#if defined(CONFIG_THROUGHPUT_MATRIX)
+	if (key == 'a') {
+		matrix_run();
+		test_ready = (default_conn != NULL);
+		return;
+	}
+#else
+	ARG_UNUSED(key);
+#endif
+
 	/* reset peer metrics */
 	err = bt_gatt_throughput_write(&gatt_throughput, dummy, 1);
 	if (err) {
@@ -369,22 +644,64 @@ static void test_run(void)
 	       data, data / 1024, delta, ((u64_t)data * 8 / delta));
 
 	/* read back char from peer */
-	err = bt_gatt_throughput_read(&gatt_throughput);
-	if (err) {
-		printk("GATT read failed (err %d)\n", err);
+	if (!peer_metrics_read()) {
+		printk("[peer] received %u bytes (%u KB)"
+		       " in %u GATT writes at %u bps\n",
+		       peer_met.write_len, peer_met.write_len / 1024,
+		       peer_met.write_count, peer_met.write_rate);
 	}
+
+	test_ready = true;
 }
 
+
 static bool le_param_req(struct bt_conn *conn, struct bt_le_conn_param *param)
 {
 	/* reject peer conn param request */
 	return false;
 }
 
+static void le_param_updated(struct bt_conn *conn, u16_t interval,
+			     u16_t latency, u16_t timeout)
+{
+	printk("Conn. interval is %u units\n", interval);
+	k_sem_give(&update_sem);
+}
+
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+static void le_phy_updated(struct bt_conn *conn,
+			   struct bt_conn_le_phy_info *param)
+{
+	printk("PHY updated, TX PHY %u, RX PHY %u\n",
+	       param->tx_phy, param->rx_phy);
+	k_sem_give(&update_sem);
+}
+#endif
+
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+static void le_data_len_updated(struct bt_conn *conn,
+				struct bt_conn_le_data_len_info *info)
+{
+	printk("Data length updated, TX %u bytes, RX %u bytes\n",
+	       info->tx_max_len, info->rx_max_len);
+	k_sem_give(&update_sem);
+}
+#endif
+
 static void device_role_select(void)
 {
 	char role;
 
+	if (IS_ENABLED(CONFIG_THROUGHPUT_ROLE_SLAVE)) {
+		printk("Slave role. Starting advertising\n");
+		adv_start();
+		return;
+	} else if (IS_ENABLED(CONFIG_THROUGHPUT_ROLE_MASTER)) {
+		printk("Master role. Starting scanning\n");
+		scan_start();
+		return;
+	}
+
 	while (true) {
 		printk("Choose device role - type s (slave role) or m (master role): ");
 
@@ -413,6 +730,13 @@ void main(void)
 	    .connected = connected,
 	    .disconnected = disconnected,
 	    .le_param_req = le_param_req,
+	    .le_param_updated = le_param_updated,
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+	    .le_phy_updated = le_phy_updated,
+#endif
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+	    .le_data_len_updated = le_data_len_updated,
+#endif
 	};
 
 	printk("Starting Bluetooth Throughput example\n");
@@ -442,6 +766,9 @@ void main(void)
 	for (;;) {
 		if (test_ready) {
 			test_run();
+		} else if (!k_sem_take(&stream_sem, K_MSEC(100))) {
+			/* Notification stream requested by the tester. */
+			stream_run();
 		}
 	}
 }
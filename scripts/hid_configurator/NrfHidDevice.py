@@ -26,6 +26,13 @@ OPT_MODULE_DEV_DESCR = 0x0
 POLL_INTERVAL_DEFAULT = 0.02
 POLL_RETRY_COUNT = 200
 
+# Stream frame data starts with a sequence number
+STREAM_HEADER_LEN = 1
+STREAM_DATA_LEN_MAX = EVENT_DATA_LEN_MAX - STREAM_HEADER_LEN
+STREAM_WINDOW_DEFAULT = 8
+STREAM_SEQ_MOD = 256
+STREAM_STALL_LIMIT = 50
+
 END_OF_TRANSFER_CHAR = '\n'
 
 
@@ -37,6 +44,7 @@ class ConfigStatus(IntEnum):
     REJECT             = 4
     WRITE_ERROR        = 5
     DISCONNECTED_ERROR = 6
+    STREAM             = 7
     FAULT              = 99
 
 class Response(object):
@@ -163,6 +171,111 @@ class NrfHidDevice():
 
         return report
 
+    @staticmethod
+    def _create_stream_report(recipient, event_id, seq, event_data):
+        """ Function creating a report which carries a single frame of
+            a configuration stream. """
+
+        assert isinstance(recipient, int)
+        assert isinstance(event_id, int)
+        assert isinstance(event_data, bytes)
+        assert len(event_data) <= STREAM_DATA_LEN_MAX
+
+        status = ConfigStatus.STREAM
+        report = struct.pack('<BHBBBB', REPORT_ID, recipient, event_id, status,
+                             STREAM_HEADER_LEN + len(event_data),
+                             seq % STREAM_SEQ_MOD)
+        report += event_data
+
+        assert len(report) <= REPORT_SIZE
+        report += b'\0' * (REPORT_SIZE - len(report))
+
+        return report
+
+    @staticmethod
+    def _get_stream_status(dev, recipient, event_id):
+        """ Function returning the next sequence number expected by
+            the device and the number of frames in flight. """
+
+        try:
+            response_raw = dev.get_feature_report(REPORT_ID, REPORT_SIZE)
+            response = Response.parse_response(response_raw)
+        except Exception:
+            response = None
+
+        if response is None:
+            logging.error('Invalid response')
+            return None
+
+        logging.debug('Parsed response: {}'.format(response))
+
+        if (response.recipient != recipient) or (response.event_id != event_id) or \
+           (response.data is None) or (len(response.data) < 2):
+            logging.error('Device does not support streaming')
+            return None
+
+        return response.data[0], response.data[1]
+
+    @staticmethod
+    def _stream_feature_reports(dev, recipient, event_id, chunks, window,
+                                poll_interval=POLL_INTERVAL_DEFAULT):
+        """ Function sending chunks as a configuration stream. The device
+            confirms the frames it accepted with the expected sequence
+            number. Frames that were dropped are sent again. """
+
+        acked = 0
+        sent = 0
+        stalls = 0
+
+        while acked < len(chunks):
+            while (sent < len(chunks)) and (sent - acked < window):
+                data = NrfHidDevice._create_stream_report(recipient, event_id,
+                                                          sent, chunks[sent])
+                try:
+                    dev.send_feature_report(data)
+                except Exception:
+                    # Device window is full or the frame was rejected.
+                    break
+                sent += 1
+
+            status = NrfHidDevice._get_stream_status(dev, recipient, event_id)
+            if status is None:
+                return False
+
+            next_seq, _ = status
+            accepted = (next_seq - acked) % STREAM_SEQ_MOD
+
+            if accepted > sent - acked:
+                logging.error('Unexpected stream sequence number')
+                return False
+
+            if accepted == 0:
+                stalls += 1
+                if stalls > STREAM_STALL_LIMIT:
+                    logging.error('Stream stalled')
+                    return False
+                time.sleep(poll_interval)
+            else:
+                stalls = 0
+
+            acked += accepted
+            # Go back to the first frame that was not accepted.
+            sent = acked
+
+        # Wait until the device processes all frames.
+        for _ in range(POLL_RETRY_COUNT):
+            status = NrfHidDevice._get_stream_status(dev, recipient, event_id)
+            if status is None:
+                return False
+
+            if status[1] == 0:
+                return True
+
+            time.sleep(poll_interval)
+
+        logging.error('Stream was not processed in time')
+        return False
+
     @staticmethod
     def _create_fetch_report(recipient, event_id):
         """ Function for creating a report which requests fetching of
@@ -410,3 +523,21 @@ class NrfHidDevice():
 
     def config_set(self, module_name, option_name, value, poll_interval=POLL_INTERVAL_DEFAULT):
         return self._config_operation(module_name, option_name, False, value, poll_interval)
+
+    def config_stream(self, module_name, option_name, chunks,
+                      window=STREAM_WINDOW_DEFAULT, poll_interval=POLL_INTERVAL_DEFAULT):
+        """ Set the option to each of the chunks in order, using
+            the configuration stream. Each chunk can hold up to
+            STREAM_DATA_LEN_MAX bytes. """
+        if not self.initialized():
+            print("Device not found")
+            return False
+
+        try:
+            event_id = NrfHidDevice._get_event_id(module_name, option_name, self.dev_config)
+        except KeyError:
+            print("No module: {} or option: {}".format(module_name, option_name))
+            return False
+
+        return NrfHidDevice._stream_feature_reports(self.dev_ptr, self.pid, event_id,
+                                                    chunks, window, poll_interval)
@@ -90,7 +90,7 @@ def perform_dfu(dev, args):
             print('Improper user input. Operation terminated.')
             return
 
-    success = dfu_transfer(dev, dfu_image, progress_bar)
+    success = dfu_transfer(dev, dfu_image, progress_bar, args.stream)
 
     if success:
         success = fwreboot(dev)
@@ -188,6 +188,9 @@ def parse_arguments():
         parser_dfu.add_argument('--autoconfirm',
                                 help='Automatically confirm user input',
                                 action='store_true')
+        parser_dfu.add_argument('--stream',
+                                help='Send image data using the configuration stream',
+                                action='store_true')
 
         sp_commands.add_parser('fwinfo', help='Obtain information about FW image')
         sp_commands.add_parser('fwreboot', help='Request FW reboot')
@@ -9,9 +9,11 @@ import os
 import time
 import logging
 
-from NrfHidDevice import EVENT_DATA_LEN_MAX
+from NrfHidDevice import EVENT_DATA_LEN_MAX, STREAM_DATA_LEN_MAX
 
 FLASH_PAGE_SIZE = 4096
+# Stream chunks must keep flash writes word aligned
+DFU_STREAM_CHUNK_SIZE = STREAM_DATA_LEN_MAX & ~3
 
 DFU_SYNC_RETRIES = 3
 DFU_SYNC_INTERVAL = 1
@@ -150,7 +152,7 @@ def dfu_sync_wait(dev, is_active):
     return dfu_info
 
 
-def dfu_transfer(dev, dfu_image, progress_callback):
+def dfu_transfer(dev, dfu_image, progress_callback, stream=False):
     img_length = os.stat(dfu_image).st_size
     dfu_info = dfu_sync_wait(dev, False)
 
@@ -177,7 +179,10 @@ def dfu_transfer(dev, dfu_image, progress_callback):
     img_file.seek(offset)
 
     try:
-        offset, success = send_chunk(dev, img_csum, img_file, img_length, offset, success, progress_callback)
+        if stream:
+            offset, success = send_chunk_stream(dev, img_csum, img_file, img_length, offset, success, progress_callback)
+        else:
+            offset, success = send_chunk(dev, img_csum, img_file, img_length, offset, success, progress_callback)
     except Exception:
         success = False
 
@@ -242,6 +247,47 @@ def send_chunk(dev, img_csum, img_file, img_length, offset, success, progress_ca
     return offset, success
 
 
+def send_chunk_stream(dev, img_csum, img_file, img_length, offset, success, progress_callback):
+    while offset < img_length:
+        # Sync DFU state before every flash page to ensure everything
+        # is all right.
+        success = False
+        dfu_info = dfu_sync(dev)
+
+        if dfu_info is None:
+            print('Lost communication with the device')
+            break
+        if dfu_info[0] == 0:
+            print('DFU interrupted by device')
+            break
+        if (dfu_info[1] != img_length) or (dfu_info[2] != img_csum) or (dfu_info[3] != offset):
+            print('Invalid sync information')
+            break
+
+        batch_len = FLASH_PAGE_SIZE - offset % FLASH_PAGE_SIZE
+        batch_data = img_file.read(batch_len)
+
+        if len(batch_data) == 0:
+            break
+
+        chunks = [batch_data[i:i + DFU_STREAM_CHUNK_SIZE]
+                  for i in range(0, len(batch_data), DFU_STREAM_CHUNK_SIZE)]
+
+        logging.debug('Stream DFU data: offset {}, size {}'.format(offset, len(batch_data)))
+
+        progress_callback(int(offset / img_length * 1000))
+
+        success = dev.config_stream('dfu', 'data', chunks)
+
+        if not success:
+            print('Lost communication with the device')
+            break
+
+        offset += len(batch_data)
+
+    return offset, success
+
+
 def get_dfu_operation_offset(dfu_image, dfu_info, img_csum):
     # Check if the previously interrupted DFU operation can be resumed.
     img_length = os.stat(dfu_image).st_size
@@ -15,6 +15,206 @@ static void bt_conn_ctx_mem_free(struct k_mem_slab *mem_slab, void **data)
 	*data = NULL;
 }
 
+#if defined(CONFIG_BT_CONN_CTX_INDEXED_LOOKUP)
+
+/* Set in the reference counter once the owner has freed the context. */
+#define CTX_REF_FREED BIT(31)
+#define CTX_REF_CNT(_ref) ((_ref) & ~CTX_REF_FREED)
+
+static struct bt_conn_ctx *ctx_by_conn(struct bt_conn_ctx_lib *ctx_lib,
+				       struct bt_conn *conn)
+{
+	u8_t id = bt_conn_index(conn);
+
+	__ASSERT_NO_MSG(id < bt_conn_ctx_count(ctx_lib));
+
+	return &ctx_lib->ctx[id];
+}
+
+static size_t ctx_block_id(struct bt_conn_ctx_lib *ctx_lib, void *data)
+{
+	size_t offset = (u8_t *)data - (u8_t *)ctx_lib->mem_slab->buffer;
+
+	__ASSERT_NO_MSG(offset % ctx_lib->mem_slab->block_size == 0);
+
+	return offset / ctx_lib->mem_slab->block_size;
+}
+
+static bool ctx_ref_get(struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref;
+
+	do {
+		ref = atomic_get(&ctx->ref);
+		if ((ref == 0) || (ref & CTX_REF_FREED)) {
+			return false;
+		}
+	} while (!atomic_cas(&ctx->ref, ref, ref + 1));
+
+	return true;
+}
+
+static void ctx_ref_put(struct bt_conn_ctx_lib *ctx_lib,
+			struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref = atomic_dec(&ctx->ref) - 1;
+
+	if (CTX_REF_CNT(ref) == 0) {
+		/* Only a freed context can lose its last reference, as the
+		 * owner reference is dropped by bt_conn_ctx_free.
+		 */
+		__ASSERT_NO_MSG(ref & CTX_REF_FREED);
+
+		bt_conn_ctx_mem_free(ctx_lib->mem_slab, &ctx->data);
+		ctx->conn = NULL;
+		atomic_set(&ctx->ref, 0);
+	}
+}
+
+static int ctx_owner_put(struct bt_conn_ctx_lib *ctx_lib,
+			 struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref;
+
+	do {
+		ref = atomic_get(&ctx->ref);
+		if ((ref == 0) || (ref & CTX_REF_FREED)) {
+			return -EINVAL;
+		}
+	} while (!atomic_cas(&ctx->ref, ref, ref | CTX_REF_FREED));
+
+	ctx_ref_put(ctx_lib, ctx);
+
+	return 0;
+}
+
+void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+{
+	__ASSERT_NO_MSG(conn != NULL);
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+
+	int err;
+	struct bt_conn_ctx *ctx = ctx_by_conn(ctx_lib, conn);
+
+	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+
+	if (atomic_get(&ctx->ref) != 0) {
+		k_mutex_unlock(ctx_lib->mutex);
+		LOG_WRN("Context for the connection is still in use");
+		return NULL;
+	}
+
+	err = k_mem_slab_alloc(ctx_lib->mem_slab, &ctx->data, K_NO_WAIT);
+	if (err) {
+		k_mutex_unlock(ctx_lib->mutex);
+		LOG_WRN("Memory can not be allocated");
+		return NULL;
+	}
+
+	ctx->conn = conn;
+	ctx_lib->block_slot[ctx_block_id(ctx_lib, ctx->data)] =
+		ctx - ctx_lib->ctx;
+
+	/* One reference for the owner and one for the caller, which has to
+	 * call bt_conn_ctx_release when done.
+	 */
+	atomic_set(&ctx->ref, 2);
+
+	k_mutex_unlock(ctx_lib->mutex);
+
+	LOG_DBG("The memory for the connection context has been allocated, "
+		"conn %p, index: %u", conn, bt_conn_index(conn));
+
+	return ctx->data;
+}
+
+int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+{
+	__ASSERT_NO_MSG(conn != NULL);
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+
+	int err = -EINVAL;
+	struct bt_conn_ctx *ctx = ctx_by_conn(ctx_lib, conn);
+
+	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+
+	if (ctx->conn == conn) {
+		err = ctx_owner_put(ctx_lib, ctx);
+	}
+
+	k_mutex_unlock(ctx_lib->mutex);
+
+	if (err) {
+		LOG_WRN("There is no allocated memory for this connection");
+	} else {
+		LOG_DBG("The context memory for the connection "
+			"has been released, conn %p", conn);
+	}
+
+	return err;
+}
+
+void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib)
+{
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+
+	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		(void)ctx_owner_put(ctx_lib, &ctx_lib->ctx[i]);
+	}
+
+	k_mutex_unlock(ctx_lib->mutex);
+
+	LOG_DBG("All allocated memory has been released");
+}
+
+void *bt_conn_ctx_get(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+{
+	__ASSERT_NO_MSG(conn != NULL);
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+
+	struct bt_conn_ctx *ctx = ctx_by_conn(ctx_lib, conn);
+
+	if (!ctx_ref_get(ctx)) {
+		LOG_WRN("No memory block for connection");
+		return NULL;
+	}
+
+	if (ctx->conn != conn) {
+		ctx_ref_put(ctx_lib, ctx);
+		LOG_WRN("No memory block for connection");
+		return NULL;
+	}
+
+	return ctx->data;
+}
+
+const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib, u8_t id)
+{
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+	__ASSERT_NO_MSG(id < bt_conn_ctx_count(ctx_lib));
+
+	struct bt_conn_ctx *ctx = &ctx_lib->ctx[id];
+
+	return ctx_ref_get(ctx) ? ctx : NULL;
+}
+
+void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
+{
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+	__ASSERT_NO_MSG(ctx_data != NULL);
+
+	u8_t id = ctx_lib->block_slot[ctx_block_id(ctx_lib, ctx_data)];
+	struct bt_conn_ctx *ctx = &ctx_lib->ctx[id];
+
+	__ASSERT_NO_MSG(ctx->data == ctx_data);
+
+	ctx_ref_put(ctx_lib, ctx);
+}
+
+#else
+
 void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
@@ -165,3 +365,5 @@ void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
 
 	__ASSERT_NO_MSG(false);
 }
+
+#endif /* CONFIG_BT_CONN_CTX_INDEXED_LOOKUP */
@@ -8,6 +8,7 @@
 #include <bluetooth/enocean.h>
 #include <settings/settings.h>
 #include <sys/byteorder.h>
+#include <sys/crc.h>
 #include <bluetooth/hci.h>
 #include <bluetooth/crypto.h>
 
@@ -17,6 +18,8 @@
 
 #define SIGNATURE_LEN 4
 #define SETTINGS_TAG_SIZE 17
+#define AD_LEN_MAX 31
+#define HASH_SIZE CONFIG_BT_ENOCEAN_DEVICES_MAX
 
 #define DATA_TYPE_COMMISSIONING 0x3e
 #define DATA_TYPE_LIGHT_LEVEL_SENSOR 0x05
@@ -45,17 +48,81 @@ enum entry_tag {
 	ENTRY_TAG_SEQ = 's',
 };
 
+enum rx_type {
+	RX_TYPE_SWITCH,
+	RX_TYPE_SENSOR,
+};
+
+/** Received packet, waiting for authentication. */
+struct rx_entry {
+	struct bt_enocean_device *dev;
+	s8_t rssi;
+	u8_t type;
+	u8_t len;
+	u8_t data[AD_LEN_MAX];
+};
+
 static struct bt_enocean_device devices[CONFIG_BT_ENOCEAN_DEVICES_MAX];
 static const struct bt_enocean_callbacks *cb;
 static struct k_delayed_work work;
+static struct k_work rx_work;
 static bool commissioning;
 
+/* Device lookup table, hashed on the device address. Each entry holds the
+ * index of a device plus one, so that 0 is an empty entry.
+ */
+static u16_t hash_heads[HASH_SIZE];
+static u16_t hash_next[CONFIG_BT_ENOCEAN_DEVICES_MAX];
+
+/* Most recent packet put in the RX queue for each device. The packet is
+ * identified by its sequence number and a checksum of its contents, so that
+ * an unauthenticated packet reusing the next sequence number can't cause the
+ * genuine packet to be dropped.
+ */
+static struct {
+	u32_t seq;
+	u32_t crc;
+} queued[CONFIG_BT_ENOCEAN_DEVICES_MAX];
+
+K_MSGQ_DEFINE(rx_queue, sizeof(struct rx_entry),
+	      CONFIG_BT_ENOCEAN_RX_QUEUE_SIZE, 4);
+
+static u16_t *hash_bucket(const bt_addr_le_t *addr)
+{
+	/* The lower address bytes are unique for each EnOcean device: */
+	return &hash_heads[sys_get_le32(addr->a.val) % HASH_SIZE];
+}
+
+static void hash_add(struct bt_enocean_device *dev)
+{
+	u16_t *head = hash_bucket(&dev->addr);
+	int index = dev - &devices[0];
+
+	hash_next[index] = *head;
+	*head = index + 1;
+}
+
+static void hash_remove(struct bt_enocean_device *dev)
+{
+	u16_t *entry = hash_bucket(&dev->addr);
+	int index = dev - &devices[0];
+
+	while (*entry) {
+		if (*entry == index + 1) {
+			*entry = hash_next[index];
+			return;
+		}
+
+		entry = &hash_next[*entry - 1];
+	}
+}
+
 static struct bt_enocean_device *device_find(const bt_addr_le_t *addr)
 {
-	for (int i = 0; i < ARRAY_SIZE(devices); ++i) {
-		if ((devices[i].flags & FLAG_ACTIVE) &&
-		    !bt_addr_le_cmp(addr, &devices[i].addr)) {
-			return &devices[i];
+	for (u16_t entry = *hash_bucket(addr); entry;
+	     entry = hash_next[entry - 1]) {
+		if (!bt_addr_le_cmp(addr, &devices[entry - 1].addr)) {
+			return &devices[entry - 1];
 		}
 	}
 
@@ -71,7 +138,10 @@ static struct bt_enocean_device *device_alloc(const bt_addr_le_t *addr,
 			bt_addr_le_copy(&devices[i].addr, addr);
 			devices[i].seq = seq;
 			memcpy(devices[i].key, key, sizeof(devices[i].key));
+			memset(&devices[i].stats, 0, sizeof(devices[i].stats));
 			devices[i].flags = 0;
+			queued[i].seq = 0;
+			queued[i].crc = 0;
 			return &devices[i];
 		}
 	}
@@ -156,23 +226,14 @@ static int handle_switch_commissioning(const struct bt_le_scan_recv_info *info,
 	return bt_enocean_commission(info->addr, key, seq);
 }
 
-static void handle_switch_data(const struct bt_le_scan_recv_info *info,
+static void handle_switch_data(struct bt_enocean_device *dev, s8_t rssi,
 			       struct net_buf_simple *buf, const u8_t *payload)
 {
-	if (!cb->button) {
-		return;
-	}
-
-	struct bt_enocean_device *dev = device_find(info->addr);
 	int err;
-
-	if (!dev) {
-		return;
-	}
-
 	u32_t seq = net_buf_simple_pull_le32(buf);
 
 	if (seq <= dev->seq) {
+		atomic_inc(&dev->stats.duplicates);
 		return;
 	}
 
@@ -204,12 +265,14 @@ static void handle_switch_data(const struct bt_le_scan_recv_info *info,
 	err = auth(dev, seq, signature, payload, 9 + opt_data_len);
 	if (err) {
 		BT_ERR("Auth failed: %d", err);
+		dev->stats.auth_failures++;
 		return;
 	}
 
 	dev->seq = seq;
-	dev->rssi = info->rssi;
+	dev->rssi = rssi;
 	dev->flags |= FLAG_DIRTY;
+	dev->stats.rx++;
 	schedule_store();
 
 	enum bt_enocean_button_action action = status & BIT(0);
@@ -262,33 +325,18 @@ static void data_entry_pull(struct net_buf_simple *buf,
 	}
 }
 
-static void handle_sensor_data(const struct bt_le_scan_recv_info *info,
+static void handle_sensor_data(struct bt_enocean_device *dev, s8_t rssi,
 			       struct net_buf_simple *buf, const u8_t *payload,
 			       u8_t tot_len)
 {
-	if (!cb->sensor) {
-		return;
-	}
-
-	struct bt_enocean_device *dev;
 	struct data_entry entry;
 	u32_t seq;
 	int err;
 
 	seq = net_buf_simple_pull_le32(buf);
 
-	dev = device_find(info->addr);
-	if (!dev) {
-		data_entry_pull(buf, &entry);
-		if (entry.type != DATA_TYPE_COMMISSIONING || !commissioning) {
-			return;
-		}
-
-		bt_enocean_commission(info->addr, entry.pointer, seq);
-		return;
-	}
-
 	if (seq <= dev->seq) {
+		atomic_inc(&dev->stats.duplicates);
 		return;
 	}
 
@@ -355,17 +403,111 @@ static void handle_sensor_data(const struct bt_le_scan_recv_info *info,
 	err = auth(dev, seq, signature, payload, tot_len);
 	if (err) {
 		BT_ERR("Auth failed: %d", err);
+		dev->stats.auth_failures++;
 		return;
 	}
 
 	dev->seq = seq;
-	dev->rssi = info->rssi;
+	dev->rssi = rssi;
 	dev->flags |= FLAG_DIRTY;
+	dev->stats.rx++;
 	schedule_store();
 
 	cb->sensor(dev, &data, opt_data, opt_data_len);
 }
 
+static void sensor_commissioning(const struct bt_le_scan_recv_info *info,
+				 struct net_buf_simple *buf)
+{
+	struct data_entry entry;
+	u32_t seq;
+
+	seq = net_buf_simple_pull_le32(buf);
+
+	data_entry_pull(buf, &entry);
+	if (entry.type != DATA_TYPE_COMMISSIONING || !commissioning) {
+		return;
+	}
+
+	bt_enocean_commission(info->addr, entry.pointer, seq);
+}
+
+/* Authentication and parsing is deferred to the RX work, so that bursts of
+ * packets don't hold up the scanner. Repeated packets are dropped before
+ * they're queued, so each packet is only authenticated once.
+ */
+static void rx_enqueue(struct bt_enocean_device *dev,
+		       const struct bt_le_scan_recv_info *info,
+		       const u8_t *payload, enum rx_type type)
+{
+	int index = dev - &devices[0];
+	struct rx_entry entry;
+	u32_t seq;
+	u32_t crc;
+
+	if (type == RX_TYPE_SWITCH ? !cb->button : !cb->sensor) {
+		return;
+	}
+
+	/* Length, type and manufacturer ID precede the sequence number: */
+	seq = sys_get_le32(&payload[4]);
+	if (seq <= dev->seq) {
+		atomic_inc(&dev->stats.duplicates);
+		return;
+	}
+
+	entry.len = payload[0] + 1;
+	crc = crc32_ieee(payload, entry.len);
+	if (seq == queued[index].seq && crc == queued[index].crc) {
+		atomic_inc(&dev->stats.duplicates);
+		return;
+	}
+
+	entry.dev = dev;
+	entry.rssi = info->rssi;
+	entry.type = type;
+	memcpy(entry.data, payload, entry.len);
+
+	if (k_msgq_put(&rx_queue, &entry, K_NO_WAIT)) {
+		BT_DBG("RX queue full");
+		dev->stats.dropped++;
+		return;
+	}
+
+	queued[index].seq = seq;
+	queued[index].crc = crc;
+	k_work_submit(&rx_work);
+}
+
+static void rx_process(struct k_work *work)
+{
+	struct rx_entry entry;
+	struct net_buf_simple buf;
+
+	while (!k_msgq_get(&rx_queue, &entry, K_NO_WAIT)) {
+		/* The device may have been decommissioned while the packet
+		 * was waiting in the queue:
+		 */
+		if (!(entry.dev->flags & FLAG_ACTIVE)) {
+			continue;
+		}
+
+		net_buf_simple_init_with_data(&buf, entry.data, entry.len);
+
+		/* Skip length, type and manufacturer ID: */
+		net_buf_simple_pull(&buf, 4);
+
+		if (entry.type == RX_TYPE_SWITCH) {
+			handle_switch_data(entry.dev, entry.rssi, &buf,
+					   entry.data);
+		} else {
+			handle_sensor_data(entry.dev, entry.rssi, &buf,
+					   entry.data,
+					   entry.data[0] + 1 - SIGNATURE_LEN);
+		}
+	}
+}
+
 static void adv_recv(const struct bt_le_scan_recv_info *info,
 		     struct net_buf_simple *buf)
 {
@@ -399,6 +541,11 @@ static void adv_recv(const struct bt_le_scan_recv_info *info,
 		return;
 	}
 
+	/* Every format starts with a sequence number: */
+	if (len + 1 > AD_LEN_MAX || buf->len < len - 3 || buf->len < 4) {
+		return;
+	}
+
 	/* The data format is decided by a mix of lengths and bitfields */
 
 	if (has_shortened_name) {
@@ -409,8 +556,13 @@ static void adv_recv(const struct bt_le_scan_recv_info *info,
 		return;
 	}
 
+	struct bt_enocean_device *dev = device_find(info->addr);
+
 	if (!(payload[8] & (BIT_MASK(3) << 5)) && len >= 12 && len <= 16) {
-		handle_switch_data(info, buf, payload);
+		if (dev) {
+			rx_enqueue(dev, info, payload, RX_TYPE_SWITCH);
+		}
+
 		return;
 	}
 
@@ -433,7 +585,12 @@ static void adv_recv(const struct bt_le_scan_recv_info *info,
 		net_buf_simple_restore(buf, &state);
 	}
 
-	handle_sensor_data(info, buf, payload, len + 1 - SIGNATURE_LEN);
+	if (!dev) {
+		sensor_commissioning(info, buf);
+		return;
+	}
+
+	rx_enqueue(dev, info, payload, RX_TYPE_SENSOR);
 }
 
 static void store_dirty(struct k_work *work)
@@ -489,9 +646,14 @@ static int settings_set(const char *key, size_t len, settings_read_cb read_cb,
 			return -EINVAL;
 		}
 
+		if (dev->flags & FLAG_ACTIVE) {
+			hash_remove(dev);
+		}
+
 		bt_addr_le_copy(&dev->addr, &entry.addr);
 		memcpy(dev->key, entry.key, sizeof(dev->key));
 		dev->flags |= FLAG_ACTIVE;
+		hash_add(dev);
 
 		BT_DBG("Loaded %s", bt_addr_le_str(&dev->addr));
 		return 0;
@@ -535,6 +697,8 @@ void bt_enocean_init(const struct bt_enocean_callbacks *callbacks)
 		k_delayed_work_init(&work, store_dirty);
 	}
 
+	k_work_init(&rx_work, rx_process);
+
 	cb = callbacks;
 
 	process_loaded_devs();
@@ -572,6 +736,7 @@ int bt_enocean_commission(const bt_addr_le_t *addr, const u8_t key[16],
 	}
 
 	dev->flags |= FLAG_ACTIVE;
+	hash_add(dev);
 
 	if (cb->commissioned) {
 		cb->commissioned(dev);
@@ -605,6 +770,10 @@ void bt_enocean_decommission(struct bt_enocean_device *dev)
 		settings_delete(name);
 	}
 
+	if (dev->flags & FLAG_ACTIVE) {
+		hash_remove(dev);
+	}
+
 	dev->flags = 0;
 }
 
@@ -14,6 +14,11 @@ LOG_MODULE_REGISTER(bt_gatt_pool, CONFIG_BT_GATT_POOL_LOG_LEVEL);
 struct svc_el_pool {
 	void *elements;
 	atomic_t *locks;
+	size_t size;
+#if CONFIG_BT_GATT_POOL_STATS != 0
+	atomic_t used;
+	atomic_t max_used;
+#endif
 };
 
 #if CONFIG_BT_GATT_UUID16_POOL_SIZE != 0
@@ -59,18 +64,22 @@ static ATOMIC_DEFINE(chrc_locks, ARRAY_SIZE(chrc_tab));
 static struct svc_el_pool uuid_16_pool = {
 	.elements = BT_UUID_16_TAB,
 	.locks = BT_UUID_16_LOCKS,
+	.size = CONFIG_BT_GATT_UUID16_POOL_SIZE,
 };
 static struct svc_el_pool uuid_32_pool = {
 	.elements = BT_UUID_32_TAB,
 	.locks = BT_UUID_32_LOCKS,
+	.size = CONFIG_BT_GATT_UUID32_POOL_SIZE,
 };
 static struct svc_el_pool uuid_128_pool = {
 	.elements = BT_UUID_128_TAB,
 	.locks = BT_UUID_128_LOCKS,
+	.size = CONFIG_BT_GATT_UUID128_POOL_SIZE,
 };
 static struct svc_el_pool chrc_pool = {
 	.elements = BT_GATT_CHRC_TAB,
 	.locks = BT_GATT_CHRC_LOCKS,
+	.size = CONFIG_BT_GATT_CHRC_POOL_SIZE,
 };
 
 static struct bt_uuid const * const uuid_primary = BT_UUID_GATT_PRIMARY;
@@ -88,25 +97,75 @@ static struct bt_uuid const * const uuid_ccc = BT_UUID_GATT_CCC;
 #define ADDR_2_INDEX(pool, el)                                                 \
 	((((u32_t)el) - ((u32_t)pool)) / (sizeof(pool[0])))
 
-static size_t free_element_find(struct svc_el_pool *el_pool, size_t el_cnt)
+static void pool_usage_inc(struct svc_el_pool *el_pool)
+{
+#if CONFIG_BT_GATT_POOL_STATS != 0
+	atomic_val_t used = atomic_inc(&el_pool->used) + 1;
+	atomic_val_t max_used = atomic_get(&el_pool->max_used);
+
+	while ((used > max_used) &&
+	       !atomic_cas(&el_pool->max_used, max_used, used)) {
+		max_used = atomic_get(&el_pool->max_used);
+	}
+#endif
+}
+
+static void pool_usage_dec(struct svc_el_pool *el_pool)
+{
+#if CONFIG_BT_GATT_POOL_STATS != 0
+	atomic_dec(&el_pool->used);
+#endif
+}
+
+/* Scan the lock mask one word at a time and only try to take bits that were
+ * seen as free. A lost race on a bit only reloads the current word, so the
+ * cost of an allocation is bounded by the number of mask words rather than
+ * by the number of elements already taken.
+ */
+static size_t free_element_find(struct svc_el_pool *el_pool)
 {
 	__ASSERT((el_pool->elements != NULL) && (el_pool->locks != NULL),
 		 "Pool uninitialized");
 
-	for (size_t i = 0; i < el_cnt; i++) {
-		if (!atomic_test_and_set_bit(el_pool->locks, i)) {
-			return i;
+	for (size_t base = 0; base < el_pool->size; base += ATOMIC_BITS) {
+		atomic_t *word = &el_pool->locks[base / ATOMIC_BITS];
+		u32_t free_mask = ~((u32_t)atomic_get(word));
+
+		while (free_mask) {
+			size_t i = base + find_lsb_set(free_mask) - 1;
+
+			if (i >= el_pool->size) {
+				/* Only padding bits are left in the last word. */
+				return el_pool->size;
+			}
+
+			if (!atomic_test_and_set_bit(el_pool->locks, i)) {
+				pool_usage_inc(el_pool);
+				return i;
+			}
+
+			free_mask = ~((u32_t)atomic_get(word));
 		}
 	}
-	return el_cnt;
+
+	return el_pool->size;
+}
+
+static void element_release(struct svc_el_pool *el_pool, size_t ind)
+{
+	__ASSERT(ind < el_pool->size, "Element index out of range");
+	__ASSERT(atomic_test_bit(el_pool->locks, ind),
+		 "Element is not allocated");
+
+	atomic_clear_bit(el_pool->locks, ind);
+	pool_usage_dec(el_pool);
 }
 
 static int uuid_16_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 {
-	size_t ind = free_element_find(uuid_pool,
-				       CONFIG_BT_GATT_UUID16_POOL_SIZE);
+	size_t ind = free_element_find(uuid_pool);
 
-	if (ind >= CONFIG_BT_GATT_UUID16_POOL_SIZE) {
+	if (ind >= uuid_pool->size) {
 		LOG_ERR("No more UUID16s in the pool!");
 		return -ENOMEM;
 	}
@@ -118,10 +177,9 @@ static int uuid_16_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 
 static int uuid_32_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 {
-	size_t ind = free_element_find(uuid_pool,
-				       CONFIG_BT_GATT_UUID32_POOL_SIZE);
+	size_t ind = free_element_find(uuid_pool);
 
-	if (ind >= CONFIG_BT_GATT_UUID32_POOL_SIZE) {
+	if (ind >= uuid_pool->size) {
 		LOG_ERR("No more UUID32s in the pool!");
 		return -ENOMEM;
 	}
@@ -133,10 +191,9 @@ static int uuid_32_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 
 static int uuid_128_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 {
-	size_t ind = free_element_find(uuid_pool,
-				       CONFIG_BT_GATT_UUID128_POOL_SIZE);
+	size_t ind = free_element_find(uuid_pool);
 
-	if (ind >= CONFIG_BT_GATT_UUID128_POOL_SIZE) {
+	if (ind >= uuid_pool->size) {
 		LOG_ERR("No more UUID128s in the pool!");
 		return -ENOMEM;
 	}
@@ -148,10 +205,9 @@ static int uuid_128_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 
 static int chrc_get(struct bt_gatt_chrc **chrc)
 {
-	size_t ind = free_element_find(&chrc_pool,
-				       CONFIG_BT_GATT_CHRC_POOL_SIZE);
+	size_t ind = free_element_find(&chrc_pool);
 
-	if (ind >= CONFIG_BT_GATT_CHRC_POOL_SIZE) {
+	if (ind >= chrc_pool.size) {
 		LOG_ERR("No more chrc descriptors in the pool!");
 		return -ENOMEM;
 	}
@@ -163,8 +219,9 @@ static int chrc_get(struct bt_gatt_chrc **chrc)
 static void chrc_release(struct bt_gatt_chrc const *chrc)
 {
 	EL_IN_POOL_VERIFY(BT_GATT_CHRC_TAB, chrc);
-	atomic_clear_bit(chrc_pool.locks,
-			 ADDR_2_INDEX(BT_GATT_CHRC_TAB, chrc));
+#if CONFIG_BT_GATT_CHRC_POOL_SIZE != 0
+	element_release(&chrc_pool, ADDR_2_INDEX(BT_GATT_CHRC_TAB, chrc));
+#endif
 }
 
 static int uuid_register(struct bt_uuid **dest_uuid,
@@ -210,24 +267,24 @@ static void uuid_unregister(struct bt_uuid const *uuid)
 	case BT_UUID_TYPE_16:
 		EL_IN_POOL_VERIFY(BT_UUID_16_TAB, uuid);
 #if CONFIG_BT_GATT_UUID16_POOL_SIZE != 0
-		atomic_clear_bit(uuid_16_pool.locks,
-				 ADDR_2_INDEX(BT_UUID_16_TAB, uuid));
+		element_release(&uuid_16_pool,
+				ADDR_2_INDEX(BT_UUID_16_TAB, uuid));
 #endif
 		break;
 
 	case BT_UUID_TYPE_32:
 		EL_IN_POOL_VERIFY(BT_UUID_32_TAB, uuid);
 #if CONFIG_BT_GATT_UUID32_POOL_SIZE != 0
-		atomic_clear_bit(uuid_32_pool.locks,
-				 ADDR_2_INDEX(BT_UUID_32_TAB, uuid));
+		element_release(&uuid_32_pool,
+				ADDR_2_INDEX(BT_UUID_32_TAB, uuid));
 #endif
 		break;
 
 	case BT_UUID_TYPE_128:
 		EL_IN_POOL_VERIFY(BT_UUID_128_TAB, uuid);
 #if CONFIG_BT_GATT_UUID128_POOL_SIZE != 0
-		atomic_clear_bit(uuid_128_pool.locks,
-				 ADDR_2_INDEX(BT_UUID_128_TAB, uuid));
+		element_release(&uuid_128_pool,
+				ADDR_2_INDEX(BT_UUID_128_TAB, uuid));
 #endif
 		break;
 
@@ -433,6 +490,24 @@ static size_t mask_print(atomic_t *mask, size_t mask_size)
 	return used_el_cnt;
 }
 
+static void usage_get(struct svc_el_pool *el_pool,
+		      struct bt_gatt_pool_usage *usage)
+{
+	usage->size = el_pool->size;
+	usage->used = atomic_get(&el_pool->used);
+	usage->max_used = atomic_get(&el_pool->max_used);
+}
+
+void bt_gatt_pool_stats_get(struct bt_gatt_pool_stats *stats)
+{
+	__ASSERT_NO_MSG(stats != NULL);
+
+	usage_get(&uuid_16_pool, &stats->uuid_16);
+	usage_get(&uuid_32_pool, &stats->uuid_32);
+	usage_get(&uuid_128_pool, &stats->uuid_128);
+	usage_get(&chrc_pool, &stats->chrc);
+}
+
 void bt_gatt_pool_stats_print(void)
 {
 	size_t used_el_cnt;
@@ -443,8 +518,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_UUID_16_LOCKS,
 				 ARRAY_SIZE(BT_UUID_16_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
-	       CONFIG_BT_GATT_UUID16_POOL_SIZE);
+	printk("\nPool element usage: %d out of %d, max %d\n\n",
+	       used_el_cnt, CONFIG_BT_GATT_UUID16_POOL_SIZE,
+	       (int)atomic_get(&uuid_16_pool.max_used));
 #endif
 
 #if CONFIG_BT_GATT_UUID32_POOL_SIZE != 0
@@ -453,8 +529,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_UUID_32_LOCKS,
 				 ARRAY_SIZE(BT_UUID_32_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
-	       CONFIG_BT_GATT_UUID32_POOL_SIZE);
+	printk("\nPool element usage: %d out of %d, max %d\n\n",
+	       used_el_cnt, CONFIG_BT_GATT_UUID32_POOL_SIZE,
+	       (int)atomic_get(&uuid_32_pool.max_used));
 #endif
 
 #if CONFIG_BT_GATT_UUID128_POOL_SIZE != 0
@@ -463,8 +540,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_UUID_128_LOCKS,
 				 ARRAY_SIZE(BT_UUID_128_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
-	       CONFIG_BT_GATT_UUID128_POOL_SIZE);
+	printk("\nPool element usage: %d out of %d, max %d\n\n",
+	       used_el_cnt, CONFIG_BT_GATT_UUID128_POOL_SIZE,
+	       (int)atomic_get(&uuid_128_pool.max_used));
 #endif
 
 #if CONFIG_BT_GATT_CHRC_POOL_SIZE != 0
@@ -473,8 +551,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_GATT_CHRC_LOCKS,
 				 ARRAY_SIZE(BT_GATT_CHRC_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
-	       CONFIG_BT_GATT_CHRC_POOL_SIZE);
+	printk("\nPool element usage: %d out of %d, max %d\n\n",
+	       used_el_cnt, CONFIG_BT_GATT_CHRC_POOL_SIZE,
+	       (int)atomic_get(&chrc_pool.max_used));
 #endif
 }
 #endif /* CONFIG_BT_GATT_POOL_STATS */
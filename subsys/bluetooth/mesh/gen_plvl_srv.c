@@ -18,12 +18,10 @@ struct bt_mesh_plvl_srv_settings_data {
 	bool is_on;
 } __packed;
 
-static int store_state(struct bt_mesh_plvl_srv *srv)
+static int store_state(struct bt_mesh_model_store_ctx *ctx)
 {
-	if (!IS_ENABLED(CONFIG_BT_SETTINGS)) {
-		return 0;
-	}
-
+	struct bt_mesh_plvl_srv *srv =
+		CONTAINER_OF(ctx, struct bt_mesh_plvl_srv, store);
 	struct bt_mesh_plvl_srv_settings_data data = {
 		.default_power = srv->default_power,
 		.last = srv->last,
@@ -149,7 +147,7 @@ static void change_lvl(struct bt_mesh_plvl_srv *srv,
 	srv->is_on = (set->power_lvl > 0);
 
 	if (state_change) {
-		store_state(srv);
+		model_store_schedule(&srv->store);
 	}
 
 	memset(status, 0, sizeof(*status));
@@ -256,7 +254,7 @@ static void set_default(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 			srv->handlers->default_update(srv, ctx, old, new);
 		}
 
-		store_state(srv);
+		model_store_schedule(&srv->store);
 	}
 
 	if (!ack) {
@@ -335,7 +333,7 @@ static void set_range(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 			srv->handlers->range_update(srv, ctx, &old, &new);
 		}
 
-		store_state(srv);
+		model_store_schedule(&srv->store);
 	}
 
 	if (!ack) {
@@ -584,6 +582,7 @@ static void bt_mesh_plvl_srv_reset(struct bt_mesh_model *mod)
 	srv->default_power = 0;
 	srv->last = UINT16_MAX;
 	srv->is_on = false;
+	model_store_cancel(&srv->store);
 }
 
 static int bt_mesh_plvl_srv_init(struct bt_mesh_model *mod)
@@ -591,6 +590,8 @@ static int bt_mesh_plvl_srv_init(struct bt_mesh_model *mod)
 	struct bt_mesh_plvl_srv *srv = mod->user_data;
 
 	srv->plvl_model = mod;
+	model_store_init(&srv->store, store_state,
+			 CONFIG_BT_MESH_MODEL_STORE_TIMEOUT);
 	bt_mesh_plvl_srv_reset(mod);
 	net_buf_simple_init(mod->pub->msg, 0);
 
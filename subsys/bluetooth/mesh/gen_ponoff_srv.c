@@ -17,13 +17,11 @@ struct ponoff_settings_data {
 	bool on_off;
 } __packed;
 
-static int store(struct bt_mesh_ponoff_srv *srv,
-		 const struct bt_mesh_onoff_status *onoff_status)
+static int store(struct bt_mesh_model_store_ctx *ctx)
 {
-	if (!IS_ENABLED(CONFIG_BT_SETTINGS)) {
-		return 0;
-	}
-
+	struct bt_mesh_ponoff_srv *srv =
+		CONTAINER_OF(ctx, struct bt_mesh_ponoff_srv, store);
+	struct bt_mesh_onoff_status onoff_status = { 0 };
 	struct ponoff_settings_data data;
 
 	data.on_power_up = (u8_t)srv->on_power_up;
@@ -36,9 +34,10 @@ static int store(struct bt_mesh_ponoff_srv *srv,
 		data.on_off = true;
 		break;
 	case BT_MESH_ON_POWER_UP_RESTORE:
-		data.on_off = onoff_status->remaining_time > 0 ?
-				      onoff_status->target_on_off :
-				      onoff_status->present_on_off;
+		srv->onoff.handlers->get(&srv->onoff, NULL, &onoff_status);
+		data.on_off = onoff_status.remaining_time > 0 ?
+				      onoff_status.target_on_off :
+				      onoff_status.present_on_off;
 		break;
 	default:
 		return -EINVAL;
@@ -88,11 +87,7 @@ static void set_on_power_up(struct bt_mesh_ponoff_srv *srv,
 		srv->update(srv, ctx, old, new);
 	}
 
-	struct bt_mesh_onoff_status onoff_status = { 0 };
-
-	srv->onoff.handlers->get(&srv->onoff, NULL, &onoff_status);
-
-	store(srv, &onoff_status);
+	model_store_schedule(&srv->store);
 }
 
 static void handle_set_msg(struct bt_mesh_model *model,
@@ -144,7 +139,7 @@ static void onoff_intercept_set(struct bt_mesh_onoff_srv *onoff_srv,
 	srv->onoff_handlers->set(onoff_srv, ctx, set, status);
 
 	if (srv->on_power_up == BT_MESH_ON_POWER_UP_RESTORE) {
-		store(srv, status);
+		model_store_schedule(&srv->store);
 	}
 }
 
@@ -180,6 +175,8 @@ static int bt_mesh_ponoff_srv_init(struct bt_mesh_model *model)
 	struct bt_mesh_ponoff_srv *srv = model->user_data;
 
 	srv->ponoff_model = model;
+	model_store_init(&srv->store, store,
+			 CONFIG_BT_MESH_MODEL_STORE_TIMEOUT);
 	net_buf_simple_init(model->pub->msg, 0);
 
 	if (IS_ENABLED(CONFIG_BT_MESH_MODEL_EXTENSIONS)) {
@@ -209,6 +206,7 @@ static void bt_mesh_ponoff_srv_reset(struct bt_mesh_model *model)
 	struct bt_mesh_ponoff_srv *srv = model->user_data;
 
 	srv->on_power_up = BT_MESH_ON_POWER_UP_OFF;
+	model_store_cancel(&srv->store);
 }
 
 #ifdef CONFIG_BT_SETTINGS
@@ -5,6 +5,7 @@
  */
 #include <bluetooth/mesh/gen_prop_srv.h>
 #include <sys/util.h>
+#include <sys/byteorder.h>
 #include <string.h>
 #include "gen_prop_internal.h"
 #include "model_utils.h"
@@ -27,6 +28,39 @@ BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_PROP_OP_MFR_PROPS_STATUS,
 		     BT_MESH_TX_SDU_MAX,
 	     "The property value must fit inside an application SDU.");
 
+static struct bt_mesh_prop_srv *prop_srv_get(struct bt_mesh_model *mod,
+					     u16_t model_id)
+{
+	struct bt_mesh_model *srv_mod =
+		bt_mesh_model_find(bt_mesh_model_elem(mod), model_id);
+
+	return srv_mod ? srv_mod->user_data : NULL;
+}
+
+static const struct bt_mesh_prop *
+prop_sorted(const struct bt_mesh_prop_srv *srv, u8_t pos)
+{
+	return &srv->properties[srv->cache.order[pos]];
+}
+
+/* Sort the property indices by Property ID, without touching the
+ * application's property array, as its order is used in storage.
+ */
+static void order_build(struct bt_mesh_prop_srv *srv)
+{
+	for (u8_t i = 0; i < srv->property_count; ++i) {
+		u16_t id = srv->properties[i].id;
+		u8_t pos = i;
+
+		while (pos > 0 && prop_sorted(srv, pos - 1)->id > id) {
+			srv->cache.order[pos] = srv->cache.order[pos - 1];
+			pos--;
+		}
+
+		srv->cache.order[pos] = i;
+	}
+}
+
 static struct bt_mesh_prop *prop_get(const struct bt_mesh_prop_srv *srv,
 				     u16_t id)
 {
@@ -34,18 +68,103 @@ static struct bt_mesh_prop *prop_get(const struct bt_mesh_prop_srv *srv,
 		return NULL;
 	}
 
-	struct bt_mesh_prop *prop;
+	u8_t lo = 0;
+	u8_t hi = srv->property_count;
+
+	while (lo < hi) {
+		u8_t mid = (lo + hi) / 2;
+		const struct bt_mesh_prop *prop = prop_sorted(srv, mid);
 
-	PROP_FOREACH(srv, prop)
-	{
 		if (prop->id == id) {
-			return prop;
+			return &srv->properties[srv->cache.order[mid]];
+		}
+
+		if (prop->id < id) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
 
 	return NULL;
 }
 
+static void list_add(struct bt_mesh_prop_srv *srv, u16_t id)
+{
+	sys_put_le16(id, &srv->cache.list[2 * srv->cache.list_count++]);
+}
+
+/* The User Property Server lists the properties of the Manufacturer and
+ * Admin Property Servers that are accessible to users, in ascending order.
+ */
+static void user_list_build(struct bt_mesh_prop_srv *srv)
+{
+	const struct bt_mesh_prop_srv *mfr = prop_srv_get(
+		srv->mod, BT_MESH_MODEL_ID_GEN_MANUFACTURER_PROP_SRV);
+	const struct bt_mesh_prop_srv *admin =
+		prop_srv_get(srv->mod, BT_MESH_MODEL_ID_GEN_ADMIN_PROP_SRV);
+	u8_t mfr_count = mfr ? mfr->property_count : 0;
+	u8_t admin_count = admin ? admin->property_count : 0;
+	u16_t prev_id = BT_MESH_PROP_ID_PROHIBITED;
+	u8_t m = 0;
+	u8_t a = 0;
+
+	srv->cache.list_count = 0;
+
+	while ((m < mfr_count || a < admin_count) &&
+	       srv->cache.list_count < CONFIG_BT_MESH_PROP_MAXCOUNT) {
+		const struct bt_mesh_prop *prop;
+
+		if (a == admin_count ||
+		    (m < mfr_count &&
+		     prop_sorted(mfr, m)->id <= prop_sorted(admin, a)->id)) {
+			prop = prop_sorted(mfr, m++);
+		} else {
+			prop = prop_sorted(admin, a++);
+		}
+
+		/* Properties owned by both servers are only listed once: */
+		if (prop->user_access == BT_MESH_PROP_ACCESS_PROHIBITED ||
+		    prop->id == prev_id) {
+			continue;
+		}
+
+		list_add(srv, prop->id);
+		prev_id = prop->id;
+	}
+
+	srv->cache.list_valid = true;
+}
+
+static void list_build(struct bt_mesh_prop_srv *srv)
+{
+	if (srv->mod->id == BT_MESH_MODEL_ID_GEN_USER_PROP_SRV) {
+		user_list_build(srv);
+		return;
+	}
+
+	srv->cache.list_count = 0;
+
+	for (u8_t i = 0; i < srv->property_count; ++i) {
+		list_add(srv, prop_sorted(srv, i)->id);
+	}
+
+	srv->cache.list_valid = true;
+}
+
+/* Invalidate the list of the User Property Server that exposes the
+ * properties of the given server.
+ */
+static void user_list_invalidate(const struct bt_mesh_prop_srv *srv)
+{
+	struct bt_mesh_prop_srv *user_srv =
+		prop_srv_get(srv->mod, BT_MESH_MODEL_ID_GEN_USER_PROP_SRV);
+
+	if (user_srv) {
+		user_srv->cache.list_valid = false;
+	}
+}
+
 static void store_props(const struct bt_mesh_prop_srv *srv)
 {
 	if (!IS_ENABLED(CONFIG_BT_SETTINGS)) {
@@ -76,24 +195,38 @@ static void set_user_access(const struct bt_mesh_prop_srv *srv,
 	prop->user_access = user_access;
 
 	if (old_access != user_access) {
+		user_list_invalidate(srv);
 		store_props(srv);
 	}
 }
 
-static void pub_list_build(const struct bt_mesh_prop_srv *srv,
+static void pub_list_build(struct bt_mesh_prop_srv *srv,
 			   struct net_buf_simple *buf, u16_t start_prop)
 {
+	u8_t lo = 0;
+	u8_t hi;
+
 	bt_mesh_model_msg_init(buf, op_get(BT_MESH_PROP_OP_PROPS_STATUS,
 					   srv_kind(srv->mod)));
 
-	struct bt_mesh_prop *prop;
+	if (!srv->cache.list_valid) {
+		list_build(srv);
+	}
+
+	/* Find the first listed property at or above the start property: */
+	hi = srv->cache.list_count;
+	while (lo < hi) {
+		u8_t mid = (lo + hi) / 2;
 
-	PROP_FOREACH(srv, prop)
-	{
-		if (prop->id >= start_prop) {
-			net_buf_simple_add_le16(buf, prop->id);
+		if (sys_get_le16(&srv->cache.list[2 * mid]) < start_prop) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
+
+	net_buf_simple_add_mem(buf, &srv->cache.list[2 * lo],
+			       2 * (srv->cache.list_count - lo));
 }
 
 /* Owner properties */
@@ -298,15 +431,6 @@ const struct bt_mesh_model_op _bt_mesh_prop_client_srv_op[] = {
 
 /* User properties */
 
-static struct bt_mesh_prop_srv *prop_srv_get(struct bt_mesh_model *user_srv_mod,
-					     u16_t model_id)
-{
-	struct bt_mesh_model *mod =
-		bt_mesh_model_find(bt_mesh_model_elem(user_srv_mod), model_id);
-
-	return mod ? mod->user_data : NULL;
-}
-
 static struct bt_mesh_prop *user_prop_get(struct bt_mesh_model *mod, u16_t id,
 					  struct bt_mesh_prop_srv **srv)
 {
@@ -337,38 +461,10 @@ static void handle_user_properties_get(struct bt_mesh_model *mod,
 		return;
 	}
 
-	BT_MESH_MODEL_BUF_DEFINE(rsp, BT_MESH_PROP_OP_PROPS_STATUS,
+	BT_MESH_MODEL_BUF_DEFINE(rsp, BT_MESH_PROP_OP_USER_PROPS_STATUS,
 				 BT_MESH_PROP_MSG_MAXLEN_PROPS_STATUS);
 
-	bt_mesh_model_msg_init(&rsp, BT_MESH_PROP_OP_USER_PROPS_STATUS);
-
-	const struct bt_mesh_prop_srv *srvs[] = {
-		prop_srv_get(mod, BT_MESH_MODEL_ID_GEN_MANUFACTURER_PROP_SRV),
-		prop_srv_get(mod, BT_MESH_MODEL_ID_GEN_ADMIN_PROP_SRV),
-	};
-
-	for (int i = 0; i < ARRAY_SIZE(srvs); ++i) {
-		if (!srvs[i]) {
-			continue;
-		}
-
-		struct bt_mesh_prop *prop;
-
-		PROP_FOREACH(srvs[i], prop)
-		{
-			if (net_buf_simple_tailroom(&rsp) < 6) {
-				break;
-			}
-
-			if (prop->user_access ==
-			    BT_MESH_PROP_ACCESS_PROHIBITED) {
-				continue;
-			}
-
-			net_buf_simple_add_le16(&rsp, prop->id);
-		}
-	}
-
+	pub_list_build(mod->user_data, &rsp, 0);
 	bt_mesh_model_send(mod, ctx, &rsp, NULL, NULL);
 }
 
@@ -515,7 +611,13 @@ static int bt_mesh_prop_srv_init(struct bt_mesh_model *mod)
 {
 	struct bt_mesh_prop_srv *srv = mod->user_data;
 
+	if (srv->property_count > CONFIG_BT_MESH_PROP_MAXCOUNT) {
+		return -ENOMEM;
+	}
+
 	srv->mod = mod;
+	srv->cache.list_valid = false;
+	order_build(srv);
 	net_buf_simple_init(mod->pub->msg, 0);
 
 	if (IS_ENABLED(CONFIG_BT_MESH_MODEL_EXTENSIONS) &&
@@ -558,6 +660,8 @@ static int bt_mesh_prop_srv_settings_set(struct bt_mesh_model *model,
 		srv->properties[i].user_access = entries[i];
 	}
 
+	user_list_invalidate(srv);
+
 	return 0;
 }
 #endif
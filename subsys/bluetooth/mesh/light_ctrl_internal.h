@@ -81,6 +81,99 @@ static inline int prop_decode(struct net_buf_simple *buf,
 	return sensor_ch_decode(buf, format, val);
 }
 
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
+/** Result of a single illuminance regulator step. */
+enum light_ctrl_reg_result {
+	/** The regulator output was updated. */
+	LIGHT_CTRL_REG_UPDATED,
+	/** The error is within the regulator's dead zone. */
+	LIGHT_CTRL_REG_STABLE,
+	/** The error has been within the dead zone long enough to suspend the
+	 *  regulator.
+	 */
+	LIGHT_CTRL_REG_IDLE,
+};
+
+/** @brief Get the illuminance regulator input.
+ *
+ *  @param[in] cfg     Regulator configuration.
+ *  @param[in] target  Target illuminance (in lux).
+ *  @param[in] ambient Measured ambient illuminance (in lux).
+ *
+ *  @return The error outside the regulator's dead zone, or 0 if the error is
+ *          within the dead zone.
+ */
+static inline s32_t
+light_ctrl_reg_input(const struct bt_mesh_light_ctrl_srv_reg_cfg *cfg,
+		     s32_t target, s32_t ambient)
+{
+	s32_t error = target - ambient;
+	/* Accuracy should be in percent and both up and down: */
+	s32_t accuracy = (cfg->accuracy * target) / (2 * 100);
+
+	if (error > accuracy) {
+		return error - accuracy;
+	}
+
+	if (error < -accuracy) {
+		return error + accuracy;
+	}
+
+	return 0;
+}
+
+/** @brief Run a single illuminance regulator step.
+ *
+ *  @param[in,out] reg     Regulator.
+ *  @param[in]     target  Target illuminance (in lux).
+ *  @param[in]     ambient Measured ambient illuminance (in lux).
+ *  @param[out]    output  Regulator output level, in linear representation.
+ *                         Only set if the output was updated.
+ *
+ *  @return The result of the regulator step.
+ */
+static inline enum light_ctrl_reg_result
+light_ctrl_reg_step(struct bt_mesh_light_ctrl_srv_reg *reg, s32_t target,
+		    s32_t ambient, u16_t *output)
+{
+	s32_t input = light_ctrl_reg_input(&reg->cfg, target, ambient);
+
+	if (!input) {
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_SUSPEND
+		reg->stable_time += CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_INTERVAL;
+		if (reg->stable_time >=
+		    CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_SUSPEND_TIMEOUT) {
+			return LIGHT_CTRL_REG_IDLE;
+		}
+#endif
+		return LIGHT_CTRL_REG_STABLE;
+	}
+
+	reg->stable_time = 0;
+	input = MAX(INT16_MIN, MIN(INT16_MAX, input));
+
+	if (input >= 0) {
+		s32_t p = input * reg->cfg.kpu;
+		s32_t i = ((s64_t)input *
+			   CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_INTERVAL *
+			   reg->cfg.kiu) / MSEC_PER_SEC;
+
+		reg->i = MIN(UINT16_MAX, reg->i + i);
+		*output = MIN(UINT16_MAX, reg->i + p);
+	} else {
+		s32_t p = input * reg->cfg.kpd;
+		s32_t i = ((s64_t)input *
+			   CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_INTERVAL *
+			   reg->cfg.kid) / MSEC_PER_SEC;
+
+		reg->i = MAX(0, reg->i + i);
+		*output = MAX(0, reg->i + p);
+	}
+
+	return LIGHT_CTRL_REG_UPDATED;
+}
+#endif /* CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG */
+
 #ifdef __cplusplus
 }
 #endif
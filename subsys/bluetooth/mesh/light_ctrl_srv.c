@@ -30,8 +30,7 @@ enum flags {
 	FLAG_ON_PENDING,
 	FLAG_OFF_PENDING,
 	FLAG_TRANSITION,
-	FLAG_STORE_CFG,
-	FLAG_STORE_STATE,
+	FLAG_REG_SUSPENDED,
 };
 
 enum stored_flags {
@@ -55,6 +54,8 @@ static void restart_timer(struct bt_mesh_light_ctrl_srv *srv, u32_t delay)
 static void reg_start(struct bt_mesh_light_ctrl_srv *srv)
 {
 #if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
+	atomic_clear_bit(&srv->flags, FLAG_REG_SUSPENDED);
+	srv->reg.stable_time = 0;
 	k_delayed_work_submit(&srv->reg.timer, K_MSEC(REG_INT));
 #endif
 }
@@ -70,22 +71,6 @@ static inline void from_centi_lux(u32_t centi_lux, struct sensor_value *lux)
 	lux->val2 = centi_lux % 10000L;
 }
 
-static void store(struct bt_mesh_light_ctrl_srv *srv, enum flags kind)
-{
-#if CONFIG_BT_SETTINGS
-	bool pending = atomic_test_bit(&srv->flags, FLAG_STORE_CFG) ||
-		       atomic_test_bit(&srv->flags, FLAG_STORE_STATE);
-
-	atomic_set_bit(&srv->flags, kind);
-
-	if (!pending) {
-		k_delayed_work_submit(
-			&srv->store_timer,
-			K_SECONDS(CONFIG_BT_MESH_LIGHT_CTRL_SRV_STORE_TIMEOUT));
-	}
-#endif
-}
-
 static bool is_enabled(const struct bt_mesh_light_ctrl_srv *srv)
 {
 	return atomic_test_bit(&srv->lightness->flags,
@@ -313,6 +298,40 @@ static void lux_get(struct bt_mesh_light_ctrl_srv *srv,
 #endif
 }
 
+static void reg_resume(struct bt_mesh_light_ctrl_srv *srv)
+{
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
+	if (is_enabled(srv) &&
+	    atomic_test_and_clear_bit(&srv->flags, FLAG_REG_SUSPENDED)) {
+		BT_DBG("Regulator resumed");
+		srv->reg.stable_time = 0;
+		/* React to the new input right away: */
+		k_delayed_work_submit(&srv->reg.timer, K_NO_WAIT);
+	}
+#endif
+}
+
+static void reg_ambient_update(struct bt_mesh_light_ctrl_srv *srv)
+{
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
+	struct sensor_value lux;
+
+	if (!atomic_test_bit(&srv->flags, FLAG_REG_SUSPENDED)) {
+		return;
+	}
+
+	/* The output is constant while the regulator is suspended. Stay
+	 * suspended as long as the reports are within the dead zone.
+	 */
+	lux_get(srv, &lux);
+
+	if (light_ctrl_reg_input(&srv->reg.cfg, lux.val1,
+				 srv->ambient_lux.val1)) {
+		reg_resume(srv);
+	}
+#endif
+}
+
 static void transition_start(struct bt_mesh_light_ctrl_srv *srv,
 			     enum bt_mesh_light_ctrl_srv_state state,
 			     u32_t fade_time)
@@ -325,6 +344,7 @@ static void transition_start(struct bt_mesh_light_ctrl_srv *srv,
 	atomic_set_bit(&srv->flags, FLAG_TRANSITION);
 	light_set(srv, srv->cfg.light[state], fade_time);
 	restart_timer(srv, fade_time);
+	reg_resume(srv);
 }
 
 static int turn_on(struct bt_mesh_light_ctrl_srv *srv,
@@ -353,7 +373,7 @@ static int turn_on(struct bt_mesh_light_ctrl_srv *srv,
 		if (prev_state == LIGHT_CTRL_STATE_STANDBY) {
 			atomic_set_bit(&srv->flags, FLAG_ON);
 			atomic_clear_bit(&srv->flags, FLAG_MANUAL);
-			store(srv, FLAG_STORE_STATE);
+			model_store_schedule(&srv->store_state);
 		}
 
 		transition_start(srv, LIGHT_CTRL_STATE_ON, fade_time);
@@ -375,7 +395,7 @@ static void turn_off_auto(struct bt_mesh_light_ctrl_srv *srv)
 			 srv->cfg.fade_standby_auto);
 
 	atomic_clear_bit(&srv->flags, FLAG_ON);
-	store(srv, FLAG_STORE_STATE);
+	model_store_schedule(&srv->store_state);
 	onoff_pub(srv, LIGHT_CTRL_STATE_PROLONG, true);
 }
 
@@ -398,7 +418,7 @@ static int turn_off(struct bt_mesh_light_ctrl_srv *srv,
 	if (prev_state != LIGHT_CTRL_STATE_STANDBY) {
 		transition_start(srv, LIGHT_CTRL_STATE_STANDBY, fade_time);
 		atomic_clear_bit(&srv->flags, FLAG_ON);
-		store(srv, FLAG_STORE_STATE);
+		model_store_schedule(&srv->store_state);
 		onoff_pub(srv, prev_state, pub_gen_onoff);
 	} else if (fade_time < remaining_fade_time(srv)) {
 		/* Replacing current transition with a manual transition if it's
@@ -459,39 +479,27 @@ static void reg_step(struct k_work *work)
 		return;
 	}
 
-	struct sensor_value raw_lux;
-
-	lux_get(srv, &raw_lux);
-
-	u32_t lux = raw_lux.val1;
-	u32_t ambient = srv->ambient_lux.val1;
-
-	s32_t error = lux - ambient;
-	/* Accuracy should be in percent and both up and down: */
-	u32_t accuracy = (srv->reg.cfg.accuracy * lux) / (2 * 100);
-	s16_t input;
+	struct sensor_value lux;
+	enum light_ctrl_reg_result result;
 	u16_t output;
 
-	if (error > accuracy) {
-		input = error - accuracy;
-	} else if (error < -accuracy) {
-		input = error + accuracy;
-	} else {
+	lux_get(srv, &lux);
+
+	result = light_ctrl_reg_step(&srv->reg, lux.val1,
+				     srv->ambient_lux.val1, &output);
+	if (result == LIGHT_CTRL_REG_IDLE &&
+	    !atomic_test_bit(&srv->flags, FLAG_TRANSITION)) {
+		/* The target is constant outside of transitions. Wait for
+		 * new input before running the next step.
+		 */
+		BT_DBG("Regulator suspended");
+		atomic_set_bit(&srv->flags, FLAG_REG_SUSPENDED);
 		return;
 	}
 
-	if (input >= 0) {
-		s32_t p = input * srv->reg.cfg.kpu;
-		s32_t i = (input * REG_INT * srv->reg.cfg.kiu) / MSEC_PER_SEC;
-
-		srv->reg.i = MIN(UINT16_MAX, srv->reg.i + i);
-		output = MIN(UINT16_MAX, srv->reg.i + p);
-	} else {
-		s32_t p = input * srv->reg.cfg.kpd;
-		s32_t i = (input * REG_INT * srv->reg.cfg.kid) / MSEC_PER_SEC;
-
-		srv->reg.i = MAX(0, srv->reg.i + i);
-		output = MAX(0, srv->reg.i + p);
+	if (result != LIGHT_CTRL_REG_UPDATED) {
+		k_delayed_work_submit(&srv->reg.timer, K_MSEC(REG_INT));
+		return;
 	}
 
 	/* The regulator output is always in linear format. We'll convert to
@@ -574,47 +582,41 @@ static void delayed_action_timeout(struct k_work *work)
 	}
 }
 
-#if CONFIG_BT_SETTINGS
-static void store_timeout(struct k_work *work)
+static int store_cfg(struct bt_mesh_model_store_ctx *ctx)
 {
-	struct bt_mesh_light_ctrl_srv *srv = CONTAINER_OF(
-		work, struct bt_mesh_light_ctrl_srv, store_timer.work);
-	int err;
-
-	if (atomic_test_and_clear_bit(&srv->flags, FLAG_STORE_CFG)) {
-		struct setup_srv_storage_data data = {
-			.cfg = srv->cfg,
+	struct bt_mesh_light_ctrl_srv *srv =
+		CONTAINER_OF(ctx, struct bt_mesh_light_ctrl_srv, store_cfg);
+	struct setup_srv_storage_data data = {
+		.cfg = srv->cfg,
 #if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
-			.reg_cfg = srv->reg.cfg,
+		.reg_cfg = srv->reg.cfg,
 #endif
-		};
+	};
 
-		err = bt_mesh_model_data_store(srv->setup_srv, false, &data,
-					       sizeof(data));
-		if (err) {
-			BT_ERR("Failed storing config: %d", err);
-		}
-	}
+	BT_DBG("");
 
-	if (atomic_test_and_clear_bit(&srv->flags, FLAG_STORE_STATE)) {
-		atomic_t data = 0;
+	return bt_mesh_model_data_store(srv->setup_srv, false, &data,
+					sizeof(data));
+}
 
-		atomic_set_bit_to(&data, STORED_FLAG_ENABLED, is_enabled(srv));
-		atomic_set_bit_to(&data, STORED_FLAG_ON,
-				  atomic_test_bit(&srv->flags, FLAG_ON));
-		atomic_set_bit_to(&data, STORED_FLAG_OCC_MODE,
-				  atomic_test_bit(&srv->flags, FLAG_OCC_MODE));
+static int store_state(struct bt_mesh_model_store_ctx *ctx)
+{
+	struct bt_mesh_light_ctrl_srv *srv =
+		CONTAINER_OF(ctx, struct bt_mesh_light_ctrl_srv, store_state);
+	atomic_t data = 0;
 
-		err = bt_mesh_model_data_store(srv->model, false, &data,
-					 sizeof(data));
-		if (err) {
-			BT_ERR("Failed storing state: %d", err);
-		}
-	}
+	atomic_set_bit_to(&data, STORED_FLAG_ENABLED, is_enabled(srv));
+	atomic_set_bit_to(&data, STORED_FLAG_ON,
+			  atomic_test_bit(&srv->flags, FLAG_ON));
+	atomic_set_bit_to(&data, STORED_FLAG_OCC_MODE,
+			  atomic_test_bit(&srv->flags, FLAG_OCC_MODE));
 
 	BT_DBG("");
+
+	return bt_mesh_model_data_store(srv->model, false, &data,
+					sizeof(data));
 }
-#endif
+
 /*******************************************************************************
  * Handlers
  ******************************************************************************/
@@ -737,7 +739,7 @@ static int om_set(struct bt_mesh_light_ctrl_srv *srv,
 	BT_DBG("%s", mode ? "on" : "off");
 
 	atomic_set_bit_to(&srv->flags, FLAG_OCC_MODE, mode);
-	store(srv, FLAG_STORE_STATE);
+	model_store_schedule(&srv->store_state);
 
 	return 0;
 }
@@ -899,6 +901,7 @@ static void handle_sensor_status(struct bt_mesh_model *mod,
 
 		if (id == BT_MESH_PROP_ID_PRESENT_AMB_LIGHT_LEVEL) {
 			srv->ambient_lux = value;
+			reg_ambient_update(srv);
 			continue;
 		}
 
@@ -1109,6 +1112,13 @@ static int prop_set(struct net_buf_simple *buf,
 		return -ENOENT;
 	}
 
+	model_store_schedule(&srv->store_cfg);
+
+	/* The new configuration might move the error out of the regulator's
+	 * dead zone:
+	 */
+	reg_resume(srv);
+
 	return 0;
 }
 
@@ -1254,9 +1264,12 @@ static int light_ctrl_srv_init(struct bt_mesh_model *mod)
 	k_delayed_work_init(&srv->timer, timeout);
 	k_delayed_work_init(&srv->action_delay, delayed_action_timeout);
 
-#if CONFIG_BT_SETTINGS
-	k_delayed_work_init(&srv->store_timer, store_timeout);
-#endif
+	model_store_init(&srv->store_state, store_state,
+			 CONFIG_BT_MESH_LIGHT_CTRL_SRV_STORE_TIMEOUT *
+				 MSEC_PER_SEC);
+	model_store_init(&srv->store_cfg, store_cfg,
+			 CONFIG_BT_MESH_LIGHT_CTRL_SRV_STORE_TIMEOUT *
+				 MSEC_PER_SEC);
 
 #if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
 	k_delayed_work_init(&srv->reg.timer, reg_step);
@@ -1317,11 +1330,11 @@ static int light_ctrl_srv_start(struct bt_mesh_model *mod)
 		 * restarts, we'll restore to On even though we were off in the
 		 * previous power cycle, unless we store the Off state here.
 		 */
-		store(srv, FLAG_STORE_STATE);
+		model_store_schedule(&srv->store_state);
 		break;
 	case BT_MESH_ON_POWER_UP_ON:
 		ctrl_disable(srv);
-		store(srv, FLAG_STORE_STATE);
+		model_store_schedule(&srv->store_state);
 		light_set(srv,
 			  (srv->lightness->default_light ?
 				   srv->lightness->default_light :
@@ -1347,10 +1360,18 @@ static int light_ctrl_srv_start(struct bt_mesh_model *mod)
 	return 0;
 }
 
+static void light_ctrl_srv_reset(struct bt_mesh_model *mod)
+{
+	struct bt_mesh_light_ctrl_srv *srv = mod->user_data;
+
+	model_store_cancel(&srv->store_state);
+}
+
 const struct bt_mesh_model_cb _bt_mesh_light_ctrl_srv_cb = {
 	.init = light_ctrl_srv_init,
 	.start = light_ctrl_srv_start,
 	.settings_set = light_ctrl_srv_settings_set,
+	.reset = light_ctrl_srv_reset,
 };
 
 static int lc_setup_srv_init(struct bt_mesh_model *mod)
@@ -1387,9 +1408,17 @@ static int lc_setup_srv_settings_set(struct bt_mesh_model *mod, size_t len_rd,
 	return 0;
 }
 
+static void lc_setup_srv_reset(struct bt_mesh_model *mod)
+{
+	struct bt_mesh_light_ctrl_srv *srv = mod->user_data;
+
+	model_store_cancel(&srv->store_cfg);
+}
+
 const struct bt_mesh_model_cb _bt_mesh_light_ctrl_setup_srv_cb = {
 	.init = lc_setup_srv_init,
 	.settings_set = lc_setup_srv_settings_set,
+	.reset = lc_setup_srv_reset,
 };
 
 int _bt_mesh_light_ctrl_srv_update(struct bt_mesh_model *mod)
@@ -1424,7 +1453,7 @@ int bt_mesh_light_ctrl_srv_enable(struct bt_mesh_light_ctrl_srv *srv)
 	}
 
 	ctrl_enable(srv);
-	store(srv, FLAG_STORE_STATE);
+	model_store_schedule(&srv->store_state);
 
 	return 0;
 }
@@ -1436,7 +1465,7 @@ int bt_mesh_light_ctrl_srv_disable(struct bt_mesh_light_ctrl_srv *srv)
 	}
 
 	ctrl_disable(srv);
-	store(srv, FLAG_STORE_STATE);
+	model_store_schedule(&srv->store_state);
 
 	return 0;
 }
@@ -27,12 +27,10 @@ struct bt_mesh_lightness_srv_settings_data {
 static const char *const repr_str[] = { "Actual", "Linear" };
 #endif
 
-static int store_state(struct bt_mesh_lightness_srv *srv)
+static int store_state(struct bt_mesh_model_store_ctx *ctx)
 {
-	if (!IS_ENABLED(CONFIG_BT_SETTINGS)) {
-		return 0;
-	}
-
+	struct bt_mesh_lightness_srv *srv =
+		CONTAINER_OF(ctx, struct bt_mesh_lightness_srv, store);
 	struct bt_mesh_lightness_srv_settings_data data = {
 		.default_light = srv->default_light,
 		.last = srv->last,
@@ -196,7 +194,7 @@ void lightness_srv_change_lvl(struct bt_mesh_lightness_srv *srv,
 	       set->transition->time);
 
 	if (state_change) {
-		store_state(srv);
+		model_store_schedule(&srv->store);
 	}
 
 	memset(status, 0, sizeof(*status));
@@ -332,7 +330,7 @@ static void set_default(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 			srv->handlers->default_update(srv, ctx, old, new);
 		}
 
-		store_state(srv);
+		model_store_schedule(&srv->store);
 	}
 
 	BT_DBG("%u", new);
@@ -413,7 +411,7 @@ static void set_range(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 			srv->handlers->range_update(srv, ctx, &old, &new);
 		}
 
-		store_state(srv);
+		model_store_schedule(&srv->store);
 	}
 
 	if (!ack) {
@@ -691,6 +689,7 @@ static void bt_mesh_lightness_srv_reset(struct bt_mesh_model *mod)
 	srv->default_light = 0;
 	srv->last = UINT16_MAX;
 	atomic_clear_bit(&srv->flags, LIGHTNESS_SRV_FLAG_IS_ON);
+	model_store_cancel(&srv->store);
 }
 
 static int bt_mesh_lightness_srv_init(struct bt_mesh_model *mod)
@@ -698,6 +697,8 @@ static int bt_mesh_lightness_srv_init(struct bt_mesh_model *mod)
 	struct bt_mesh_lightness_srv *srv = mod->user_data;
 
 	srv->lightness_model = mod;
+	model_store_init(&srv->store, store_state,
+			 CONFIG_BT_MESH_MODEL_STORE_TIMEOUT);
 	bt_mesh_lightness_srv_reset(mod);
 	net_buf_simple_init(mod->pub->msg, 0);
 
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <init.h>
+#include <bluetooth/mesh/models.h>
+#include "model_utils.h"
+
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG_MODEL)
+#define LOG_MODULE_NAME bt_mesh_model_store
+#include "common/log.h"
+
+#define STORE_FOR_EACH_SAFE(_list, _node, _tmp)                                \
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(_list, _node, _tmp, node)
+
+static struct k_delayed_work store_work;
+static sys_slist_t pending_list;
+static struct bt_mesh_model_store_stats stats;
+
+/* Protects the pending list, the pending state of each context and the
+ * statistics. The store callbacks may block, so they're called without it.
+ */
+static struct k_spinlock lock;
+
+/* Must be called with the lock held. */
+static void pending_remove(struct bt_mesh_model_store_ctx *ctx)
+{
+	sys_slist_find_and_remove(&pending_list, &ctx->node);
+	ctx->pending = false;
+}
+
+/* Take the first context that is due from the pending list, or any pending
+ * context if @p all is set.
+ */
+static struct bt_mesh_model_store_ctx *due_take(u32_t now, bool all)
+{
+	struct bt_mesh_model_store_ctx *ctx, *tmp;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	STORE_FOR_EACH_SAFE(&pending_list, ctx, tmp)
+	{
+		if (all || (s32_t)(ctx->due - now) <= 0) {
+			pending_remove(ctx);
+			stats.writes++;
+			k_spin_unlock(&lock, key);
+			return ctx;
+		}
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return NULL;
+}
+
+static void store_write(struct bt_mesh_model_store_ctx *ctx)
+{
+	int err;
+
+	err = ctx->store(ctx);
+	if (err) {
+		BT_ERR("Failed storing model state: %d", err);
+	}
+}
+
+/* Must be called with the lock held. */
+static void schedule(u32_t now)
+{
+	struct bt_mesh_model_store_ctx *ctx, *tmp;
+	s32_t next = INT32_MAX;
+
+	STORE_FOR_EACH_SAFE(&pending_list, ctx, tmp)
+	{
+		next = MIN(next, MAX(0, (s32_t)(ctx->due - now)));
+	}
+
+	if (next == INT32_MAX) {
+		k_delayed_work_cancel(&store_work);
+		return;
+	}
+
+	k_delayed_work_submit(&store_work, K_MSEC(next));
+}
+
+/* Write all states that are due in one pass, so that models changing together
+ * are stored together.
+ */
+static void store_timeout(struct k_work *work)
+{
+	struct bt_mesh_model_store_ctx *ctx;
+	u32_t now = k_uptime_get_32();
+	k_spinlock_key_t key;
+
+	/* A context that is scheduled again while its state is written
+	 * goes back on the pending list, and is written again later.
+	 */
+	while ((ctx = due_take(now, false))) {
+		store_write(ctx);
+	}
+
+	key = k_spin_lock(&lock);
+	schedule(now);
+	k_spin_unlock(&lock, key);
+}
+
+void model_store_init(struct bt_mesh_model_store_ctx *ctx,
+		      int (*store)(struct bt_mesh_model_store_ctx *ctx),
+		      u32_t timeout)
+{
+	ctx->store = store;
+	ctx->timeout = timeout;
+	ctx->pending = false;
+}
+
+void model_store_schedule(struct bt_mesh_model_store_ctx *ctx)
+{
+	u32_t now = k_uptime_get_32();
+	k_spinlock_key_t key;
+
+	if (!IS_ENABLED(CONFIG_BT_SETTINGS)) {
+		return;
+	}
+
+	key = k_spin_lock(&lock);
+
+	stats.requests++;
+
+	if (!ctx->pending) {
+		ctx->pending = true;
+		ctx->first = now;
+		sys_slist_append(&pending_list, &ctx->node);
+	}
+
+	/* Wait for the changes to settle, but don't let a continuous stream of
+	 * changes hold back the write forever:
+	 */
+	u32_t settled = now + ctx->timeout;
+	u32_t deadline = ctx->first + MAX(ctx->timeout,
+					  CONFIG_BT_MESH_MODEL_STORE_DEADLINE);
+
+	ctx->due = ((s32_t)(settled - deadline) < 0) ? settled : deadline;
+
+	BT_DBG("Store in %d ms", (s32_t)(ctx->due - now));
+
+	schedule(now);
+
+	k_spin_unlock(&lock, key);
+}
+
+void model_store_cancel(struct bt_mesh_model_store_ctx *ctx)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (ctx->pending) {
+		pending_remove(ctx);
+		schedule(k_uptime_get_32());
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+void bt_mesh_model_store_flush(void)
+{
+	struct bt_mesh_model_store_ctx *ctx;
+
+	k_delayed_work_cancel(&store_work);
+
+	while ((ctx = due_take(0, true))) {
+		store_write(ctx);
+	}
+}
+
+void bt_mesh_model_store_stats_get(struct bt_mesh_model_store_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*out = stats;
+
+	k_spin_unlock(&lock, key);
+}
+
+static int model_store_sys_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_delayed_work_init(&store_work, store_timeout);
+
+	return 0;
+}
+
+SYS_INIT(model_store_sys_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
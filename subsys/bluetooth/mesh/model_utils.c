@@ -148,6 +148,46 @@ int model_ackd_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 	return retval;
 }
 
+int model_ackd_send_multi(struct bt_mesh_model *mod,
+			  struct bt_mesh_msg_ctx *ctx,
+			  struct net_buf_simple *buf,
+			  struct bt_mesh_model_ack_ctx *ack, u32_t rsp_op,
+			  void *user_data, s32_t part_timeout)
+{
+	if (ack &&
+	    model_ack_ctx_prepare(ack, rsp_op, ctx ? ctx->addr : mod->pub->addr,
+				  user_data) != 0) {
+		return -EALREADY;
+	}
+
+	int retval = model_send(mod, ctx, buf);
+
+	if (!ack) {
+		return retval;
+	}
+
+	if (retval) {
+		model_ack_clear(ack);
+		return retval;
+	}
+
+	u8_t ttl = (ctx ? ctx->send_ttl : mod->pub->ttl);
+	s32_t time = (MOD_ACKD_TIMEOUT_BASE + ttl * MOD_ACKD_TIMEOUT_PER_HOP);
+
+	retval = k_sem_take(&ack->sem, K_MSEC(time));
+
+	/* The handler clears the opcode when the last part is received. */
+	while (retval == 0 && model_ack_busy(ack)) {
+		if (k_sem_take(&ack->sem, K_MSEC(part_timeout))) {
+			retval = -ETIMEDOUT;
+		}
+	}
+
+	model_ack_clear(ack);
+
+	return retval;
+}
+
 bool bt_mesh_model_pub_is_unicast(const struct bt_mesh_model *mod)
 {
 	return mod->pub && BT_MESH_ADDR_IS_UNICAST(mod->pub->addr);
@@ -67,6 +67,42 @@ int model_ackd_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 		    struct bt_mesh_model_ack_ctx *ack, u32_t rsp_op,
 		    void *user_data);
 
+/** @brief Send an acknowledged model message with a multi-part response.
+ *
+ * Works like @ref model_ackd_send, but keeps the response context open after
+ * the first response is received, to collect the following parts of the
+ * response. The response is complete when the message handler calls
+ * @ref model_ack_clear before releasing the response context, and fails if no
+ * new part is received within @c part_timeout milliseconds.
+ *
+ * @param mod Model to send the message on.
+ * @param ctx Message context, or NULL to send with the configured publish
+ * parameters.
+ * @param buf Message to send.
+ * @param ack Message response context, or NULL if no response is expected.
+ * @param rsp_op Expected response opcode.
+ * @param user_data User defined parameter.
+ * @param part_timeout Time to wait for the next part of the response in
+ * milliseconds.
+ *
+ * @retval 0 The message was sent successfully, and at least one part of the
+ * response was received.
+ * @retval -EALREADY A blocking request is already in progress.
+ * @retval -ENOTSUP A message context was not provided and publishing is not
+ * supported.
+ * @retval -EADDRNOTAVAIL A message context was not provided and publishing is
+ * not configured.
+ * @retval -EAGAIN The device has not been provisioned, or the request timed
+ * out without a response.
+ * @retval -ETIMEDOUT The response was incomplete, as the next part of the
+ * response wasn't received in time.
+ */
+int model_ackd_send_multi(struct bt_mesh_model *mod,
+			  struct bt_mesh_msg_ctx *ctx,
+			  struct net_buf_simple *buf,
+			  struct bt_mesh_model_ack_ctx *ack, u32_t rsp_op,
+			  void *user_data, s32_t part_timeout);
+
 static inline void model_ack_init(struct bt_mesh_model_ack_ctx *ack)
 {
 	k_sem_init(&ack->sem, 0, 1);
@@ -157,6 +193,35 @@ model_transition_is_active(const struct bt_mesh_model_transition *transition)
 	return (transition->time > 0 || transition->delay > 0);
 }
 
+/** @brief Initialize a deferred storage context.
+ *
+ * @param ctx Storage context.
+ * @param store Callback writing the current state of the model to persistent
+ * storage.
+ * @param timeout Time to wait for further changes before writing, in
+ * milliseconds.
+ */
+void model_store_init(struct bt_mesh_model_store_ctx *ctx,
+		      int (*store)(struct bt_mesh_model_store_ctx *ctx),
+		      u32_t timeout);
+
+/** @brief Schedule a write of the model state to persistent storage.
+ *
+ * The state is written when it hasn't changed for the storage context's
+ * timeout, or at the latest @c CONFIG_BT_MESH_MODEL_STORE_DEADLINE
+ * milliseconds after the first change since the previous write. All states
+ * that are due at the same time are written in the same pass.
+ *
+ * @param ctx Storage context.
+ */
+void model_store_schedule(struct bt_mesh_model_store_ctx *ctx);
+
+/** @brief Cancel a pending write of the model state.
+ *
+ * @param ctx Storage context.
+ */
+void model_store_cancel(struct bt_mesh_model_store_ctx *ctx);
+
 #endif /* MODEL_UTILS_H__ */
 
 /** @} */
@@ -176,6 +176,36 @@ int sensor_status_encode(struct net_buf_simple *buf,
 	return sensor_value_encode(buf, type, values);
 }
 
+int sensor_status_batch_add(struct net_buf_simple *buf,
+			    const struct bt_mesh_sensor *sensor,
+			    const struct sensor_value *values)
+{
+	struct net_buf_simple_state state;
+	int err;
+
+	net_buf_simple_save(buf, &state);
+
+	err = sensor_status_encode(buf, sensor, values);
+	if (!err && net_buf_simple_tailroom(buf) < BT_MESH_MIC_SHORT) {
+		err = -ENOMEM;
+	}
+
+	if (err) {
+		net_buf_simple_restore(buf, &state);
+	}
+
+	return err;
+}
+
+u32_t sensor_pub_min_int_remaining(const struct bt_mesh_sensor *sensor,
+				   u32_t now)
+{
+	u32_t elapsed = now - sensor->state.pub_time;
+	u32_t min_int = (1U << sensor->state.min_int);
+
+	return (elapsed < min_int) ? (min_int - elapsed) : 0;
+}
+
 const struct bt_mesh_sensor_format *
 bt_mesh_sensor_column_format_get(const struct bt_mesh_sensor_type *type)
 {
@@ -187,12 +217,36 @@ bt_mesh_sensor_column_format_get(const struct bt_mesh_sensor_type *type)
 	return &bt_mesh_sensor_format_time_decihour_8;
 }
 
-int sensor_column_encode(struct net_buf_simple *buf,
-			 struct bt_mesh_sensor *sensor,
-			 struct bt_mesh_msg_ctx *ctx,
-			 const struct bt_mesh_sensor_column *col)
+int sensor_series_values_get(
+	struct bt_mesh_sensor *sensor, struct bt_mesh_msg_ctx *ctx,
+	const struct bt_mesh_sensor_column **cols, u32_t count,
+	struct sensor_value (*values)[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX])
+{
+	if (sensor->series.get_batch) {
+		return sensor->series.get_batch(sensor, ctx, cols, count,
+						values);
+	}
+
+	if (!sensor->series.get) {
+		return -ENOTSUP;
+	}
+
+	for (u32_t i = 0; i < count; ++i) {
+		int err = sensor->series.get(sensor, ctx, cols[i], values[i]);
+
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int sensor_column_value_encode(struct net_buf_simple *buf,
+			       struct bt_mesh_sensor *sensor,
+			       const struct bt_mesh_sensor_column *col,
+			       const struct sensor_value *value)
 {
-	struct sensor_value values[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
 	const struct bt_mesh_sensor_format *col_format;
 	const u64_t width_million =
 		(col->end.val1 - col->start.val1) * 1000000L +
@@ -221,12 +275,23 @@ int sensor_column_encode(struct net_buf_simple *buf,
 		return err;
 	}
 
-	err = sensor->series.get(sensor, ctx, col, values);
+	return sensor_value_encode(buf, sensor->type, value);
+}
+
+int sensor_column_encode(struct net_buf_simple *buf,
+			 struct bt_mesh_sensor *sensor,
+			 struct bt_mesh_msg_ctx *ctx,
+			 const struct bt_mesh_sensor_column *col)
+{
+	struct sensor_value values[1][CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	int err;
+
+	err = sensor_series_values_get(sensor, ctx, &col, 1, values);
 	if (err) {
 		return err;
 	}
 
-	return sensor_value_encode(buf, sensor->type, values);
+	return sensor_column_value_encode(buf, sensor, col, values[0]);
 }
 
 int sensor_column_decode(
@@ -114,6 +114,32 @@ int sensor_status_encode(struct net_buf_simple *buf,
 			 const struct bt_mesh_sensor *sensor,
 			 const struct sensor_value *values);
 
+/** @brief Add a sensor value to a batched Sensor Status message.
+ *
+ *  The value is only added if it fits in the buffer together with the
+ *  transport MIC. The buffer is left untouched on failure.
+ *
+ *  @param buf    Sensor Status message buffer.
+ *  @param sensor Sensor to add the value of.
+ *  @param values Sensor channel values.
+ *
+ *  @retval 0       The value was added.
+ *  @retval -ENOMEM The value doesn't fit in the message.
+ */
+int sensor_status_batch_add(struct net_buf_simple *buf,
+			    const struct bt_mesh_sensor *sensor,
+			    const struct sensor_value *values);
+
+/** @brief Get the time left of the sensor's minimum publication interval.
+ *
+ *  @param sensor Sensor instance.
+ *  @param now    Current uptime, in milliseconds.
+ *
+ *  @return Number of milliseconds until the sensor may publish again.
+ */
+u32_t sensor_pub_min_int_remaining(const struct bt_mesh_sensor *sensor,
+				   u32_t now);
+
 int sensor_status_id_encode(struct net_buf_simple *buf, u8_t len, u16_t id);
 void sensor_status_id_decode(struct net_buf_simple *buf, u8_t *len, u16_t *id);
 
@@ -131,6 +157,14 @@ int sensor_ch_decode(struct net_buf_simple *buf,
 		     const struct bt_mesh_sensor_format *format,
 		     struct sensor_value *value);
 
+int sensor_series_values_get(
+	struct bt_mesh_sensor *sensor, struct bt_mesh_msg_ctx *ctx,
+	const struct bt_mesh_sensor_column **cols, u32_t count,
+	struct sensor_value (*values)[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX]);
+int sensor_column_value_encode(struct net_buf_simple *buf,
+			       struct bt_mesh_sensor *sensor,
+			       const struct bt_mesh_sensor_column *col,
+			       const struct sensor_value *value);
 int sensor_column_encode(struct net_buf_simple *buf,
 			 struct bt_mesh_sensor *sensor,
 			 struct bt_mesh_msg_ctx *ctx,
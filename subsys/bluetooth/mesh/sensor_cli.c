@@ -43,6 +43,8 @@ struct series_data_rsp {
 	const struct bt_mesh_sensor_column *col;
 	u16_t id;
 	u32_t count;
+	/* Number of entries received in all pages so far. */
+	u32_t received;
 };
 
 struct cadence_rsp {
@@ -292,7 +294,7 @@ static void handle_series_status(struct bt_mesh_model *mod,
 	}
 
 	if (model_ack_match(&cli->ack, BT_MESH_SENSOR_OP_SERIES_STATUS, ctx) &&
-	    rsp->id == id) {
+	    ((struct series_data_rsp *)cli->ack.user_data)->id == id) {
 		rsp = cli->ack.user_data;
 	}
 
@@ -301,14 +303,14 @@ static void handle_series_status(struct bt_mesh_model *mod,
 		BT_WARN("Received unsupported column format 0x%04x", id);
 
 		if (rsp) {
-			rsp->count = 0;
+			model_ack_clear(&cli->ack);
 			model_ack_rx(&cli->ack);
 		}
 
 		return;
 	}
 
-	u8_t count = buf->len / col_format->size * 2 + sensor_value_len(type);
+	u8_t count = buf->len / (col_format->size * 2 + sensor_value_len(type));
 
 	for (u8_t i = 0; i < count; i++) {
 		struct bt_mesh_sensor_series_entry entry;
@@ -319,13 +321,24 @@ static void handle_series_status(struct bt_mesh_model *mod,
 			cli->cb->series_entry(cli, ctx, type, i, count, &entry);
 		}
 
-		if (rsp && i < rsp->count) {
-			rsp->entries[i] = entry;
+		/* Large series are split into several pages by the server.
+		 * Append the entries to the ones received in earlier pages.
+		 */
+		if (rsp && rsp->received < rsp->count) {
+			rsp->entries[rsp->received] = entry;
+		}
+
+		if (rsp) {
+			rsp->received++;
 		}
 	}
 
 	if (rsp) {
-		rsp->count = count;
+		/* The server ends the response with an empty page. */
+		if (count == 0) {
+			model_ack_clear(&cli->ack);
+		}
+
 		model_ack_rx(&cli->ack);
 	}
 }
@@ -509,6 +522,7 @@ static int sensor_cli_init(struct bt_mesh_model *mod)
 	cli->mod = mod;
 
 	net_buf_simple_init(cli->pub.msg, 0);
+	model_ack_init(&cli->ack);
 
 	return 0;
 }
@@ -895,30 +909,45 @@ int bt_mesh_sensor_cli_series_entries_get(
 	net_buf_simple_add_le16(&msg, sensor->id);
 
 	col_format = bt_mesh_sensor_column_format_get(sensor);
-
-	err = sensor_ch_encode(&msg, col_format, &range->start);
-	if (err) {
-		return err;
+	if (!col_format) {
+		return -ENOTSUP;
 	}
 
-	err = sensor_ch_encode(&msg, col_format, &range->end);
-	if (err) {
-		return err;
+	if (range) {
+		err = sensor_ch_encode(&msg, col_format, &range->start);
+		if (err) {
+			return err;
+		}
+
+		err = sensor_ch_encode(&msg, col_format, &range->end);
+		if (err) {
+			return err;
+		}
 	}
 
 	struct series_data_rsp rsp_data = {
 		.entries = rsp,
 		.id = sensor->id,
-		.count = *count,
+		.count = rsp ? *count : 0,
 	};
 
-	err = model_ackd_send(cli->mod, ctx, &msg, rsp ? &cli->ack : NULL,
-			       BT_MESH_SENSOR_OP_SERIES_STATUS, &rsp_data);
+	err = model_ackd_send_multi(
+		cli->mod, ctx, &msg, rsp ? &cli->ack : NULL,
+		BT_MESH_SENSOR_OP_SERIES_STATUS, &rsp_data,
+		CONFIG_BT_MESH_SENSOR_CLI_SERIES_PAGE_TIMEOUT);
+	if (!rsp) {
+		return err;
+	}
+
+	*count = rsp_data.received;
+
 	if (err) {
 		return err;
 	}
 
-	*count = rsp_data.count;
+	if (rsp_data.received > rsp_data.count) {
+		return -E2BIG;
+	}
 
 	return 0;
 }
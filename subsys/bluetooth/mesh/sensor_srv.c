@@ -36,6 +36,12 @@ static struct bt_mesh_sensor *sensor_get(struct bt_mesh_sensor_srv *srv,
 	return NULL;
 }
 
+static bool series_supported(const struct bt_mesh_sensor *sensor)
+{
+	return sensor->series.columns &&
+	       (sensor->series.get || sensor->series.get_batch);
+}
+
 static u16_t tolerance_encode(const struct sensor_value *tol)
 {
 	u64_t tol_mill = 1000000L * tol->val1 + tol->val2;
@@ -270,7 +276,7 @@ static void handle_column_get(struct bt_mesh_model *mod,
 	struct sensor_value col_x;
 
 	col_format = bt_mesh_sensor_column_format_get(sensor->type);
-	if (!col_format || !sensor->series.columns || !sensor->series.get) {
+	if (!col_format || !series_supported(sensor)) {
 		BT_WARN("No series support in 0x%04x", sensor->type->id);
 		goto respond;
 	}
@@ -299,6 +305,175 @@ respond:
 	bt_mesh_model_send(mod, ctx, &rsp, NULL, NULL);
 }
 
+static u32_t series_batch_get(struct bt_mesh_sensor_srv *srv,
+			      const struct bt_mesh_sensor_column **cols,
+			      u32_t max_count)
+{
+	const struct bt_mesh_sensor_series *series =
+		&srv->series.sensor->series;
+	u32_t count = 0;
+
+	while (srv->series.next < series->column_count && count < max_count) {
+		const struct bt_mesh_sensor_column *col =
+			&series->columns[srv->series.next++];
+
+		if (srv->series.ranged &&
+		    !bt_mesh_sensor_value_in_column(&col->start,
+						    &srv->series.range)) {
+			continue;
+		}
+
+		cols[count++] = col;
+	}
+
+	return count;
+}
+
+static void series_page_sent(int err, void *cb_data);
+
+static const struct bt_mesh_send_cb series_page_send_cb = {
+	.end = series_page_sent,
+};
+
+/* Encode as many of the remaining columns as fit in a single Series Status
+ * message, and send it. The next page is built when this one is done, so the
+ * pages don't compete for the segmented transmission contexts. The response
+ * ends with an empty page, which tells the client that it's complete.
+ *
+ * Only called from the series work item.
+ */
+static void series_page_send(struct bt_mesh_sensor_srv *srv)
+{
+	struct bt_mesh_sensor *sensor = srv->series.sensor;
+	const struct bt_mesh_sensor_format *col_format =
+		bt_mesh_sensor_column_format_get(sensor->type);
+	const size_t entry_len =
+		col_format->size * 2 + sensor_value_len(sensor->type);
+	const struct bt_mesh_sensor_column
+		*cols[CONFIG_BT_MESH_SENSOR_SRV_SERIES_BATCH_SIZE];
+	struct sensor_value values[CONFIG_BT_MESH_SENSOR_SRV_SERIES_BATCH_SIZE]
+				  [CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	u32_t entries = 0;
+	int err;
+
+	NET_BUF_SIMPLE_DEFINE(rsp, BT_MESH_TX_SDU_MAX);
+	bt_mesh_model_msg_init(&rsp, BT_MESH_SENSOR_OP_SERIES_STATUS);
+	net_buf_simple_add_le16(&rsp, sensor->type->id);
+
+	while (srv->series.next < sensor->series.column_count) {
+		u32_t room = (net_buf_simple_tailroom(&rsp) -
+			      BT_MESH_MIC_SHORT) / entry_len;
+
+		if (room == 0) {
+			break;
+		}
+
+		u32_t count = series_batch_get(
+			srv, cols,
+			MIN(room, CONFIG_BT_MESH_SENSOR_SRV_SERIES_BATCH_SIZE));
+
+		if (count == 0) {
+			break;
+		}
+
+		BT_DBG("Columns: %u (next #%u)", count, srv->series.next);
+
+		err = sensor_series_values_get(sensor, &srv->series.ctx, cols,
+					       count, values);
+		if (err) {
+			BT_WARN("Failed getting series values: %d", err);
+			srv->series.next = sensor->series.column_count;
+			break;
+		}
+
+		for (u32_t i = 0; i < count; ++i) {
+			struct net_buf_simple_state state;
+
+			net_buf_simple_save(&rsp, &state);
+
+			err = sensor_column_value_encode(&rsp, sensor, cols[i],
+							 values[i]);
+			if (err) {
+				BT_WARN("Failed encoding: %d", err);
+				net_buf_simple_restore(&rsp, &state);
+				srv->series.next = sensor->series.column_count;
+				break;
+			}
+
+			entries++;
+		}
+	}
+
+	bool last = (entries == 0);
+
+	if (last) {
+		srv->series.sensor = NULL;
+	} else {
+		atomic_set(&srv->series.in_flight, 1);
+	}
+
+	err = bt_mesh_model_send(srv->model, &srv->series.ctx, &rsp,
+				 last ? NULL : &series_page_send_cb, srv);
+	if (err) {
+		BT_WARN("Failed sending series page: %d", err);
+		srv->series.sensor = NULL;
+		atomic_set(&srv->series.in_flight, 0);
+	}
+}
+
+static void series_page_sent(int err, void *cb_data)
+{
+	struct bt_mesh_sensor_srv *srv = cb_data;
+
+	/* The work item doesn't touch the response while the page is in
+	 * flight.
+	 */
+	if (err) {
+		BT_WARN("Series page not sent: %d", err);
+		srv->series.sensor = NULL;
+	}
+
+	atomic_set(&srv->series.in_flight, 0);
+
+	/* Called from the mesh TX context. Build the next page in the system
+	 * workqueue instead, so the sensor getters don't hold up the
+	 * transmission, and the next send isn't nested in this callback.
+	 */
+	k_work_submit(&srv->series.work);
+}
+
+static void series_page_work(struct k_work *work)
+{
+	struct bt_mesh_sensor_srv *srv = CONTAINER_OF(
+		work, struct bt_mesh_sensor_srv, series.work);
+	k_spinlock_key_t key;
+
+	/* Resubmitted when the page is sent. */
+	if (atomic_get(&srv->series.in_flight)) {
+		return;
+	}
+
+	/* A new request replaces the response in progress between two
+	 * pages.
+	 */
+	key = k_spin_lock(&srv->series.lock);
+	if (srv->series.pending.sensor) {
+		srv->series.sensor = srv->series.pending.sensor;
+		srv->series.ctx = srv->series.pending.ctx;
+		srv->series.range = srv->series.pending.range;
+		srv->series.ranged = srv->series.pending.ranged;
+		srv->series.next = 0;
+		srv->series.pending.sensor = NULL;
+	}
+	k_spin_unlock(&srv->series.lock, key);
+
+	if (!srv->series.sensor) {
+		return;
+	}
+
+	series_page_send(srv);
+}
+
 static void handle_series_get(struct bt_mesh_model *mod,
 			      struct bt_mesh_msg_ctx *ctx,
 			      struct net_buf_simple *buf)
@@ -318,16 +493,15 @@ static void handle_series_get(struct bt_mesh_model *mod,
 
 	struct bt_mesh_sensor *sensor = sensor_get(srv, id);
 
-	NET_BUF_SIMPLE_DEFINE(rsp, BT_MESH_TX_SDU_MAX);
+	BT_MESH_MODEL_BUF_DEFINE(rsp, BT_MESH_SENSOR_OP_SERIES_STATUS, 2);
 	bt_mesh_model_msg_init(&rsp, BT_MESH_SENSOR_OP_SERIES_STATUS);
-	net_buf_simple_add_le16(&rsp, id);
 
 	if (!sensor) {
 		goto respond;
 	}
 
 	col_format = bt_mesh_sensor_column_format_get(sensor->type);
-	if (!col_format || !sensor->series.columns || !sensor->series.get) {
+	if (!col_format || !series_supported(sensor)) {
 		BT_WARN("No series support in 0x%04x", sensor->type->id);
 		goto respond;
 	}
@@ -355,26 +529,28 @@ static void handle_series_get(struct bt_mesh_model *mod,
 		return;
 	}
 
-	for (u32_t i = 0; i < sensor->series.column_count; ++i) {
-		const struct bt_mesh_sensor_column *col =
-			&sensor->series.columns[i];
+	/* Large series are split into several Series Status messages, each
+	 * covering a contiguous part of the requested range. The pages are
+	 * built by the work item, which picks up the request once the page
+	 * of a previous response in progress has been sent.
+	 */
+	k_spinlock_key_t key = k_spin_lock(&srv->series.lock);
 
-		if (ranged &&
-		    !bt_mesh_sensor_value_in_column(&col->start, &range)) {
-			continue;
-		}
+	srv->series.pending.sensor = sensor;
+	srv->series.pending.ctx = *ctx;
+	srv->series.pending.ranged = ranged;
+	if (ranged) {
+		srv->series.pending.range = range;
+	}
 
-		BT_DBG("Column #%u", i);
+	k_spin_unlock(&srv->series.lock, key);
 
-		int err = sensor_column_encode(&rsp, sensor, ctx, col);
+	k_work_submit(&srv->series.work);
 
-		if (err) {
-			BT_WARN("Failed encoding: %d", err);
-			return;
-		}
-	}
+	return;
 
 respond:
+	net_buf_simple_add_le16(&rsp, id);
 	bt_mesh_model_send(mod, ctx, &rsp, NULL, NULL);
 }
 
@@ -709,6 +885,86 @@ const struct bt_mesh_model_op _bt_mesh_sensor_setup_srv_op[] = {
 	  BT_MESH_SENSOR_MSG_MINLEN_SETTING_SET, handle_setting_set_unack },
 };
 
+static void pub_batch_send(struct bt_mesh_sensor_srv *srv,
+			   struct net_buf_simple *msg)
+{
+	int err;
+
+	err = model_send(srv->model, NULL, msg);
+	if (err) {
+		BT_WARN("Batched publication failed: %d", err);
+	}
+
+	bt_mesh_model_msg_init(msg, BT_MESH_SENSOR_OP_STATUS);
+}
+
+/* Publish the pending sensors whose minimum interval has expired, packed into
+ * as few Sensor Status messages as possible. The sensor list is sorted, so
+ * every message lists its sensors in ascending order, as required. Sensors
+ * still inside their minimum interval stay pending, and get published when the
+ * first of them expires.
+ */
+static void pub_batch_flush(struct k_work *work)
+{
+	struct bt_mesh_sensor_srv *srv = CONTAINER_OF(
+		work, struct bt_mesh_sensor_srv, pub_batch.work);
+	struct sensor_value value[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	struct bt_mesh_sensor *s;
+	u32_t now = k_uptime_get_32();
+	u32_t next = UINT32_MAX;
+	size_t empty_len;
+	int err;
+
+	NET_BUF_SIMPLE_DEFINE(msg, BT_MESH_TX_SDU_MAX);
+	bt_mesh_model_msg_init(&msg, BT_MESH_SENSOR_OP_STATUS);
+	empty_len = msg.len;
+
+	SENSOR_FOR_EACH(&srv->sensors, s)
+	{
+		if (!s->state.pub_pending) {
+			continue;
+		}
+
+		u32_t remaining = sensor_pub_min_int_remaining(s, now);
+
+		if (remaining) {
+			next = MIN(next, remaining);
+			continue;
+		}
+
+		s->state.pub_pending = 0;
+
+		err = value_get(s, NULL, value);
+		if (err) {
+			continue;
+		}
+
+		err = sensor_status_batch_add(&msg, s, value);
+		if (err == -ENOMEM && msg.len > empty_len) {
+			pub_batch_send(srv, &msg);
+			err = sensor_status_batch_add(&msg, s, value);
+		}
+
+		if (err) {
+			BT_WARN("Sensor value encode for 0x%04x: %d",
+				s->type->id, err);
+			continue;
+		}
+
+		s->state.prev = value[0];
+		s->state.pub_time = now;
+	}
+
+	if (msg.len > empty_len) {
+		pub_batch_send(srv, &msg);
+	}
+
+	if (next != UINT32_MAX) {
+		BT_DBG("Deferred for %u ms", next);
+		k_delayed_work_submit(&srv->pub_batch, K_MSEC(next));
+	}
+}
+
 static int sensor_srv_init(struct bt_mesh_model *mod)
 {
 	struct bt_mesh_sensor_srv *srv = mod->user_data;
@@ -744,6 +1000,9 @@ static int sensor_srv_init(struct bt_mesh_model *mod)
 
 	srv->model = mod;
 
+	k_delayed_work_init(&srv->pub_batch, pub_batch_flush);
+	k_work_init(&srv->series.work, series_page_work);
+
 	net_buf_simple_init(srv->pub.msg, 0);
 	net_buf_simple_init(srv->setup_pub.msg, 0);
 
@@ -879,6 +1138,8 @@ static void pub_msg_add(struct bt_mesh_sensor_srv *srv,
 
 	s->state.prev = value[0];
 	s->state.seq = srv->seq;
+	s->state.pub_time = k_uptime_get_32();
+	s->state.pub_pending = 0;
 }
 
 int _bt_mesh_sensor_srv_update_handler(struct bt_mesh_model *mod)
@@ -945,6 +1206,40 @@ int bt_mesh_sensor_srv_pub(struct bt_mesh_sensor_srv *srv,
 	}
 
 	sensor->state.prev = value[0];
+	sensor->state.pub_time = k_uptime_get_32();
+	if (!ctx) {
+		sensor->state.pub_pending = 0;
+	}
+
+	return 0;
+}
+
+static int pub_batch_add(struct bt_mesh_sensor_srv *srv,
+			 struct bt_mesh_sensor *sensor)
+{
+	if (!bt_mesh_is_provisioned()) {
+		return -EAGAIN;
+	}
+
+	if (srv->pub.addr == BT_MESH_ADDR_UNASSIGNED) {
+		return -EADDRNOTAVAIL;
+	}
+
+	sensor->state.pub_pending = 1;
+
+	/* Open a new window, unless one is already open. A batch deferred by
+	 * some sensor's minimum interval is brought forward, so that it
+	 * doesn't hold back the sensors that are free to publish.
+	 */
+	s32_t remaining = k_delayed_work_remaining_get(&srv->pub_batch);
+
+	if ((remaining == 0 && !k_work_pending(&srv->pub_batch.work)) ||
+	    remaining > CONFIG_BT_MESH_SENSOR_SRV_PUB_BATCH_WINDOW) {
+		k_delayed_work_submit(
+			&srv->pub_batch,
+			K_MSEC(CONFIG_BT_MESH_SENSOR_SRV_PUB_BATCH_WINDOW));
+	}
+
 	return 0;
 }
 
@@ -967,5 +1262,9 @@ int bt_mesh_sensor_srv_sample(struct bt_mesh_sensor_srv *srv,
 
 	BT_DBG("Publishing 0x%04x", sensor->type->id);
 
+	if (CONFIG_BT_MESH_SENSOR_SRV_PUB_BATCH_WINDOW) {
+		return pub_batch_add(srv, sensor);
+	}
+
 	return bt_mesh_sensor_srv_pub(srv, NULL, sensor, value);
 }
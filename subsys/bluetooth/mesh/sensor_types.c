@@ -24,9 +24,24 @@
 #define FORMAT(_name)                                                          \
 	const struct bt_mesh_sensor_format bt_mesh_sensor_format_##_name
 
-#define SENSOR_TYPE(name)                                                      \
-	const Z_STRUCT_SECTION_ITERABLE(bt_mesh_sensor_type,                   \
-					bt_mesh_sensor_##name)
+/* The linker sorts the sensor types by section name. The section name starts
+ * with the property ID, so the sensor type list is sorted by ID, and can be
+ * binary searched. All property IDs in properties.h are four digit hex
+ * literals, which makes the name order match the numeric order.
+ *
+ * The enumerator named after the ID breaks the build if two sensor types
+ * share the same property ID.
+ */
+#define SENSOR_TYPE_ID_ENUM(_id) _SENSOR_TYPE_ID_ENUM(_id)
+#define _SENSOR_TYPE_ID_ENUM(_id) bt_mesh_sensor_type_id_##_id
+
+#define SENSOR_TYPE(name, _id, ...)                                            \
+	enum { SENSOR_TYPE_ID_ENUM(_id) };                                     \
+	const Z_DECL_ALIGN(struct bt_mesh_sensor_type) bt_mesh_sensor_##name   \
+		__attribute__((section("._bt_mesh_sensor_type.static."         \
+				       STRINGIFY(_id) "_" #name))) __used = { \
+			.id = _id, __VA_ARGS__                                 \
+		}
 
 #ifdef CONFIG_BT_MESH_SENSOR_LABELS
 
@@ -67,25 +82,73 @@ UNIT(unitless) = { "Unitless" };
 /*******************************************************************************
  * Encoders and decoders
  ******************************************************************************/
-#define BRANCHLESS_ABS8(x) (((x) + ((x) >> 7)) ^ ((x) >> 7))
-
-#define SCALAR(mul, bin)                                                       \
-	((double)(mul) *                                                       \
-	 (double)((bin) >= 0 ? (1ULL << BRANCHLESS_ABS8(bin)) :                \
-			       (1.0 / (1ULL << BRANCHLESS_ABS8(bin)))))
-
-#define SCALAR_IS_DIV(_scalar) ((_scalar) > -1.0 && (_scalar) < 1.0)
-
-#define SCALAR_REPR_RANGED(_scalar, _flags, _max)                              \
+/* Scalar formats represent the channel value as an integer multiple of a
+ * resolution of 10^dec * 2^bin. The factors used to convert between the
+ * encoded integer and struct sensor_value are precomputed for every format, so
+ * the conversion only takes integer multiplications, shifts and divisions by
+ * small constants.
+ *
+ * Supported exponents:
+ * - dec is in the range -6 to 9, and bin is in the range -16 to 0.
+ * - Formats with a positive dec can't have a bin.
+ * - bin + dec must be at least -18.
+ */
+#define POW10(_e)                                                              \
+	((_e) == 0 ? 1UL :                                                     \
+	 (_e) == 1 ? 10UL :                                                    \
+	 (_e) == 2 ? 100UL :                                                   \
+	 (_e) == 3 ? 1000UL :                                                  \
+	 (_e) == 4 ? 10000UL :                                                 \
+	 (_e) == 5 ? 100000UL :                                                \
+	 (_e) == 6 ? 1000000UL :                                               \
+	 (_e) == 7 ? 10000000UL :                                              \
+	 (_e) == 8 ? 100000000UL :                                             \
+		     1000000000UL)
+
+#define POW5(_e)                                                               \
+	((_e) == 0 ? 1UL :                                                     \
+	 (_e) == 1 ? 5UL :                                                     \
+	 (_e) == 2 ? 25UL :                                                    \
+	 (_e) == 3 ? 125UL :                                                   \
+	 (_e) == 4 ? 625UL :                                                   \
+	 (_e) == 5 ? 3125UL :                                                  \
+		     15625UL)
+
+/* Decimal exponent of the micro units in a single encoded unit. */
+#define FRAC_EXP(_dec) ((_dec) <= 0 ? 6 + (_dec) : 0)
+
+#define SCALAR(_dec, _bin) (_dec, _bin)
+
+#define SCALAR_FACTORS(_dec, _bin)                                             \
+	.dec = (_dec), .shift = -(_bin),                                       \
+	.frac_shift = -(_bin) - FRAC_EXP(_dec),                                \
+	.pow10 = POW10((_dec) < 0 ? -(_dec) : (_dec)),                         \
+	.frac_pow10 = POW10(FRAC_EXP(_dec)),                                   \
+	.frac_pow5 = POW5(FRAC_EXP(_dec))
+
+#define SCALAR_MAX(_size, _flags, _max)                                        \
+	(((_flags) & HAS_MAX) ?                                                \
+		 (_max) :                                                      \
+	 ((_flags) & SIGNED) ?                                                 \
+		 (BIT64(8 * (_size) - 1) - 1) :                                \
+	 ((_flags) & (HAS_HIGHER_THAN | HAS_INVALID)) ?                        \
+		 (BIT64(8 * (_size)) - 3) :                                    \
+	 ((_flags) & HAS_UNDEFINED) ? (BIT64(8 * (_size)) - 2) :               \
+				      (BIT64(8 * (_size)) - 1))
+
+#define SCALAR_MIN(_size, _flags)                                              \
+	(((_flags) & SIGNED) ? -(s64_t)BIT64(8 * (_size) - 1) : 0)
+
+#define SCALAR_REPR_RANGED(_size, _flags, _max, _scalar)                       \
 	{                                                                      \
-		.flags = ((_flags) | (SCALAR_IS_DIV(_scalar) ? DIVIDE : 0)),   \
-		.max = _max,                                                   \
-		.value = (s64_t)((SCALAR_IS_DIV(_scalar) ? (1.0 / (_scalar)) : \
-							   (_scalar)) +        \
-				 0.5),                                         \
+		.flags = (_flags),                                             \
+		.min = SCALAR_MIN(_size, _flags),                              \
+		.max = SCALAR_MAX(_size, _flags, _max),                        \
+		SCALAR_FACTORS _scalar                                         \
 	}
 
-#define SCALAR_REPR(_scalar, _flags) SCALAR_REPR_RANGED(_scalar, _flags, 0)
+#define SCALAR_REPR(_size, _flags, _scalar)                                    \
+	SCALAR_REPR_RANGED(_size, _flags, 0, _scalar)
 
 #ifdef CONFIG_BT_MESH_SENSOR_LABELS
 
@@ -96,7 +159,7 @@ UNIT(unitless) = { "Unitless" };
 		.size = _size,                                                 \
 		.user_data = (void *)&(                                        \
 			(const struct scalar_repr)SCALAR_REPR_RANGED(          \
-				_scalar, ((_flags) | HAS_MAX), _max)),         \
+				_size, ((_flags) | HAS_MAX), _max, _scalar)),  \
 	}
 
 #define SCALAR_FORMAT(_size, _flags, _unit, _scalar)                           \
@@ -105,7 +168,7 @@ UNIT(unitless) = { "Unitless" };
 		.encode = scalar_encode, .decode = scalar_decode,              \
 		.size = _size,                                                 \
 		.user_data = (void *)&((const struct scalar_repr)SCALAR_REPR(  \
-			_scalar, _flags)),                                     \
+			_size, _flags, _scalar)),                              \
 	}
 #else
 
@@ -115,7 +178,7 @@ UNIT(unitless) = { "Unitless" };
 		.size = _size,                                                 \
 		.user_data = (void *)&(                                        \
 			(const struct scalar_repr)SCALAR_REPR_RANGED(          \
-				_scalar, ((_flags) | HAS_MAX), _max)),         \
+				_size, ((_flags) | HAS_MAX), _max, _scalar)),  \
 	}
 
 #define SCALAR_FORMAT(_size, _flags, _unit, _scalar)                           \
@@ -123,14 +186,13 @@ UNIT(unitless) = { "Unitless" };
 		.encode = scalar_encode, .decode = scalar_decode,              \
 		.size = _size,                                                 \
 		.user_data = (void *)&((const struct scalar_repr)SCALAR_REPR(  \
-			_scalar, _flags)),                                     \
+			_size, _flags, _scalar)),                              \
 	}
 #endif
 
 enum scalar_repr_flags {
 	UNSIGNED = 0,
 	SIGNED = BIT(1),
-	DIVIDE = BIT(2),
 	/** The highest encoded value represents "undefined" */
 	HAS_UNDEFINED = BIT(3),
 	/**
@@ -145,59 +207,79 @@ enum scalar_repr_flags {
 
 struct scalar_repr {
 	enum scalar_repr_flags flags;
+	s32_t min; /**< Lowest encoded value */
 	u32_t max; /**< Highest encoded value */
-	s64_t value;
-};
-
-static s64_t mul_scalar(s64_t val, const struct scalar_repr *repr)
-{
-	return (repr->flags & DIVIDE) ? (val / repr->value) :
-	       (val * repr->value);
-}
-
-static s64_t div_scalar(s64_t val, const struct scalar_repr *repr)
+	s8_t dec; /**< Decimal exponent of the resolution */
+	u8_t shift; /**< Negated binary exponent of the resolution */
+	/** Shift of the fractional micro units to get encoded units. */
+	s8_t frac_shift;
+	/** 10 to the power of the absolute decimal exponent. */
+	u32_t pow10;
+	/** Micro units in a single encoded unit, before the binary shift. */
+	u32_t frac_pow10;
+	/** Odd factor of frac_pow10. */
+	u32_t frac_pow5;
+};
+
+static void raw_put(struct net_buf_simple *buf, size_t size, u32_t raw)
 {
-	return (repr->flags & DIVIDE) ? (val * repr->value) :
-	       (val / repr->value);
+	switch (size) {
+	case 1:
+		net_buf_simple_add_u8(buf, raw);
+		break;
+	case 2:
+		net_buf_simple_add_le16(buf, raw);
+		break;
+	case 3:
+		net_buf_simple_add_le24(buf, raw);
+		break;
+	case 4:
+		net_buf_simple_add_le32(buf, raw);
+		break;
+	}
 }
 
-static u32_t scalar_max(const struct bt_mesh_sensor_format *format)
+static s32_t raw_pull(struct net_buf_simple *buf, size_t size, bool is_signed)
 {
-	const struct scalar_repr *repr = format->user_data;
+	u32_t raw;
 
-	if (repr->flags & HAS_MAX) {
-		return repr->max;
-	}
-
-	if (repr->flags & SIGNED) {
-		return BIT64(8 * format->size - 1) - 1;
+	switch (size) {
+	case 1:
+		raw = net_buf_simple_pull_u8(buf);
+		break;
+	case 2:
+		raw = net_buf_simple_pull_le16(buf);
+		break;
+	case 3:
+		raw = net_buf_simple_pull_le24(buf);
+		break;
+	case 4:
+		return net_buf_simple_pull_le32(buf);
+	default:
+		return 0;
 	}
 
-	u32_t max_value = BIT64(8 * format->size) - 1;
-
-	if (repr->flags & (HAS_HIGHER_THAN | HAS_INVALID)) {
-		max_value -= 2;
-	} else if (repr->flags & HAS_UNDEFINED) {
-		max_value -= 1;
+	if (is_signed && (raw & BIT(8 * size - 1))) {
+		raw |= ~BIT_MASK(8 * size);
 	}
 
-	return max_value;
+	return raw;
 }
 
-static s32_t scalar_min(const struct bt_mesh_sensor_format *format)
+static bool scalar_raw_valid(const struct scalar_repr *repr, s32_t raw)
 {
-	const struct scalar_repr *repr = format->user_data;
-
 	if (repr->flags & SIGNED) {
-		return -BIT64(8 * format->size - 1);
+		return (raw >= repr->min) && (raw <= (s32_t)repr->max);
 	}
 
-	return 0;
+	/* Unsigned 32-bit values don't fit in s32_t, and are passed as u32_t
+	 * cast to s32_t.
+	 */
+	return ((u32_t)raw <= repr->max);
 }
 
-static int scalar_encode(const struct bt_mesh_sensor_format *format,
-			 const struct sensor_value *val,
-			 struct net_buf_simple *buf)
+static int scalar_raw_encode(const struct bt_mesh_sensor_format *format,
+			     s64_t raw, struct net_buf_simple *buf)
 {
 	const struct scalar_repr *repr = format->user_data;
 
@@ -205,13 +287,7 @@ static int scalar_encode(const struct bt_mesh_sensor_format *format,
 		return -ENOMEM;
 	}
 
-	s64_t raw = div_scalar(val->val1, repr) +
-		    div_scalar(val->val2, repr) / 1000000LL;
-
-	u32_t max_value = scalar_max(format);
-	s32_t min_value = scalar_min(format);
-
-	if (raw > max_value || raw < min_value) {
+	if (raw > repr->max || raw < repr->min) {
 		u32_t type_max = BIT64(8 * format->size) - 1;
 
 		if (repr->flags & (HAS_HIGHER_THAN | HAS_INVALID)) {
@@ -223,26 +299,90 @@ static int scalar_encode(const struct bt_mesh_sensor_format *format,
 		}
 	}
 
-	switch (format->size) {
-	case 1:
-		net_buf_simple_add_u8(buf, raw);
-		break;
-	case 2:
-		net_buf_simple_add_le16(buf, raw);
-		break;
-	case 3:
-		net_buf_simple_add_le24(buf, raw);
-		break;
-	case 4:
-		net_buf_simple_add_le32(buf, raw);
-		break;
-	default:
-		return -EIO;
-	}
+	raw_put(buf, format->size, raw);
 
 	return 0;
 }
 
+static s64_t scalar_from_value(const struct scalar_repr *repr,
+			       const struct sensor_value *val)
+{
+	s32_t val1 = val->val1;
+	s32_t val2 = val->val2;
+
+	/* Give both parts the same sign, so they can be encoded as one
+	 * magnitude:
+	 */
+	if (val1 > 0 && val2 < 0) {
+		val1--;
+		val2 += 1000000L;
+	} else if (val1 < 0 && val2 > 0) {
+		val1++;
+		val2 -= 1000000L;
+	}
+
+	bool neg = (val1 < 0 || val2 < 0);
+	u32_t mag1 = neg ? -(u32_t)val1 : val1;
+	u32_t mag2 = neg ? -(u32_t)val2 : val2;
+	u64_t mag;
+
+	if (repr->dec > 0) {
+		/* The fractional part is below the resolution. */
+		mag = mag1 / repr->pow10;
+	} else {
+		/* mag2 * 2^shift / frac_pow10, with the powers of two in
+		 * frac_pow10 moved into the shift:
+		 */
+		u32_t frac = (repr->frac_shift >= 0) ?
+				     (mag2 << repr->frac_shift) :
+				     (mag2 >> -repr->frac_shift);
+
+		mag = (((u64_t)mag1 * repr->pow10) << repr->shift) +
+		      frac / repr->frac_pow5;
+	}
+
+	return neg ? -(s64_t)mag : (s64_t)mag;
+}
+
+static void scalar_to_value(const struct scalar_repr *repr, s32_t raw,
+			    struct sensor_value *val)
+{
+	bool neg = (repr->flags & SIGNED) && (raw < 0);
+	u32_t mag = neg ? -(u32_t)raw : (u32_t)raw;
+	u64_t ip;
+	u32_t fp;
+
+	if (repr->dec > 0) {
+		ip = (u64_t)mag * repr->pow10;
+		fp = 0;
+	} else if (repr->pow10 == 1) {
+		ip = mag;
+		fp = 0;
+	} else {
+		ip = mag / repr->pow10;
+		fp = (mag % repr->pow10) * repr->frac_pow10;
+	}
+
+	if (repr->shift) {
+		u64_t frac = (ip & BIT_MASK(repr->shift)) * 1000000ULL + fp;
+
+		ip >>= repr->shift;
+		fp = frac >> repr->shift;
+	}
+
+	val->val1 = neg ? -(s64_t)ip : (s64_t)ip;
+	val->val2 = neg ? -(s32_t)fp : (s32_t)fp;
+}
+
+static int scalar_encode(const struct bt_mesh_sensor_format *format,
+			 const struct sensor_value *val,
+			 struct net_buf_simple *buf)
+{
+	return scalar_raw_encode(format,
+				 scalar_from_value(format->user_data, val),
+				 buf);
+}
+
 static int scalar_decode(const struct bt_mesh_sensor_format *format,
 			 struct net_buf_simple *buf, struct sensor_value *val)
 {
@@ -252,50 +392,27 @@ static int scalar_decode(const struct bt_mesh_sensor_format *format,
 		return -ENOMEM;
 	}
 
-	s32_t raw;
+	s32_t raw = raw_pull(buf, format->size, repr->flags & SIGNED);
 
-	switch (format->size) {
-	case 1:
-		if (repr->flags & SIGNED) {
-			raw = (s8_t) net_buf_simple_pull_u8(buf);
-		} else {
-			raw = net_buf_simple_pull_u8(buf);
-		}
-		break;
-	case 2:
-		if (repr->flags & SIGNED) {
-			raw = (s16_t) net_buf_simple_pull_le16(buf);
-		} else {
-			raw = net_buf_simple_pull_le16(buf);
-		}
-		break;
-	case 3:
-		raw = net_buf_simple_pull_le24(buf);
-
-		if ((repr->flags & SIGNED) && (raw & BIT(24))) {
-			raw |= (BIT_MASK(8) << 24);
-		}
-		break;
-	case 4:
-		raw = net_buf_simple_pull_le32(buf);
-		break;
-	default:
+	if (!scalar_raw_valid(repr, raw)) {
 		return -ERANGE;
 	}
 
-	u32_t max_value = scalar_max(format);
-	s32_t min_value = scalar_min(format);
-
-	if (raw < min_value || raw > max_value) {
-		return -ERANGE;
-	}
+	scalar_to_value(repr, raw, val);
 
-	s64_t million = mul_scalar(raw * 1000000LL, repr);
+	return 0;
+}
 
-	val->val1 = million / 1000000LL;
-	val->val2 = million % 1000000LL;
+static bool is_scalar(const struct bt_mesh_sensor_format *format)
+{
+	return (format->encode == scalar_encode);
+}
 
-	return 0;
+static bool is_signed(const struct bt_mesh_sensor_format *format)
+{
+	return is_scalar(format) &&
+	       (((const struct scalar_repr *)format->user_data)->flags &
+		SIGNED);
 }
 
 static int boolean_encode(const struct bt_mesh_sensor_format *format,
@@ -355,18 +472,58 @@ static int exp_1_1_decode(const struct bt_mesh_sensor_format *format,
 	return 0;
 }
 
+/* The coefficient format is an IEEE-754 32-bit floating point number. The
+ * conversion is done with integer operations, as most of the devices don't
+ * have a floating point unit.
+ */
+#define FLOAT32_MANT_BITS 23
+#define FLOAT32_EXP_BIAS 127
+#define FLOAT32_EXP_MASK BIT_MASK(8)
+
 static int float32_encode(const struct bt_mesh_sensor_format *format,
 			  const struct sensor_value *val,
 			  struct net_buf_simple *buf)
 {
-	if (net_buf_simple_tailroom(buf) < 1) {
+	if (net_buf_simple_tailroom(buf) < sizeof(u32_t)) {
 		return -ENOMEM;
 	}
 
-	/* IEEE-754 32-bit floating point */
-	float fvalue = (float)val->val1 + (float)val->val2 / 1000000L;
+	s64_t micro = (s64_t)val->val1 * 1000000LL + val->val2;
+	bool neg = (micro < 0);
+	u64_t mag = neg ? -(u64_t)micro : (u64_t)micro;
+	u32_t bits = neg ? BIT(31) : 0;
 
-	net_buf_simple_add_mem(buf, &fvalue, sizeof(float));
+	if (mag == 0) {
+		net_buf_simple_add_le32(buf, bits);
+		return 0;
+	}
+
+	/* Normalize, so the quotient keeps more than 24 significant bits: */
+	int lz = __builtin_clzll(mag);
+	u64_t num = mag << lz;
+	u64_t q = num / 1000000ULL;
+	bool sticky = (num % 1000000ULL) != 0;
+	int q_bits = 64 - __builtin_clzll(q);
+	int shift = q_bits - (FLOAT32_MANT_BITS + 1);
+	u32_t mant = q >> shift;
+	u64_t rem = q & (BIT64(shift) - 1);
+	u64_t half = BIT64(shift - 1);
+
+	/* Round to nearest, ties to even: */
+	if (rem > half || (rem == half && (sticky || (mant & 1)))) {
+		mant++;
+		if (mant == BIT(FLOAT32_MANT_BITS + 1)) {
+			mant >>= 1;
+			shift++;
+		}
+	}
+
+	s32_t exp = shift - lz + FLOAT32_MANT_BITS + FLOAT32_EXP_BIAS;
+
+	bits |= (exp << FLOAT32_MANT_BITS) |
+		(mant & BIT_MASK(FLOAT32_MANT_BITS));
+
+	net_buf_simple_add_le32(buf, bits);
 
 	return 0;
 }
@@ -374,17 +531,145 @@ static int float32_encode(const struct bt_mesh_sensor_format *format,
 static int float32_decode(const struct bt_mesh_sensor_format *format,
 			  struct net_buf_simple *buf, struct sensor_value *val)
 {
-	if (buf->len < 1) {
+	if (buf->len < sizeof(u32_t)) {
 		return -ENOMEM;
 	}
 
-	float fvalue;
+	u32_t bits = net_buf_simple_pull_le32(buf);
+	bool neg = (bits & BIT(31));
+	s32_t exp = (bits >> FLOAT32_MANT_BITS) & FLOAT32_EXP_MASK;
+	u64_t mant = bits & BIT_MASK(FLOAT32_MANT_BITS);
+
+	if (exp == FLOAT32_EXP_MASK) {
+		/* Infinity or NaN */
+		return -ERANGE;
+	}
+
+	if (exp == 0) {
+		/* Subnormal */
+		exp = 1;
+	} else {
+		mant |= BIT(FLOAT32_MANT_BITS);
+	}
+
+	/* value = mant * 2^(exp - bias - mantissa bits) */
+	s32_t shift = FLOAT32_EXP_BIAS + FLOAT32_MANT_BITS - exp;
+	u64_t ip;
+	u32_t fp;
+
+	if (shift <= 0) {
+		if (-shift > 31 - (FLOAT32_MANT_BITS + 1)) {
+			return -ERANGE;
+		}
+
+		ip = mant << -shift;
+		fp = 0;
+	} else if (shift > 44) {
+		/* Below the micro unit resolution. */
+		ip = 0;
+		fp = 0;
+	} else {
+		ip = mant >> shift;
+		fp = ((mant & (BIT64(shift) - 1)) * 1000000ULL) >> shift;
+	}
+
+	val->val1 = neg ? -(s64_t)ip : (s64_t)ip;
+	val->val2 = neg ? -(s32_t)fp : (s32_t)fp;
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Raw channel values
+ ******************************************************************************/
+int bt_mesh_sensor_ch_to_raw(const struct bt_mesh_sensor_format *format,
+			     const struct sensor_value *val, s32_t *raw)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, sizeof(u32_t));
+	int err;
+
+	err = format->encode(format, val, &buf);
+	if (err) {
+		return err;
+	}
+
+	*raw = raw_pull(&buf, format->size, is_signed(format));
+
+	return 0;
+}
+
+int bt_mesh_sensor_ch_from_raw(const struct bt_mesh_sensor_format *format,
+			       s32_t raw, struct sensor_value *val)
+{
+	if (is_scalar(format)) {
+		if (!scalar_raw_valid(format->user_data, raw)) {
+			return -ERANGE;
+		}
+
+		scalar_to_value(format->user_data, raw, val);
+		return 0;
+	}
+
+	NET_BUF_SIMPLE_DEFINE(buf, sizeof(u32_t));
 
-	memcpy(&fvalue, net_buf_simple_pull_mem(buf, sizeof(float)),
-	       sizeof(float));
+	raw_put(&buf, format->size, raw);
+
+	return format->decode(format, &buf, val);
+}
+
+int bt_mesh_sensor_raw_encode(struct net_buf_simple *buf,
+			      const struct bt_mesh_sensor_type *type,
+			      const s32_t *raw)
+{
+	for (u32_t i = 0; i < type->channel_count; ++i) {
+		const struct bt_mesh_sensor_format *format =
+			type->channels[i].format;
+		int err;
+
+		if (!is_scalar(format)) {
+			if (net_buf_simple_tailroom(buf) < format->size) {
+				return -ENOMEM;
+			}
+
+			raw_put(buf, format->size, raw[i]);
+			continue;
+		}
+
+		const struct scalar_repr *repr = format->user_data;
+
+		err = scalar_raw_encode(format,
+					(repr->flags & SIGNED) ?
+						(s64_t)raw[i] :
+						(s64_t)(u32_t)raw[i],
+					buf);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int bt_mesh_sensor_raw_decode(struct net_buf_simple *buf,
+			      const struct bt_mesh_sensor_type *type,
+			      s32_t *raw)
+{
+	for (u32_t i = 0; i < type->channel_count; ++i) {
+		const struct bt_mesh_sensor_format *format =
+			type->channels[i].format;
+
+		if (buf->len < format->size) {
+			return -ENOMEM;
+		}
+
+		raw[i] = raw_pull(buf, format->size, is_signed(format));
+
+		if (is_scalar(format) &&
+		    !scalar_raw_valid(format->user_data, raw[i])) {
+			return -ERANGE;
+		}
+	}
 
-	val->val1 = (u32_t)fvalue;
-	val->val2 = ((u32_t)(fvalue * 1000000.0f)) / 1000000L;
 	return 0;
 }
 
@@ -404,12 +689,12 @@ static int float32_decode(const struct bt_mesh_sensor_format *format,
 FORMAT(percentage_8)  = SCALAR_FORMAT_MAX(1,
 					  (UNSIGNED | HAS_UNDEFINED),
 					  percent,
-					  SCALAR(1, -1),
+					  SCALAR(0, -1),
 					  200);
 FORMAT(percentage_16) = SCALAR_FORMAT_MAX(2,
 					  (UNSIGNED | HAS_UNDEFINED),
 					  percent,
-					  SCALAR(1e-2, 0),
+					  SCALAR(-2, 0),
 					  200);
 
 /*******************************************************************************
@@ -418,32 +703,32 @@ FORMAT(percentage_16) = SCALAR_FORMAT_MAX(2,
 FORMAT(temp_8)		  = SCALAR_FORMAT(1,
 					  SIGNED,
 					  celsius,
-					  SCALAR(1, -1));
+					  SCALAR(0, -1));
 FORMAT(temp)		  = SCALAR_FORMAT(2,
 					  SIGNED,
 					  celsius,
-					  SCALAR(1e-2, 0));
+					  SCALAR(-2, 0));
 FORMAT(co2_concentration) = SCALAR_FORMAT(2,
 					  (HAS_HIGHER_THAN | HAS_UNDEFINED),
 					  ppm,
-					  SCALAR(1, 0));
+					  SCALAR(0, 0));
 FORMAT(noise)		  = SCALAR_FORMAT(1,
 					  (UNSIGNED |
 					   HAS_HIGHER_THAN |
 					   HAS_UNDEFINED),
 					  db,
-					  SCALAR(1, 0));
+					  SCALAR(0, 0));
 FORMAT(voc_concentration) = SCALAR_FORMAT_MAX(2,
 					      (UNSIGNED |
 					       HAS_HIGHER_THAN |
 					       HAS_UNDEFINED),
 					      ppb,
-					      SCALAR(1, 0),
+					      SCALAR(0, 0),
 					      65533);
 FORMAT(humidity)          = SCALAR_FORMAT_MAX(2,
 					      UNSIGNED,
 					      percent,
-					      SCALAR(1e-2, 0),
+					      SCALAR(-2, 0),
 					      10000);
 
 /*******************************************************************************
@@ -452,20 +737,20 @@ FORMAT(humidity)          = SCALAR_FORMAT_MAX(2,
 FORMAT(time_decihour_8)	    = SCALAR_FORMAT_MAX(1,
 						(UNSIGNED | HAS_UNDEFINED),
 						hours,
-						SCALAR(1e-1, 0),
+						SCALAR(-1, 0),
 						240);
 FORMAT(time_hour_24)	    = SCALAR_FORMAT(3,
 					    (UNSIGNED | HAS_UNDEFINED),
 					    hours,
-					    SCALAR(1e-1, 0));
+					    SCALAR(-1, 0));
 FORMAT(time_second_16)	    = SCALAR_FORMAT(2,
 					    (UNSIGNED | HAS_UNDEFINED),
 					    seconds,
-					    SCALAR(1, 0));
+					    SCALAR(0, 0));
 FORMAT(time_millisecond_24) = SCALAR_FORMAT(3,
 					    (UNSIGNED | HAS_UNDEFINED),
 					    seconds,
-					    SCALAR(1e-3, 0));
+					    SCALAR(-3, 0));
 FORMAT(time_exp_8)	    = {
 	 .size = 1,
 #ifdef CONFIG_BT_MESH_SENSOR_LABELS
@@ -481,23 +766,23 @@ FORMAT(time_exp_8)	    = {
 FORMAT(electric_current) = SCALAR_FORMAT(2,
 					 (UNSIGNED | HAS_UNDEFINED),
 					 ampere,
-					 SCALAR(1e-2, 0));
+					 SCALAR(-2, 0));
 FORMAT(voltage)		 = SCALAR_FORMAT(2,
 					 (UNSIGNED | HAS_UNDEFINED),
 					 volt,
-					 SCALAR(1, -6));
+					 SCALAR(0, -6));
 FORMAT(energy32)	 = SCALAR_FORMAT(4,
 					 UNSIGNED | HAS_INVALID | HAS_UNDEFINED,
 					 kwh,
-					 SCALAR(1e-3, 0));
+					 SCALAR(-3, 0));
 FORMAT(power)		 = SCALAR_FORMAT(3,
 					 (UNSIGNED | HAS_UNDEFINED),
 					 watt,
-					 SCALAR(1e-1, 0));
+					 SCALAR(-1, 0));
 FORMAT(energy)           = SCALAR_FORMAT(3,
 					 (UNSIGNED | HAS_UNDEFINED),
 					 kwh,
-					 SCALAR(1, 0));
+					 SCALAR(0, 0));
 
 /*******************************************************************************
  * Lighting formats
@@ -506,40 +791,40 @@ FORMAT(chromatic_distance)      = SCALAR_FORMAT_MAX(2,
 						(SIGNED |
 						 HAS_INVALID |
 						 HAS_UNDEFINED),
-						unitless, SCALAR(1e-5, 0),
+						unitless, SCALAR(-5, 0),
 						5000);
 FORMAT(chromaticity_coordinate) = SCALAR_FORMAT(2,
 						UNSIGNED,
 						unitless,
-						SCALAR(1, -16));
+						SCALAR(0, -16));
 FORMAT(correlated_color_temp)	= SCALAR_FORMAT(2,
 						(UNSIGNED | HAS_UNDEFINED),
 						kelvin,
-						SCALAR(1, 0));
+						SCALAR(0, 0));
 FORMAT(illuminance)		= SCALAR_FORMAT(3,
 						(UNSIGNED | HAS_UNDEFINED),
 						lux,
-						SCALAR(1e-2, 0));
+						SCALAR(-2, 0));
 FORMAT(luminous_efficacy)	= SCALAR_FORMAT(2,
 						(UNSIGNED | HAS_UNDEFINED),
 						lumen_per_watt,
-						SCALAR(1e-1, 0));
+						SCALAR(-1, 0));
 FORMAT(luminous_energy)		= SCALAR_FORMAT(3,
 						(UNSIGNED | HAS_UNDEFINED),
 						lumen_hour,
-						SCALAR(1e3, 0));
+						SCALAR(3, 0));
 FORMAT(luminous_exposure)	= SCALAR_FORMAT(3,
 						(UNSIGNED | HAS_UNDEFINED),
 						lux_hour,
-						SCALAR(1e3, 0));
+						SCALAR(3, 0));
 FORMAT(luminous_flux)		= SCALAR_FORMAT(2,
 						(UNSIGNED | HAS_UNDEFINED),
 						lumen,
-						SCALAR(1, 0));
+						SCALAR(0, 0));
 FORMAT(perceived_lightness)	= SCALAR_FORMAT(2,
 						UNSIGNED,
 						unitless,
-						SCALAR(1, 0));
+						SCALAR(0, 0));
 
 /*******************************************************************************
  * Miscellaneous formats
@@ -547,15 +832,15 @@ FORMAT(perceived_lightness)	= SCALAR_FORMAT(2,
 FORMAT(count_16)	 = SCALAR_FORMAT(2,
 					 (UNSIGNED | HAS_UNDEFINED),
 					 unitless,
-					 SCALAR(1, 0));
+					 SCALAR(0, 0));
 FORMAT(gen_lvl)		 = SCALAR_FORMAT(2,
 					 UNSIGNED,
 					 unitless,
-					 SCALAR(1, 0));
+					 SCALAR(0, 0));
 FORMAT(cos_of_the_angle) = SCALAR_FORMAT_MAX(1,
 					     SIGNED,
 					     unitless,
-					     SCALAR(1, 0),
+					     SCALAR(0, 0),
 					     100);
 FORMAT(boolean) = {
 	.encode = boolean_encode,
@@ -602,359 +887,276 @@ static const struct bt_mesh_sensor_channel voltage_stats[] = {
 /*******************************************************************************
  * Occupancy
  ******************************************************************************/
-SENSOR_TYPE(motion_sensed) = {
-	.id = BT_MESH_PROP_ID_MOTION_SENSED,
-	CHANNELS(CHANNEL("Motion sensed", percentage_8)),
-};
-SENSOR_TYPE(motion_threshold) = {
-	.id = BT_MESH_PROP_ID_MOTION_THRESHOLD,
-	CHANNELS(CHANNEL("Motion threshold", percentage_8)),
-};
-SENSOR_TYPE(people_count) = {
-	.id = BT_MESH_PROP_ID_PEOPLE_COUNT,
-	CHANNELS(CHANNEL("People count", count_16)),
-};
-SENSOR_TYPE(presence_detected) = {
-	.id = BT_MESH_PROP_ID_PRESENCE_DETECTED,
-	CHANNELS(CHANNEL("Presence detected", boolean)),
-};
-SENSOR_TYPE(time_since_motion_sensed) = {
-	.id = BT_MESH_PROP_ID_TIME_SINCE_MOTION_SENSED,
-	CHANNELS(CHANNEL("Time since motion detected", time_second_16)),
-};
-SENSOR_TYPE(time_since_presence_detected) = {
-	.id = BT_MESH_PROP_ID_TIME_SINCE_PRESENCE_DETECTED,
-	CHANNELS(CHANNEL("Time since presence detected", time_second_16)),
-};
+SENSOR_TYPE(motion_sensed, BT_MESH_PROP_ID_MOTION_SENSED,
+	    CHANNELS(CHANNEL("Motion sensed", percentage_8)));
+SENSOR_TYPE(motion_threshold, BT_MESH_PROP_ID_MOTION_THRESHOLD,
+	    CHANNELS(CHANNEL("Motion threshold", percentage_8)));
+SENSOR_TYPE(people_count, BT_MESH_PROP_ID_PEOPLE_COUNT,
+	    CHANNELS(CHANNEL("People count", count_16)));
+SENSOR_TYPE(presence_detected, BT_MESH_PROP_ID_PRESENCE_DETECTED,
+	    CHANNELS(CHANNEL("Presence detected", boolean)));
+SENSOR_TYPE(time_since_motion_sensed, BT_MESH_PROP_ID_TIME_SINCE_MOTION_SENSED,
+	    CHANNELS(CHANNEL("Time since motion detected", time_second_16)));
+SENSOR_TYPE(time_since_presence_detected,
+	    BT_MESH_PROP_ID_TIME_SINCE_PRESENCE_DETECTED,
+	    CHANNELS(CHANNEL("Time since presence detected", time_second_16)));
 
 /*******************************************************************************
  * Ambient temperature
  ******************************************************************************/
-SENSOR_TYPE(avg_amb_temp_in_day) = {
-	.id = BT_MESH_PROP_ID_AVG_AMB_TEMP_IN_A_PERIOD_OF_DAY,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Temperature", temp_8),
-		 CHANNEL("Start time", time_decihour_8),
-		 CHANNEL("End time", time_decihour_8)),
-};
-SENSOR_TYPE(indoor_amb_temp_stat_values) = {
-	.id = BT_MESH_PROP_ID_INDOOR_AMB_TEMP_STAT_VALUES,
-	CHANNELS(CHANNEL("Avg", temp_8),
-		 CHANNEL("Standard deviation", temp_8),
-		 CHANNEL("Min", temp_8),
-		 CHANNEL("Max", temp_8),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(outdoor_stat_values) = {
-	.id = BT_MESH_PROP_ID_OUTDOOR_STAT_VALUES,
-	CHANNELS(CHANNEL("Avg", temp_8),
-		 CHANNEL("Standard deviation", temp_8),
-		 CHANNEL("Min", temp_8),
-		 CHANNEL("Max", temp_8),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(present_amb_temp) = {
-	.id = BT_MESH_PROP_ID_PRESENT_AMB_TEMP,
-	CHANNELS(CHANNEL("Present ambient temperature", temp_8)),
-};
-SENSOR_TYPE(present_indoor_amb_temp) = {
-	.id = BT_MESH_PROP_ID_PRESENT_INDOOR_AMB_TEMP,
-	CHANNELS(CHANNEL("Present indoor ambient temperature", temp_8)),
-};
-SENSOR_TYPE(present_outdoor_amb_temp) = {
-	.id = BT_MESH_PROP_ID_PRESENT_OUTDOOR_AMB_TEMP,
-	CHANNELS(CHANNEL("Present outdoor ambient temperature", temp_8)),
-};
-SENSOR_TYPE(desired_amb_temp) = {
-	.id = BT_MESH_PROP_ID_DESIRED_AMB_TEMP,
-	CHANNELS(CHANNEL("Desired ambient temperature", temp_8)),
-};
-SENSOR_TYPE(precise_present_amb_temp) = {
-	.id = BT_MESH_PROP_ID_PRECISE_PRESENT_AMB_TEMP,
-	CHANNELS(CHANNEL("Precise present ambient temperature", temp)),
-};
+SENSOR_TYPE(avg_amb_temp_in_day,
+	    BT_MESH_PROP_ID_AVG_AMB_TEMP_IN_A_PERIOD_OF_DAY,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Temperature", temp_8),
+		     CHANNEL("Start time", time_decihour_8),
+		     CHANNEL("End time", time_decihour_8)));
+SENSOR_TYPE(indoor_amb_temp_stat_values,
+	    BT_MESH_PROP_ID_INDOOR_AMB_TEMP_STAT_VALUES,
+	    CHANNELS(CHANNEL("Avg", temp_8),
+		     CHANNEL("Standard deviation", temp_8),
+		     CHANNEL("Min", temp_8),
+		     CHANNEL("Max", temp_8),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(outdoor_stat_values, BT_MESH_PROP_ID_OUTDOOR_STAT_VALUES,
+	    CHANNELS(CHANNEL("Avg", temp_8),
+		     CHANNEL("Standard deviation", temp_8),
+		     CHANNEL("Min", temp_8),
+		     CHANNEL("Max", temp_8),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(present_amb_temp, BT_MESH_PROP_ID_PRESENT_AMB_TEMP,
+	    CHANNELS(CHANNEL("Present ambient temperature", temp_8)));
+SENSOR_TYPE(present_indoor_amb_temp, BT_MESH_PROP_ID_PRESENT_INDOOR_AMB_TEMP,
+	    CHANNELS(CHANNEL("Present indoor ambient temperature", temp_8)));
+SENSOR_TYPE(present_outdoor_amb_temp, BT_MESH_PROP_ID_PRESENT_OUTDOOR_AMB_TEMP,
+	    CHANNELS(CHANNEL("Present outdoor ambient temperature", temp_8)));
+SENSOR_TYPE(desired_amb_temp, BT_MESH_PROP_ID_DESIRED_AMB_TEMP,
+	    CHANNELS(CHANNEL("Desired ambient temperature", temp_8)));
+SENSOR_TYPE(precise_present_amb_temp, BT_MESH_PROP_ID_PRECISE_PRESENT_AMB_TEMP,
+	    CHANNELS(CHANNEL("Precise present ambient temperature", temp)));
 
 /*******************************************************************************
  * Environmental
  ******************************************************************************/
-SENSOR_TYPE(present_amb_rel_humidity) = {
-	.id = BT_MESH_PROP_ID_PRESENT_AMB_REL_HUMIDITY,
-	CHANNELS(CHANNEL("Present ambient relative humidity", humidity)),
-};
-SENSOR_TYPE(present_amb_co2_concentration) = {
-	.id = BT_MESH_PROP_ID_PRESENT_AMB_CO2_CONCENTRATION,
-	CHANNELS(CHANNEL("Present ambient CO2 concentration",
-			 co2_concentration)),
-};
-SENSOR_TYPE(present_amb_voc_concentration) = {
-	.id = BT_MESH_PROP_ID_PRESENT_AMB_VOC_CONCENTRATION,
-	CHANNELS(CHANNEL("Present ambient VOC concentration",
-			 voc_concentration)),
-};
-SENSOR_TYPE(present_amb_noise) = {
-	.id = BT_MESH_PROP_ID_PRESENT_AMB_NOISE,
-	CHANNELS(CHANNEL("Present ambient noise", noise)),
-};
+SENSOR_TYPE(present_amb_rel_humidity, BT_MESH_PROP_ID_PRESENT_AMB_REL_HUMIDITY,
+	    CHANNELS(CHANNEL("Present ambient relative humidity", humidity)));
+SENSOR_TYPE(present_amb_co2_concentration,
+	    BT_MESH_PROP_ID_PRESENT_AMB_CO2_CONCENTRATION,
+	    CHANNELS(CHANNEL("Present ambient CO2 concentration",
+			     co2_concentration)));
+SENSOR_TYPE(present_amb_voc_concentration,
+	    BT_MESH_PROP_ID_PRESENT_AMB_VOC_CONCENTRATION,
+	    CHANNELS(CHANNEL("Present ambient VOC concentration",
+			     voc_concentration)));
+SENSOR_TYPE(present_amb_noise, BT_MESH_PROP_ID_PRESENT_AMB_NOISE,
+	    CHANNELS(CHANNEL("Present ambient noise", noise)));
 
 /*******************************************************************************
  * Device operating temperature
  ******************************************************************************/
-SENSOR_TYPE(dev_op_temp_range_spec) = {
-	.id = BT_MESH_PROP_ID_DEV_OP_TEMP_RANGE_SPEC,
-	CHANNELS(CHANNEL("Min", temp),
-		 CHANNEL("Max", temp)),
-};
-SENSOR_TYPE(dev_op_temp_stat_values) = {
-	.id = BT_MESH_PROP_ID_DEV_OP_TEMP_STAT_VALUES,
-	CHANNELS(CHANNEL("Avg", temp),
-		 CHANNEL("Standard deviation", temp),
-		 CHANNEL("Min", temp),
-		 CHANNEL("Max", temp),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(present_dev_op_temp) = {
-	.id = BT_MESH_PROP_ID_PRESENT_DEV_OP_TEMP,
-	CHANNELS(CHANNEL("Temperature", temp)),
-};
-
-SENSOR_TYPE(rel_runtime_in_a_dev_op_temp_range) = {
-	.id = BT_MESH_PROP_ID_REL_RUNTIME_IN_A_DEV_OP_TEMP_RANGE,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Relative value", percentage_8),
-		 CHANNEL("Min", temp),
-		 CHANNEL("Max", temp))
-};
+SENSOR_TYPE(dev_op_temp_range_spec, BT_MESH_PROP_ID_DEV_OP_TEMP_RANGE_SPEC,
+	    CHANNELS(CHANNEL("Min", temp),
+		     CHANNEL("Max", temp)));
+SENSOR_TYPE(dev_op_temp_stat_values, BT_MESH_PROP_ID_DEV_OP_TEMP_STAT_VALUES,
+	    CHANNELS(CHANNEL("Avg", temp),
+		     CHANNEL("Standard deviation", temp),
+		     CHANNEL("Min", temp),
+		     CHANNEL("Max", temp),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(present_dev_op_temp, BT_MESH_PROP_ID_PRESENT_DEV_OP_TEMP,
+	    CHANNELS(CHANNEL("Temperature", temp)));
+
+SENSOR_TYPE(rel_runtime_in_a_dev_op_temp_range,
+	    BT_MESH_PROP_ID_REL_RUNTIME_IN_A_DEV_OP_TEMP_RANGE,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Relative value", percentage_8),
+		     CHANNEL("Min", temp),
+		     CHANNEL("Max", temp)));
 
 /*******************************************************************************
  * Electrical input
  ******************************************************************************/
-SENSOR_TYPE(avg_input_current) = {
-	.id = BT_MESH_PROP_ID_AVG_INPUT_CURRENT,
-	CHANNELS(CHANNEL("Electric current value", electric_current),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(avg_input_voltage) = {
-	.id = BT_MESH_PROP_ID_AVG_INPUT_VOLTAGE,
-	CHANNELS(CHANNEL("Voltage value", voltage),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(input_current_range_spec) = {
-	.id = BT_MESH_PROP_ID_INPUT_CURRENT_RANGE_SPEC,
-	CHANNELS(CHANNEL("Min", electric_current),
-		 CHANNEL("Max", electric_current),
-		 CHANNEL("Typical electric current value", electric_current)),
-};
-SENSOR_TYPE(input_current_stat) = {
-	.id = BT_MESH_PROP_ID_INPUT_CURRENT_STAT,
-	.channel_count = ARRAY_SIZE(electric_current_stats),
-	.channels = electric_current_stats,
-};
-SENSOR_TYPE(input_voltage_range_spec) = {
-	.id = BT_MESH_PROP_ID_INPUT_VOLTAGE_RANGE_SPEC,
-	CHANNELS(CHANNEL("Min", voltage),
-		 CHANNEL("Max", voltage),
-		 CHANNEL("Typical voltage value", voltage)),
-};
-SENSOR_TYPE(input_voltage_stat) = {
-	.id = BT_MESH_PROP_ID_INPUT_VOLTAGE_STAT,
-	.channel_count = ARRAY_SIZE(voltage_stats),
-	.channels = voltage_stats,
-};
-SENSOR_TYPE(present_input_current) = {
-	.id = BT_MESH_PROP_ID_PRESENT_INPUT_CURRENT,
-	CHANNELS(CHANNEL("Present input current", electric_current)),
-};
-SENSOR_TYPE(present_input_ripple_voltage) = {
-	.id = BT_MESH_PROP_ID_PRESENT_INPUT_RIPPLE_VOLTAGE,
-	CHANNELS(CHANNEL("Present input ripple voltage", percentage_8)),
-};
-SENSOR_TYPE(present_input_voltage) = {
-	.id = BT_MESH_PROP_ID_PRESENT_INPUT_VOLTAGE,
-	CHANNELS(CHANNEL("Present input voltage", voltage)),
-};
-SENSOR_TYPE(rel_runtime_in_an_input_current_range) = {
-	.id = BT_MESH_PROP_ID_REL_RUNTIME_IN_AN_INPUT_CURRENT_RANGE,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Relative runtime value", percentage_8),
-		 CHANNEL("Min", electric_current),
-		 CHANNEL("Max", electric_current)),
-};
-
-SENSOR_TYPE(rel_runtime_in_an_input_voltage_range) = {
-	.id = BT_MESH_PROP_ID_REL_RUNTIME_IN_AN_INPUT_VOLTAGE_RANGE,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Relative runtime value", percentage_8),
-		 CHANNEL("Min", voltage),
-		 CHANNEL("Max", voltage)),
-};
+SENSOR_TYPE(avg_input_current, BT_MESH_PROP_ID_AVG_INPUT_CURRENT,
+	    CHANNELS(CHANNEL("Electric current value", electric_current),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(avg_input_voltage, BT_MESH_PROP_ID_AVG_INPUT_VOLTAGE,
+	    CHANNELS(CHANNEL("Voltage value", voltage),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(input_current_range_spec, BT_MESH_PROP_ID_INPUT_CURRENT_RANGE_SPEC,
+	    CHANNELS(CHANNEL("Min", electric_current),
+		     CHANNEL("Max", electric_current),
+		     CHANNEL("Typical electric current value",
+			     electric_current)));
+SENSOR_TYPE(input_current_stat, BT_MESH_PROP_ID_INPUT_CURRENT_STAT,
+	    .channel_count = ARRAY_SIZE(electric_current_stats),
+	    .channels = electric_current_stats);
+SENSOR_TYPE(input_voltage_range_spec, BT_MESH_PROP_ID_INPUT_VOLTAGE_RANGE_SPEC,
+	    CHANNELS(CHANNEL("Min", voltage),
+		     CHANNEL("Max", voltage),
+		     CHANNEL("Typical voltage value", voltage)));
+SENSOR_TYPE(input_voltage_stat, BT_MESH_PROP_ID_INPUT_VOLTAGE_STAT,
+	    .channel_count = ARRAY_SIZE(voltage_stats),
+	    .channels = voltage_stats);
+SENSOR_TYPE(present_input_current, BT_MESH_PROP_ID_PRESENT_INPUT_CURRENT,
+	    CHANNELS(CHANNEL("Present input current", electric_current)));
+SENSOR_TYPE(present_input_ripple_voltage,
+	    BT_MESH_PROP_ID_PRESENT_INPUT_RIPPLE_VOLTAGE,
+	    CHANNELS(CHANNEL("Present input ripple voltage", percentage_8)));
+SENSOR_TYPE(present_input_voltage, BT_MESH_PROP_ID_PRESENT_INPUT_VOLTAGE,
+	    CHANNELS(CHANNEL("Present input voltage", voltage)));
+SENSOR_TYPE(rel_runtime_in_an_input_current_range,
+	    BT_MESH_PROP_ID_REL_RUNTIME_IN_AN_INPUT_CURRENT_RANGE,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Relative runtime value", percentage_8),
+		     CHANNEL("Min", electric_current),
+		     CHANNEL("Max", electric_current)));
+
+SENSOR_TYPE(rel_runtime_in_an_input_voltage_range,
+	    BT_MESH_PROP_ID_REL_RUNTIME_IN_AN_INPUT_VOLTAGE_RANGE,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Relative runtime value", percentage_8),
+		     CHANNEL("Min", voltage),
+		     CHANNEL("Max", voltage)));
 
 /*******************************************************************************
  * Energy management
  ******************************************************************************/
-SENSOR_TYPE(present_dev_input_power) = {
-	.id = BT_MESH_PROP_ID_PRESENT_DEV_INPUT_POWER,
-	CHANNELS(CHANNEL("Present device input power", power)),
-};
-SENSOR_TYPE(present_dev_op_efficiency) = {
-	.id = BT_MESH_PROP_ID_PRESENT_DEV_OP_EFFICIENCY,
-	CHANNELS(CHANNEL("Present device operating efficiency", percentage_8)),
-};
-SENSOR_TYPE(tot_dev_energy_use) = {
-	.id = BT_MESH_PROP_ID_TOT_DEV_ENERGY_USE,
-	CHANNELS(CHANNEL("Total device energy use", energy)),
-};
-SENSOR_TYPE(precise_tot_dev_energy_use) = {
-	.id = BT_MESH_PROP_ID_PRECISE_TOT_DEV_ENERGY_USE,
-	CHANNELS(CHANNEL("Total device energy use", energy32)),
-};
-SENSOR_TYPE(dev_energy_use_since_turn_on) = {
-	.id = BT_MESH_PROP_ID_DEV_ENERGY_USE_SINCE_TURN_ON,
-	CHANNELS(CHANNEL("Device energy use since turn on", energy)),
-};
-SENSOR_TYPE(power_factor) = {
-	.id = BT_MESH_PROP_ID_POWER_FACTOR,
-	CHANNELS(CHANNEL("Cosine of the angle", cos_of_the_angle)),
-};
-SENSOR_TYPE(rel_dev_energy_use_in_a_period_of_day) = {
-	.id = BT_MESH_PROP_ID_REL_DEV_ENERGY_USE_IN_A_PERIOD_OF_DAY,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Energy", energy),
-		 CHANNEL("Start time", time_decihour_8),
-		 CHANNEL("End time", time_decihour_8)),
-};
-SENSOR_TYPE(rel_dev_runtime_in_a_generic_level_range) = {
-	.id = BT_MESH_PROP_ID_REL_DEV_RUNTIME_IN_A_GENERIC_LEVEL_RANGE,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Relative value", percentage_8),
-		 CHANNEL("Min", gen_lvl),
-		 CHANNEL("Max", gen_lvl)),
-};
+SENSOR_TYPE(present_dev_input_power, BT_MESH_PROP_ID_PRESENT_DEV_INPUT_POWER,
+	    CHANNELS(CHANNEL("Present device input power", power)));
+SENSOR_TYPE(present_dev_op_efficiency,
+	    BT_MESH_PROP_ID_PRESENT_DEV_OP_EFFICIENCY,
+	    CHANNELS(CHANNEL("Present device operating efficiency",
+			     percentage_8)));
+SENSOR_TYPE(tot_dev_energy_use, BT_MESH_PROP_ID_TOT_DEV_ENERGY_USE,
+	    CHANNELS(CHANNEL("Total device energy use", energy)));
+SENSOR_TYPE(precise_tot_dev_energy_use,
+	    BT_MESH_PROP_ID_PRECISE_TOT_DEV_ENERGY_USE,
+	    CHANNELS(CHANNEL("Total device energy use", energy32)));
+SENSOR_TYPE(dev_energy_use_since_turn_on,
+	    BT_MESH_PROP_ID_DEV_ENERGY_USE_SINCE_TURN_ON,
+	    CHANNELS(CHANNEL("Device energy use since turn on", energy)));
+SENSOR_TYPE(power_factor, BT_MESH_PROP_ID_POWER_FACTOR,
+	    CHANNELS(CHANNEL("Cosine of the angle", cos_of_the_angle)));
+SENSOR_TYPE(rel_dev_energy_use_in_a_period_of_day,
+	    BT_MESH_PROP_ID_REL_DEV_ENERGY_USE_IN_A_PERIOD_OF_DAY,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Energy", energy),
+		     CHANNEL("Start time", time_decihour_8),
+		     CHANNEL("End time", time_decihour_8)));
+SENSOR_TYPE(rel_dev_runtime_in_a_generic_level_range,
+	    BT_MESH_PROP_ID_REL_DEV_RUNTIME_IN_A_GENERIC_LEVEL_RANGE,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Relative value", percentage_8),
+		     CHANNEL("Min", gen_lvl),
+		     CHANNEL("Max", gen_lvl)));
 
 /*******************************************************************************
  * Photometry
  ******************************************************************************/
-SENSOR_TYPE(present_amb_light_level) = {
-	.id = BT_MESH_PROP_ID_PRESENT_AMB_LIGHT_LEVEL,
-	CHANNELS(CHANNEL("Present ambient light level", illuminance)),
-};
-SENSOR_TYPE(present_cie_1931_chromaticity_coords) = {
-	.id = BT_MESH_PROP_ID_PRESENT_CIE_1931_CHROMATICITY_COORDS,
-	CHANNELS(CHANNEL("Chromaticity x-coordinate", chromaticity_coordinate),
-		 CHANNEL("Chromaticity y-coordinate", chromaticity_coordinate)),
-};
-SENSOR_TYPE(present_correlated_col_temp) = {
-	.id = BT_MESH_PROP_ID_PRESENT_CORRELATED_COL_TEMP,
-	CHANNELS(CHANNEL("Present correlated color temperature",
-			 correlated_color_temp)),
-};
-SENSOR_TYPE(present_illuminance) = {
-	.id = BT_MESH_PROP_ID_PRESENT_ILLUMINANCE,
-	CHANNELS(CHANNEL("Present illuminance", illuminance)),
-};
-SENSOR_TYPE(present_luminous_flux) = {
-	.id = BT_MESH_PROP_ID_PRESENT_LUMINOUS_FLUX,
-	CHANNELS(CHANNEL("Present luminous flux", luminous_flux)),
-};
-SENSOR_TYPE(present_planckian_distance) = {
-	.id = BT_MESH_PROP_ID_PRESENT_PLANCKIAN_DISTANCE,
-	CHANNELS(CHANNEL("Present planckian distance", chromatic_distance)),
-};
-SENSOR_TYPE(rel_exposure_time_in_an_illuminance_range) = {
-	.id = BT_MESH_PROP_ID_REL_EXPOSURE_TIME_IN_AN_ILLUMINANCE_RANGE,
-	.flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
-	CHANNELS(CHANNEL("Relative value", percentage_8),
-		 CHANNEL("Min", illuminance),
-		 CHANNEL("Max", illuminance))
-};
-SENSOR_TYPE(tot_light_exposure_time) = {
-	.id = BT_MESH_PROP_ID_TOT_LIGHT_EXPOSURE_TIME,
-	CHANNELS(CHANNEL("Total light exposure time", time_hour_24)),
-};
-SENSOR_TYPE(lumen_maintenance_factor) = {
-	.id = BT_MESH_PROP_ID_LUMEN_MAINTENANCE_FACTOR,
-	CHANNELS(CHANNEL("Lumen maintenance factor", percentage_8)),
-};
-SENSOR_TYPE(luminous_efficacy) = {
-	.id = BT_MESH_PROP_ID_LUMINOUS_EFFICACY,
-	CHANNELS(CHANNEL("Luminous efficacy", luminous_efficacy)),
-};
-SENSOR_TYPE(luminous_energy_since_turn_on) = {
-	.id = BT_MESH_PROP_ID_LUMINOUS_ENERGY_SINCE_TURN_ON,
-	CHANNELS(CHANNEL("Luminous energy since turn on", luminous_energy)),
-};
-SENSOR_TYPE(luminous_exposure) = {
-	.id = BT_MESH_PROP_ID_LUMINOUS_EXPOSURE,
-	CHANNELS(CHANNEL("Luminous exposure", luminous_exposure)),
-};
-SENSOR_TYPE(luminous_flux_range) = {
-	.id = BT_MESH_PROP_ID_LUMINOUS_FLUX_RANGE,
-	CHANNELS(CHANNEL("Min", luminous_flux),
-		 CHANNEL("Max", luminous_flux)),
-};
+SENSOR_TYPE(present_amb_light_level, BT_MESH_PROP_ID_PRESENT_AMB_LIGHT_LEVEL,
+	    CHANNELS(CHANNEL("Present ambient light level", illuminance)));
+SENSOR_TYPE(present_cie_1931_chromaticity_coords,
+	    BT_MESH_PROP_ID_PRESENT_CIE_1931_CHROMATICITY_COORDS,
+	    CHANNELS(CHANNEL("Chromaticity x-coordinate",
+			     chromaticity_coordinate),
+		     CHANNEL("Chromaticity y-coordinate",
+			     chromaticity_coordinate)));
+SENSOR_TYPE(present_correlated_col_temp,
+	    BT_MESH_PROP_ID_PRESENT_CORRELATED_COL_TEMP,
+	    CHANNELS(CHANNEL("Present correlated color temperature",
+			     correlated_color_temp)));
+SENSOR_TYPE(present_illuminance, BT_MESH_PROP_ID_PRESENT_ILLUMINANCE,
+	    CHANNELS(CHANNEL("Present illuminance", illuminance)));
+SENSOR_TYPE(present_luminous_flux, BT_MESH_PROP_ID_PRESENT_LUMINOUS_FLUX,
+	    CHANNELS(CHANNEL("Present luminous flux", luminous_flux)));
+SENSOR_TYPE(present_planckian_distance,
+	    BT_MESH_PROP_ID_PRESENT_PLANCKIAN_DISTANCE,
+	    CHANNELS(CHANNEL("Present planckian distance",
+			     chromatic_distance)));
+SENSOR_TYPE(rel_exposure_time_in_an_illuminance_range,
+	    BT_MESH_PROP_ID_REL_EXPOSURE_TIME_IN_AN_ILLUMINANCE_RANGE,
+	    .flags = BT_MESH_SENSOR_TYPE_FLAG_SERIES,
+	    CHANNELS(CHANNEL("Relative value", percentage_8),
+		     CHANNEL("Min", illuminance),
+		     CHANNEL("Max", illuminance)));
+SENSOR_TYPE(tot_light_exposure_time, BT_MESH_PROP_ID_TOT_LIGHT_EXPOSURE_TIME,
+	    CHANNELS(CHANNEL("Total light exposure time", time_hour_24)));
+SENSOR_TYPE(lumen_maintenance_factor, BT_MESH_PROP_ID_LUMEN_MAINTENANCE_FACTOR,
+	    CHANNELS(CHANNEL("Lumen maintenance factor", percentage_8)));
+SENSOR_TYPE(luminous_efficacy, BT_MESH_PROP_ID_LUMINOUS_EFFICACY,
+	    CHANNELS(CHANNEL("Luminous efficacy", luminous_efficacy)));
+SENSOR_TYPE(luminous_energy_since_turn_on,
+	    BT_MESH_PROP_ID_LUMINOUS_ENERGY_SINCE_TURN_ON,
+	    CHANNELS(CHANNEL("Luminous energy since turn on",
+			     luminous_energy)));
+SENSOR_TYPE(luminous_exposure, BT_MESH_PROP_ID_LUMINOUS_EXPOSURE,
+	    CHANNELS(CHANNEL("Luminous exposure", luminous_exposure)));
+SENSOR_TYPE(luminous_flux_range, BT_MESH_PROP_ID_LUMINOUS_FLUX_RANGE,
+	    CHANNELS(CHANNEL("Min", luminous_flux),
+		     CHANNEL("Max", luminous_flux)));
 
 /*******************************************************************************
  * Power supply output
  ******************************************************************************/
-SENSOR_TYPE(avg_output_current) = {
-	.id = BT_MESH_PROP_ID_AVG_OUTPUT_CURRENT,
-	CHANNELS(CHANNEL("Electric current value", electric_current),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(avg_output_voltage) = {
-	.id = BT_MESH_PROP_ID_AVG_OUTPUT_VOLTAGE,
-	CHANNELS(CHANNEL("Voltage value", voltage),
-		 CHANNEL("Sensing duration", time_exp_8)),
-};
-SENSOR_TYPE(output_current_range) = {
-	.id = BT_MESH_PROP_ID_OUTPUT_CURRENT_RANGE,
-	CHANNELS(CHANNEL("Min", electric_current),
-		 CHANNEL("Max", electric_current)),
-};
-SENSOR_TYPE(output_current_stat) = {
-	.id = BT_MESH_PROP_ID_OUTPUT_CURRENT_STAT,
-	.channel_count = ARRAY_SIZE(electric_current_stats),
-	.channels = electric_current_stats,
-};
-SENSOR_TYPE(output_ripple_voltage_spec) = {
-	.id = BT_MESH_PROP_ID_OUTPUT_RIPPLE_VOLTAGE_SPEC,
-	CHANNELS(CHANNEL("Output ripple voltage", percentage_8)),
-};
-SENSOR_TYPE(output_voltage_range) = {
-	.id = BT_MESH_PROP_ID_OUTPUT_VOLTAGE_RANGE,
-	CHANNELS(CHANNEL("Min", voltage),
-		 CHANNEL("Max", voltage)),
-};
-SENSOR_TYPE(output_voltage_stat) = {
-	.id = BT_MESH_PROP_ID_OUTPUT_VOLTAGE_STAT,
-	.channel_count = ARRAY_SIZE(voltage_stats),
-	.channels = voltage_stats,
-};
-SENSOR_TYPE(present_output_current) = {
-	.id = BT_MESH_PROP_ID_PRESENT_OUTPUT_CURRENT,
-	CHANNELS(CHANNEL("Present output current", electric_current)),
-};
-SENSOR_TYPE(present_output_voltage) = {
-	.id = BT_MESH_PROP_ID_PRESENT_OUTPUT_VOLTAGE,
-	CHANNELS(CHANNEL("Present output voltage", voltage)),
-};
-SENSOR_TYPE(present_rel_output_ripple_voltage) = {
-	.id = BT_MESH_PROP_ID_PRESENT_REL_OUTPUT_RIPPLE_VOLTAGE,
-	CHANNELS(CHANNEL("Output ripple voltage", percentage_8)),
-};
-
-SENSOR_TYPE(gain) = {
-	.id = BT_MESH_PROP_ID_SENSOR_GAIN,
-	CHANNELS(CHANNEL("Sensor gain", coefficient)),
-};
+SENSOR_TYPE(avg_output_current, BT_MESH_PROP_ID_AVG_OUTPUT_CURRENT,
+	    CHANNELS(CHANNEL("Electric current value", electric_current),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(avg_output_voltage, BT_MESH_PROP_ID_AVG_OUTPUT_VOLTAGE,
+	    CHANNELS(CHANNEL("Voltage value", voltage),
+		     CHANNEL("Sensing duration", time_exp_8)));
+SENSOR_TYPE(output_current_range, BT_MESH_PROP_ID_OUTPUT_CURRENT_RANGE,
+	    CHANNELS(CHANNEL("Min", electric_current),
+		     CHANNEL("Max", electric_current)));
+SENSOR_TYPE(output_current_stat, BT_MESH_PROP_ID_OUTPUT_CURRENT_STAT,
+	    .channel_count = ARRAY_SIZE(electric_current_stats),
+	    .channels = electric_current_stats);
+SENSOR_TYPE(output_ripple_voltage_spec,
+	    BT_MESH_PROP_ID_OUTPUT_RIPPLE_VOLTAGE_SPEC,
+	    CHANNELS(CHANNEL("Output ripple voltage", percentage_8)));
+SENSOR_TYPE(output_voltage_range, BT_MESH_PROP_ID_OUTPUT_VOLTAGE_RANGE,
+	    CHANNELS(CHANNEL("Min", voltage),
+		     CHANNEL("Max", voltage)));
+SENSOR_TYPE(output_voltage_stat, BT_MESH_PROP_ID_OUTPUT_VOLTAGE_STAT,
+	    .channel_count = ARRAY_SIZE(voltage_stats),
+	    .channels = voltage_stats);
+SENSOR_TYPE(present_output_current, BT_MESH_PROP_ID_PRESENT_OUTPUT_CURRENT,
+	    CHANNELS(CHANNEL("Present output current", electric_current)));
+SENSOR_TYPE(present_output_voltage, BT_MESH_PROP_ID_PRESENT_OUTPUT_VOLTAGE,
+	    CHANNELS(CHANNEL("Present output voltage", voltage)));
+SENSOR_TYPE(present_rel_output_ripple_voltage,
+	    BT_MESH_PROP_ID_PRESENT_REL_OUTPUT_RIPPLE_VOLTAGE,
+	    CHANNELS(CHANNEL("Output ripple voltage", percentage_8)));
+
+SENSOR_TYPE(gain, BT_MESH_PROP_ID_SENSOR_GAIN,
+	    CHANNELS(CHANNEL("Sensor gain", coefficient)));
 /******************************************************************************/
 
 const struct bt_mesh_sensor_type *bt_mesh_sensor_type_get(u16_t id)
 {
-	Z_STRUCT_SECTION_FOREACH(bt_mesh_sensor_type, type) {
-		if (type->id == id) {
-			return type;
+	extern const struct bt_mesh_sensor_type
+		_bt_mesh_sensor_type_list_start[];
+	extern const struct bt_mesh_sensor_type
+		_bt_mesh_sensor_type_list_end[];
+	const struct bt_mesh_sensor_type *types =
+		_bt_mesh_sensor_type_list_start;
+	size_t count = _bt_mesh_sensor_type_list_end -
+		       _bt_mesh_sensor_type_list_start;
+	size_t lower = 0;
+	size_t upper = count;
+
+	/* Sensor types are sorted by ID, see SENSOR_TYPE. */
+	while (lower < upper) {
+		size_t mid = lower + (upper - lower) / 2;
+
+		if (types[mid].id < id) {
+			lower = mid + 1;
+		} else {
+			upper = mid;
 		}
 	}
 
+	if ((lower < count) && (types[lower].id == id)) {
+		return &types[lower];
+	}
+
 	return NULL;
 }
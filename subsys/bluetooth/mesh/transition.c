@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <init.h>
+#include <bluetooth/mesh/transition.h>
+
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG_MODEL)
+#define LOG_MODULE_NAME bt_mesh_transition
+#include "common/log.h"
+
+#define STEP_INTERVAL CONFIG_BT_MESH_TRANSITION_STEP_INTERVAL
+
+#define TRANSITION_FOR_EACH(_list, _node)                                      \
+	SYS_SLIST_FOR_EACH_CONTAINER(_list, _node, state.node)
+
+static struct k_delayed_work step_work;
+static sys_slist_t transitions;
+/* Step pass counter. Transitions started in a pass wait for the next one. */
+static u32_t step_pass;
+
+/* Protects the transition list and the step work. The step callbacks are
+ * called with the mutex held, and may start or stop transitions.
+ */
+static K_MUTEX_DEFINE(transitions_mutex);
+
+/** Get the first point on the step grid after the given time. */
+static u32_t next_step_time(u32_t time)
+{
+	return time - (time % STEP_INTERVAL) + STEP_INTERVAL;
+}
+
+static s32_t value_at(const struct bt_mesh_transition *transition,
+		      u32_t elapsed)
+{
+	s32_t delta = transition->state.target - transition->state.start;
+
+	return transition->state.start +
+	       (s32_t)(((s64_t)delta * elapsed) / transition->state.duration);
+}
+
+static void transition_remove(struct bt_mesh_transition *transition)
+{
+	if (transition->state.active) {
+		sys_slist_find_and_remove(&transitions,
+					  &transition->state.node);
+		transition->state.active = false;
+	}
+}
+
+/* Schedule the next step at the first grid point where any of the transitions
+ * may change, or stop the timer if there are no transitions left.
+ */
+static void schedule(u32_t now)
+{
+	struct bt_mesh_transition *transition;
+	u32_t next = UINT32_MAX;
+
+	TRANSITION_FOR_EACH(&transitions, transition)
+	{
+		s32_t until_start = transition->state.start_time - now;
+		u32_t from = (until_start > 0) ? transition->state.start_time :
+						 now;
+
+		next = MIN(next, next_step_time(from) - now);
+	}
+
+	if (next == UINT32_MAX) {
+		k_delayed_work_cancel(&step_work);
+		return;
+	}
+
+	k_delayed_work_submit(&step_work, K_MSEC(next));
+}
+
+/* Step the next transition that hasn't been processed in this pass. Returns
+ * false when all transitions have been processed.
+ */
+static bool step_next(u32_t now)
+{
+	struct bt_mesh_transition *transition;
+
+	TRANSITION_FOR_EACH(&transitions, transition)
+	{
+		if (transition->state.pass == step_pass) {
+			continue;
+		}
+
+		transition->state.pass = step_pass;
+
+		s32_t elapsed = now - transition->state.start_time;
+
+		if (elapsed < 0) {
+			continue;
+		}
+
+		if ((u32_t)elapsed >= transition->state.duration) {
+			transition_remove(transition);
+			transition->state.value = transition->state.target;
+			transition->step(transition, transition->state.target,
+					 true);
+			return true;
+		}
+
+		s32_t value = value_at(transition, elapsed);
+
+		/* Slow transitions may not change on every step: */
+		if (value != transition->state.value) {
+			transition->state.value = value;
+			transition->step(transition, value, false);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void step_timeout(struct k_work *work)
+{
+	u32_t now = k_uptime_get_32();
+
+	k_mutex_lock(&transitions_mutex, K_FOREVER);
+
+	step_pass++;
+
+	/* The step callbacks may start or stop transitions, so the list is
+	 * walked from the start again after every callback.
+	 */
+	while (step_next(now)) {
+	}
+
+	schedule(now);
+
+	k_mutex_unlock(&transitions_mutex);
+}
+
+void bt_mesh_transition_start(struct bt_mesh_transition *transition,
+			      s32_t start, s32_t target,
+			      const struct bt_mesh_model_transition *params)
+{
+	u32_t now = k_uptime_get_32();
+
+	k_mutex_lock(&transitions_mutex, K_FOREVER);
+
+	transition_remove(transition);
+
+	if (!params || (params->time == 0 && params->delay == 0)) {
+		transition->state.value = target;
+		transition->step(transition, target, true);
+		schedule(now);
+		k_mutex_unlock(&transitions_mutex);
+		return;
+	}
+
+	BT_DBG("%d -> %d [%u + %u ms]", start, target, params->delay,
+	       params->time);
+
+	transition->state.start = start;
+	transition->state.target = target;
+	transition->state.value = start;
+	transition->state.start_time = now + params->delay;
+	transition->state.duration = params->time;
+	transition->state.pass = step_pass;
+	transition->state.active = true;
+
+	sys_slist_append(&transitions, &transition->state.node);
+
+	schedule(now);
+
+	k_mutex_unlock(&transitions_mutex);
+}
+
+void bt_mesh_transition_stop(struct bt_mesh_transition *transition)
+{
+	k_mutex_lock(&transitions_mutex, K_FOREVER);
+
+	if (transition->state.active) {
+		transition_remove(transition);
+		schedule(k_uptime_get_32());
+	}
+
+	k_mutex_unlock(&transitions_mutex);
+}
+
+bool bt_mesh_transition_in_progress(
+	const struct bt_mesh_transition *transition)
+{
+	bool active;
+
+	k_mutex_lock(&transitions_mutex, K_FOREVER);
+	active = transition->state.active;
+	k_mutex_unlock(&transitions_mutex);
+
+	return active;
+}
+
+u32_t bt_mesh_transition_remaining(const struct bt_mesh_transition *transition)
+{
+	u32_t remaining = 0;
+
+	k_mutex_lock(&transitions_mutex, K_FOREVER);
+
+	if (transition->state.active) {
+		s32_t elapsed =
+			k_uptime_get_32() - transition->state.start_time;
+
+		if (elapsed < (s32_t)transition->state.duration) {
+			remaining = transition->state.duration - elapsed;
+		}
+	}
+
+	k_mutex_unlock(&transitions_mutex);
+
+	return remaining;
+}
+
+static int transition_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_delayed_work_init(&step_work, step_timeout);
+
+	return 0;
+}
+
+SYS_INIT(transition_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -4,9 +4,11 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <sys/printk.h>
 #include <zephyr/types.h>
+#include <init.h>
 #include <logging/log.h>
 
 #include <bluetooth/bluetooth.h>
@@ -17,15 +19,220 @@
 #include <bluetooth/services/latency.h>
 #include <bluetooth/services/latency_c.h>
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_SHELL)
+#include <shell/shell.h>
+#endif
+
 LOG_MODULE_REGISTER(bt_gatt_latency_c, CONFIG_BT_GATT_LATENCY_C_LOG_LEVEL);
 
 enum {
 	LATENCY_INITIALIZED,
-	LATENCY_ASYNC_WRITE_PENDING
+	LATENCY_ASYNC_WRITE_PENDING,
+	LATENCY_MEASURING
 };
 
 static const struct bt_gatt_latency_c_cb *callbacks;
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+/* Measured clients, each with a reference to its connection. */
+static struct {
+	struct bt_gatt_latency_c *latency;
+	struct bt_conn *conn;
+} measured[CONFIG_BT_MAX_CONN];
+
+/* Initialized clients, used to drop their connection on disconnection. */
+static sys_slist_t clients = SYS_SLIST_STATIC_INIT(&clients);
+
+/* Protects the measured and clients lists. */
+static K_MUTEX_DEFINE(measured_mutex);
+
+static void stats_update(struct bt_gatt_latency_c *latency)
+{
+	struct bt_gatt_latency_c_stats *stats = &latency->stats;
+	u32_t rtt = k_cyc_to_us_floor32(k_cycle_get_32() - latency->req_stamp);
+	size_t bucket = MIN(rtt / CONFIG_BT_GATT_LATENCY_C_STATS_BUCKET_US,
+			    ARRAY_SIZE(stats->hist) - 1);
+
+	stats->hist[bucket]++;
+	stats->count++;
+	stats->last = rtt;
+	stats->max = MAX(stats->max, rtt);
+
+	stats->last_event = latency->req_event;
+	stats->last_event_span = latency->event_counter - latency->req_event;
+	stats->max_event_span = MAX(stats->max_event_span,
+				    stats->last_event_span);
+}
+
+static void measure_work_handler(struct k_work *work)
+{
+	struct bt_gatt_latency_c *latency =
+		CONTAINER_OF(work, struct bt_gatt_latency_c, measure_work);
+	int err;
+
+	if (!atomic_test_bit(&latency->state, LATENCY_MEASURING)) {
+		return;
+	}
+
+	err = bt_gatt_latency_c_request(latency, &latency->req_stamp,
+					sizeof(latency->req_stamp));
+	if (err) {
+		/* Retry after the next period, the link may be busy. */
+		k_delayed_work_submit(&latency->measure_work,
+				      K_MSEC(MAX(latency->measure_period, 1)));
+	}
+}
+
+static void measure_cancel(struct bt_gatt_latency_c *latency)
+{
+	atomic_clear_bit(&latency->state, LATENCY_MEASURING);
+	k_delayed_work_cancel(&latency->measure_work);
+}
+
+/* Must be called with measured_mutex held. */
+static void measured_release(size_t id)
+{
+	measure_cancel(measured[id].latency);
+	bt_conn_unref(measured[id].conn);
+
+	measured[id].latency = NULL;
+	measured[id].conn = NULL;
+}
+
+int bt_gatt_latency_c_measure_start(struct bt_gatt_latency_c *latency,
+				    u32_t period)
+{
+	size_t free_slot = ARRAY_SIZE(measured);
+
+	if (!latency) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	if (!latency->conn) {
+		k_mutex_unlock(&measured_mutex);
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(measured); i++) {
+		if (measured[i].latency == latency) {
+			free_slot = i;
+			break;
+		} else if (!measured[i].latency &&
+			   (free_slot == ARRAY_SIZE(measured))) {
+			free_slot = i;
+		}
+	}
+
+	if (free_slot == ARRAY_SIZE(measured)) {
+		k_mutex_unlock(&measured_mutex);
+		return -ENOMEM;
+	}
+
+	if (!measured[free_slot].latency) {
+		measured[free_slot].latency = latency;
+		measured[free_slot].conn = bt_conn_ref(latency->conn);
+	}
+
+	latency->measure_period = period;
+	atomic_set_bit(&latency->state, LATENCY_MEASURING);
+
+	k_mutex_unlock(&measured_mutex);
+
+	return k_delayed_work_submit(&latency->measure_work, K_NO_WAIT);
+}
+
+void bt_gatt_latency_c_measure_stop(struct bt_gatt_latency_c *latency)
+{
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	measure_cancel(latency);
+
+	for (size_t i = 0; i < ARRAY_SIZE(measured); i++) {
+		if (measured[i].latency == latency) {
+			measured_release(i);
+		}
+	}
+
+	k_mutex_unlock(&measured_mutex);
+}
+
+void bt_gatt_latency_c_stats_reset(struct bt_gatt_latency_c *latency)
+{
+	memset(&latency->stats, 0, sizeof(latency->stats));
+}
+
+u32_t bt_gatt_latency_c_percentile_get(const struct bt_gatt_latency_c *latency,
+				       u8_t percent)
+{
+	const struct bt_gatt_latency_c_stats *stats = &latency->stats;
+	u32_t threshold;
+	u32_t sum = 0;
+
+	if (!stats->count) {
+		return 0;
+	}
+
+	threshold = DIV_ROUND_UP((u64_t)stats->count * percent, 100);
+
+	for (size_t i = 0; i < ARRAY_SIZE(stats->hist) - 1; i++) {
+		sum += stats->hist[i];
+		if (sum >= threshold) {
+			return MIN((i + 1) *
+				   CONFIG_BT_GATT_LATENCY_C_STATS_BUCKET_US,
+				   stats->max);
+		}
+	}
+
+	return stats->max;
+}
+
+void bt_gatt_latency_c_conn_event_update(struct bt_gatt_latency_c *latency,
+					 u16_t event_counter)
+{
+	latency->event_counter = event_counter;
+}
+
+static void disconnected(struct bt_conn *conn, u8_t reason)
+{
+	struct bt_gatt_latency_c *latency;
+
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(measured); i++) {
+		if (measured[i].conn == conn) {
+			LOG_DBG("Measurement stopped on disconnection");
+			measured_release(i);
+		}
+	}
+
+	/* The connection object can be reused once it is disconnected. */
+	SYS_SLIST_FOR_EACH_CONTAINER(&clients, latency, node) {
+		if (latency->conn == conn) {
+			latency->conn = NULL;
+		}
+	}
+
+	k_mutex_unlock(&measured_mutex);
+}
+
+static struct bt_conn_cb conn_callbacks = {
+	.disconnected = disconnected,
+};
+
+static int latency_c_sys_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	bt_conn_cb_register(&conn_callbacks);
+
+	return 0;
+}
+
+SYS_INIT(latency_c_sys_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* CONFIG_BT_GATT_LATENCY_C_STATS */
+
 static void received_latency_response(struct bt_conn *conn, u8_t err,
 				      struct bt_gatt_write_params *params)
 {
@@ -43,6 +250,17 @@ static void received_latency_response(struct bt_conn *conn, u8_t err,
 
 	atomic_clear_bit(&latency->state, LATENCY_ASYNC_WRITE_PENDING);
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+	if (atomic_test_bit(&latency->state, LATENCY_MEASURING)) {
+		if (!err) {
+			stats_update(latency);
+		}
+
+		k_delayed_work_submit(&latency->measure_work,
+				      K_MSEC(latency->measure_period));
+	}
+#endif
+
 	if (err) {
 		LOG_ERR("Received invalid Latency response (err %d)", err);
 		return;
@@ -67,6 +285,15 @@ int bt_gatt_latency_c_init(struct bt_gatt_latency_c *latency,
 	}
 
 	callbacks = cb;
+
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+	k_delayed_work_init(&latency->measure_work, measure_work_handler);
+
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+	sys_slist_append(&clients, &latency->node);
+	k_mutex_unlock(&measured_mutex);
+#endif
+
 	return 0;
 }
 
@@ -118,6 +345,10 @@ int bt_gatt_latency_c_request(struct bt_gatt_latency_c *latency,
 {
 	int err;
 
+	if (!latency->conn) {
+		return -ENOTCONN;
+	}
+
 	if (atomic_test_and_set_bit(&latency->state,
 				    LATENCY_ASYNC_WRITE_PENDING)) {
 		return -EALREADY;
@@ -129,6 +360,11 @@ int bt_gatt_latency_c_request(struct bt_gatt_latency_c *latency,
 	latency->latency_params.data = data;
 	latency->latency_params.length = len;
 
+#if defined(CONFIG_BT_GATT_LATENCY_C_STATS)
+	latency->req_stamp = k_cycle_get_32();
+	latency->req_event = latency->event_counter;
+#endif
+
 	err = bt_gatt_write(latency->conn, &latency->latency_params);
 	if (err) {
 		LOG_ERR("Send Latency request failed (err %d)", err);
@@ -137,3 +373,117 @@ int bt_gatt_latency_c_request(struct bt_gatt_latency_c *latency,
 
 	return err;
 }
+
+#if defined(CONFIG_BT_GATT_LATENCY_C_SHELL)
+static int cmd_start(const struct shell *shell, size_t argc, char **argv)
+{
+	struct bt_gatt_latency_c *latency;
+	u32_t period = strtoul(argv[1], NULL, 0);
+	size_t started = 0;
+
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&clients, latency, node) {
+		int err;
+
+		if (!latency->conn) {
+			continue;
+		}
+
+		err = bt_gatt_latency_c_measure_start(latency, period);
+		if (err) {
+			shell_error(shell, "Measurement start failed (err %d)",
+				    err);
+		} else {
+			started++;
+		}
+	}
+
+	k_mutex_unlock(&measured_mutex);
+
+	shell_print(shell, "Measuring %u connection(s) every %u ms", started,
+		    period);
+
+	return 0;
+}
+
+static int cmd_stop(const struct shell *shell, size_t argc, char **argv)
+{
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(measured); i++) {
+		if (measured[i].latency) {
+			measured_release(i);
+		}
+	}
+
+	k_mutex_unlock(&measured_mutex);
+
+	shell_print(shell, "Latency measurement stopped");
+
+	return 0;
+}
+
+static int cmd_stats(const struct shell *shell, size_t argc, char **argv)
+{
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(measured); i++) {
+		const struct bt_gatt_latency_c *latency = measured[i].latency;
+		char addr[BT_ADDR_LE_STR_LEN];
+
+		if (!latency) {
+			continue;
+		}
+
+		bt_addr_le_to_str(bt_conn_get_dst(measured[i].conn), addr,
+				  sizeof(addr));
+
+		shell_print(shell, "%s: count %u last %u us max %u us", addr,
+			    latency->stats.count, latency->stats.last,
+			    latency->stats.max);
+		shell_print(shell, "  p50 %u us p90 %u us p99 %u us",
+			    bt_gatt_latency_c_percentile_get(latency, 50),
+			    bt_gatt_latency_c_percentile_get(latency, 90),
+			    bt_gatt_latency_c_percentile_get(latency, 99));
+		shell_print(shell, "  last event %u span %u max span %u",
+			    latency->stats.last_event,
+			    latency->stats.last_event_span,
+			    latency->stats.max_event_span);
+	}
+
+	k_mutex_unlock(&measured_mutex);
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *shell, size_t argc, char **argv)
+{
+	k_mutex_lock(&measured_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(measured); i++) {
+		if (measured[i].latency) {
+			bt_gatt_latency_c_stats_reset(measured[i].latency);
+		}
+	}
+
+	k_mutex_unlock(&measured_mutex);
+
+	shell_print(shell, "Latency statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_latency_c,
+	SHELL_CMD_ARG(start, NULL,
+		      "Start measuring all connections <period_ms>",
+		      cmd_start, 2, 0),
+	SHELL_CMD_ARG(stop, NULL, "Stop measuring", cmd_stop, 1, 0),
+	SHELL_CMD_ARG(stats, NULL, "Print latency statistics", cmd_stats, 1, 0),
+	SHELL_CMD_ARG(reset, NULL, "Reset latency statistics", cmd_reset, 1, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(latency_c, &sub_latency_c, "Latency client commands",
+		   NULL);
+#endif /* CONFIG_BT_GATT_LATENCY_C_SHELL */
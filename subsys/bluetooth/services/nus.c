@@ -4,9 +4,11 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 
+#include <init.h>
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
+#include <sys/ring_buffer.h>
 
 #include <bluetooth/services/nus.h>
 #include <logging/log.h>
@@ -57,6 +59,225 @@ BT_GATT_PRIMARY_SERVICE(BT_UUID_NUS_SERVICE),
 			       NULL, on_receive, NULL),
 );
 
+#if defined(CONFIG_BT_GATT_NUS_TX_QUEUE)
+#define TX_IN_FLIGHT_MAX CONFIG_BT_GATT_NUS_TX_QUEUE_MAX_IN_FLIGHT
+#define TX_RETRY_DELAY K_MSEC(CONFIG_BT_GATT_NUS_TX_QUEUE_RETRY_DELAY)
+
+enum {
+	TX_RESET,
+};
+
+RING_BUF_DECLARE(tx_ring_buf, CONFIG_BT_GATT_NUS_TX_QUEUE_SIZE);
+static K_SEM_DEFINE(tx_credits, TX_IN_FLIGHT_MAX, TX_IN_FLIGHT_MAX);
+static K_SEM_DEFINE(tx_space, 0, 1);
+static K_MUTEX_DEFINE(tx_mutex);
+static struct k_delayed_work tx_work;
+static struct bt_conn *tx_conn;
+static atomic_t tx_flags;
+
+static u32_t tx_queued_get(void)
+{
+	return ring_buf_capacity_get(&tx_ring_buf) -
+	       ring_buf_space_get(&tx_ring_buf);
+}
+
+/* Must be called with tx_mutex held. */
+static void tx_discard(void)
+{
+	u8_t *data;
+	u32_t len;
+
+	do {
+		len = ring_buf_get_claim(&tx_ring_buf, &data, UINT32_MAX);
+		ring_buf_get_finish(&tx_ring_buf, len);
+	} while (len);
+}
+
+/* Must be called with tx_mutex held. */
+static void tx_reset(void)
+{
+	tx_discard();
+
+	k_sem_reset(&tx_credits);
+	for (size_t i = 0; i < TX_IN_FLIGHT_MAX; i++) {
+		k_sem_give(&tx_credits);
+	}
+
+	if (tx_conn) {
+		bt_conn_unref(tx_conn);
+		tx_conn = NULL;
+	}
+
+	/* Wake up the producer so that it notices the disconnection. */
+	k_sem_give(&tx_space);
+}
+
+static void on_queue_sent(struct bt_conn *conn, void *user_data)
+{
+	k_sem_give(&tx_credits);
+	k_delayed_work_submit(&tx_work, K_NO_WAIT);
+
+	on_sent(conn, user_data);
+}
+
+static void tx_send(struct bt_conn *conn)
+{
+	const struct bt_gatt_attr *attr = &nus_svc.attrs[2];
+
+	if (!bt_gatt_is_subscribed(conn, attr, BT_GATT_CCC_NOTIFY)) {
+		/* Peer has not enabled notifications: don't accumulate data. */
+		tx_discard();
+		k_sem_give(&tx_space);
+		return;
+	}
+
+	while (!ring_buf_is_empty(&tx_ring_buf)) {
+		struct bt_gatt_notify_params params = {0};
+		u32_t max_len = bt_gatt_nus_max_send(conn);
+		u8_t *data;
+		int err;
+
+		/* Let small writes accumulate into a full notification while
+		 * the previous ones are still in flight. The next completed
+		 * notification resumes sending.
+		 */
+		if ((tx_queued_get() < max_len) &&
+		    (k_sem_count_get(&tx_credits) < TX_IN_FLIGHT_MAX)) {
+			break;
+		}
+
+		if (k_sem_take(&tx_credits, K_NO_WAIT)) {
+			break;
+		}
+
+		params.attr = attr;
+		params.len = ring_buf_get_claim(&tx_ring_buf, &data, max_len);
+		params.data = data;
+		params.func = on_queue_sent;
+
+		err = bt_gatt_notify_cb(conn, &params);
+		if (err) {
+			ring_buf_get_finish(&tx_ring_buf, 0);
+			k_sem_give(&tx_credits);
+
+			if (err == -ENOMEM) {
+				k_delayed_work_submit(&tx_work, TX_RETRY_DELAY);
+			} else {
+				LOG_WRN("Cannot send queued data (err %d)",
+					err);
+				tx_discard();
+				k_sem_give(&tx_space);
+			}
+			return;
+		}
+
+		/* The notification data is copied by the stack. */
+		ring_buf_get_finish(&tx_ring_buf, params.len);
+		k_sem_give(&tx_space);
+	}
+}
+
+static void tx_work_handler(struct k_work *work)
+{
+	/* Producers only hold the mutex while they copy data into the
+	 * ring buffer, so the queue is drained with the mutex held.
+	 */
+	k_mutex_lock(&tx_mutex, K_FOREVER);
+
+	if (atomic_test_and_clear_bit(&tx_flags, TX_RESET)) {
+		tx_reset();
+	} else if (tx_conn) {
+		tx_send(tx_conn);
+	}
+
+	k_mutex_unlock(&tx_mutex);
+}
+
+static void disconnected(struct bt_conn *conn, u8_t reason)
+{
+	if (conn == tx_conn) {
+		atomic_set_bit(&tx_flags, TX_RESET);
+		k_delayed_work_submit(&tx_work, K_NO_WAIT);
+	}
+}
+
+static struct bt_conn_cb conn_callbacks = {
+	.disconnected = disconnected,
+};
+
+int bt_gatt_nus_tx_queue_put(struct bt_conn *conn, const u8_t *data,
+			     u16_t len, k_timeout_t timeout)
+{
+	const struct bt_gatt_attr *attr = &nus_svc.attrs[2];
+	u32_t written = 0;
+
+	if (!conn || !data) {
+		return -EINVAL;
+	}
+
+	if (!bt_gatt_is_subscribed(conn, attr, BT_GATT_CCC_NOTIFY)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&tx_mutex, K_FOREVER);
+
+	if (tx_conn && (tx_conn != conn)) {
+		k_mutex_unlock(&tx_mutex);
+		return -EBUSY;
+	}
+
+	if (!tx_conn) {
+		tx_conn = bt_conn_ref(conn);
+	}
+
+	while (true) {
+		written += ring_buf_put(&tx_ring_buf, &data[written],
+					len - written);
+		k_delayed_work_submit(&tx_work, K_NO_WAIT);
+
+		if (written == len) {
+			break;
+		}
+
+		/* Wait for free space without blocking the disconnection
+		 * handling, which needs the mutex.
+		 */
+		k_mutex_unlock(&tx_mutex);
+		if (k_sem_take(&tx_space, timeout)) {
+			return written;
+		}
+		k_mutex_lock(&tx_mutex, K_FOREVER);
+
+		if (tx_conn != conn) {
+			LOG_DBG("Connection lost while waiting for TX queue");
+			break;
+		}
+	}
+
+	k_mutex_unlock(&tx_mutex);
+
+	return written;
+}
+
+u32_t bt_gatt_nus_tx_queue_space_get(void)
+{
+	return ring_buf_space_get(&tx_ring_buf);
+}
+
+static int nus_tx_queue_sys_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_delayed_work_init(&tx_work, tx_work_handler);
+	bt_conn_cb_register(&conn_callbacks);
+
+	return 0;
+}
+
+SYS_INIT(nus_tx_queue_sys_init, APPLICATION,
+	 CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* CONFIG_BT_GATT_NUS_TX_QUEUE */
+
 int bt_gatt_nus_init(struct bt_gatt_nus_cb *callbacks)
 {
 	if (callbacks) {
@@ -8,6 +8,7 @@
 #include <sys/printk.h>
 #include <string.h>
 #include <zephyr/types.h>
+#include <sys/byteorder.h>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/conn.h>
@@ -21,9 +22,175 @@
 
 LOG_MODULE_REGISTER(bt_gatt_throughput, CONFIG_BT_GATT_THROUGHPUT_LOG_LEVEL);
 
+#define CMD_STREAM_LEN sizeof(u32_t)
+
 static struct bt_gatt_throughput_metrics met;
 static const struct bt_gatt_throughput_cb *callbacks;
 
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+/* Send timestamps of the packets in flight. Each packet is identified by
+ * its sequence number, which is passed to the completion callback.
+ */
+struct latency_tracker {
+	struct {
+		u32_t seq;
+		u32_t stamp;
+	} slots[CONFIG_BT_GATT_THROUGHPUT_LATENCY_SLOTS];
+	u32_t tx_seq;
+};
+
+static struct latency_tracker write_tracker;
+static struct latency_tracker notif_tracker;
+static u32_t latency_hist[CONFIG_BT_GATT_THROUGHPUT_LATENCY_BUCKETS];
+static u32_t latency_count;
+static u32_t latency_max;
+
+/* Packets are sent from the application threads, while the completion
+ * callbacks come from the Bluetooth stack. The lock protects the trackers
+ * and the histogram.
+ */
+static struct k_spinlock latency_lock;
+
+static u32_t latency_tx_start(struct latency_tracker *tracker)
+{
+	k_spinlock_key_t key = k_spin_lock(&latency_lock);
+	u32_t seq = ++tracker->tx_seq;
+	size_t idx;
+
+	/* Sequence number 0 marks a free slot. */
+	if (seq == 0) {
+		seq = ++tracker->tx_seq;
+	}
+
+	idx = seq % ARRAY_SIZE(tracker->slots);
+	tracker->slots[idx].stamp = k_cycle_get_32();
+	tracker->slots[idx].seq = seq;
+
+	k_spin_unlock(&latency_lock, key);
+
+	return seq;
+}
+
+static void latency_tx_abort(struct latency_tracker *tracker, u32_t seq)
+{
+	k_spinlock_key_t key = k_spin_lock(&latency_lock);
+	size_t idx = seq % ARRAY_SIZE(tracker->slots);
+
+	/* Other senders may have taken newer sequence numbers in the
+	 * meantime, so only the slot of this packet is released.
+	 */
+	if (tracker->slots[idx].seq == seq) {
+		tracker->slots[idx].seq = 0;
+	}
+
+	k_spin_unlock(&latency_lock, key);
+}
+
+static void latency_tx_done(struct latency_tracker *tracker, u32_t seq)
+{
+	k_spinlock_key_t key = k_spin_lock(&latency_lock);
+	size_t idx = seq % ARRAY_SIZE(tracker->slots);
+	u32_t latency;
+	size_t bucket;
+
+	if (tracker->slots[idx].seq != seq) {
+		/* Timestamp overwritten by newer packets. */
+		k_spin_unlock(&latency_lock, key);
+		return;
+	}
+
+	tracker->slots[idx].seq = 0;
+
+	latency = k_cyc_to_us_floor32(k_cycle_get_32() -
+				      tracker->slots[idx].stamp);
+	bucket = MIN(latency / CONFIG_BT_GATT_THROUGHPUT_LATENCY_BUCKET_US,
+		     ARRAY_SIZE(latency_hist) - 1);
+
+	latency_hist[bucket]++;
+	latency_count++;
+	latency_max = MAX(latency_max, latency);
+
+	k_spin_unlock(&latency_lock, key);
+}
+
+static u32_t latency_percentile(u32_t percent)
+{
+	u32_t threshold = DIV_ROUND_UP((u64_t)latency_count * percent, 100);
+	u32_t sum = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(latency_hist) - 1; i++) {
+		sum += latency_hist[i];
+		if (sum >= threshold) {
+			return MIN((i + 1) *
+				   CONFIG_BT_GATT_THROUGHPUT_LATENCY_BUCKET_US,
+				   latency_max);
+		}
+	}
+
+	return latency_max;
+}
+
+void bt_gatt_throughput_latency_get(struct bt_gatt_throughput_latency *lat)
+{
+	k_spinlock_key_t key = k_spin_lock(&latency_lock);
+
+	lat->count = latency_count;
+	if (!latency_count) {
+		lat->p50 = lat->p90 = lat->p99 = lat->max = 0;
+	} else {
+		lat->p50 = latency_percentile(50);
+		lat->p90 = latency_percentile(90);
+		lat->p99 = latency_percentile(99);
+		lat->max = latency_max;
+	}
+
+	k_spin_unlock(&latency_lock, key);
+}
+
+void bt_gatt_throughput_latency_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&latency_lock);
+
+	memset(latency_hist, 0, sizeof(latency_hist));
+	latency_count = 0;
+	latency_max = 0;
+
+	k_spin_unlock(&latency_lock, key);
+}
+
+static void write_complete(struct bt_conn *conn, void *user_data)
+{
+	latency_tx_done(&write_tracker, POINTER_TO_UINT(user_data));
+}
+
+static void notif_complete(struct bt_conn *conn, void *user_data)
+{
+	latency_tx_done(&notif_tracker, POINTER_TO_UINT(user_data));
+}
+#endif /* CONFIG_BT_GATT_THROUGHPUT_LATENCY */
+
+static void metrics_update(struct bt_gatt_throughput_metrics *metrics,
+			   u32_t *start, u16_t len)
+{
+	u64_t delta;
+
+	delta = k_cycle_get_32() - *start;
+	delta = k_cyc_to_ns_floor64(delta);
+
+	if (len == 1) {
+		/* reset metrics */
+		metrics->write_count = 0;
+		metrics->write_len = 0;
+		metrics->write_rate = 0;
+		*start = k_cycle_get_32();
+	} else {
+		metrics->write_count++;
+		metrics->write_len += len;
+		metrics->write_rate =
+		    ((u64_t)metrics->write_len << 3) * 1000000000 / delta;
+	}
+}
+
 static u8_t read_fn(struct bt_conn *conn, u8_t err,
 		    struct bt_gatt_read_params *params, const void *data,
 		    u16_t len)
@@ -49,28 +216,10 @@ static ssize_t write_callback(struct bt_conn *conn,
 			      u16_t len, u16_t offset, u8_t flags)
 {
 	static u32_t clock_cycles;
-	static u32_t kb;
-
-	u64_t delta;
 
 	struct bt_gatt_throughput_metrics *met_data = attr->user_data;
 
-	delta = k_cycle_get_32() - clock_cycles;
-	delta = k_cyc_to_ns_floor64(delta);
-
-	if (len == 1) {
-		/* reset metrics */
-		kb = 0;
-		met_data->write_count = 0;
-		met_data->write_len = 0;
-		met_data->write_rate = 0;
-		clock_cycles = k_cycle_get_32();
-	} else {
-		met_data->write_count++;
-		met_data->write_len += len;
-		met_data->write_rate =
-		    ((u64_t)met_data->write_len << 3) * 1000000000 / delta;
-	}
+	metrics_update(met_data, &clock_cycles, len);
 
 	LOG_DBG("Received data.");
 
@@ -81,6 +230,28 @@ static ssize_t write_callback(struct bt_conn *conn,
 	return len;
 }
 
+static ssize_t stream_write_callback(struct bt_conn *conn,
+				     const struct bt_gatt_attr *attr,
+				     const void *buf, u16_t len, u16_t offset,
+				     u8_t flags)
+{
+	if (offset) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
+	if (len != CMD_STREAM_LEN) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+	}
+
+	LOG_DBG("Notification stream requested.");
+
+	if (callbacks->stream_request) {
+		callbacks->stream_request(conn, sys_get_le32(buf));
+	}
+
+	return len;
+}
+
 static ssize_t read_callback(struct bt_conn *conn,
 			     const struct bt_gatt_attr *attr, void *buf,
 			     u16_t len, u16_t offset)
@@ -106,8 +277,36 @@ BT_GATT_PRIMARY_SERVICE(BT_UUID_THROUGHPUT),
 		BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
 		BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
 		read_callback, write_callback, &met),
+	BT_GATT_CHARACTERISTIC(BT_UUID_THROUGHPUT_NOTIF_CHAR,
+		BT_GATT_CHRC_NOTIFY | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+		BT_GATT_PERM_WRITE,
+		NULL, stream_write_callback, NULL),
+	BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
 
+static u8_t notify_func(struct bt_conn *conn,
+			struct bt_gatt_subscribe_params *params,
+			const void *data, u16_t length)
+{
+	struct bt_gatt_throughput *throughput =
+		CONTAINER_OF(params, struct bt_gatt_throughput, sub_params);
+
+	if (!data) {
+		LOG_DBG("Unsubscribed from notifications.");
+		params->value_handle = 0;
+		return BT_GATT_ITER_STOP;
+	}
+
+	metrics_update(&throughput->notif_met, &throughput->notif_start,
+		       length);
+
+	if (callbacks->notif_received) {
+		callbacks->notif_received(&throughput->notif_met);
+	}
+
+	return BT_GATT_ITER_CONTINUE;
+}
+
 int bt_gatt_throughput_init(struct bt_gatt_throughput *throughput,
 			    const struct bt_gatt_throughput_cb *cb)
 {
@@ -152,6 +351,28 @@ int bt_gatt_throughput_handles_assign(struct bt_gatt_dm *dm,
 	LOG_DBG("Found handle for Throughput characteristic.");
 	throughput->char_handle = gatt_desc->handle;
 
+	/* Notification Characteristic, not present on older peers. */
+	throughput->notif_handle = 0;
+	throughput->ccc_handle = 0;
+	gatt_chrc = bt_gatt_dm_char_by_uuid(dm, BT_UUID_THROUGHPUT_NOTIF_CHAR);
+	if (gatt_chrc) {
+		gatt_desc = bt_gatt_dm_desc_by_uuid(
+			dm, gatt_chrc, BT_UUID_THROUGHPUT_NOTIF_CHAR);
+		if (gatt_desc) {
+			throughput->notif_handle = gatt_desc->handle;
+		}
+
+		gatt_desc = bt_gatt_dm_desc_by_uuid(dm, gatt_chrc,
+						    BT_UUID_GATT_CCC);
+		if (gatt_desc) {
+			throughput->ccc_handle = gatt_desc->handle;
+		}
+	}
+
+	if (!throughput->notif_handle || !throughput->ccc_handle) {
+		LOG_DBG("Notification characteristic not found.");
+	}
+
 	/* Assign connection object. */
 	throughput->conn = bt_gatt_dm_conn_get(dm);
 	return 0;
@@ -177,7 +398,101 @@ int bt_gatt_throughput_read(struct bt_gatt_throughput *throughput)
 int bt_gatt_throughput_write(struct bt_gatt_throughput *throughput,
 			     const u8_t *data, u16_t len)
 {
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+	u32_t seq = latency_tx_start(&write_tracker);
+	int err;
+
+	err = bt_gatt_write_without_response_cb(throughput->conn,
+						throughput->char_handle,
+						data, len, false,
+						write_complete,
+						UINT_TO_POINTER(seq));
+	if (err) {
+		latency_tx_abort(&write_tracker, seq);
+	}
+
+	return err;
+#else
 	return bt_gatt_write_without_response(throughput->conn,
 					      throughput->char_handle,
 					      data, len, false);
+#endif
+}
+
+int bt_gatt_throughput_subscribe(struct bt_gatt_throughput *throughput)
+{
+	int err;
+
+	if (!throughput->notif_handle || !throughput->ccc_handle) {
+		return -ENOTSUP;
+	}
+
+	memset(&throughput->notif_met, 0, sizeof(throughput->notif_met));
+	throughput->notif_start = k_cycle_get_32();
+
+	throughput->sub_params.notify = notify_func;
+	throughput->sub_params.value = BT_GATT_CCC_NOTIFY;
+	throughput->sub_params.value_handle = throughput->notif_handle;
+	throughput->sub_params.ccc_handle = throughput->ccc_handle;
+
+	err = bt_gatt_subscribe(throughput->conn, &throughput->sub_params);
+	if (err && (err != -EALREADY)) {
+		LOG_ERR("Subscribe failed (err %d)", err);
+		return err;
+	}
+
+	return 0;
+}
+
+int bt_gatt_throughput_stream_request(struct bt_gatt_throughput *throughput,
+				      u32_t duration)
+{
+	u8_t cmd[CMD_STREAM_LEN];
+
+	if (!throughput->notif_handle) {
+		return -ENOTSUP;
+	}
+
+	sys_put_le32(duration, cmd);
+
+	/* Written to the Notification Characteristic, so the request can't
+	 * be mistaken for data written to the Throughput Characteristic.
+	 */
+	return bt_gatt_write_without_response(throughput->conn,
+					      throughput->notif_handle,
+					      cmd, sizeof(cmd), false);
+}
+
+int bt_gatt_throughput_notify(struct bt_conn *conn, const u8_t *data,
+			      u16_t len)
+{
+	struct bt_gatt_notify_params params = {0};
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+	u32_t seq;
+#endif
+	int err;
+
+	params.attr = &throughput_svc.attrs[4];
+	params.data = data;
+	params.len = len;
+
+	if (!bt_gatt_is_subscribed(conn, params.attr, BT_GATT_CCC_NOTIFY)) {
+		return -EINVAL;
+	}
+
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+	seq = latency_tx_start(&notif_tracker);
+	params.func = notif_complete;
+	params.user_data = UINT_TO_POINTER(seq);
+#endif
+
+	err = bt_gatt_notify_cb(conn, &params);
+
+#if defined(CONFIG_BT_GATT_THROUGHPUT_LATENCY)
+	if (err) {
+		latency_tx_abort(&notif_tracker, seq);
+	}
+#endif
+
+	return err;
 }
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <sys/util.h>
+
+#include "chmap_estimator.h"
+
+#define CHN_COUNT		CHMAP_ESTIMATOR_CHANNEL_COUNT
+#define HOP_INCREMENT		7
+#define ERR_PROB_SCALE		1000
+#define BACKGROUND_ERR_PROB	20
+#define WIFI_ERR_PROB		600
+#define WIFI_HALF_WIDTH_MHZ	10
+#define LEARN_EVENTS		20000
+#define MEASURE_EVENTS		20000
+
+#define ERR_RATE_FROM_PERCENT(_p) \
+	((_p) * CHMAP_ESTIMATOR_ERR_RATE_MAX / 100)
+
+static const struct chmap_estimator_params params = {
+	.eval_sample_count = 1000,
+	.chn_sample_count_min = 8,
+	.ewma_shift = 3,
+	.decay_shift = 6,
+	.block_threshold = ERR_RATE_FROM_PERCENT(25),
+	.unblock_threshold = ERR_RATE_FROM_PERCENT(10),
+	.min_channel_count = 4,
+};
+
+/* Synthetic interference trace: packet error probability of every channel
+ * caused by the Wi-Fi networks that are active.
+ */
+struct trace {
+	const char *name;
+	u16_t err_prob[CHN_COUNT];
+};
+
+struct link {
+	u8_t last_chn;
+	bool adaptive;
+};
+
+static u32_t rand_state;
+
+static u32_t rand_get(void)
+{
+	/* Deterministic LCG, so failures can be reproduced. */
+	rand_state = rand_state * 1103515245u + 12345u;
+
+	return rand_state >> 8;
+}
+
+static u8_t ble_chn_freq_get(u8_t chn_idx)
+{
+	return (chn_idx <= 10) ? (4 + 2 * chn_idx) : (6 + 2 * chn_idx);
+}
+
+static void trace_init(struct trace *trace, const char *name,
+		       const u8_t *wifi_chn, size_t wifi_chn_count)
+{
+	trace->name = name;
+
+	for (size_t i = 0; i < CHN_COUNT; i++) {
+		trace->err_prob[i] = BACKGROUND_ERR_PROB;
+
+		for (size_t j = 0; j < wifi_chn_count; j++) {
+			int center = 12 + 5 * (wifi_chn[j] - 1);
+			int distance = ble_chn_freq_get(i) - center;
+
+			if ((distance >= -WIFI_HALF_WIDTH_MHZ) &&
+			    (distance <= WIFI_HALF_WIDTH_MHZ)) {
+				trace->err_prob[i] = WIFI_ERR_PROB;
+			}
+		}
+	}
+}
+
+/* Channel selection algorithm #1: unused channels are remapped to
+ * the used ones.
+ */
+static u8_t chn_select(struct link *link, const struct chmap_estimator *est)
+{
+	u8_t used[CHN_COUNT];
+	size_t used_count = 0;
+
+	link->last_chn = (link->last_chn + HOP_INCREMENT) % CHN_COUNT;
+
+	if (!link->adaptive) {
+		return link->last_chn;
+	}
+
+	if (chmap_estimator_chn_used(est, link->last_chn)) {
+		return link->last_chn;
+	}
+
+	for (size_t i = 0; i < CHN_COUNT; i++) {
+		if (chmap_estimator_chn_used(est, i)) {
+			used[used_count] = i;
+			used_count++;
+		}
+	}
+
+	return used[link->last_chn % used_count];
+}
+
+/* Run connection events and return packet error rate in 1/1000. */
+static u32_t link_run(struct link *link, struct chmap_estimator *est,
+		      const struct trace *trace, size_t event_count)
+{
+	u32_t errors = 0;
+
+	for (size_t i = 0; i < event_count; i++) {
+		u8_t chn = chn_select(link, est);
+		bool error = (rand_get() % ERR_PROB_SCALE) <
+			     trace->err_prob[chn];
+
+		if (error) {
+			errors++;
+		}
+
+		if (link->adaptive &&
+		    chmap_estimator_crc_update(est, chn, !error, error)) {
+			chmap_estimator_process(est);
+		}
+	}
+
+	return errors * ERR_PROB_SCALE / event_count;
+}
+
+static size_t chmap_count(const struct chmap_estimator *est)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < CHN_COUNT; i++) {
+		if (chmap_estimator_chn_used(est, i)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static void test_clean_channels(void)
+{
+	struct chmap_estimator est;
+	struct link link = {.adaptive = true};
+	struct trace trace;
+
+	trace_init(&trace, "clean", NULL, 0);
+	chmap_estimator_init(&est, &params);
+	rand_state = 1;
+
+	link_run(&link, &est, &trace, LEARN_EVENTS);
+
+	zassert_equal(chmap_count(&est), CHN_COUNT,
+		      "Clean channel was blocked");
+}
+
+static void test_min_channel_count(void)
+{
+	struct chmap_estimator est;
+
+	chmap_estimator_init(&est, &params);
+
+	/* All channels are bad. */
+	for (size_t i = 0; i < 4 * params.eval_sample_count; i++) {
+		if (chmap_estimator_crc_update(&est, i % CHN_COUNT, 0, 1)) {
+			chmap_estimator_process(&est);
+		}
+	}
+
+	zassert_equal(chmap_count(&est), params.min_channel_count,
+		      "Minimal channel count not kept");
+}
+
+static void test_blacklist(void)
+{
+	struct chmap_estimator est;
+	u8_t blacklist[CHMAP_ESTIMATOR_BITMASK_SIZE] = {0xFF, 0x0F};
+
+	chmap_estimator_init(&est, &params);
+
+	zassert_true(chmap_estimator_blacklist_set(&est, blacklist),
+		     "Map not updated");
+
+	for (size_t i = 0; i < CHN_COUNT; i++) {
+		zassert_equal(chmap_estimator_chn_used(&est, i), i >= 12,
+			      "Blacklist not applied to channel %u", i);
+	}
+
+	/* Minimal channel count takes precedence over the blacklist. */
+	memset(blacklist, 0xFF, sizeof(blacklist));
+	chmap_estimator_blacklist_set(&est, blacklist);
+	zassert_equal(chmap_count(&est), params.min_channel_count, NULL);
+}
+
+static void test_recovery(void)
+{
+	static const u8_t wifi_chn[] = {6};
+	struct chmap_estimator est;
+	struct link link = {.adaptive = true};
+	struct trace trace;
+
+	trace_init(&trace, "wifi 6", wifi_chn, ARRAY_SIZE(wifi_chn));
+	chmap_estimator_init(&est, &params);
+	rand_state = 2;
+
+	link_run(&link, &est, &trace, LEARN_EVENTS);
+	zassert_true(chmap_count(&est) < CHN_COUNT, "No channel blocked");
+
+	/* Interference disappears, blocked channels are evaluated again. */
+	trace_init(&trace, "clean", NULL, 0);
+
+	size_t events = 0;
+
+	while ((chmap_count(&est) < CHN_COUNT) && (events < 1000000)) {
+		link_run(&link, &est, &trace, params.eval_sample_count);
+		events += params.eval_sample_count;
+	}
+
+	zassert_equal(chmap_count(&est), CHN_COUNT, "Channels not recovered");
+	TC_PRINT("Channels recovered after %u events\n", events);
+}
+
+static void test_history(void)
+{
+	static const u8_t wifi_chn[] = {1, 11};
+	struct chmap_estimator est;
+	struct chmap_estimator restored;
+	struct chmap_estimator_history history;
+	struct link link = {.adaptive = true};
+	struct trace trace;
+
+	trace_init(&trace, "wifi 1+11", wifi_chn, ARRAY_SIZE(wifi_chn));
+	chmap_estimator_init(&est, &params);
+	rand_state = 3;
+
+	link_run(&link, &est, &trace, LEARN_EVENTS);
+	chmap_estimator_history_get(&est, &history);
+
+	/* Simulate reboot. */
+	chmap_estimator_init(&restored, &params);
+	chmap_estimator_history_set(&restored, &history);
+
+	zassert_mem_equal(chmap_estimator_map_get(&restored),
+			  chmap_estimator_map_get(&est),
+			  CHMAP_ESTIMATOR_BITMASK_SIZE,
+			  "Learned map not restored");
+
+	for (size_t i = 0; i < CHN_COUNT; i++) {
+		zassert_equal(chmap_estimator_err_rate_get(&restored, i),
+			      chmap_estimator_err_rate_get(&est, i), NULL);
+	}
+}
+
+static void test_per_simulation(void)
+{
+	static const u8_t wifi_1[] = {1};
+	static const u8_t wifi_6[] = {6};
+	static const u8_t wifi_1_6_11[] = {1, 6, 11};
+	struct trace traces[3];
+
+	trace_init(&traces[0], "wifi 1", wifi_1, ARRAY_SIZE(wifi_1));
+	trace_init(&traces[1], "wifi 6", wifi_6, ARRAY_SIZE(wifi_6));
+	trace_init(&traces[2], "wifi 1+6+11", wifi_1_6_11,
+		   ARRAY_SIZE(wifi_1_6_11));
+
+	TC_PRINT("trace        static_PER[1/1000]  adaptive_PER[1/1000]  "
+		 "restored_PER[1/1000]\n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(traces); i++) {
+		struct chmap_estimator est;
+		struct chmap_estimator restored;
+		struct chmap_estimator_history history;
+		struct link link = {.adaptive = false};
+
+		rand_state = i;
+		u32_t static_per = link_run(&link, &est, &traces[i],
+					    MEASURE_EVENTS);
+
+		chmap_estimator_init(&est, &params);
+		link.adaptive = true;
+		link_run(&link, &est, &traces[i], LEARN_EVENTS);
+		u32_t adaptive_per = link_run(&link, &est, &traces[i],
+					      MEASURE_EVENTS);
+
+		/* Right after reboot, the stored history is used. */
+		chmap_estimator_history_get(&est, &history);
+		chmap_estimator_init(&restored, &params);
+		chmap_estimator_history_set(&restored, &history);
+		u32_t restored_per = link_run(&link, &restored, &traces[i],
+					      params.eval_sample_count);
+
+		TC_PRINT("%-11s  %18u  %20u  %20u\n", traces[i].name,
+			 static_per, adaptive_per, restored_per);
+
+		zassert_true(adaptive_per < static_per / 2,
+			     "No PER improvement for %s", traces[i].name);
+		zassert_true(restored_per < static_per / 2,
+			     "No PER improvement after restore for %s",
+			     traces[i].name);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(chmap_estimator_tests,
+			 ztest_unit_test(test_clean_channels),
+			 ztest_unit_test(test_min_channel_count),
+			 ztest_unit_test(test_blacklist),
+			 ztest_unit_test(test_recovery),
+			 ztest_unit_test(test_history),
+			 ztest_unit_test(test_per_simulation)
+			 );
+
+	ztest_run_test_suite(chmap_estimator_tests);
+}
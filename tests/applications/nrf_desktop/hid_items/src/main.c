@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/util.h>
+
+#include "hid_items.h"
+
+#define ITEM_COUNT_MAX		64
+#define RANDOM_ITERATIONS	20000
+#define BENCH_ITERATIONS	200
+
+static const size_t bench_item_counts[] = {4, 8, 16, 32, ITEM_COUNT_MAX};
+
+struct items {
+	size_t size;
+	size_t count;
+	struct hid_item item[ITEM_COUNT_MAX];
+};
+
+static u32_t rand_state;
+
+static u32_t rand_get(void)
+{
+	/* Deterministic LCG, so failures can be reproduced. */
+	rand_state = rand_state * 1103515245u + 12345u;
+
+	return rand_state >> 8;
+}
+
+static void items_init(struct items *items, size_t size)
+{
+	memset(items, 0, sizeof(*items));
+	items->size = size;
+}
+
+/* Reference implementation: full selection sort after each change, as it
+ * was done by the HID state before the sorted set was introduced.
+ */
+static void ref_sort(struct hid_item *item, size_t size)
+{
+	for (size_t k = 0; k < size; k++) {
+		size_t id = k;
+
+		for (size_t l = k + 1; l < size; l++) {
+			if (item[l].usage_id < item[id].usage_id) {
+				id = l;
+			}
+		}
+		if (id != k) {
+			struct hid_item tmp = item[k];
+
+			item[k] = item[id];
+			item[id] = tmp;
+		}
+	}
+}
+
+static bool ref_value_set(struct items *items, u16_t usage_id, s16_t value)
+{
+	size_t prev_count = items->count;
+	bool update_needed = false;
+	struct hid_item *p_item = NULL;
+
+	for (size_t i = 0; i < items->size; i++) {
+		if (items->item[i].usage_id == usage_id) {
+			p_item = &items->item[i];
+			break;
+		}
+	}
+
+	if (p_item) {
+		p_item->value += value;
+		if (p_item->value == 0) {
+			items->count--;
+			p_item->usage_id = 0;
+		}
+		update_needed = true;
+	} else if ((value > 0) && (prev_count < items->size)) {
+		size_t idx = items->size - prev_count - 1;
+
+		items->item[idx].usage_id = usage_id;
+		items->item[idx].value = value;
+		items->count++;
+		update_needed = true;
+	}
+
+	if (prev_count != items->count) {
+		ref_sort(items->item, items->size);
+	}
+
+	return update_needed;
+}
+
+/* Same logic as key_value_set in the HID state module. */
+static bool value_set(struct items *items, u16_t usage_id, s16_t value)
+{
+	int idx = hid_items_find(items->item, items->size, items->count,
+				 usage_id);
+
+	if (idx >= 0) {
+		items->item[idx].value += value;
+		if (items->item[idx].value == 0) {
+			hid_items_remove(items->item, items->size,
+					 items->count, idx);
+			items->count--;
+		}
+		return true;
+	} else if ((value > 0) && (items->count < items->size)) {
+		hid_items_insert(items->item, items->size, items->count,
+				 usage_id, value);
+		items->count++;
+		return true;
+	}
+
+	return false;
+}
+
+static void items_check(const struct items *items)
+{
+	size_t first = items->size - items->count;
+
+	for (size_t i = 0; i < first; i++) {
+		zassert_equal(items->item[i].usage_id, 0,
+			      "Free slot %u is not empty", i);
+	}
+
+	for (size_t i = first + 1; i < items->size; i++) {
+		zassert_true(items->item[i - 1].usage_id <
+			     items->item[i].usage_id,
+			     "Items are not sorted at %u", i);
+	}
+}
+
+static void test_insert_remove(void)
+{
+	struct items items;
+
+	items_init(&items, 6);
+
+	static const u16_t usages[] = {0x20, 0x04, 0xE1, 0x10, 0x05};
+
+	for (size_t i = 0; i < ARRAY_SIZE(usages); i++) {
+		zassert_true(value_set(&items, usages[i], 1), "Insert failed");
+		items_check(&items);
+	}
+	zassert_equal(items.count, ARRAY_SIZE(usages), "Wrong item count");
+
+	/* Items are browsed from the end. */
+	zassert_equal(items.item[items.size - 1].usage_id, 0xE1, NULL);
+	zassert_equal(items.item[items.size - 5].usage_id, 0x04, NULL);
+
+	/* Second press of the same usage only increases the value. */
+	zassert_true(value_set(&items, 0x10, 1), NULL);
+	zassert_equal(items.count, ARRAY_SIZE(usages), NULL);
+
+	zassert_true(value_set(&items, 0x10, -1), NULL);
+	zassert_true(hid_items_find(items.item, items.size, items.count,
+				    0x10) >= 0, "Item removed too early");
+	zassert_true(value_set(&items, 0x10, -1), NULL);
+	zassert_true(hid_items_find(items.item, items.size, items.count,
+				    0x10) < 0, "Item not removed");
+	items_check(&items);
+
+	/* Unpaired release is ignored. */
+	zassert_false(value_set(&items, 0x10, -1), NULL);
+
+	/* Set is full. */
+	zassert_true(value_set(&items, 0x30, 1), NULL);
+	zassert_true(value_set(&items, 0x31, 1), NULL);
+	zassert_false(value_set(&items, 0x32, 1), NULL);
+	items_check(&items);
+}
+
+static void test_random_vs_reference(void)
+{
+	for (size_t c = 0; c < ARRAY_SIZE(bench_item_counts); c++) {
+		struct items items;
+		struct items ref;
+		size_t size = bench_item_counts[c];
+
+		items_init(&items, size);
+		items_init(&ref, size);
+		rand_state = size;
+
+		for (size_t i = 0; i < RANDOM_ITERATIONS; i++) {
+			/* Use twice as many usages as there are slots to
+			 * exercise the full set.
+			 */
+			u16_t usage_id = 1 + (rand_get() % (2 * size));
+			s16_t value = (rand_get() & 1) ? 1 : -1;
+
+			zassert_equal(value_set(&items, usage_id, value),
+				      ref_value_set(&ref, usage_id, value),
+				      "Update mismatch at %u", i);
+			zassert_equal(items.count, ref.count, NULL);
+			zassert_mem_equal(items.item, ref.item,
+					  size * sizeof(items.item[0]),
+					  "Set mismatch at %u", i);
+		}
+	}
+}
+
+typedef bool (*value_set_fn)(struct items *items, u16_t usage_id,
+			     s16_t value);
+
+/* Measure average cost of a key edge: press all keys in pseudo-random
+ * order, then release them.
+ */
+static u32_t key_edge_cost(value_set_fn fn, size_t size)
+{
+	struct items items;
+	u16_t usages[ITEM_COUNT_MAX];
+	u32_t cycles = 0;
+
+	for (size_t i = 0; i < size; i++) {
+		usages[i] = i + 1;
+	}
+
+	rand_state = size;
+
+	for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+		items_init(&items, size);
+
+		for (size_t i = size - 1; i > 0; i--) {
+			size_t j = rand_get() % (i + 1);
+			u16_t tmp = usages[i];
+
+			usages[i] = usages[j];
+			usages[j] = tmp;
+		}
+
+		u32_t start = k_cycle_get_32();
+
+		for (size_t i = 0; i < size; i++) {
+			fn(&items, usages[i], 1);
+		}
+		for (size_t i = 0; i < size; i++) {
+			fn(&items, usages[size - i - 1], -1);
+		}
+
+		cycles += k_cycle_get_32() - start;
+	}
+
+	return cycles / (BENCH_ITERATIONS * 2 * size);
+}
+
+static void test_key_edge_benchmark(void)
+{
+	TC_PRINT("item_count  sorted_set[cycles]  full_sort[cycles]\n");
+
+	for (size_t c = 0; c < ARRAY_SIZE(bench_item_counts); c++) {
+		size_t size = bench_item_counts[c];
+		u32_t set_cost = key_edge_cost(value_set, size);
+		u32_t ref_cost = key_edge_cost(ref_value_set, size);
+
+		TC_PRINT("%10u  %18u  %17u\n", size, set_cost, ref_cost);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hid_items_tests,
+			 ztest_unit_test(test_insert_remove),
+			 ztest_unit_test(test_random_vs_reference),
+			 ztest_unit_test(test_key_edge_benchmark)
+			 );
+
+	ztest_run_test_suite(hid_items_tests);
+}
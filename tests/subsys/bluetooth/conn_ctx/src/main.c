@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/util.h>
+#include <bluetooth/conn_ctx.h>
+
+#define WORKER_CNT		4
+#define WORKER_STACK_SIZE	1024
+#define WORKER_PRIO		K_PRIO_PREEMPT(5)
+#define WORKER_ITERATIONS	5000
+#define BENCH_ITERATIONS	10000
+
+struct test_ctx {
+	u8_t id;
+	u32_t access_cnt;
+};
+
+BT_CONN_CTX_DEF(test, CONFIG_BT_MAX_CONN, sizeof(struct test_ctx));
+
+/* Simulated connection objects. Only their addresses are used. */
+static u8_t fake_conns[CONFIG_BT_MAX_CONN];
+
+static K_THREAD_STACK_ARRAY_DEFINE(worker_stacks, WORKER_CNT,
+				   WORKER_STACK_SIZE);
+static struct k_thread worker_threads[WORKER_CNT];
+static K_SEM_DEFINE(workers_done, 0, WORKER_CNT);
+static atomic_t lookup_miss_cnt;
+
+u8_t __wrap_bt_conn_index(struct bt_conn *conn)
+{
+	return (u8_t *)conn - fake_conns;
+}
+
+static struct bt_conn *fake_conn(size_t id)
+{
+	return (struct bt_conn *)&fake_conns[id];
+}
+
+static void all_ctx_alloc(void)
+{
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		struct test_ctx *ctx = bt_conn_ctx_alloc(&test_ctx_lib,
+							 fake_conn(i));
+
+		zassert_not_null(ctx, "Context %u not allocated", i);
+		ctx->id = i;
+		ctx->access_cnt = 0;
+		bt_conn_ctx_release(&test_ctx_lib, ctx);
+	}
+}
+
+static void test_teardown(void)
+{
+	bt_conn_ctx_free_all(&test_ctx_lib);
+}
+
+static void test_alloc_get_free(void)
+{
+	struct test_ctx *ctx;
+	struct bt_conn *conn = fake_conn(CONFIG_BT_MAX_CONN - 1);
+
+	zassert_is_null(bt_conn_ctx_get(&test_ctx_lib, conn),
+			"Context found before allocation");
+
+	ctx = bt_conn_ctx_alloc(&test_ctx_lib, conn);
+	zassert_not_null(ctx, "Context not allocated");
+	ctx->id = CONFIG_BT_MAX_CONN - 1;
+	bt_conn_ctx_release(&test_ctx_lib, ctx);
+
+	ctx = bt_conn_ctx_get(&test_ctx_lib, conn);
+	zassert_not_null(ctx, "Context not found");
+	zassert_equal(ctx->id, CONFIG_BT_MAX_CONN - 1, "Wrong context");
+	bt_conn_ctx_release(&test_ctx_lib, ctx);
+
+	zassert_equal(bt_conn_ctx_free(&test_ctx_lib, conn), 0,
+		      "Context not freed");
+	zassert_is_null(bt_conn_ctx_get(&test_ctx_lib, conn),
+			"Context found after free");
+	zassert_equal(bt_conn_ctx_free(&test_ctx_lib, conn), -EINVAL,
+		      "Context freed twice");
+}
+
+static void test_get_by_id(void)
+{
+	all_ctx_alloc();
+
+	for (size_t i = 0; i < bt_conn_ctx_count(&test_ctx_lib); i++) {
+		const struct bt_conn_ctx *ctx =
+			bt_conn_ctx_get_by_id(&test_ctx_lib, i);
+		struct test_ctx *data;
+
+		zassert_not_null(ctx, "Context %u not found", i);
+		data = ctx->data;
+		zassert_equal(ctx->conn, fake_conn(data->id),
+			      "Context does not match connection");
+		bt_conn_ctx_release(&test_ctx_lib, ctx->data);
+	}
+}
+
+static void worker_fn(void *p1, void *p2, void *p3)
+{
+	u32_t seed = POINTER_TO_UINT(p1);
+
+	for (size_t i = 0; i < WORKER_ITERATIONS; i++) {
+		size_t id;
+		struct test_ctx *ctx;
+
+		/* Simple LCG, enough to spread the lookups. */
+		seed = seed * 1103515245 + 12345;
+		id = (seed >> 16) % CONFIG_BT_MAX_CONN;
+
+		ctx = bt_conn_ctx_get(&test_ctx_lib, fake_conn(id));
+		if (!ctx) {
+			atomic_inc(&lookup_miss_cnt);
+			continue;
+		}
+
+		zassert_equal(ctx->id, id, "Wrong context returned");
+		ctx->access_cnt++;
+		k_yield();
+
+		bt_conn_ctx_release(&test_ctx_lib, ctx);
+	}
+
+	k_sem_give(&workers_done);
+}
+
+static void test_concurrent_lookup(void)
+{
+	all_ctx_alloc();
+	atomic_clear(&lookup_miss_cnt);
+
+	for (size_t i = 0; i < WORKER_CNT; i++) {
+		k_thread_create(&worker_threads[i], worker_stacks[i],
+				K_THREAD_STACK_SIZEOF(worker_stacks[i]),
+				worker_fn, UINT_TO_POINTER(i + 1), NULL, NULL,
+				WORKER_PRIO, 0, K_NO_WAIT);
+	}
+
+	for (size_t i = 0; i < WORKER_CNT; i++) {
+		zassert_equal(k_sem_take(&workers_done, K_SECONDS(30)), 0,
+			      "Worker did not finish");
+	}
+
+	zassert_equal(atomic_get(&lookup_miss_cnt), 0,
+		      "Lookups failed while all contexts were allocated");
+}
+
+static void test_lookup_cost(void)
+{
+	u32_t start;
+	u32_t cycles;
+
+	all_ctx_alloc();
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+		struct bt_conn *conn = fake_conn(i % CONFIG_BT_MAX_CONN);
+		struct test_ctx *ctx = bt_conn_ctx_get(&test_ctx_lib, conn);
+
+		zassert_not_null(ctx, "Context not found");
+		bt_conn_ctx_release(&test_ctx_lib, ctx);
+	}
+	cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("get and release: %u cycles per lookup, %u connections\n",
+		 cycles / BENCH_ITERATIONS, CONFIG_BT_MAX_CONN);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(
+		test_conn_ctx,
+		ztest_unit_test_setup_teardown(test_alloc_get_free, unit_test_noop, test_teardown),
+		ztest_unit_test_setup_teardown(test_get_by_id, unit_test_noop, test_teardown),
+		ztest_unit_test_setup_teardown(test_concurrent_lookup, unit_test_noop, test_teardown),
+		ztest_unit_test_setup_teardown(test_lookup_cost, unit_test_noop, test_teardown)
+	);
+
+	ztest_run_test_suite(test_conn_ctx);
+}
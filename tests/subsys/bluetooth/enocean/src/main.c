@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/byteorder.h>
+#include <bluetooth/enocean.h>
+#include <bluetooth/gap.h>
+
+#define DEVICE_CNT		CONFIG_BT_ENOCEAN_DEVICES_MAX
+#define PACKETS_PER_DEVICE	3
+/* EnOcean switches transmit each packet three times. */
+#define COPIES			3
+
+#define SIG_VALID		0x5a
+#define SIG_FORGED		0xa5
+
+#define SWITCH_PRESSED_A0	(BIT(0) | BIT(1))
+
+static struct bt_le_scan_cb *scan_cb;
+static struct bt_enocean_device *devices[DEVICE_CNT];
+static size_t commissioned_cnt;
+static atomic_t auth_cnt;
+static atomic_t button_cnt;
+
+void __wrap_bt_le_scan_cb_register(struct bt_le_scan_cb *cb)
+{
+	scan_cb = cb;
+}
+
+int __wrap_bt_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
+			  const u8_t *enc_data, size_t len, const u8_t *aad,
+			  size_t aad_len, u8_t *plaintext, size_t mic_size)
+{
+	atomic_inc(&auth_cnt);
+
+	/* The signature follows the encrypted data: */
+	return (enc_data[len] == SIG_VALID) ? 0 : -EBADMSG;
+}
+
+static void button(struct bt_enocean_device *device,
+		   enum bt_enocean_button_action action, u8_t changed,
+		   const u8_t *opt_data, size_t opt_data_len)
+{
+	/* Called from the system workqueue, so only count the expected
+	 * events and let the test thread check the count:
+	 */
+	if (action == BT_ENOCEAN_BUTTON_PRESS &&
+	    changed == (SWITCH_PRESSED_A0 >> 1)) {
+		atomic_inc(&button_cnt);
+	}
+}
+
+static void commissioned(struct bt_enocean_device *device)
+{
+	devices[commissioned_cnt++] = device;
+}
+
+static const struct bt_enocean_callbacks enocean_cbs = {
+	.button = button,
+	.commissioned = commissioned,
+};
+
+static void device_addr(u16_t id, bt_addr_le_t *addr)
+{
+	addr->type = BT_ADDR_LE_RANDOM;
+	sys_put_le16(id, &addr->a.val[0]);
+	addr->a.val[2] = 0x00;
+	addr->a.val[3] = 0x00;
+	addr->a.val[4] = 0x15;
+	addr->a.val[5] = 0xe2;
+}
+
+/* Inject a PTM 215B data telegram from the given device. */
+static void report_send(u16_t id, u32_t seq, u8_t signature)
+{
+	u8_t data[] = {
+		12, BT_DATA_MANUFACTURER_DATA, 0xda, 0x03,
+		0, 0, 0, 0,
+		SWITCH_PRESSED_A0,
+		signature, signature, signature, signature,
+	};
+	struct bt_le_scan_recv_info info = {
+		.rssi = -40,
+		.adv_type = BT_GAP_ADV_TYPE_ADV_NONCONN_IND,
+	};
+	struct net_buf_simple buf;
+	bt_addr_le_t addr;
+
+	device_addr(id, &addr);
+	info.addr = &addr;
+	sys_put_le32(seq, &data[4]);
+
+	net_buf_simple_init_with_data(&buf, data, sizeof(data));
+	scan_cb->recv(&info, &buf);
+}
+
+/* Let the system workqueue authenticate the queued packets. */
+static void rx_drain(void)
+{
+	k_sleep(K_MSEC(1));
+}
+
+static void test_commission(void)
+{
+	static const u8_t key[16];
+
+	bt_enocean_init(&enocean_cbs);
+	zassert_not_null(scan_cb, "Scanner callbacks not registered");
+
+	for (u16_t id = 0; id < DEVICE_CNT; id++) {
+		bt_addr_le_t addr;
+
+		device_addr(id, &addr);
+		zassert_equal(bt_enocean_commission(&addr, key, 0), 0,
+			      "Device %u not commissioned", id);
+	}
+
+	zassert_equal(commissioned_cnt, DEVICE_CNT, NULL);
+}
+
+static void test_burst(void)
+{
+	u32_t duplicates = 0;
+	u32_t dropped = 0;
+
+	atomic_clear(&auth_cnt);
+	atomic_clear(&button_cnt);
+
+	for (u32_t seq = 1; seq <= PACKETS_PER_DEVICE; seq++) {
+		for (u16_t id = 0; id < DEVICE_CNT; id++) {
+			for (int i = 0; i < COPIES; i++) {
+				report_send(id, seq, SIG_VALID);
+			}
+
+			rx_drain();
+		}
+	}
+
+	for (u16_t id = 0; id < DEVICE_CNT; id++) {
+		const struct bt_enocean_device_stats *stats =
+			&devices[id]->stats;
+
+		zassert_equal(stats->rx, PACKETS_PER_DEVICE,
+			      "Device %u: %u packets", id, stats->rx);
+		zassert_equal(stats->auth_failures, 0, NULL);
+
+		duplicates += atomic_get(&stats->duplicates);
+		dropped += stats->dropped;
+	}
+
+	TC_PRINT("devices  reports  authentications  button_events  "
+		 "duplicates  dropped\n");
+	TC_PRINT("%7u  %7u  %15u  %13u  %10u  %7u\n", DEVICE_CNT,
+		 DEVICE_CNT * PACKETS_PER_DEVICE * COPIES,
+		 (u32_t)atomic_get(&auth_cnt), (u32_t)atomic_get(&button_cnt),
+		 duplicates, dropped);
+
+	/* Each packet is authenticated once, no matter how many copies
+	 * are received:
+	 */
+	zassert_equal(atomic_get(&auth_cnt), DEVICE_CNT * PACKETS_PER_DEVICE,
+		      NULL);
+	zassert_equal(atomic_get(&button_cnt), DEVICE_CNT * PACKETS_PER_DEVICE,
+		      NULL);
+	zassert_equal(duplicates,
+		      DEVICE_CNT * PACKETS_PER_DEVICE * (COPIES - 1), NULL);
+	zassert_equal(dropped, 0, NULL);
+}
+
+static void test_forged_seq(void)
+{
+	struct bt_enocean_device *dev = devices[0];
+	u32_t seq = dev->seq + 1;
+	u32_t rx = dev->stats.rx;
+
+	atomic_clear(&auth_cnt);
+	atomic_clear(&button_cnt);
+
+	/* An unauthenticated packet with the next sequence number must not
+	 * make the genuine packet look like a duplicate:
+	 */
+	report_send(0, seq, SIG_FORGED);
+	for (int i = 0; i < COPIES; i++) {
+		report_send(0, seq, SIG_VALID);
+	}
+
+	rx_drain();
+
+	zassert_equal(dev->stats.auth_failures, 1, NULL);
+	zassert_equal(dev->stats.rx, rx + 1, "Genuine packet dropped");
+	zassert_equal(dev->seq, seq, NULL);
+	zassert_equal(atomic_get(&auth_cnt), 2, NULL);
+	zassert_equal(atomic_get(&button_cnt), 1, NULL);
+
+	/* Replays of the forged packet are rejected without authentication: */
+	report_send(0, seq, SIG_FORGED);
+	rx_drain();
+
+	zassert_equal(atomic_get(&auth_cnt), 2, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(enocean_tests,
+			 ztest_unit_test(test_commission),
+			 ztest_unit_test(test_burst),
+			 ztest_unit_test(test_forged_seq)
+			 );
+
+	ztest_run_test_suite(enocean_tests);
+}
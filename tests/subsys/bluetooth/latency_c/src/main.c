@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/util.h>
+#include <bluetooth/att.h>
+#include <bluetooth/services/latency.h>
+#include <bluetooth/services/latency_c.h>
+
+#define MEASURE_PERIOD_MS	5
+#define RESPONSE_CNT		20
+#define WRITE_TIMEOUT		K_MSEC(100)
+
+/* Simulated connection objects. Only their addresses are used. */
+static u8_t fake_conns[CONFIG_BT_MAX_CONN];
+static struct bt_conn *dm_conn;
+
+static struct bt_gatt_latency_c latency_client;
+static struct bt_conn_cb *conn_cb;
+static struct bt_gatt_write_params *write_params;
+static bool write_pending;
+static K_SEM_DEFINE(write_sem, 0, 1);
+static atomic_t write_cnt;
+static atomic_t conn_ref_cnt;
+
+static struct bt_gatt_service_val service_val = {
+	.uuid = BT_UUID_LATENCY,
+};
+
+static struct bt_gatt_dm_attr service_attr;
+static struct bt_gatt_dm_attr chrc_attr;
+static struct bt_gatt_dm_attr desc_attr = {
+	.handle = 0x10,
+};
+
+struct bt_conn *__wrap_bt_conn_ref(struct bt_conn *conn)
+{
+	atomic_inc(&conn_ref_cnt);
+
+	return conn;
+}
+
+void __wrap_bt_conn_unref(struct bt_conn *conn)
+{
+	atomic_dec(&conn_ref_cnt);
+}
+
+void __wrap_bt_conn_cb_register(struct bt_conn_cb *cb)
+{
+	conn_cb = cb;
+}
+
+int __wrap_bt_gatt_write(struct bt_conn *conn,
+			 struct bt_gatt_write_params *params)
+{
+	write_params = params;
+	write_pending = true;
+	atomic_inc(&write_cnt);
+	k_sem_give(&write_sem);
+
+	return 0;
+}
+
+const struct bt_gatt_dm_attr *__wrap_bt_gatt_dm_service_get(
+	const struct bt_gatt_dm *dm)
+{
+	return &service_attr;
+}
+
+struct bt_gatt_service_val *__wrap_bt_gatt_dm_attr_service_val(
+	const struct bt_gatt_dm_attr *attr)
+{
+	return &service_val;
+}
+
+const struct bt_gatt_dm_attr *__wrap_bt_gatt_dm_char_by_uuid(
+	const struct bt_gatt_dm *dm, const struct bt_uuid *uuid)
+{
+	return &chrc_attr;
+}
+
+const struct bt_gatt_dm_attr *__wrap_bt_gatt_dm_desc_by_uuid(
+	const struct bt_gatt_dm *dm, const struct bt_gatt_dm_attr *attr,
+	const struct bt_uuid *uuid)
+{
+	return &desc_attr;
+}
+
+struct bt_conn *__wrap_bt_gatt_dm_conn_get(struct bt_gatt_dm *dm)
+{
+	return dm_conn;
+}
+
+static void client_connect(size_t id)
+{
+	dm_conn = (struct bt_conn *)&fake_conns[id];
+
+	zassert_equal(bt_gatt_latency_c_handles_assign(NULL, &latency_client),
+		      0, "Handles not assigned");
+}
+
+static void request_wait(void)
+{
+	zassert_equal(k_sem_take(&write_sem, WRITE_TIMEOUT), 0,
+		      "No latency request sent");
+}
+
+static void respond(u8_t err)
+{
+	write_pending = false;
+	write_params->func(latency_client.conn, err, write_params);
+}
+
+/* Wait for the next request and answer it. */
+static void request_respond(void)
+{
+	request_wait();
+	respond(0);
+}
+
+static void test_setup(void)
+{
+	k_sem_reset(&write_sem);
+	atomic_clear(&write_cnt);
+	bt_gatt_latency_c_stats_reset(&latency_client);
+}
+
+static void test_teardown(void)
+{
+	bt_gatt_latency_c_measure_stop(&latency_client);
+
+	/* Complete the request left by the measurement, if any. */
+	if (write_pending) {
+		respond(BT_ATT_ERR_UNLIKELY);
+	}
+
+	zassert_equal(atomic_get(&conn_ref_cnt), 0,
+		      "Connection reference leaked");
+}
+
+static void test_init(void)
+{
+	zassert_equal(bt_gatt_latency_c_init(&latency_client, NULL), 0,
+		      "Client not initialized");
+	zassert_not_null(conn_cb, "Connection callbacks not registered");
+	zassert_not_null(conn_cb->disconnected,
+			 "Disconnection callback not registered");
+}
+
+static void test_measure(void)
+{
+	u32_t p50;
+	u32_t p99;
+
+	zassert_equal(bt_gatt_latency_c_measure_start(&latency_client, 0),
+		      -EINVAL, "Measurement started without connection");
+
+	client_connect(0);
+
+	zassert_equal(bt_gatt_latency_c_measure_start(&latency_client,
+						      MEASURE_PERIOD_MS),
+		      0, "Measurement not started");
+	zassert_equal(atomic_get(&conn_ref_cnt), 1,
+		      "Connection not referenced");
+
+	for (size_t i = 0; i < RESPONSE_CNT; i++) {
+		request_respond();
+	}
+
+	zassert_equal(latency_client.stats.count, RESPONSE_CNT,
+		      "Wrong sample count");
+
+	p50 = bt_gatt_latency_c_percentile_get(&latency_client, 50);
+	p99 = bt_gatt_latency_c_percentile_get(&latency_client, 99);
+	zassert_true(p50 <= p99, "Percentiles not ordered");
+	zassert_true(p99 <= latency_client.stats.max,
+		     "Percentile above the maximum");
+
+	/* Restarting a measured client must not take another reference. */
+	zassert_equal(bt_gatt_latency_c_measure_start(&latency_client,
+						      MEASURE_PERIOD_MS),
+		      0, "Measurement not restarted");
+	zassert_equal(atomic_get(&conn_ref_cnt), 1,
+		      "Connection referenced twice");
+}
+
+static void test_conn_event_span(void)
+{
+	client_connect(0);
+
+	bt_gatt_latency_c_conn_event_update(&latency_client, 100);
+
+	zassert_equal(bt_gatt_latency_c_measure_start(&latency_client,
+						      MEASURE_PERIOD_MS),
+		      0, "Measurement not started");
+	request_wait();
+
+	bt_gatt_latency_c_conn_event_update(&latency_client, 103);
+	respond(0);
+
+	zassert_equal(latency_client.stats.last_event, 100,
+		      "Wrong request event");
+	zassert_equal(latency_client.stats.last_event_span, 3,
+		      "Wrong event span");
+	zassert_equal(latency_client.stats.max_event_span, 3,
+		      "Wrong maximum event span");
+}
+
+static void test_disconnect(void)
+{
+	struct bt_conn *conn;
+	atomic_val_t writes;
+
+	client_connect(1);
+	conn = latency_client.conn;
+
+	zassert_equal(bt_gatt_latency_c_measure_start(&latency_client,
+						      MEASURE_PERIOD_MS),
+		      0, "Measurement not started");
+	request_respond();
+
+	/* The disconnection of another link must not stop the measurement. */
+	conn_cb->disconnected((struct bt_conn *)&fake_conns[0], 0);
+	zassert_equal(atomic_get(&conn_ref_cnt), 1,
+		      "Reference of another connection released");
+	request_respond();
+
+	conn_cb->disconnected(conn, 0);
+
+	zassert_equal(atomic_get(&conn_ref_cnt), 0,
+		      "Connection reference not released");
+	zassert_is_null(latency_client.conn, "Connection not cleared");
+
+	writes = atomic_get(&write_cnt);
+	k_sleep(K_MSEC(10 * MEASURE_PERIOD_MS));
+	zassert_equal(atomic_get(&write_cnt), writes,
+		      "Request sent after disconnection");
+
+	zassert_equal(bt_gatt_latency_c_measure_start(&latency_client,
+						      MEASURE_PERIOD_MS),
+		      -EINVAL, "Measurement started on disconnected link");
+	zassert_equal(bt_gatt_latency_c_request(&latency_client, NULL, 0),
+		      -ENOTCONN, "Request sent on disconnected link");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(latency_c_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test_setup_teardown(test_measure,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_conn_event_span,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_disconnect,
+							test_setup,
+							test_teardown)
+			 );
+
+	ztest_run_test_suite(latency_c_tests);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/byteorder.h>
+#include <bluetooth/mesh.h>
+#include <bluetooth/mesh/models.h>
+
+#define CLIENT_ADDR		0x0100
+#define RSP_MAXLEN		64
+
+/* Readable by users, and owned by both the Admin and the Manufacturer
+ * Property Server:
+ */
+#define PROP_SHARED		0x0010
+/* Hidden from users until an Admin Property Set changes its access: */
+#define PROP_HIDDEN		0x0020
+
+/* Neither array is sorted, as the servers must not rely on the
+ * application's order:
+ */
+static struct bt_mesh_prop admin_props[] = {
+	{ 0x0030, BT_MESH_PROP_ACCESS_READ_WRITE },
+	{ PROP_SHARED, BT_MESH_PROP_ACCESS_READ },
+	{ PROP_HIDDEN, BT_MESH_PROP_ACCESS_PROHIBITED },
+	{ 0x0005, BT_MESH_PROP_ACCESS_WRITE },
+};
+
+static struct bt_mesh_prop mfr_props[] = {
+	{ 0x0040, BT_MESH_PROP_ACCESS_READ },
+	{ 0x0008, BT_MESH_PROP_ACCESS_PROHIBITED },
+	{ PROP_SHARED, BT_MESH_PROP_ACCESS_READ },
+};
+
+static const struct bt_mesh_prop client_props[] = {
+	{ 0x0050 },
+	{ 0x0003 },
+	{ 0x0021 },
+	{ 0x0011 },
+};
+
+static void prop_get(struct bt_mesh_prop_srv *srv, struct bt_mesh_msg_ctx *ctx,
+		     struct bt_mesh_prop_val *val)
+{
+	val->size = 1;
+	val->value[0] = 0;
+}
+
+static void prop_set(struct bt_mesh_prop_srv *srv, struct bt_mesh_msg_ctx *ctx,
+		     struct bt_mesh_prop_val *val)
+{
+}
+
+static struct bt_mesh_cfg_srv cfg_srv = {
+	.default_ttl = 7,
+};
+
+static struct bt_mesh_prop_srv user_srv = BT_MESH_PROP_SRV_USER_INIT();
+static struct bt_mesh_prop_srv admin_srv =
+	BT_MESH_PROP_SRV_ADMIN_INIT(admin_props, prop_get, prop_set);
+static struct bt_mesh_prop_srv mfr_srv =
+	BT_MESH_PROP_SRV_MFR_INIT(mfr_props, prop_get);
+static struct bt_mesh_prop_srv client_srv =
+	BT_MESH_PROP_SRV_CLIENT_INIT(client_props);
+
+static struct bt_mesh_elem elements[] = {
+	BT_MESH_ELEM(1,
+		     BT_MESH_MODEL_LIST(
+			     BT_MESH_MODEL_CFG_SRV(&cfg_srv),
+			     BT_MESH_MODEL_PROP_SRV_USER(&user_srv),
+			     BT_MESH_MODEL_PROP_SRV_ADMIN(&admin_srv),
+			     BT_MESH_MODEL_PROP_SRV_MFR(&mfr_srv),
+			     BT_MESH_MODEL_PROP_SRV_CLIENT(&client_srv)),
+		     BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+	.cid = CONFIG_BT_COMPANY_ID,
+	.elem = elements,
+	.elem_count = ARRAY_SIZE(elements),
+};
+
+static const u8_t dev_uuid[16] = { 0xdd, 0xdd };
+
+static const struct bt_mesh_prov prov = {
+	.uuid = dev_uuid,
+};
+
+/* Last response sent by a server. */
+static u32_t rsp_op;
+static u8_t rsp_data[RSP_MAXLEN];
+static u16_t rsp_len;
+static u32_t rsp_cnt;
+
+int __wrap_bt_mesh_model_send(struct bt_mesh_model *model,
+			      struct bt_mesh_msg_ctx *ctx,
+			      struct net_buf_simple *msg,
+			      const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+	struct net_buf_simple buf;
+
+	net_buf_simple_init_with_data(&buf, msg->data, msg->len);
+
+	if ((buf.data[0] & 0x80) == 0) {
+		rsp_op = net_buf_simple_pull_u8(&buf);
+	} else {
+		rsp_op = net_buf_simple_pull_be16(&buf);
+	}
+
+	zassert_true(buf.len <= sizeof(rsp_data), "Response too long");
+	memcpy(rsp_data, buf.data, buf.len);
+	rsp_len = buf.len;
+	rsp_cnt++;
+
+	return 0;
+}
+
+int __wrap_bt_mesh_model_publish(struct bt_mesh_model *model)
+{
+	return 0;
+}
+
+/* Pass the message parameters to the model's handler for the opcode. */
+static void msg_recv(struct bt_mesh_prop_srv *srv, u32_t opcode,
+		     const void *data, size_t len)
+{
+	struct bt_mesh_msg_ctx ctx = {
+		.addr = CLIENT_ADDR,
+		.send_ttl = BT_MESH_TTL_DEFAULT,
+	};
+	struct bt_mesh_model *mod = srv->mod;
+	const struct bt_mesh_model_op *op;
+	struct net_buf_simple buf;
+
+	net_buf_simple_init_with_data(&buf, (void *)data, len);
+
+	for (op = mod->op; op->func; op++) {
+		if (op->opcode == opcode) {
+			op->func(mod, &ctx, &buf);
+			return;
+		}
+	}
+
+	zassert_unreachable("No handler for 0x%06x", opcode);
+}
+
+/* Check that the last response is a property list with the given IDs. */
+static void list_check(u32_t opcode, const u16_t *ids, size_t count)
+{
+	zassert_equal(rsp_op, opcode, "Wrong opcode 0x%06x", rsp_op);
+	zassert_equal(rsp_len, 2 * count, "%u IDs listed", rsp_len / 2);
+
+	for (size_t i = 0; i < count; i++) {
+		zassert_equal(sys_get_le16(&rsp_data[2 * i]), ids[i],
+			      "ID %u is 0x%04x, expected 0x%04x", i,
+			      sys_get_le16(&rsp_data[2 * i]), ids[i]);
+	}
+}
+
+static void user_props_get(void)
+{
+	u32_t cnt = rsp_cnt;
+
+	msg_recv(&user_srv, BT_MESH_PROP_OP_USER_PROPS_GET, NULL, 0);
+	zassert_equal(rsp_cnt, cnt + 1, "No response");
+}
+
+static void client_props_get(u16_t start_id)
+{
+	u8_t data[2];
+	u32_t cnt = rsp_cnt;
+
+	sys_put_le16(start_id, data);
+	msg_recv(&client_srv, BT_MESH_PROP_OP_CLIENT_PROPS_GET, data,
+		 sizeof(data));
+	zassert_equal(rsp_cnt, cnt + 1, "No response");
+}
+
+static void admin_prop_set(u16_t id, enum bt_mesh_prop_access user_access)
+{
+	u8_t data[4];
+	u32_t cnt = rsp_cnt;
+
+	sys_put_le16(id, &data[0]);
+	data[2] = user_access;
+	data[3] = 0;
+	msg_recv(&admin_srv, BT_MESH_PROP_OP_ADMIN_PROP_SET, data,
+		 sizeof(data));
+	zassert_equal(rsp_cnt, cnt + 1, "No response");
+	zassert_equal(rsp_op, BT_MESH_PROP_OP_ADMIN_PROP_STATUS, NULL);
+	zassert_equal(rsp_data[2], user_access, NULL);
+}
+
+static void test_init(void)
+{
+	int err;
+
+	err = bt_mesh_init(&prov, &comp);
+	zassert_equal(err, 0, "Mesh init failed: %d", err);
+}
+
+static void test_owner_list(void)
+{
+	static const u16_t admin_ids[] = { 0x0005, PROP_SHARED, PROP_HIDDEN,
+					   0x0030 };
+	static const u16_t mfr_ids[] = { 0x0008, PROP_SHARED, 0x0040 };
+
+	/* The owners list all their properties, regardless of user access:
+	 */
+	msg_recv(&admin_srv, BT_MESH_PROP_OP_ADMIN_PROPS_GET, NULL, 0);
+	list_check(BT_MESH_PROP_OP_ADMIN_PROPS_STATUS, admin_ids,
+		   ARRAY_SIZE(admin_ids));
+
+	msg_recv(&mfr_srv, BT_MESH_PROP_OP_MFR_PROPS_GET, NULL, 0);
+	list_check(BT_MESH_PROP_OP_MFR_PROPS_STATUS, mfr_ids,
+		   ARRAY_SIZE(mfr_ids));
+}
+
+static void test_user_list(void)
+{
+	/* Both owners' user accessible properties in ascending order, with
+	 * the shared property listed once:
+	 */
+	static const u16_t ids[] = { 0x0005, PROP_SHARED, 0x0030, 0x0040 };
+
+	user_props_get();
+	list_check(BT_MESH_PROP_OP_USER_PROPS_STATUS, ids, ARRAY_SIZE(ids));
+}
+
+static void test_client_list(void)
+{
+	static const u16_t all_ids[] = { 0x0003, 0x0011, 0x0021, 0x0050 };
+
+	client_props_get(0x0000);
+	list_check(BT_MESH_PROP_OP_CLIENT_PROPS_STATUS, all_ids,
+		   ARRAY_SIZE(all_ids));
+
+	/* The list starts at the start property, if present: */
+	client_props_get(0x0011);
+	list_check(BT_MESH_PROP_OP_CLIENT_PROPS_STATUS, &all_ids[1],
+		   ARRAY_SIZE(all_ids) - 1);
+
+	/* ...or at the first property above it: */
+	client_props_get(0x0012);
+	list_check(BT_MESH_PROP_OP_CLIENT_PROPS_STATUS, &all_ids[2],
+		   ARRAY_SIZE(all_ids) - 2);
+
+	client_props_get(0x0051);
+	list_check(BT_MESH_PROP_OP_CLIENT_PROPS_STATUS, NULL, 0);
+}
+
+static void test_user_list_rebuild(void)
+{
+	static const u16_t shown_ids[] = { 0x0005, PROP_SHARED, PROP_HIDDEN,
+					   0x0030, 0x0040 };
+	static const u16_t hidden_ids[] = { 0x0005, PROP_SHARED, PROP_HIDDEN,
+					    0x0040 };
+
+	/* Showing a property to users adds it to the cached list: */
+	admin_prop_set(PROP_HIDDEN, BT_MESH_PROP_ACCESS_READ);
+	user_props_get();
+	list_check(BT_MESH_PROP_OP_USER_PROPS_STATUS, shown_ids,
+		   ARRAY_SIZE(shown_ids));
+
+	/* Hiding one removes it: */
+	admin_prop_set(0x0030, BT_MESH_PROP_ACCESS_PROHIBITED);
+	user_props_get();
+	list_check(BT_MESH_PROP_OP_USER_PROPS_STATUS, hidden_ids,
+		   ARRAY_SIZE(hidden_ids));
+
+	/* The shared property stays listed while the Manufacturer Property
+	 * Server still exposes it:
+	 */
+	admin_prop_set(PROP_SHARED, BT_MESH_PROP_ACCESS_PROHIBITED);
+	user_props_get();
+	list_check(BT_MESH_PROP_OP_USER_PROPS_STATUS, hidden_ids,
+		   ARRAY_SIZE(hidden_ids));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(gen_prop_srv_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_owner_list),
+			 ztest_unit_test(test_user_list),
+			 ztest_unit_test(test_client_list),
+			 ztest_unit_test(test_user_list_rebuild)
+			 );
+
+	ztest_run_test_suite(gen_prop_srv_tests);
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <stdlib.h>
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/mesh/models.h>
+#include "light_ctrl_internal.h"
+
+#define REG_INT			CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_INTERVAL
+#define SUSPEND_TIMEOUT                                                        \
+	CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_SUSPEND_TIMEOUT
+#define SIM_TICK		10
+#define SIM_DURATION		(60 * 60 * MSEC_PER_SEC)
+#define TARGET_LUX		300
+#define LAMP_LUX_MAX		600
+#define SENSOR_INTERVAL		100
+#define SENSOR_DELTA		3
+#define SENSOR_PERIOD		(10 * MSEC_PER_SEC)
+#define SENSOR_NOISE		1
+
+static const struct bt_mesh_light_ctrl_srv_reg_cfg reg_cfg = {
+	.kiu = CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_KIU,
+	.kid = CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_KID,
+	.kpu = CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_KPU,
+	.kpd = CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_KPD,
+	.accuracy = CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ACCURACY,
+};
+
+/* Daylight in the room during the simulated hour. */
+static const struct {
+	u32_t time;
+	s32_t lux;
+} daylight_steps[] = {
+	{ 0, 50 },
+	{ 5 * 60 * MSEC_PER_SEC, 120 },
+	{ 15 * 60 * MSEC_PER_SEC, 250 },
+	{ 25 * 60 * MSEC_PER_SEC, 180 },
+	{ 35 * 60 * MSEC_PER_SEC, 0 },
+	{ 45 * 60 * MSEC_PER_SEC, 90 },
+	{ 55 * 60 * MSEC_PER_SEC, 30 },
+};
+
+/* Light LC Server regulator scheduling, as done by the server model. */
+struct node {
+	struct bt_mesh_light_ctrl_srv_reg reg;
+	bool suspend;
+	bool suspended;
+	u32_t next_step;
+	u16_t output;
+	s32_t ambient;
+	u32_t wakeups;
+};
+
+/* Ambient light sensor with delta and periodic publishing. */
+struct sensor {
+	s32_t published;
+	u32_t last_pub;
+};
+
+struct sim_result {
+	u32_t wakeups;
+	u32_t convergence_max;
+	u32_t convergence_avg;
+};
+
+static u32_t rand_state;
+
+static u32_t rand_get(void)
+{
+	/* Deterministic LCG, so failures can be reproduced. */
+	rand_state = rand_state * 1103515245u + 12345u;
+
+	return rand_state >> 8;
+}
+
+static s32_t daylight_get(u32_t time)
+{
+	s32_t lux = daylight_steps[0].lux;
+
+	for (size_t i = 1; i < ARRAY_SIZE(daylight_steps); i++) {
+		if (daylight_steps[i].time > time) {
+			break;
+		}
+
+		lux = daylight_steps[i].lux;
+	}
+
+	return lux;
+}
+
+static bool daylight_changed(u32_t time)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(daylight_steps); i++) {
+		if (daylight_steps[i].time == time) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static s32_t lamp_lux(u16_t output)
+{
+	return (output * LAMP_LUX_MAX) / UINT16_MAX;
+}
+
+static void node_init(struct node *node, bool suspend)
+{
+	memset(node, 0, sizeof(*node));
+	node->reg.cfg = reg_cfg;
+	node->suspend = suspend;
+	node->next_step = REG_INT;
+}
+
+static void node_step(struct node *node, u32_t time)
+{
+	enum light_ctrl_reg_result result;
+	u16_t output;
+
+	node->wakeups++;
+	node->next_step = time + REG_INT;
+
+	result = light_ctrl_reg_step(&node->reg, TARGET_LUX, node->ambient,
+				     &output);
+	if (result == LIGHT_CTRL_REG_IDLE && node->suspend) {
+		node->suspended = true;
+	} else if (result == LIGHT_CTRL_REG_UPDATED) {
+		/* The state machine light level is 0, so the regulator output
+		 * is always used.
+		 */
+		node->output = output;
+	}
+}
+
+static void node_sensor_rx(struct node *node, s32_t lux, u32_t time)
+{
+	node->ambient = lux;
+
+	if (node->suspended &&
+	    light_ctrl_reg_input(&node->reg.cfg, TARGET_LUX, lux)) {
+		node->suspended = false;
+		node->reg.stable_time = 0;
+		node->next_step = time;
+	}
+}
+
+static void sensor_sample(struct sensor *sensor, struct node *node,
+			  s32_t lux, u32_t time)
+{
+	s32_t measured = lux + (s32_t)(rand_get() % (2 * SENSOR_NOISE + 1)) -
+			 SENSOR_NOISE;
+
+	if (abs(measured - sensor->published) < SENSOR_DELTA &&
+	    time - sensor->last_pub < SENSOR_PERIOD) {
+		return;
+	}
+
+	sensor->published = measured;
+	sensor->last_pub = time;
+	node_sensor_rx(node, measured, time);
+}
+
+static bool converged(s32_t lux)
+{
+	return !light_ctrl_reg_input(&reg_cfg, TARGET_LUX, lux);
+}
+
+/* Closed loop simulation of an hour with changing daylight. */
+static void simulate(bool suspend, struct sim_result *result)
+{
+	struct node node;
+	struct sensor sensor = {};
+	u32_t convergence_start = 0;
+	u32_t convergence_sum = 0;
+	u32_t convergence_count = 0;
+	bool converging = false;
+
+	node_init(&node, suspend);
+	memset(result, 0, sizeof(*result));
+	rand_state = 1;
+
+	for (u32_t time = 0; time < SIM_DURATION; time += SIM_TICK) {
+		s32_t lux = daylight_get(time) + lamp_lux(node.output);
+
+		if (daylight_changed(time)) {
+			converging = true;
+			convergence_start = time;
+		} else if (converging && converged(lux)) {
+			u32_t convergence = time - convergence_start;
+
+			converging = false;
+			convergence_sum += convergence;
+			convergence_count++;
+			result->convergence_max =
+				MAX(result->convergence_max, convergence);
+		}
+
+		if ((time % SENSOR_INTERVAL) == 0) {
+			sensor_sample(&sensor, &node, lux, time);
+		}
+
+		if (!node.suspended && time >= node.next_step) {
+			node_step(&node, time);
+		}
+	}
+
+	zassert_false(converging, "Not converged at the end");
+	zassert_equal(convergence_count, ARRAY_SIZE(daylight_steps), NULL);
+
+	result->wakeups = node.wakeups;
+	result->convergence_avg = convergence_sum / convergence_count;
+}
+
+static void test_dead_zone(void)
+{
+	s32_t accuracy = (reg_cfg.accuracy * TARGET_LUX) / (2 * 100);
+
+	zassert_true(accuracy > 0, "Accuracy too low for the test");
+
+	/* The dead zone is symmetric around the target: */
+	zassert_equal(light_ctrl_reg_input(&reg_cfg, TARGET_LUX,
+					   TARGET_LUX + accuracy),
+		      0, NULL);
+	zassert_equal(light_ctrl_reg_input(&reg_cfg, TARGET_LUX,
+					   TARGET_LUX - accuracy),
+		      0, NULL);
+	zassert_equal(light_ctrl_reg_input(&reg_cfg, TARGET_LUX,
+					   TARGET_LUX + accuracy + 1),
+		      -1, NULL);
+	zassert_equal(light_ctrl_reg_input(&reg_cfg, TARGET_LUX,
+					   TARGET_LUX - accuracy - 1),
+		      1, NULL);
+}
+
+static void test_idle(void)
+{
+	struct bt_mesh_light_ctrl_srv_reg reg = { .cfg = reg_cfg };
+	u16_t output;
+	u32_t time = 0;
+
+	zassert_equal(light_ctrl_reg_step(&reg, TARGET_LUX, 0, &output),
+		      LIGHT_CTRL_REG_UPDATED, NULL);
+	zassert_true(output > 0, "No output");
+
+	/* Stable until the error has been in the dead zone for the suspend
+	 * timeout:
+	 */
+	while (light_ctrl_reg_step(&reg, TARGET_LUX, TARGET_LUX, &output) ==
+	       LIGHT_CTRL_REG_STABLE) {
+		time += REG_INT;
+		zassert_true(time < SUSPEND_TIMEOUT, "Not idle");
+	}
+
+	zassert_true(time + REG_INT >= SUSPEND_TIMEOUT, NULL);
+
+	/* Any error outside the dead zone restarts the timeout: */
+	zassert_equal(light_ctrl_reg_step(&reg, TARGET_LUX, 0, &output),
+		      LIGHT_CTRL_REG_UPDATED, NULL);
+	zassert_equal(reg.stable_time, 0, NULL);
+}
+
+static void test_simulation(void)
+{
+	struct sim_result polling;
+	struct sim_result event_driven;
+
+	simulate(false, &polling);
+	simulate(true, &event_driven);
+
+	TC_PRINT("mode          wakeups[1/h]  max_convergence[ms]  "
+		 "avg_convergence[ms]\n");
+	TC_PRINT("polling       %12u  %19u  %19u\n", polling.wakeups,
+		 polling.convergence_max, polling.convergence_avg);
+	TC_PRINT("event-driven  %12u  %19u  %19u\n", event_driven.wakeups,
+		 event_driven.convergence_max, event_driven.convergence_avg);
+
+	zassert_true(event_driven.wakeups < polling.wakeups / 10,
+		     "Regulator not suspended");
+
+	/* The regulator resumes as soon as the sensor reports a change: */
+	zassert_true(event_driven.convergence_max <=
+			     polling.convergence_max + REG_INT,
+		     "Slower convergence");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(light_ctrl_reg_tests,
+			 ztest_unit_test(test_dead_zone),
+			 ztest_unit_test(test_idle),
+			 ztest_unit_test(test_simulation)
+			 );
+
+	ztest_run_test_suite(light_ctrl_reg_tests);
+}
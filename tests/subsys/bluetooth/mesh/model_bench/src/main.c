@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/byteorder.h>
+#include <bluetooth/mesh.h>
+#include <bluetooth/mesh/models.h>
+#if defined(CONFIG_ARCH_POSIX)
+#include "native_rtc.h"
+#endif
+
+#define TRACE_ROUNDS		50
+#define OPS_MAX			64
+#define MSG_MAXLEN		16
+#define HANDLER_STACK_SIZE	2048
+/* Stack that must be left unused by every handler: */
+#define STACK_MARGIN		256
+#define PRIMARY_ADDR		0x0001
+#define CLIENT_ADDR		0x0100
+
+#define PROP_ADMIN_RW		0x0010
+#define PROP_ADMIN_RO		0x0011
+#define PROP_MFR		0x0020
+
+/* A single access message, as received by an element. */
+struct trace_msg {
+	u8_t elem;
+	u8_t len;
+	bool ack;
+	u32_t opcode;
+	const char *data;
+};
+
+#define TRACE_MSG(_elem, _op, _data, _ack)                                     \
+	{                                                                      \
+		.elem = _elem, .opcode = _op, .data = _data,                   \
+		.len = sizeof(_data) - 1, .ack = _ack,                         \
+	}
+/* Message the model must respond to: */
+#define MSG(_elem, _op, _data) TRACE_MSG(_elem, _op, _data, true)
+/* Message the model must not respond to: */
+#define MSG_UNACK(_elem, _op, _data) TRACE_MSG(_elem, _op, _data, false)
+
+/* Handling cost of a single opcode. */
+struct op_stats {
+	u32_t opcode;
+	u32_t calls;
+	/** Total handling time, in nanoseconds. */
+	u32_t ns;
+	/** Longest handling time, in nanoseconds. */
+	u32_t max_ns;
+	/** Responses sent to the message context. */
+	u32_t rsp;
+	/** Publications triggered by the message. */
+	u32_t pub;
+	/** Access payload bytes handed to the access layer. */
+	u32_t bytes;
+	/** Stack high-water mark of the handler thread, in bytes. */
+	size_t stack;
+};
+
+/* Message currently being handled. */
+struct dispatch {
+	struct bt_mesh_model *mod;
+	const struct bt_mesh_model_op *op;
+	struct bt_mesh_msg_ctx ctx;
+	struct net_buf_simple *buf;
+	u32_t ns;
+};
+
+/*******************************************************************************
+ * Composition
+ ******************************************************************************/
+
+static void light_set(struct bt_mesh_lightness_srv *srv,
+		      struct bt_mesh_msg_ctx *ctx,
+		      const struct bt_mesh_lightness_set *set,
+		      struct bt_mesh_lightness_status *rsp);
+static void light_get(struct bt_mesh_lightness_srv *srv,
+		      struct bt_mesh_msg_ctx *ctx,
+		      struct bt_mesh_lightness_status *rsp);
+static void prop_get(struct bt_mesh_prop_srv *srv, struct bt_mesh_msg_ctx *ctx,
+		     struct bt_mesh_prop_val *val);
+static void prop_set(struct bt_mesh_prop_srv *srv, struct bt_mesh_msg_ctx *ctx,
+		     struct bt_mesh_prop_val *val);
+static int amb_light_get(struct bt_mesh_sensor *sensor,
+			 struct bt_mesh_msg_ctx *ctx, struct sensor_value *rsp);
+static int people_count_get(struct bt_mesh_sensor *sensor,
+			    struct bt_mesh_msg_ctx *ctx,
+			    struct sensor_value *rsp);
+
+static u16_t light_lvl;
+static u16_t prop_value = 0x1234;
+
+static const struct bt_mesh_lightness_srv_handlers lightness_handlers = {
+	.light_set = light_set,
+	.light_get = light_get,
+};
+
+static struct bt_mesh_prop admin_props[] = {
+	{ PROP_ADMIN_RW, BT_MESH_PROP_ACCESS_READ_WRITE },
+	{ PROP_ADMIN_RO, BT_MESH_PROP_ACCESS_READ },
+};
+
+static struct bt_mesh_prop mfr_props[] = {
+	{ PROP_MFR, BT_MESH_PROP_ACCESS_READ },
+};
+
+static const struct bt_mesh_prop client_props[] = {
+	{ BT_MESH_PROP_ID_MOTION_SENSED },
+	{ BT_MESH_PROP_ID_PRESENT_AMB_LIGHT_LEVEL },
+};
+
+static struct bt_mesh_sensor amb_light = {
+	.type = &bt_mesh_sensor_present_amb_light_level,
+	.get = amb_light_get,
+};
+
+static struct bt_mesh_sensor people_count = {
+	.type = &bt_mesh_sensor_people_count,
+	.get = people_count_get,
+};
+
+static struct bt_mesh_sensor *const sensors[] = {
+	&amb_light,
+	&people_count,
+};
+
+static struct bt_mesh_cfg_srv cfg_srv = {
+	.default_ttl = 7,
+	.net_transmit = BT_MESH_TRANSMIT(2, 20),
+	.relay_retransmit = BT_MESH_TRANSMIT(2, 20),
+};
+
+static struct bt_mesh_lightness_srv lightness_srv =
+	BT_MESH_LIGHTNESS_SRV_INIT(&lightness_handlers);
+static struct bt_mesh_light_ctrl_srv light_ctrl_srv =
+	BT_MESH_LIGHT_CTRL_SRV_INIT(&lightness_srv);
+static struct bt_mesh_sensor_srv sensor_srv =
+	BT_MESH_SENSOR_SRV_INIT(sensors, ARRAY_SIZE(sensors));
+static struct bt_mesh_prop_srv user_prop_srv = BT_MESH_PROP_SRV_USER_INIT();
+static struct bt_mesh_prop_srv admin_prop_srv =
+	BT_MESH_PROP_SRV_ADMIN_INIT(admin_props, prop_get, prop_set);
+static struct bt_mesh_prop_srv mfr_prop_srv =
+	BT_MESH_PROP_SRV_MFR_INIT(mfr_props, prop_get);
+static struct bt_mesh_prop_srv client_prop_srv =
+	BT_MESH_PROP_SRV_CLIENT_INIT(client_props);
+
+/* A luminaire with an occupancy sensor, like the Light Lightness Control
+ * samples. The LC Server controls the Lightness Server in the primary element.
+ */
+static struct bt_mesh_elem elements[] = {
+	BT_MESH_ELEM(1,
+		     BT_MESH_MODEL_LIST(
+			     BT_MESH_MODEL_CFG_SRV(&cfg_srv),
+			     BT_MESH_MODEL_LIGHTNESS_SRV(&lightness_srv),
+			     BT_MESH_MODEL_SENSOR_SRV(&sensor_srv),
+			     BT_MESH_MODEL_PROP_SRV_USER(&user_prop_srv),
+			     BT_MESH_MODEL_PROP_SRV_ADMIN(&admin_prop_srv),
+			     BT_MESH_MODEL_PROP_SRV_MFR(&mfr_prop_srv),
+			     BT_MESH_MODEL_PROP_SRV_CLIENT(&client_prop_srv)),
+		     BT_MESH_MODEL_NONE),
+	BT_MESH_ELEM(2,
+		     BT_MESH_MODEL_LIST(
+			     BT_MESH_MODEL_LIGHT_CTRL_SRV(&light_ctrl_srv)),
+		     BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+	.cid = CONFIG_BT_COMPANY_ID,
+	.elem = elements,
+	.elem_count = ARRAY_SIZE(elements),
+};
+
+static const u8_t dev_uuid[16] = { 0xdd, 0xdd };
+
+static const struct bt_mesh_prov prov = {
+	.uuid = dev_uuid,
+};
+
+static void light_set(struct bt_mesh_lightness_srv *srv,
+		      struct bt_mesh_msg_ctx *ctx,
+		      const struct bt_mesh_lightness_set *set,
+		      struct bt_mesh_lightness_status *rsp)
+{
+	light_lvl = set->lvl;
+	light_get(srv, ctx, rsp);
+}
+
+static void light_get(struct bt_mesh_lightness_srv *srv,
+		      struct bt_mesh_msg_ctx *ctx,
+		      struct bt_mesh_lightness_status *rsp)
+{
+	rsp->current = light_lvl;
+	rsp->target = light_lvl;
+	rsp->remaining_time = 0;
+}
+
+static void prop_get(struct bt_mesh_prop_srv *srv, struct bt_mesh_msg_ctx *ctx,
+		     struct bt_mesh_prop_val *val)
+{
+	val->size = sizeof(prop_value);
+	sys_put_le16(prop_value, val->value);
+}
+
+static void prop_set(struct bt_mesh_prop_srv *srv, struct bt_mesh_msg_ctx *ctx,
+		     struct bt_mesh_prop_val *val)
+{
+	if (val->size != sizeof(prop_value)) {
+		val->meta.id = BT_MESH_PROP_ID_PROHIBITED;
+		return;
+	}
+
+	prop_value = sys_get_le16(val->value);
+}
+
+static int amb_light_get(struct bt_mesh_sensor *sensor,
+			 struct bt_mesh_msg_ctx *ctx, struct sensor_value *rsp)
+{
+	rsp[0].val1 = 500;
+	rsp[0].val2 = 0;
+
+	return 0;
+}
+
+static int people_count_get(struct bt_mesh_sensor *sensor,
+			    struct bt_mesh_msg_ctx *ctx,
+			    struct sensor_value *rsp)
+{
+	rsp[0].val1 = 3;
+	rsp[0].val2 = 0;
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Traces
+ ******************************************************************************/
+
+/* A wall switch dimming the light up and down, then turning it off and on. The
+ * level deltas share a transaction, like a user holding the dimmer.
+ */
+static const struct trace_msg dimmer_trace[] = {
+	MSG(0, BT_MESH_LIGHTNESS_OP_GET, ""),
+	MSG_UNACK(0, BT_MESH_LVL_OP_DELTA_SET_UNACK, "\x00\x10\x00\x00\x01"),
+	MSG_UNACK(0, BT_MESH_LVL_OP_DELTA_SET_UNACK, "\x00\x20\x00\x00\x01"),
+	MSG(0, BT_MESH_LVL_OP_DELTA_SET, "\x00\x30\x00\x00\x01"),
+	MSG(0, BT_MESH_LVL_OP_MOVE_SET, "\x00\x01\x02\x41\x00"),
+	MSG(0, BT_MESH_LVL_OP_SET, "\x00\x00\x03"),
+	MSG(0, BT_MESH_LVL_OP_GET, ""),
+	MSG(0, BT_MESH_LIGHTNESS_OP_SET, "\x00\xc0\x04"),
+	MSG_UNACK(0, BT_MESH_LIGHTNESS_OP_SET_UNACK, "\x00\x80\x05\x05\x00"),
+	MSG(0, BT_MESH_LIGHTNESS_OP_LINEAR_GET, ""),
+	MSG(0, BT_MESH_ONOFF_OP_SET, "\x00\x06"),
+	MSG(0, BT_MESH_ONOFF_OP_GET, ""),
+	MSG_UNACK(0, BT_MESH_ONOFF_OP_SET_UNACK, "\x01\x07"),
+	MSG(0, BT_MESH_LIGHTNESS_OP_LAST_GET, ""),
+};
+
+/* A commissioning tool configuring the luminaire. */
+static const struct trace_msg setup_trace[] = {
+	MSG(0, BT_MESH_LIGHTNESS_OP_RANGE_SET, "\x00\x10\xff\xff"),
+	MSG(0, BT_MESH_LIGHTNESS_OP_RANGE_GET, ""),
+	MSG(0, BT_MESH_LIGHTNESS_OP_DEFAULT_SET, "\x00\x80"),
+	MSG(0, BT_MESH_LIGHTNESS_OP_DEFAULT_GET, ""),
+	MSG(0, BT_MESH_PONOFF_OP_SET, "\x02"),
+	MSG(0, BT_MESH_PONOFF_OP_GET, ""),
+	MSG(0, BT_MESH_SENSOR_OP_DESCRIPTOR_GET, ""),
+	MSG(0, BT_MESH_SENSOR_OP_CADENCE_GET, "\x4e\x00"),
+	MSG(0, BT_MESH_SENSOR_OP_SETTINGS_GET, "\x4e\x00"),
+	MSG(0, BT_MESH_PROP_OP_ADMIN_PROPS_GET, ""),
+	MSG(0, BT_MESH_PROP_OP_ADMIN_PROP_SET, "\x10\x00\x03\x34\x12"),
+	MSG(0, BT_MESH_PROP_OP_ADMIN_PROP_GET, "\x11\x00"),
+	MSG(0, BT_MESH_PROP_OP_MFR_PROPS_GET, ""),
+	MSG(0, BT_MESH_PROP_OP_MFR_PROP_GET, "\x20\x00"),
+	/* Lightness On and Time Fade On: */
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_PROP_SET, "\x2e\x00\x00\xc0"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_PROP_SET, "\x37\x00\xe8\x03\x00"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_PROP_GET, "\x2e\x00"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_OM_SET, "\x01"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_MODE_SET, "\x01"),
+};
+
+/* Occupancy and ambient light reports driving the LC Server, while a gateway
+ * polls the luminaire's sensors and user properties.
+ */
+static const struct trace_msg occupancy_trace[] = {
+	/* Motion Sensed: 100 % */
+	MSG_UNACK(1, BT_MESH_SENSOR_OP_STATUS, "\x40\x08\xc8"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_LIGHT_ONOFF_GET, ""),
+	/* Present Ambient Light Level: 500 lux */
+	MSG_UNACK(1, BT_MESH_SENSOR_OP_STATUS, "\xc4\x09\x50\xc3\x00"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_MODE_GET, ""),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_OM_GET, ""),
+	MSG(1, BT_MESH_ONOFF_OP_GET, ""),
+	MSG(0, BT_MESH_SENSOR_OP_GET, ""),
+	MSG(0, BT_MESH_SENSOR_OP_GET, "\x4e\x00"),
+	MSG(0, BT_MESH_PROP_OP_USER_PROPS_GET, ""),
+	MSG(0, BT_MESH_PROP_OP_USER_PROP_GET, "\x10\x00"),
+	MSG(0, BT_MESH_PROP_OP_USER_PROP_SET, "\x10\x00\x78\x56"),
+	MSG(0, BT_MESH_PROP_OP_CLIENT_PROPS_GET, "\x00\x00"),
+	MSG(1, BT_MESH_LIGHT_CTRL_OP_LIGHT_ONOFF_SET, "\x00\x08"),
+};
+
+static const struct {
+	const char *name;
+	const struct trace_msg *msgs;
+	size_t count;
+} traces[] = {
+	{ "dimmer", dimmer_trace, ARRAY_SIZE(dimmer_trace) },
+	{ "setup", setup_trace, ARRAY_SIZE(setup_trace) },
+	{ "occupancy", occupancy_trace, ARRAY_SIZE(occupancy_trace) },
+};
+
+/*******************************************************************************
+ * Loopback access layer
+ ******************************************************************************/
+
+K_THREAD_STACK_DEFINE(handler_stack, HANDLER_STACK_SIZE);
+static struct k_thread handler_thread;
+static K_SEM_DEFINE(handler_done, 0, 1);
+
+static struct op_stats ops[OPS_MAX];
+static size_t op_count;
+static struct op_stats *current;
+
+int __wrap_bt_mesh_model_send(struct bt_mesh_model *model,
+			      struct bt_mesh_msg_ctx *ctx,
+			      struct net_buf_simple *msg,
+			      const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+	if (current) {
+		current->rsp++;
+		current->bytes += msg->len;
+	}
+
+	return 0;
+}
+
+int __wrap_bt_mesh_model_publish(struct bt_mesh_model *model)
+{
+	/* Models also publish from their timers, which isn't part of the
+	 * message handling cost.
+	 */
+	if (current) {
+		current->pub++;
+		current->bytes += model->pub->msg->len;
+	}
+
+	return 0;
+}
+
+static struct op_stats *op_stats_get(u32_t opcode)
+{
+	for (size_t i = 0; i < op_count; i++) {
+		if (ops[i].opcode == opcode) {
+			return &ops[i];
+		}
+	}
+
+	zassert_true(op_count < OPS_MAX, "Out of op stats");
+
+	ops[op_count].opcode = opcode;
+	return &ops[op_count++];
+}
+
+/* Find the model operation for an incoming message, like the access layer. */
+static const struct bt_mesh_model_op *op_find(struct bt_mesh_elem *elem,
+					      u32_t opcode,
+					      struct bt_mesh_model **mod)
+{
+	for (int i = 0; i < elem->model_count; i++) {
+		const struct bt_mesh_model_op *op;
+
+		for (op = elem->models[i].op; op && op->func; op++) {
+			if (op->opcode == opcode) {
+				*mod = &elem->models[i];
+				return op;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* The kernel clock doesn't advance while the handlers run on native_posix, as
+ * they run in zero simulated time. Measure the handlers with the host clock
+ * there, and with the cycle counter on hardware.
+ */
+static u32_t timestamp_get(void)
+{
+#if defined(CONFIG_ARCH_POSIX)
+	u64_t sec;
+	u32_t nsec;
+
+	native_rtc_gettime(RTC_CLOCK_REAL, &nsec, &sec);
+	return sec * NSEC_PER_SEC + nsec;
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+static u32_t elapsed_ns(u32_t start)
+{
+	u32_t delta = timestamp_get() - start;
+
+#if defined(CONFIG_ARCH_POSIX)
+	return delta;
+#else
+	return k_cyc_to_ns_floor64(delta);
+#endif
+}
+
+static void handler_run(void *p1, void *p2, void *p3)
+{
+	struct dispatch *dispatch = p1;
+	u32_t start = timestamp_get();
+
+	dispatch->op->func(dispatch->mod, &dispatch->ctx, dispatch->buf);
+	dispatch->ns = elapsed_ns(start);
+
+	k_sem_give(&handler_done);
+}
+
+static void msg_recv(const struct trace_msg *msg, u16_t src)
+{
+	struct dispatch dispatch = {
+		.ctx = {
+			.app_idx = 0,
+			.addr = src,
+			.recv_dst = PRIMARY_ADDR + msg->elem,
+			.recv_ttl = 5,
+			.send_ttl = BT_MESH_TTL_DEFAULT,
+		},
+	};
+	struct op_stats *stats = op_stats_get(msg->opcode);
+	u32_t rsp = stats->rsp;
+	size_t unused;
+	int err;
+
+	NET_BUF_SIMPLE_DEFINE(buf, MSG_MAXLEN);
+	net_buf_simple_add_mem(&buf, msg->data, msg->len);
+	dispatch.buf = &buf;
+
+	dispatch.op = op_find(&elements[msg->elem], msg->opcode, &dispatch.mod);
+	zassert_not_null(dispatch.op, "No handler for 0x%06x", msg->opcode);
+	zassert_true(buf.len >= dispatch.op->min_len,
+		     "0x%06x too short for the handler", msg->opcode);
+
+	current = stats;
+
+	/* Every message is handled in a freshly painted thread, so the stack
+	 * high-water mark belongs to this message alone. The handler thread
+	 * preempts everything, and is done once the semaphore is given.
+	 */
+	k_thread_create(&handler_thread, handler_stack,
+			K_THREAD_STACK_SIZEOF(handler_stack), handler_run,
+			&dispatch, NULL, NULL, K_HIGHEST_THREAD_PRIO, 0,
+			K_NO_WAIT);
+	k_sem_take(&handler_done, K_FOREVER);
+
+	current = NULL;
+
+	err = k_thread_stack_space_get(&handler_thread, &unused);
+	zassert_equal(err, 0, "No stack info: %d", err);
+
+	stats->calls++;
+	stats->ns += dispatch.ns;
+	stats->max_ns = MAX(stats->max_ns, dispatch.ns);
+	stats->stack = MAX(stats->stack, HANDLER_STACK_SIZE - unused);
+
+	if (msg->ack) {
+		zassert_true(stats->rsp > rsp, "No response to 0x%06x",
+			     msg->opcode);
+	} else {
+		zassert_equal(stats->rsp, rsp, "Responded to 0x%06x",
+			      msg->opcode);
+	}
+}
+
+static void trace_replay(const struct trace_msg *msgs, size_t count,
+			 u16_t src)
+{
+	for (size_t i = 0; i < count; i++) {
+		msg_recv(&msgs[i], src);
+	}
+}
+
+/*******************************************************************************
+ * Tests
+ ******************************************************************************/
+
+static void test_init(void)
+{
+	int err;
+
+	err = bt_mesh_init(&prov, &comp);
+	zassert_equal(err, 0, "Mesh init failed: %d", err);
+}
+
+static void test_dispatch(void)
+{
+	/* Every message in the traces reaches a handler: */
+	for (size_t i = 0; i < ARRAY_SIZE(traces); i++) {
+		for (size_t j = 0; j < traces[i].count; j++) {
+			const struct trace_msg *msg = &traces[i].msgs[j];
+			struct bt_mesh_model *mod;
+
+			zassert_true(msg->elem < ARRAY_SIZE(elements), NULL);
+			zassert_not_null(op_find(&elements[msg->elem],
+						 msg->opcode, &mod),
+					 "%s: No handler for 0x%06x",
+					 traces[i].name, msg->opcode);
+		}
+	}
+}
+
+/* Replays every trace a number of times, and reports the cost of each opcode.
+ *
+ * The stack usage is only checked on hardware, as native_posix runs the
+ * Zephyr threads on the host's stacks, and never touches the painted ones.
+ */
+static void test_replay(void)
+{
+	u32_t calls = 0;
+	u32_t ns = 0;
+
+	memset(ops, 0, sizeof(ops));
+	op_count = 0;
+
+	for (u16_t pass = 0; pass < TRACE_ROUNDS; pass++) {
+		/* Clients use a new address every pass, so the transaction
+		 * IDs in the traces are always new to the models:
+		 */
+		for (size_t i = 0; i < ARRAY_SIZE(traces); i++) {
+			trace_replay(traces[i].msgs, traces[i].count,
+				     CLIENT_ADDR + pass);
+		}
+	}
+
+	TC_PRINT("opcode    calls   avg[ns]   max[ns]  rsp   pub   "
+		 "bytes  stack[B]\n");
+
+	for (size_t i = 0; i < op_count; i++) {
+		struct op_stats *stats = &ops[i];
+
+		TC_PRINT("0x%06x  %5u  %8u  %8u  %4u  %4u  %6u  %8u\n",
+			 stats->opcode, stats->calls, stats->ns / stats->calls,
+			 stats->max_ns, stats->rsp, stats->pub, stats->bytes,
+			 (u32_t)stats->stack);
+
+		if (!IS_ENABLED(CONFIG_ARCH_POSIX)) {
+			zassert_true(stats->stack > 0,
+				     "No stack usage for 0x%06x",
+				     stats->opcode);
+			zassert_true(stats->stack <=
+					     HANDLER_STACK_SIZE - STACK_MARGIN,
+				     "0x%06x used %u bytes of stack",
+				     stats->opcode, (u32_t)stats->stack);
+		}
+
+		calls += stats->calls;
+		ns += stats->ns;
+	}
+
+	/* A clock that doesn't advance would hide every regression: */
+	zassert_true(ns > 0, "No handling time measured");
+
+	zassert_equal(calls,
+		      TRACE_ROUNDS * (ARRAY_SIZE(dimmer_trace) +
+				      ARRAY_SIZE(setup_trace) +
+				      ARRAY_SIZE(occupancy_trace)),
+		      NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(model_bench_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_dispatch),
+			 ztest_unit_test(test_replay)
+			 );
+
+	ztest_run_test_suite(model_bench_tests);
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <stdlib.h>
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/mesh/models.h>
+#include "model_utils.h"
+
+#define STORE_TIMEOUT		CONFIG_BT_MESH_MODEL_STORE_TIMEOUT
+#define STORE_DEADLINE		CONFIG_BT_MESH_MODEL_STORE_DEADLINE
+/* Time it may take the store work to run after it's due: */
+#define SLACK			10
+#define STATE_COUNT		8
+#define SIM_DURATION		(60 * MSEC_PER_SEC)
+#define DIM_INTERVAL		50
+
+/* Persistent state of a single model. */
+struct state {
+	struct bt_mesh_model_store_ctx store;
+	s32_t value;
+	s32_t stored;
+	u32_t writes;
+	u32_t last_write;
+	u32_t dirty_since;
+	u32_t max_latency;
+	bool dirty;
+};
+
+static struct state states[STATE_COUNT];
+static u32_t rand_state;
+
+static u32_t rand_get(void)
+{
+	/* Deterministic LCG, so failures can be reproduced. */
+	rand_state = rand_state * 1103515245u + 12345u;
+
+	return rand_state >> 8;
+}
+
+static int store(struct bt_mesh_model_store_ctx *ctx)
+{
+	struct state *state = CONTAINER_OF(ctx, struct state, store);
+	u32_t now = k_uptime_get_32();
+
+	state->stored = state->value;
+	state->writes++;
+	state->last_write = now;
+	state->max_latency = MAX(state->max_latency, now - state->dirty_since);
+	state->dirty = false;
+
+	return 0;
+}
+
+static void state_set(struct state *state, s32_t value)
+{
+	if (!state->dirty) {
+		state->dirty = true;
+		state->dirty_since = k_uptime_get_32();
+	}
+
+	state->value = value;
+	model_store_schedule(&state->store);
+}
+
+static void states_init(void)
+{
+	bt_mesh_model_store_flush();
+	memset(states, 0, sizeof(states));
+
+	for (int i = 0; i < STATE_COUNT; i++) {
+		model_store_init(&states[i].store, store, STORE_TIMEOUT);
+	}
+}
+
+static void test_settle(void)
+{
+	struct state *state = &states[0];
+
+	states_init();
+
+	/* Changes that come faster than the timeout are coalesced: */
+	for (int i = 0; i < 10; i++) {
+		state_set(state, i);
+		k_sleep(K_MSEC(STORE_TIMEOUT / 5));
+	}
+
+	zassert_equal(state->writes, 0, "Stored before settling");
+
+	k_sleep(K_MSEC(STORE_TIMEOUT + SLACK));
+	zassert_equal(state->writes, 1, "%u writes", state->writes);
+	zassert_equal(state->stored, 9, NULL);
+
+	k_sleep(K_MSEC(STORE_DEADLINE));
+	zassert_equal(state->writes, 1, "Stored without changes");
+}
+
+static void test_deadline(void)
+{
+	struct state *state = &states[0];
+	u32_t start = k_uptime_get_32();
+
+	states_init();
+
+	/* A state that never settles is still stored within the deadline: */
+	for (int i = 0; k_uptime_get_32() - start < 3 * STORE_DEADLINE; i++) {
+		state_set(state, i);
+		k_sleep(K_MSEC(STORE_TIMEOUT / 2));
+	}
+
+	k_sleep(K_MSEC(STORE_TIMEOUT + SLACK));
+	zassert_true(state->writes >= 3, "%u writes", state->writes);
+	zassert_false(state->dirty, NULL);
+	zassert_true(state->max_latency <= STORE_DEADLINE + SLACK,
+		     "Latency: %u ms", state->max_latency);
+}
+
+static void test_shared_pass(void)
+{
+	states_init();
+
+	/* States changed by the same message are written together: */
+	for (int i = 0; i < STATE_COUNT; i++) {
+		state_set(&states[i], i + 1);
+	}
+
+	k_sleep(K_MSEC(STORE_TIMEOUT + SLACK));
+
+	for (int i = 0; i < STATE_COUNT; i++) {
+		zassert_equal(states[i].writes, 1, NULL);
+		zassert_equal(states[i].stored, i + 1, NULL);
+		zassert_equal(states[i].last_write, states[0].last_write,
+			      "Separate passes");
+	}
+}
+
+static void test_cancel_flush(void)
+{
+	states_init();
+
+	state_set(&states[0], 1);
+	model_store_cancel(&states[0].store);
+	k_sleep(K_MSEC(STORE_TIMEOUT + SLACK));
+	zassert_equal(states[0].writes, 0, "Stored after cancel");
+
+	/* Flushing writes every pending state immediately: */
+	state_set(&states[0], 2);
+	state_set(&states[1], 3);
+	bt_mesh_model_store_flush();
+	zassert_equal(states[0].writes, 1, NULL);
+	zassert_equal(states[0].stored, 2, NULL);
+	zassert_equal(states[1].writes, 1, NULL);
+	zassert_equal(states[1].stored, 3, NULL);
+	zassert_equal(states[2].writes, 0, NULL);
+
+	k_sleep(K_MSEC(STORE_TIMEOUT + SLACK));
+	zassert_equal(states[0].writes, 1, "Stored twice");
+	zassert_equal(states[1].writes, 1, "Stored twice");
+}
+
+/* A minute of dimming: Each state is dimmed in bursts of level changes, with
+ * quiet periods in between, like a user holding a dimmer switch.
+ */
+static void test_dimming(void)
+{
+	struct bt_mesh_model_store_stats before, after;
+	u32_t start = k_uptime_get_32();
+	u32_t next_burst[STATE_COUNT];
+	u32_t burst_end[STATE_COUNT] = { 0 };
+	u32_t requests, writes = 0;
+	u32_t max_latency = 0;
+
+	states_init();
+	rand_state = 1;
+
+	for (int i = 0; i < STATE_COUNT; i++) {
+		next_burst[i] = rand_get() % 5000;
+	}
+
+	bt_mesh_model_store_stats_get(&before);
+
+	for (u32_t time = 0; time < SIM_DURATION; time += DIM_INTERVAL) {
+		for (int i = 0; i < STATE_COUNT; i++) {
+			if (time >= next_burst[i]) {
+				burst_end[i] = time + 500 + rand_get() % 1500;
+				next_burst[i] = burst_end[i] + 500 +
+						rand_get() % 4500;
+			}
+
+			if (time < burst_end[i]) {
+				state_set(&states[i], states[i].value + 1);
+			}
+		}
+
+		s32_t delay = start + time + DIM_INTERVAL - k_uptime_get_32();
+
+		k_sleep(K_MSEC(MAX(0, delay)));
+	}
+
+	k_sleep(K_MSEC(STORE_TIMEOUT + SLACK));
+	bt_mesh_model_store_stats_get(&after);
+
+	requests = after.requests - before.requests;
+
+	for (int i = 0; i < STATE_COUNT; i++) {
+		zassert_false(states[i].dirty, "State %d not stored", i);
+		zassert_equal(states[i].stored, states[i].value, NULL);
+		writes += states[i].writes;
+		max_latency = MAX(max_latency, states[i].max_latency);
+	}
+
+	zassert_equal(after.writes - before.writes, writes, NULL);
+
+	/* Without coalescing, every request is a separate write: */
+	TC_PRINT("requests  writes  max_latency[ms]\n");
+	TC_PRINT("%8u  %6u  %15u\n", requests, writes, max_latency);
+
+	zassert_true(writes < requests / 10, "%u writes", writes);
+	zassert_true(max_latency <= STORE_DEADLINE + SLACK, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(model_store_tests,
+			 ztest_unit_test(test_settle),
+			 ztest_unit_test(test_deadline),
+			 ztest_unit_test(test_shared_pass),
+			 ztest_unit_test(test_cancel_flush),
+			 ztest_unit_test(test_dimming)
+			 );
+
+	ztest_run_test_suite(model_store_tests);
+}
@@ -0,0 +1,648 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/mesh/models.h>
+#include "sensor.h"
+
+#define FUZZ_ITERATIONS		20000
+#define BENCH_ITERATIONS	1000
+
+/* Reference implementation: the scalar codec as it was before the conversion
+ * factors were precomputed, with the range check of negative encoded values
+ * fixed.
+ */
+#define BRANCHLESS_ABS8(x) (((x) + ((x) >> 7)) ^ ((x) >> 7))
+
+#define SCALAR(mul, bin)                                                       \
+	((double)(mul) *                                                       \
+	 (double)((bin) >= 0 ? (1ULL << BRANCHLESS_ABS8(bin)) :                \
+			       (1.0 / (1ULL << BRANCHLESS_ABS8(bin)))))
+
+#define SCALAR_IS_DIV(_scalar) ((_scalar) > -1.0 && (_scalar) < 1.0)
+
+#define REF_REPR(_scalar, _flags, _max)                                        \
+	{                                                                      \
+		.flags = ((_flags) | (SCALAR_IS_DIV(_scalar) ? DIVIDE : 0)),   \
+		.max = _max,                                                   \
+		.value = (s64_t)((SCALAR_IS_DIV(_scalar) ? (1.0 / (_scalar)) : \
+							   (_scalar)) +        \
+				 0.5),                                         \
+	}
+
+#define REF_FORMAT(_name, _flags, _scalar)                                     \
+	{                                                                      \
+		.format = &bt_mesh_sensor_format_##_name,                      \
+		.repr = REF_REPR(_scalar, _flags, 0),                          \
+	}
+
+#define REF_FORMAT_MAX(_name, _flags, _scalar, _max)                           \
+	{                                                                      \
+		.format = &bt_mesh_sensor_format_##_name,                      \
+		.repr = REF_REPR(_scalar, ((_flags) | HAS_MAX), _max),         \
+	}
+
+enum ref_repr_flags {
+	UNSIGNED = 0,
+	SIGNED = BIT(1),
+	DIVIDE = BIT(2),
+	HAS_UNDEFINED = BIT(3),
+	HAS_HIGHER_THAN = (BIT(4)),
+	HAS_INVALID = (BIT(5)),
+	HAS_MAX = BIT(6),
+};
+
+struct ref_repr {
+	enum ref_repr_flags flags;
+	u32_t max;
+	s64_t value;
+};
+
+struct ref_format {
+	const struct bt_mesh_sensor_format *format;
+	struct ref_repr repr;
+};
+
+static const struct ref_format ref_formats[] = {
+	REF_FORMAT_MAX(percentage_8, (UNSIGNED | HAS_UNDEFINED), SCALAR(1, -1),
+		       200),
+	REF_FORMAT_MAX(percentage_16, (UNSIGNED | HAS_UNDEFINED),
+		       SCALAR(1e-2, 0), 200),
+	REF_FORMAT(temp_8, SIGNED, SCALAR(1, -1)),
+	REF_FORMAT(temp, SIGNED, SCALAR(1e-2, 0)),
+	REF_FORMAT(co2_concentration, (HAS_HIGHER_THAN | HAS_UNDEFINED),
+		   SCALAR(1, 0)),
+	REF_FORMAT(noise, (UNSIGNED | HAS_HIGHER_THAN | HAS_UNDEFINED),
+		   SCALAR(1, 0)),
+	REF_FORMAT_MAX(voc_concentration,
+		       (UNSIGNED | HAS_HIGHER_THAN | HAS_UNDEFINED),
+		       SCALAR(1, 0), 65533),
+	REF_FORMAT_MAX(humidity, UNSIGNED, SCALAR(1e-2, 0), 10000),
+	REF_FORMAT_MAX(time_decihour_8, (UNSIGNED | HAS_UNDEFINED),
+		       SCALAR(1e-1, 0), 240),
+	REF_FORMAT(time_hour_24, (UNSIGNED | HAS_UNDEFINED), SCALAR(1e-1, 0)),
+	REF_FORMAT(time_second_16, (UNSIGNED | HAS_UNDEFINED), SCALAR(1, 0)),
+	REF_FORMAT(time_millisecond_24, (UNSIGNED | HAS_UNDEFINED),
+		   SCALAR(1e-3, 0)),
+	REF_FORMAT(electric_current, (UNSIGNED | HAS_UNDEFINED),
+		   SCALAR(1e-2, 0)),
+	REF_FORMAT(voltage, (UNSIGNED | HAS_UNDEFINED), SCALAR(1, -6)),
+	REF_FORMAT(energy32, UNSIGNED | HAS_INVALID | HAS_UNDEFINED,
+		   SCALAR(1e-3, 0)),
+	REF_FORMAT(power, (UNSIGNED | HAS_UNDEFINED), SCALAR(1e-1, 0)),
+	REF_FORMAT(energy, (UNSIGNED | HAS_UNDEFINED), SCALAR(1, 0)),
+	REF_FORMAT_MAX(chromatic_distance,
+		       (SIGNED | HAS_INVALID | HAS_UNDEFINED), SCALAR(1e-5, 0),
+		       5000),
+	REF_FORMAT(chromaticity_coordinate, UNSIGNED, SCALAR(1, -16)),
+	REF_FORMAT(correlated_color_temp, (UNSIGNED | HAS_UNDEFINED),
+		   SCALAR(1, 0)),
+	REF_FORMAT(illuminance, (UNSIGNED | HAS_UNDEFINED), SCALAR(1e-2, 0)),
+	REF_FORMAT(luminous_efficacy, (UNSIGNED | HAS_UNDEFINED),
+		   SCALAR(1e-1, 0)),
+	REF_FORMAT(luminous_energy, (UNSIGNED | HAS_UNDEFINED), SCALAR(1e3, 0)),
+	REF_FORMAT(luminous_exposure, (UNSIGNED | HAS_UNDEFINED),
+		   SCALAR(1e3, 0)),
+	REF_FORMAT(luminous_flux, (UNSIGNED | HAS_UNDEFINED), SCALAR(1, 0)),
+	REF_FORMAT(perceived_lightness, UNSIGNED, SCALAR(1, 0)),
+	REF_FORMAT(count_16, (UNSIGNED | HAS_UNDEFINED), SCALAR(1, 0)),
+	REF_FORMAT(gen_lvl, UNSIGNED, SCALAR(1, 0)),
+	REF_FORMAT_MAX(cos_of_the_angle, SIGNED, SCALAR(1, 0), 100),
+};
+
+static s64_t mul_scalar(s64_t val, const struct ref_repr *repr)
+{
+	return (repr->flags & DIVIDE) ? (val / repr->value) :
+	       (val * repr->value);
+}
+
+static s64_t div_scalar(s64_t val, const struct ref_repr *repr)
+{
+	return (repr->flags & DIVIDE) ? (val * repr->value) :
+	       (val / repr->value);
+}
+
+static s64_t ref_max(const struct ref_format *ref)
+{
+	if (ref->repr.flags & HAS_MAX) {
+		return ref->repr.max;
+	}
+
+	if (ref->repr.flags & SIGNED) {
+		return BIT64(8 * ref->format->size - 1) - 1;
+	}
+
+	s64_t max_value = BIT64(8 * ref->format->size) - 1;
+
+	if (ref->repr.flags & (HAS_HIGHER_THAN | HAS_INVALID)) {
+		max_value -= 2;
+	} else if (ref->repr.flags & HAS_UNDEFINED) {
+		max_value -= 1;
+	}
+
+	return max_value;
+}
+
+static s64_t ref_min(const struct ref_format *ref)
+{
+	if (ref->repr.flags & SIGNED) {
+		return -BIT64(8 * ref->format->size - 1);
+	}
+
+	return 0;
+}
+
+static int ref_encode(const struct ref_format *ref,
+		      const struct sensor_value *val,
+		      struct net_buf_simple *buf)
+{
+	const struct ref_repr *repr = &ref->repr;
+	size_t size = ref->format->size;
+
+	if (net_buf_simple_tailroom(buf) < size) {
+		return -ENOMEM;
+	}
+
+	s64_t raw = div_scalar(val->val1, repr) +
+		    div_scalar(val->val2, repr) / 1000000LL;
+
+	if (raw > ref_max(ref) || raw < ref_min(ref)) {
+		u32_t type_max = BIT64(8 * size) - 1;
+
+		if (repr->flags & (HAS_HIGHER_THAN | HAS_INVALID)) {
+			raw = type_max - 2;
+		} else if (repr->flags & HAS_UNDEFINED) {
+			raw = type_max - 1;
+		} else {
+			return -ERANGE;
+		}
+	}
+
+	switch (size) {
+	case 1:
+		net_buf_simple_add_u8(buf, raw);
+		break;
+	case 2:
+		net_buf_simple_add_le16(buf, raw);
+		break;
+	case 3:
+		net_buf_simple_add_le24(buf, raw);
+		break;
+	case 4:
+		net_buf_simple_add_le32(buf, raw);
+		break;
+	default:
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int ref_decode(const struct ref_format *ref, struct net_buf_simple *buf,
+		      struct sensor_value *val)
+{
+	const struct ref_repr *repr = &ref->repr;
+	bool is_signed = (repr->flags & SIGNED);
+	s64_t raw;
+
+	if (buf->len < ref->format->size) {
+		return -ENOMEM;
+	}
+
+	switch (ref->format->size) {
+	case 1:
+		raw = is_signed ? (s8_t)net_buf_simple_pull_u8(buf) :
+				  net_buf_simple_pull_u8(buf);
+		break;
+	case 2:
+		raw = is_signed ? (s16_t)net_buf_simple_pull_le16(buf) :
+				  net_buf_simple_pull_le16(buf);
+		break;
+	case 3:
+		raw = net_buf_simple_pull_le24(buf);
+		if (is_signed && (raw & BIT(23))) {
+			raw -= BIT(24);
+		}
+		break;
+	case 4:
+		raw = is_signed ? (s32_t)net_buf_simple_pull_le32(buf) :
+				  net_buf_simple_pull_le32(buf);
+		break;
+	default:
+		return -ERANGE;
+	}
+
+	if (raw < ref_min(ref) || raw > ref_max(ref)) {
+		return -ERANGE;
+	}
+
+	s64_t million = mul_scalar(raw * 1000000LL, repr);
+
+	val->val1 = million / 1000000LL;
+	val->val2 = million % 1000000LL;
+
+	return 0;
+}
+
+static u32_t rand_state;
+
+static u32_t rand_get(void)
+{
+	/* Deterministic LCG, so failures can be reproduced. */
+	rand_state = rand_state * 1103515245u + 12345u;
+
+	return rand_state >> 8;
+}
+
+static u32_t rand_get32(void)
+{
+	return (rand_get() << 16) ^ rand_get();
+}
+
+/* Random encoded value in the range of the format's integer type. */
+static s32_t rand_raw(const struct ref_format *ref)
+{
+	u32_t raw = rand_get32();
+	size_t size = ref->format->size;
+
+	if (size < 4) {
+		raw &= BIT_MASK(8 * size);
+	}
+
+	if ((ref->repr.flags & SIGNED) && (raw & BIT(8 * size - 1))) {
+		raw |= ~BIT_MASK(8 * size);
+	}
+
+	return raw;
+}
+
+static void raw_put(struct net_buf_simple *buf, size_t size, s32_t raw)
+{
+	net_buf_simple_reset(buf);
+
+	for (size_t i = 0; i < size; i++) {
+		net_buf_simple_add_u8(buf, raw >> (8 * i));
+	}
+}
+
+/* Random sensor value slightly outside the value range of the format. */
+static void rand_value(const struct ref_format *ref, struct sensor_value *val)
+{
+	s64_t lo = mul_scalar(ref_min(ref), &ref->repr) - 1;
+	s64_t hi = mul_scalar(ref_max(ref), &ref->repr) + 1;
+
+	lo = MAX(lo, INT32_MIN + 1);
+	hi = MIN(hi, INT32_MAX - 1);
+
+	val->val1 = lo + (s64_t)(rand_get32() % (u32_t)(hi - lo + 1));
+	val->val2 = rand_get() % 1000000L;
+
+	if (val->val1 < 0 || (val->val1 == 0 && (rand_get() & 1))) {
+		val->val2 = -val->val2;
+	}
+}
+
+static void test_decode_fuzz(void)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, 4);
+
+	rand_state = 1;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ref_formats); i++) {
+		const struct ref_format *ref = &ref_formats[i];
+		const struct bt_mesh_sensor_format *format = ref->format;
+
+		for (u32_t j = 0; j < FUZZ_ITERATIONS; j++) {
+			struct sensor_value val, ref_val;
+			s32_t raw = rand_raw(ref);
+			int err, ref_err;
+
+			raw_put(&buf, format->size, raw);
+			err = format->decode(format, &buf, &val);
+
+			raw_put(&buf, format->size, raw);
+			ref_err = ref_decode(ref, &buf, &ref_val);
+
+			zassert_equal(err, ref_err, "format #%u raw %d", i,
+				      raw);
+			if (err) {
+				continue;
+			}
+
+			zassert_equal(val.val1, ref_val.val1,
+				      "format #%u raw %d", i, raw);
+			zassert_equal(val.val2, ref_val.val2,
+				      "format #%u raw %d", i, raw);
+		}
+	}
+}
+
+static void test_encode_fuzz(void)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, 4);
+	NET_BUF_SIMPLE_DEFINE(ref_buf, 4);
+
+	rand_state = 2;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ref_formats); i++) {
+		const struct ref_format *ref = &ref_formats[i];
+		const struct bt_mesh_sensor_format *format = ref->format;
+
+		for (u32_t j = 0; j < FUZZ_ITERATIONS; j++) {
+			struct sensor_value val;
+			int err, ref_err;
+
+			rand_value(ref, &val);
+
+			net_buf_simple_reset(&buf);
+			net_buf_simple_reset(&ref_buf);
+			err = format->encode(format, &val, &buf);
+			ref_err = ref_encode(ref, &val, &ref_buf);
+
+			zassert_equal(err, ref_err, "format #%u value %d.%06d",
+				      i, val.val1, val.val2);
+			zassert_equal(buf.len, ref_buf.len, NULL);
+			zassert_mem_equal(buf.data, ref_buf.data, ref_buf.len,
+					  "format #%u value %d.%06d", i,
+					  val.val1, val.val2);
+		}
+	}
+}
+
+static void test_round_trip(void)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, 4);
+
+	rand_state = 3;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ref_formats); i++) {
+		const struct ref_format *ref = &ref_formats[i];
+		const struct bt_mesh_sensor_format *format = ref->format;
+
+		for (u32_t j = 0; j < FUZZ_ITERATIONS; j++) {
+			struct sensor_value val, raw_val;
+			s32_t raw = rand_raw(ref);
+			s32_t raw_out;
+			int err;
+
+			raw_put(&buf, format->size, raw);
+			err = format->decode(format, &buf, &val);
+			if (err) {
+				zassert_equal(bt_mesh_sensor_ch_from_raw(
+						      format, raw, &raw_val),
+					      err, NULL);
+				continue;
+			}
+
+			/* Values that don't fit in struct sensor_value wrap
+			 * around.
+			 */
+			s64_t raw64 = (ref->repr.flags & SIGNED) ? raw :
+								 (u32_t)raw;
+
+			if (mul_scalar(raw64, &ref->repr) > INT32_MAX) {
+				continue;
+			}
+
+			zassert_equal(bt_mesh_sensor_ch_from_raw(format, raw,
+								 &raw_val),
+				      0, NULL);
+			zassert_equal(raw_val.val1, val.val1, NULL);
+			zassert_equal(raw_val.val2, val.val2, NULL);
+
+			net_buf_simple_reset(&buf);
+			zassert_equal(format->encode(format, &val, &buf), 0,
+				      NULL);
+			zassert_equal(buf.len, format->size, NULL);
+
+			zassert_equal(bt_mesh_sensor_ch_to_raw(format, &val,
+							       &raw_out),
+				      0, NULL);
+			zassert_mem_equal(&raw_out, buf.data, format->size,
+					  NULL);
+
+			/* Resolutions that aren't a whole number of micro
+			 * units are truncated on decoding.
+			 */
+			s64_t diff = (s64_t)raw_out - raw;
+
+			zassert_true(diff >= -1 && diff <= 1,
+				     "format #%u raw %d", i, raw);
+		}
+	}
+}
+
+static void test_raw_type(void)
+{
+	const struct bt_mesh_sensor_type *type =
+		&bt_mesh_sensor_avg_amb_temp_in_day;
+	const s32_t raw[] = { -21, 75, 180 };
+	struct sensor_value val[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	s32_t raw_out[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+
+	NET_BUF_SIMPLE_DEFINE(buf, 16);
+	NET_BUF_SIMPLE_DEFINE(val_buf, 16);
+
+	zassert_equal(type->channel_count, ARRAY_SIZE(raw), NULL);
+
+	zassert_equal(bt_mesh_sensor_raw_encode(&buf, type, raw), 0, NULL);
+	zassert_equal(buf.len, sensor_value_len(type), NULL);
+
+	for (u32_t i = 0; i < type->channel_count; i++) {
+		const struct bt_mesh_sensor_format *format =
+			type->channels[i].format;
+
+		zassert_equal(bt_mesh_sensor_ch_from_raw(format, raw[i],
+							 &val[i]),
+			      0, NULL);
+	}
+
+	zassert_equal(val[0].val1, -10, NULL);
+	zassert_equal(val[0].val2, -500000, NULL);
+	zassert_equal(val[1].val1, 7, NULL);
+	zassert_equal(val[1].val2, 500000, NULL);
+	zassert_equal(val[2].val1, 18, NULL);
+	zassert_equal(val[2].val2, 0, NULL);
+
+	zassert_equal(sensor_value_encode(&val_buf, type, val), 0, NULL);
+	zassert_mem_equal(buf.data, val_buf.data, buf.len, NULL);
+
+	zassert_equal(bt_mesh_sensor_raw_decode(&buf, type, raw_out), 0, NULL);
+	zassert_mem_equal(raw_out, raw, sizeof(raw), NULL);
+
+	/* Out of range for a format without special values. */
+	const s32_t humidity = 10001;
+
+	net_buf_simple_reset(&buf);
+	zassert_equal(bt_mesh_sensor_raw_encode(
+			      &buf, &bt_mesh_sensor_present_amb_rel_humidity,
+			      &humidity),
+		      -ERANGE, NULL);
+}
+
+static void test_float_fuzz(void)
+{
+	const struct bt_mesh_sensor_format *format =
+		&bt_mesh_sensor_format_coefficient;
+
+	NET_BUF_SIMPLE_DEFINE(buf, 4);
+
+	rand_state = 4;
+
+	for (u32_t i = 0; i < FUZZ_ITERATIONS; i++) {
+		struct sensor_value val = {
+			.val1 = (s32_t)rand_get32() >> (rand_get() % 32),
+			.val2 = rand_get() % 1000000L,
+		};
+
+		if (val.val1 < 0) {
+			val.val2 = -val.val2;
+		}
+
+		s64_t micro = val.val1 * 1000000LL + val.val2;
+		float ref = (float)((double)micro / 1000000.0);
+		u32_t ref_bits;
+
+		memcpy(&ref_bits, &ref, sizeof(ref_bits));
+
+		net_buf_simple_reset(&buf);
+		zassert_equal(format->encode(format, &val, &buf), 0, NULL);
+
+		s32_t ulps = sys_get_le32(buf.data) - ref_bits;
+
+		/* Allow one unit in the last place for double rounding in
+		 * the reference.
+		 */
+		zassert_true(ulps >= -1 && ulps <= 1,
+			     "value %d.%06d: 0x%08x != 0x%08x", val.val1,
+			     val.val2, sys_get_le32(buf.data), ref_bits);
+
+		struct sensor_value out;
+		int err = format->decode(format, &buf, &out);
+
+		if (ref >= 2147483648.0f || ref <= -2147483648.0f) {
+			zassert_equal(err, -ERANGE, NULL);
+			continue;
+		}
+
+		zassert_equal(err, 0, NULL);
+
+		s64_t out_micro = out.val1 * 1000000LL + out.val2;
+		s64_t ref_micro = (s64_t)((double)ref * 1000000.0);
+		s64_t diff = out_micro - ref_micro;
+
+		zassert_true(diff >= -1 && diff <= 1,
+			     "value %d.%06d decoded as %d.%06d", val.val1,
+			     val.val2, out.val1, out.val2);
+	}
+}
+
+typedef int (*codec_fn)(const struct ref_format *ref, s32_t raw,
+			struct net_buf_simple *buf);
+
+static int ref_codec(const struct ref_format *ref, s32_t raw,
+		     struct net_buf_simple *buf)
+{
+	struct sensor_value val;
+	int err;
+
+	err = ref_decode(ref, buf, &val);
+	if (err) {
+		return err;
+	}
+
+	net_buf_simple_reset(buf);
+
+	return ref_encode(ref, &val, buf);
+}
+
+static int codec(const struct ref_format *ref, s32_t raw,
+		 struct net_buf_simple *buf)
+{
+	const struct bt_mesh_sensor_format *format = ref->format;
+	struct sensor_value val;
+	int err;
+
+	err = format->decode(format, buf, &val);
+	if (err) {
+		return err;
+	}
+
+	net_buf_simple_reset(buf);
+
+	return format->encode(format, &val, buf);
+}
+
+static int raw_codec(const struct ref_format *ref, s32_t raw,
+		     struct net_buf_simple *buf)
+{
+	const struct bt_mesh_sensor_type *type =
+		&bt_mesh_sensor_present_amb_rel_humidity;
+
+	/* The raw API works on sensor types. Use a single channel type, and
+	 * only count the cost of the channel.
+	 */
+	ARG_UNUSED(ref);
+	raw = MIN((u32_t)raw, 10000);
+
+	net_buf_simple_reset(buf);
+
+	return bt_mesh_sensor_raw_encode(buf, type, &raw) ||
+	       bt_mesh_sensor_raw_decode(buf, type, &raw);
+}
+
+/* Average cycles per channel for a decode and encode of every format. */
+static u32_t codec_cost(codec_fn fn)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, 4);
+	u32_t cycles = 0;
+	u32_t count = 0;
+
+	rand_state = 5;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ref_formats); i++) {
+		const struct ref_format *ref = &ref_formats[i];
+
+		for (u32_t j = 0; j < BENCH_ITERATIONS; j++) {
+			s32_t raw = rand_raw(ref);
+
+			raw_put(&buf, ref->format->size, raw);
+
+			u32_t start = k_cycle_get_32();
+
+			(void)fn(ref, raw, &buf);
+			cycles += k_cycle_get_32() - start;
+			count++;
+		}
+	}
+
+	return cycles / count;
+}
+
+static void test_benchmark(void)
+{
+	u32_t ref_cost = codec_cost(ref_codec);
+	u32_t cost = codec_cost(codec);
+	u32_t raw_cost = codec_cost(raw_codec);
+
+	TC_PRINT("reference[cycles/ch]  table_driven[cycles/ch]  "
+		 "raw[cycles/ch]\n");
+	TC_PRINT("%20u  %23u  %14u\n", ref_cost, cost, raw_cost);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(sensor_codec_tests,
+			 ztest_unit_test(test_decode_fuzz),
+			 ztest_unit_test(test_encode_fuzz),
+			 ztest_unit_test(test_round_trip),
+			 ztest_unit_test(test_raw_type),
+			 ztest_unit_test(test_float_fuzz),
+			 ztest_unit_test(test_benchmark)
+			 );
+
+	ztest_run_test_suite(sensor_codec_tests);
+}
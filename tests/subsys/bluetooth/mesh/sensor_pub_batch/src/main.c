@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/mesh/models.h>
+#include "sensor.h"
+
+/* BT_MESH_TX_SDU_MAX, which is internal to the mesh stack. */
+#define SDU_MAX			(CONFIG_BT_MESH_TX_SEG_MAX * 12)
+#define UNSEG_PDU_MAX		15
+#define SEG_PAYLOAD		12
+#define WINDOW			CONFIG_BT_MESH_SENSOR_SRV_PUB_BATCH_WINDOW
+#define SIM_TICK		5
+#define SIM_START		(10 * MSEC_PER_SEC)
+#define SIM_DURATION		(10 * 60 * MSEC_PER_SEC)
+#define SAMPLE_INTERVAL		MSEC_PER_SEC
+#define SAMPLE_SPREAD		10
+
+/* A sensor node, where the application samples all its sensors one after the
+ * other on a common timer.
+ */
+struct sim_sensor {
+	struct bt_mesh_sensor sensor;
+	/** Delta threshold, in whole units. */
+	s32_t delta;
+	/** Random walk step per sample, in whole units. */
+	s32_t step;
+	s32_t min;
+	s32_t max;
+	s32_t value;
+	u32_t trip_time;
+	u32_t max_latency;
+	u32_t pubs;
+};
+
+#define SIM_SENSOR(_type, _delta, _step, _min, _max, _min_int)                 \
+	{                                                                      \
+		.sensor = {                                                    \
+			.type = &bt_mesh_sensor_##_type,                       \
+			.state.min_int = _min_int,                             \
+		},                                                             \
+		.delta = _delta, .step = _step, .min = _min, .max = _max,      \
+	}
+
+/* Sorted by sensor ID, like the server's sensor list. */
+static struct sim_sensor sensors[] = {
+	SIM_SENSOR(motion_sensed, 20, 15, 0, 100, 0),
+	SIM_SENSOR(people_count, 1, 1, 0, 50, 0),
+	/* Noisy, with a 2 second minimum interval: */
+	SIM_SENSOR(present_amb_light_level, 5, 20, 0, 10000, 11),
+	SIM_SENSOR(present_amb_temp, 1, 1, -20, 40, 0),
+	SIM_SENSOR(present_dev_input_power, 10, 8, 0, 2000, 0),
+	SIM_SENSOR(present_dev_op_temp, 1, 1, -20, 80, 0),
+	SIM_SENSOR(present_amb_rel_humidity, 2, 1, 0, 100, 0),
+	SIM_SENSOR(present_amb_noise, 3, 2, 0, 120, 0),
+};
+
+struct sim_result {
+	u32_t messages;
+	u32_t pdus;
+	u32_t pubs;
+	u32_t max_latency;
+};
+
+static u32_t rand_state;
+
+static u32_t rand_get(void)
+{
+	/* Deterministic LCG, so failures can be reproduced. */
+	rand_state = rand_state * 1103515245u + 12345u;
+
+	return rand_state >> 8;
+}
+
+static u32_t pdu_count(size_t access_len)
+{
+	size_t len = access_len + BT_MESH_MIC_SHORT;
+
+	if (len <= UNSEG_PDU_MAX) {
+		return 1;
+	}
+
+	return ceiling_fraction(len, SEG_PAYLOAD);
+}
+
+static void value_get(struct sim_sensor *s, struct sensor_value *value)
+{
+	memset(value, 0, sizeof(*value) * CONFIG_BT_MESH_SENSOR_CHANNELS_MAX);
+	value[0].val1 = s->value;
+}
+
+static void msg_send(struct net_buf_simple *buf, struct sim_result *result)
+{
+	result->messages++;
+	result->pdus += pdu_count(buf->len);
+	bt_mesh_model_msg_init(buf, BT_MESH_SENSOR_OP_STATUS);
+}
+
+static void published(struct sim_sensor *s, const struct sensor_value *value,
+		      u32_t time, struct sim_result *result)
+{
+	u32_t latency = time - s->trip_time;
+
+	s->sensor.state.prev = value[0];
+	s->sensor.state.pub_time = time;
+	s->sensor.state.pub_pending = 0;
+	s->max_latency = MAX(s->max_latency, latency);
+	s->pubs++;
+	result->pubs++;
+}
+
+/* Publishes the pending sensors, as done by the server model when the batching
+ * window expires. Returns the time until the next deferred sensor may publish,
+ * or 0 if no sensors are deferred.
+ */
+static u32_t batch_flush(u32_t time, struct sim_result *result)
+{
+	struct sensor_value value[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	u32_t next = UINT32_MAX;
+	size_t empty_len;
+	int err;
+
+	NET_BUF_SIMPLE_DEFINE(buf, SDU_MAX);
+	bt_mesh_model_msg_init(&buf, BT_MESH_SENSOR_OP_STATUS);
+	empty_len = buf.len;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		struct sim_sensor *s = &sensors[i];
+
+		if (!s->sensor.state.pub_pending) {
+			continue;
+		}
+
+		u32_t remaining =
+			sensor_pub_min_int_remaining(&s->sensor, time);
+
+		if (remaining) {
+			next = MIN(next, remaining);
+			continue;
+		}
+
+		value_get(s, value);
+
+		err = sensor_status_batch_add(&buf, &s->sensor, value);
+		if (err == -ENOMEM && buf.len > empty_len) {
+			msg_send(&buf, result);
+			err = sensor_status_batch_add(&buf, &s->sensor, value);
+		}
+
+		zassert_equal(err, 0, "Encoding 0x%04x failed: %d",
+			      s->sensor.type->id, err);
+		published(s, value, time, result);
+	}
+
+	if (buf.len > empty_len) {
+		msg_send(&buf, result);
+	}
+
+	return (next == UINT32_MAX) ? 0 : next;
+}
+
+static bool sample(struct sim_sensor *s, struct sensor_value *value)
+{
+	s32_t step = (s32_t)(rand_get() % (2 * s->step + 1)) - s->step;
+
+	s->value = CLAMP(s->value + step, s->min, s->max);
+	value_get(s, value);
+
+	return bt_mesh_sensor_delta_threshold(&s->sensor, value);
+}
+
+static void simulate(bool batch, struct sim_result *result)
+{
+	struct sensor_value value[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	u32_t flush_time = 0;
+	bool flush_pending = false;
+
+	memset(result, 0, sizeof(*result));
+	rand_state = 1;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		struct sim_sensor *s = &sensors[i];
+
+		s->value = (s->min + s->max) / 2;
+		s->pubs = 0;
+		s->max_latency = 0;
+		s->sensor.state.pub_pending = 0;
+		s->sensor.state.pub_time = 0;
+		s->sensor.state.prev.val1 = s->value;
+		s->sensor.state.prev.val2 = 0;
+		s->sensor.state.threshold.delta.type =
+			BT_MESH_SENSOR_DELTA_VALUE;
+		s->sensor.state.threshold.delta.up.val1 = s->delta;
+		s->sensor.state.threshold.delta.down.val1 = s->delta;
+	}
+
+	/* Start after the longest minimum interval, so that no sensor is held
+	 * back by the initial publication time.
+	 */
+	for (u32_t time = SIM_START; time < SIM_START + SIM_DURATION;
+	     time += SIM_TICK) {
+		for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+			struct sim_sensor *s = &sensors[i];
+
+			if ((time % SAMPLE_INTERVAL) != i * SAMPLE_SPREAD ||
+			    !sample(s, value)) {
+				continue;
+			}
+
+			if (!batch) {
+				NET_BUF_SIMPLE_DEFINE(buf, SDU_MAX);
+
+				bt_mesh_model_msg_init(
+					&buf, BT_MESH_SENSOR_OP_STATUS);
+				zassert_equal(sensor_status_batch_add(
+						      &buf, &s->sensor, value),
+					      0, NULL);
+				s->trip_time = time;
+				msg_send(&buf, result);
+				published(s, value, time, result);
+				continue;
+			}
+
+			if (!s->sensor.state.pub_pending) {
+				s->sensor.state.pub_pending = 1;
+				s->trip_time = time;
+			}
+
+			if (!flush_pending || flush_time > time + WINDOW) {
+				flush_pending = true;
+				flush_time = time + WINDOW;
+			}
+		}
+
+		if (flush_pending && time >= flush_time) {
+			u32_t next = batch_flush(time, result);
+
+			flush_pending = (next != 0);
+			flush_time = time + next;
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		result->max_latency =
+			MAX(result->max_latency, sensors[i].max_latency);
+	}
+}
+
+static void test_batch_add(void)
+{
+	struct sim_sensor *s = &sensors[3];
+	struct sensor_value value[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX] = {
+		{ 21 },
+	};
+	u32_t count = 0;
+	size_t len;
+	u16_t id;
+	u8_t size;
+
+	NET_BUF_SIMPLE_DEFINE(buf, SDU_MAX);
+	bt_mesh_model_msg_init(&buf, BT_MESH_SENSOR_OP_STATUS);
+
+	while (sensor_status_batch_add(&buf, &s->sensor, value) == 0) {
+		count++;
+	}
+
+	len = buf.len;
+	zassert_true(count > 1, "Only %u values in a message", count);
+	zassert_true(len + BT_MESH_MIC_SHORT <= SDU_MAX, "No room for MIC");
+
+	/* A failed add leaves the buffer untouched: */
+	zassert_equal(sensor_status_batch_add(&buf, &s->sensor, value),
+		      -ENOMEM, NULL);
+	zassert_equal(buf.len, len, NULL);
+
+	net_buf_simple_pull(&buf,
+			    BT_MESH_MODEL_OP_LEN(BT_MESH_SENSOR_OP_STATUS));
+
+	for (u32_t i = 0; i < count; i++) {
+		sensor_status_id_decode(&buf, &size, &id);
+		zassert_equal(id, s->sensor.type->id, NULL);
+		zassert_equal(sensor_value_decode(&buf, s->sensor.type, value),
+			      0, NULL);
+		zassert_equal(value[0].val1, 21, NULL);
+	}
+
+	zassert_equal(buf.len, 0, NULL);
+}
+
+static void test_min_int(void)
+{
+	struct bt_mesh_sensor sensor = {
+		.state = { .min_int = 10, .pub_time = 1000 },
+	};
+
+	zassert_equal(sensor_pub_min_int_remaining(&sensor, 1000), 1024, NULL);
+	zassert_equal(sensor_pub_min_int_remaining(&sensor, 1500), 524, NULL);
+	zassert_equal(sensor_pub_min_int_remaining(&sensor, 2024), 0, NULL);
+	zassert_equal(sensor_pub_min_int_remaining(&sensor, 5000), 0, NULL);
+
+	/* Uptime wraparound: */
+	sensor.state.pub_time = UINT32_MAX - 100;
+	zassert_equal(sensor_pub_min_int_remaining(&sensor, 200), 723, NULL);
+}
+
+static void test_simulation(void)
+{
+	struct sim_result per_trip;
+	struct sim_result batched;
+
+	simulate(false, &per_trip);
+	simulate(true, &batched);
+
+	/* The batch respects every sensor's minimum interval: */
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		struct bt_mesh_sensor *sensor = &sensors[i].sensor;
+
+		zassert_true(sensors[i].max_latency <=
+				     WINDOW + BIT(sensor->state.min_int),
+			     "0x%04x held back for %u ms", sensor->type->id,
+			     sensors[i].max_latency);
+		zassert_true(sensors[i].pubs <=
+				     SIM_DURATION / BIT(sensor->state.min_int),
+			     "0x%04x published too often", sensor->type->id);
+	}
+
+	TC_PRINT("mode      messages  network_pdus  sensor_values  "
+		 "max_latency[ms]\n");
+	TC_PRINT("per-trip  %8u  %12u  %13u  %15u\n", per_trip.messages,
+		 per_trip.pdus, per_trip.pubs, per_trip.max_latency);
+	TC_PRINT("batched   %8u  %12u  %13u  %15u\n", batched.messages,
+		 batched.pdus, batched.pubs, batched.max_latency);
+
+	zassert_true(batched.messages < (per_trip.messages * 3) / 4,
+		     "Messages not batched");
+	zassert_true(batched.pdus < per_trip.pdus, "More network PDUs");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(sensor_pub_batch_tests,
+			 ztest_unit_test(test_batch_add),
+			 ztest_unit_test(test_min_int),
+			 ztest_unit_test(test_simulation)
+			 );
+
+	ztest_run_test_suite(sensor_pub_batch_tests);
+}
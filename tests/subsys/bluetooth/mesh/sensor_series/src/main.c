@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <sys/byteorder.h>
+#include <bluetooth/mesh/models.h>
+#include "sensor.h"
+
+#define SRV_ADDR		0x0001
+#define CLI_ADDR		0x0002
+#define OTHER_CLI_ADDR		0x0003
+#define COLUMN_CNT		24
+#define BATCH_SIZE		CONFIG_BT_MESH_SENSOR_SRV_SERIES_BATCH_SIZE
+#define PAGES_MAX		COLUMN_CNT
+#define SMALL_RSP_CNT		10
+#define RANGE_START		10
+#define RANGE_END		15
+
+/* Average ambient temperature in one hour columns. Each entry holds the
+ * column start and width, and the temperature, start and end channels.
+ */
+#define SENSOR_TYPE		(&bt_mesh_sensor_avg_amb_temp_in_day)
+#define ENTRY_LEN		5
+
+static struct bt_mesh_sensor_column columns[COLUMN_CNT];
+static u32_t batch_calls;
+static u32_t columns_fetched;
+
+static u32_t page_entries[PAGES_MAX];
+static u32_t page_cnt;
+
+/* Series Get from another client, injected after the given page. */
+static u32_t inject_after_page;
+static u32_t other_entries;
+static u32_t other_first_start;
+static bool other_done;
+
+/* Sends made from the send end callback, on the callback's thread. */
+static u32_t nested_sends;
+static bool in_send_end;
+static struct k_thread *send_end_thread;
+
+static int series_get_batch(
+	struct bt_mesh_sensor *sensor, struct bt_mesh_msg_ctx *ctx,
+	const struct bt_mesh_sensor_column **cols, u32_t count,
+	struct sensor_value (*values)[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX])
+{
+	batch_calls++;
+	columns_fetched += count;
+
+	for (u32_t i = 0; i < count; i++) {
+		values[i][0].val1 = cols[i] - &columns[0];
+		values[i][0].val2 = 0;
+		values[i][1] = cols[i]->start;
+		values[i][2] = cols[i]->end;
+	}
+
+	return 0;
+}
+
+static struct bt_mesh_sensor temp_sensor = {
+	.type = SENSOR_TYPE,
+	.series = {
+		.columns = columns,
+		.column_count = COLUMN_CNT,
+		.get_batch = series_get_batch,
+	},
+};
+
+static struct bt_mesh_sensor *const sensors[] = {
+	&temp_sensor,
+};
+
+static struct bt_mesh_sensor_srv srv =
+	BT_MESH_SENSOR_SRV_INIT(sensors, ARRAY_SIZE(sensors));
+static struct bt_mesh_sensor_cli cli = BT_MESH_SENSOR_CLI_INIT(NULL);
+
+static struct bt_mesh_model srv_mod = {
+	.user_data = &srv,
+	.pub = &srv.pub,
+};
+static struct bt_mesh_model cli_mod = {
+	.user_data = &cli,
+	.pub = &cli.pub,
+};
+
+static bool opcode_match(u32_t opcode, const struct net_buf_simple *buf)
+{
+	switch (BT_MESH_MODEL_OP_LEN(opcode)) {
+	case 1:
+		return buf->data[0] == opcode;
+	case 2:
+		return sys_get_be16(buf->data) == opcode;
+	default:
+		return false;
+	}
+}
+
+/* Pass the message to the handler of the receiving model. */
+static void msg_deliver(struct bt_mesh_model *mod,
+			const struct bt_mesh_model_op *ops, u16_t src,
+			struct net_buf_simple *msg)
+{
+	struct bt_mesh_msg_ctx ctx = {
+		.addr = src,
+		.recv_dst = (src == SRV_ADDR) ? CLI_ADDR : SRV_ADDR,
+	};
+	struct net_buf_simple buf;
+
+	net_buf_simple_init_with_data(&buf, msg->data, msg->len);
+
+	for (; ops->func; ops++) {
+		if (!opcode_match(ops->opcode, &buf)) {
+			continue;
+		}
+
+		net_buf_simple_pull(&buf, BT_MESH_MODEL_OP_LEN(ops->opcode));
+		if (buf.len >= ops->min_len) {
+			ops->func(mod, &ctx, &buf);
+		}
+
+		return;
+	}
+}
+
+static u32_t status_entries(const struct net_buf_simple *msg)
+{
+	return (msg->len -
+		BT_MESH_MODEL_OP_LEN(BT_MESH_SENSOR_OP_SERIES_STATUS) -
+		sizeof(u16_t)) / ENTRY_LEN;
+}
+
+/* Series Get for a range of columns, from another client. */
+static void other_series_get(void)
+{
+	const struct bt_mesh_sensor_format *col_format =
+		bt_mesh_sensor_column_format_get(SENSOR_TYPE);
+	struct sensor_value start = { RANGE_START };
+	struct sensor_value end = { RANGE_END };
+
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_SENSOR_OP_SERIES_GET,
+				 BT_MESH_SENSOR_MSG_MAXLEN_SERIES_GET);
+	bt_mesh_model_msg_init(&msg, BT_MESH_SENSOR_OP_SERIES_GET);
+	net_buf_simple_add_le16(&msg, SENSOR_TYPE->id);
+	(void)sensor_ch_encode(&msg, col_format, &start);
+	(void)sensor_ch_encode(&msg, col_format, &end);
+
+	msg_deliver(&srv_mod, _bt_mesh_sensor_srv_op, OTHER_CLI_ADDR, &msg);
+}
+
+/* Record the response to the other client, without passing it on. */
+static void other_status_recv(struct net_buf_simple *msg)
+{
+	u32_t entries = status_entries(msg);
+
+	if (entries == 0) {
+		other_done = true;
+		return;
+	}
+
+	if (other_entries == 0) {
+		/* The first column start, in decihours: */
+		other_first_start = msg->data[
+			BT_MESH_MODEL_OP_LEN(BT_MESH_SENSOR_OP_SERIES_STATUS) +
+			sizeof(u16_t)] / 10;
+	}
+
+	other_entries += entries;
+}
+
+int __wrap_bt_mesh_model_send(struct bt_mesh_model *model,
+			      struct bt_mesh_msg_ctx *ctx,
+			      struct net_buf_simple *msg,
+			      const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+	if (in_send_end && k_current_get() == send_end_thread) {
+		nested_sends++;
+	}
+
+	if (model == &cli_mod) {
+		msg_deliver(&srv_mod, _bt_mesh_sensor_srv_op, CLI_ADDR, msg);
+		return 0;
+	}
+
+	if (ctx->addr == OTHER_CLI_ADDR) {
+		other_status_recv(msg);
+	} else {
+		if (page_cnt < PAGES_MAX) {
+			page_entries[page_cnt++] = status_entries(msg);
+		}
+
+		msg_deliver(&cli_mod, _bt_mesh_sensor_cli_op, SRV_ADDR, msg);
+	}
+
+	/* Received by the server while this page is being sent: */
+	if (inject_after_page && page_cnt == inject_after_page) {
+		inject_after_page = 0;
+		other_series_get();
+	}
+
+	if (cb && cb->end) {
+		send_end_thread = k_current_get();
+		in_send_end = true;
+		cb->end(0, cb_data);
+		in_send_end = false;
+	}
+
+	return 0;
+}
+
+static int series_get(struct bt_mesh_sensor_series_entry *entries,
+		      u32_t *count)
+{
+	struct bt_mesh_msg_ctx ctx = {
+		.addr = SRV_ADDR,
+	};
+
+	return bt_mesh_sensor_cli_series_entries_get(
+		&cli, &ctx, (struct bt_mesh_sensor_type *)SENSOR_TYPE, NULL,
+		entries, count);
+}
+
+static void entries_check(const struct bt_mesh_sensor_series_entry *entries,
+			  u32_t count)
+{
+	for (u32_t i = 0; i < count; i++) {
+		zassert_equal(entries[i].column.start.val1, i,
+			      "Entry %u out of order", i);
+		zassert_equal(entries[i].column.end.val1, i + 1,
+			      "Wrong width of entry %u", i);
+		zassert_equal(entries[i].value[0].val1, i,
+			      "Wrong value of entry %u", i);
+	}
+}
+
+/* Expected batch getter calls, as every page starts a new batch. */
+static u32_t batch_calls_expected(void)
+{
+	u32_t calls = 0;
+
+	for (u32_t i = 0; i < page_cnt; i++) {
+		calls += ceiling_fraction(page_entries[i], BATCH_SIZE);
+	}
+
+	return calls;
+}
+
+static void test_setup(void)
+{
+	batch_calls = 0;
+	columns_fetched = 0;
+	page_cnt = 0;
+	nested_sends = 0;
+	inject_after_page = 0;
+	other_entries = 0;
+	other_done = false;
+}
+
+static void test_init(void)
+{
+	for (u32_t i = 0; i < COLUMN_CNT; i++) {
+		columns[i].start.val1 = i;
+		columns[i].end.val1 = i + 1;
+	}
+
+	zassert_equal(_bt_mesh_sensor_srv_cb.init(&srv_mod), 0, NULL);
+	zassert_equal(_bt_mesh_sensor_cli_cb.init(&cli_mod), 0, NULL);
+}
+
+static void test_reassembly(void)
+{
+	struct bt_mesh_sensor_series_entry entries[COLUMN_CNT];
+	u32_t count = ARRAY_SIZE(entries);
+
+	zassert_equal(series_get(entries, &count), 0, NULL);
+
+	TC_PRINT("columns  pages  batch_calls  columns_fetched\n");
+	TC_PRINT("%7u  %5u  %11u  %15u\n", COLUMN_CNT, page_cnt, batch_calls,
+		 columns_fetched);
+
+	/* The data pages are followed by an empty page ending the
+	 * response:
+	 */
+	zassert_true(page_cnt > 2, "Series not split");
+	zassert_equal(page_entries[page_cnt - 1], 0, "No end marker");
+	zassert_equal(count, COLUMN_CNT, "%u entries", count);
+	entries_check(entries, count);
+
+	/* Every column is fetched once, in batches: */
+	zassert_equal(columns_fetched, COLUMN_CNT, NULL);
+	zassert_equal(batch_calls, batch_calls_expected(), NULL);
+
+	/* The following pages are sent from the workqueue, not from the send
+	 * end callback of the previous page:
+	 */
+	zassert_equal(nested_sends, 0, "%u nested sends", nested_sends);
+	zassert_is_null(srv.series.sensor, "Response still pending");
+}
+
+static void test_e2big(void)
+{
+	struct bt_mesh_sensor_series_entry entries[SMALL_RSP_CNT];
+	u32_t count = ARRAY_SIZE(entries);
+
+	zassert_equal(series_get(entries, &count), -E2BIG, NULL);
+
+	/* The count reports the full series, and the buffer holds the
+	 * first entries:
+	 */
+	zassert_equal(count, COLUMN_CNT, "%u entries", count);
+	entries_check(entries, ARRAY_SIZE(entries));
+
+	zassert_equal(columns_fetched, COLUMN_CNT, NULL);
+	zassert_equal(batch_calls, batch_calls_expected(), NULL);
+	zassert_is_null(srv.series.sensor, "Response still pending");
+}
+
+static void test_replaced(void)
+{
+	struct bt_mesh_sensor_series_entry entries[COLUMN_CNT];
+	u32_t count = ARRAY_SIZE(entries);
+
+	/* A Series Get from another client arrives while the second page
+	 * is sent. It takes over once the page is done, so the first
+	 * response never ends, and the client reports the timeout:
+	 */
+	inject_after_page = 2;
+
+	zassert_equal(series_get(entries, &count), -ETIMEDOUT, NULL);
+	zassert_equal(count, page_entries[0] + page_entries[1],
+		      "%u entries", count);
+	entries_check(entries, count);
+
+	/* The new response covers the requested range only, and isn't
+	 * mixed with the position of the replaced one:
+	 */
+	zassert_true(other_done, "Other response not ended");
+	zassert_equal(other_first_start, RANGE_START, NULL);
+	zassert_equal(other_entries, RANGE_END - RANGE_START + 1, "%u entries",
+		      other_entries);
+	zassert_is_null(srv.series.sensor, "Response still pending");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(sensor_series_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test_setup_teardown(test_reassembly,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_e2big, test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_replaced,
+							test_setup,
+							unit_test_noop)
+			 );
+
+	ztest_run_test_suite(sensor_series_tests);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/mesh/models.h>
+#include "sensor.h"
+
+#define STATUS_BUF_SIZE		2048
+#define BENCH_ITERATIONS	100
+
+NET_BUF_SIMPLE_DEFINE_STATIC(status_buf, STATUS_BUF_SIZE);
+
+/* Reference implementation: linear scan of the sensor type list, as it was
+ * done before the list was sorted.
+ */
+static const struct bt_mesh_sensor_type *ref_type_get(u16_t id)
+{
+	Z_STRUCT_SECTION_FOREACH(bt_mesh_sensor_type, type) {
+		if (type->id == id) {
+			return type;
+		}
+	}
+
+	return NULL;
+}
+
+typedef const struct bt_mesh_sensor_type *(*type_get_fn)(u16_t id);
+
+static size_t status_encode(struct net_buf_simple *buf)
+{
+	struct sensor_value value[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX] = {};
+	size_t count = 0;
+
+	net_buf_simple_reset(buf);
+
+	Z_STRUCT_SECTION_FOREACH(bt_mesh_sensor_type, type) {
+		struct net_buf_simple_state state;
+
+		net_buf_simple_save(buf, &state);
+
+		if (sensor_status_id_encode(buf, sensor_value_len(type),
+					    type->id) ||
+		    sensor_value_encode(buf, type, value)) {
+			/* Type can't represent zero, skip it. */
+			net_buf_simple_restore(buf, &state);
+			continue;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+/* Same steps as the Sensor Status handler of the sensor client. */
+static size_t status_decode(struct net_buf_simple *buf, type_get_fn type_get)
+{
+	struct sensor_value value[CONFIG_BT_MESH_SENSOR_CHANNELS_MAX];
+	size_t count = 0;
+
+	while (buf->len > 3) {
+		const struct bt_mesh_sensor_type *type;
+		u8_t length;
+		u16_t id;
+
+		sensor_status_id_decode(buf, &length, &id);
+
+		type = type_get(id);
+		zassert_not_null(type, "Unknown type 0x%04x", id);
+		zassert_equal(length, sensor_value_len(type), NULL);
+		zassert_equal(sensor_value_decode(buf, type, value), 0, NULL);
+
+		count++;
+	}
+
+	return count;
+}
+
+static void test_sorted(void)
+{
+	const struct bt_mesh_sensor_type *prev = NULL;
+	size_t count = 0;
+
+	Z_STRUCT_SECTION_FOREACH(bt_mesh_sensor_type, type) {
+		if (prev) {
+			zassert_true(prev->id < type->id,
+				     "0x%04x is not sorted", type->id);
+		}
+
+		prev = type;
+		count++;
+	}
+
+	zassert_true(count > 0, "No sensor types");
+	TC_PRINT("%u sensor types\n", count);
+}
+
+static void test_lookup(void)
+{
+	for (u32_t id = 0; id <= UINT16_MAX; id++) {
+		zassert_equal_ptr(bt_mesh_sensor_type_get(id),
+				  ref_type_get(id), "Mismatch for 0x%04x", id);
+	}
+
+	zassert_equal_ptr(bt_mesh_sensor_type_get(
+				  BT_MESH_PROP_ID_PRESENT_AMB_TEMP),
+			  &bt_mesh_sensor_present_amb_temp, NULL);
+	zassert_is_null(bt_mesh_sensor_type_get(BT_MESH_PROP_ID_PROHIBITED),
+			NULL);
+}
+
+static u32_t status_decode_cost(type_get_fn type_get, size_t *count)
+{
+	struct net_buf_simple_state state;
+	u32_t cycles = 0;
+
+	net_buf_simple_save(&status_buf, &state);
+
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+		net_buf_simple_restore(&status_buf, &state);
+
+		u32_t start = k_cycle_get_32();
+
+		*count = status_decode(&status_buf, type_get);
+		cycles += k_cycle_get_32() - start;
+	}
+
+	/* Leave the encoded status for the next measurement: */
+	net_buf_simple_restore(&status_buf, &state);
+
+	return cycles / BENCH_ITERATIONS;
+}
+
+static void test_status_decode_benchmark(void)
+{
+	size_t encoded = status_encode(&status_buf);
+	size_t decoded;
+
+	zassert_true(encoded > 0, "Nothing encoded");
+
+	u32_t ref_cost = status_decode_cost(ref_type_get, &decoded);
+
+	zassert_equal(decoded, encoded, NULL);
+
+	u32_t cost = status_decode_cost(bt_mesh_sensor_type_get, &decoded);
+
+	zassert_equal(decoded, encoded, NULL);
+
+	TC_PRINT("properties  sorted_lookup[cycles]  linear_scan[cycles]\n");
+	TC_PRINT("%10u  %21u  %19u\n", encoded, cost, ref_cost);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(sensor_types_tests,
+			 ztest_unit_test(test_sorted),
+			 ztest_unit_test(test_lookup),
+			 ztest_unit_test(test_status_decode_benchmark)
+			 );
+
+	ztest_run_test_suite(sensor_types_tests);
+}
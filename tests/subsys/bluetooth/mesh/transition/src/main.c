@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <stdlib.h>
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/mesh/models.h>
+
+#define STEP_INTERVAL		CONFIG_BT_MESH_TRANSITION_STEP_INTERVAL
+#define ELEM_COUNT		32
+
+/* Transitioning state of a single element. */
+struct elem {
+	struct bt_mesh_transition transition;
+	s32_t value;
+	u32_t steps;
+	u32_t last_step;
+	bool done;
+	bool decreased;
+	bool increased;
+};
+
+static struct elem elems[ELEM_COUNT];
+static u32_t wakeups;
+static u32_t prev_step_time;
+
+static void step(struct bt_mesh_transition *transition, s32_t value, bool done)
+{
+	struct elem *elem = CONTAINER_OF(transition, struct elem, transition);
+	u32_t now = k_uptime_get_32();
+
+	/* Steps that happen at the same time share a wakeup: */
+	if (!wakeups || now != prev_step_time) {
+		wakeups++;
+		prev_step_time = now;
+	}
+
+	if (value > elem->value) {
+		elem->increased = true;
+	} else if (value < elem->value) {
+		elem->decreased = true;
+	}
+
+	elem->value = value;
+	elem->steps++;
+	elem->last_step = now;
+	elem->done = done;
+}
+
+static void elems_init(void)
+{
+	memset(elems, 0, sizeof(elems));
+	wakeups = 0;
+
+	for (int i = 0; i < ELEM_COUNT; i++) {
+		elems[i].transition.step = step;
+	}
+}
+
+static void test_immediate(void)
+{
+	struct elem *elem = &elems[0];
+	struct bt_mesh_model_transition params = { 0 };
+
+	elems_init();
+
+	bt_mesh_transition_start(&elem->transition, 0, 100, NULL);
+	zassert_true(elem->done, "No step");
+	zassert_equal(elem->value, 100, NULL);
+	zassert_false(bt_mesh_transition_in_progress(&elem->transition), NULL);
+
+	bt_mesh_transition_start(&elem->transition, 100, -100, &params);
+	zassert_true(elem->done, "No step");
+	zassert_equal(elem->value, -100, NULL);
+	zassert_equal(elem->steps, 2, NULL);
+}
+
+static void test_linear(void)
+{
+	struct elem *elem = &elems[0];
+	struct bt_mesh_model_transition params = {
+		.time = 500,
+		.delay = 100,
+	};
+	u32_t start;
+
+	elems_init();
+
+	start = k_uptime_get_32();
+	bt_mesh_transition_start(&elem->transition, 0, 0xffff, &params);
+	zassert_true(bt_mesh_transition_in_progress(&elem->transition), NULL);
+	zassert_equal(bt_mesh_transition_remaining(&elem->transition), 600,
+		      NULL);
+
+	/* Nothing happens during the delay: */
+	k_sleep(K_MSEC(params.delay));
+	zassert_equal(elem->steps, 0, NULL);
+
+	k_sleep(K_MSEC(params.time / 2));
+	zassert_false(elem->done, NULL);
+	zassert_within(elem->value, 0xffff / 2, 0xffff / 10, "Value: %d",
+		       elem->value);
+	zassert_within(bt_mesh_transition_remaining(&elem->transition),
+		       params.time / 2, STEP_INTERVAL, NULL);
+
+	k_sleep(K_MSEC(params.time / 2 + STEP_INTERVAL));
+	zassert_true(elem->done, "Not done");
+	zassert_equal(elem->value, 0xffff, NULL);
+	zassert_false(elem->decreased, "Not monotonic");
+	zassert_false(bt_mesh_transition_in_progress(&elem->transition), NULL);
+	zassert_equal(bt_mesh_transition_remaining(&elem->transition), 0,
+		      NULL);
+
+	/* The last step comes at most one step interval late: */
+	zassert_true(elem->last_step - start >= params.delay + params.time,
+		     NULL);
+	zassert_true(elem->last_step - start <=
+			     params.delay + params.time + STEP_INTERVAL,
+		     NULL);
+	zassert_true(elem->steps <= params.time / STEP_INTERVAL + 1,
+		     "%u steps", elem->steps);
+}
+
+static void test_stop(void)
+{
+	struct elem *elem = &elems[0];
+	struct bt_mesh_model_transition params = { .time = 200 };
+	u32_t steps;
+
+	elems_init();
+	elem->value = 100;
+
+	bt_mesh_transition_start(&elem->transition, 100, 0, &params);
+	k_sleep(K_MSEC(params.time / 2));
+	bt_mesh_transition_stop(&elem->transition);
+	steps = elem->steps;
+	zassert_false(bt_mesh_transition_in_progress(&elem->transition), NULL);
+
+	k_sleep(K_MSEC(params.time));
+	zassert_equal(elem->steps, steps, "Stepped after stop");
+	zassert_false(elem->done, NULL);
+	zassert_false(elem->increased, "Not monotonic");
+
+	/* Restarting a transition in progress replaces it: */
+	bt_mesh_transition_start(&elem->transition, 0, 50, &params);
+	bt_mesh_transition_start(&elem->transition, 50, 10, &params);
+	k_sleep(K_MSEC(params.time + STEP_INTERVAL));
+	zassert_true(elem->done, NULL);
+	zassert_equal(elem->value, 10, NULL);
+}
+
+static void test_many(void)
+{
+	struct bt_mesh_model_transition params;
+	u32_t start = k_uptime_get_32();
+	u32_t steps = 0;
+	u32_t end = 0;
+
+	elems_init();
+
+	/* Staggered transitions of different lengths, like a luminaire with a
+	 * lot of elements, dimmed by several scenes:
+	 */
+	for (int i = 0; i < ELEM_COUNT; i++) {
+		params.delay = (i % 4) * 35;
+		params.time = 200 + (i % 8) * 100;
+		end = MAX(end, params.delay + params.time);
+
+		bt_mesh_transition_start(&elems[i].transition, 0,
+					 (i & 1) ? 0xffff : -0x8000, &params);
+	}
+
+	k_sleep(K_MSEC(end + STEP_INTERVAL));
+
+	for (int i = 0; i < ELEM_COUNT; i++) {
+		zassert_true(elems[i].done, "Elem %d not done", i);
+		zassert_equal(elems[i].value, (i & 1) ? 0xffff : -0x8000,
+			      NULL);
+		steps += elems[i].steps;
+	}
+
+	/* With a timer per transition, every step is a separate wakeup: */
+	TC_PRINT("transitions  steps  wakeups\n");
+	TC_PRINT("%11u  %5u  %7u\n", ELEM_COUNT, steps, wakeups);
+
+	/* At most one wakeup per step interval, no matter how many
+	 * transitions are in progress:
+	 */
+	zassert_true(wakeups <= (k_uptime_get_32() - start) / STEP_INTERVAL + 1,
+		     "%u wakeups", wakeups);
+	zassert_true(wakeups < steps / 10, NULL);
+}
+
+static const struct bt_mesh_model_transition chain_params = { .time = 100 };
+static u32_t chain_stop_steps;
+static bool chained;
+
+/* Stops the next transition in the list, and restarts itself. */
+static void chain_step(struct bt_mesh_transition *transition, s32_t value,
+		       bool done)
+{
+	step(transition, value, done);
+
+	if (done && !chained) {
+		chained = true;
+		bt_mesh_transition_stop(&elems[1].transition);
+		chain_stop_steps = elems[1].steps;
+		bt_mesh_transition_start(transition, value, 0, &chain_params);
+	}
+}
+
+static void test_callback_restart(void)
+{
+	struct bt_mesh_model_transition params = { .time = 300 };
+
+	elems_init();
+	chained = false;
+	elems[0].transition.step = chain_step;
+
+	bt_mesh_transition_start(&elems[0].transition, 0, 100, &chain_params);
+	bt_mesh_transition_start(&elems[1].transition, 0, 100, &params);
+	bt_mesh_transition_start(&elems[2].transition, 0, 100, &params);
+
+	k_sleep(K_MSEC(params.time + STEP_INTERVAL));
+
+	zassert_true(chained, "Callback not called");
+	zassert_true(elems[0].done, NULL);
+	zassert_equal(elems[0].value, 0, NULL);
+	zassert_false(bt_mesh_transition_in_progress(&elems[0].transition),
+		      NULL);
+
+	zassert_equal(elems[1].steps, chain_stop_steps, "Stepped after stop");
+	zassert_false(elems[1].done, NULL);
+
+	zassert_true(elems[2].done, NULL);
+	zassert_equal(elems[2].value, 100, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(transition_tests,
+			 ztest_unit_test(test_immediate),
+			 ztest_unit_test(test_linear),
+			 ztest_unit_test(test_stop),
+			 ztest_unit_test(test_many),
+			 ztest_unit_test(test_callback_restart)
+			 );
+
+	ztest_run_test_suite(transition_tests);
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <bluetooth/services/throughput.h>
+
+#define BUCKET_US		CONFIG_BT_GATT_THROUGHPUT_LATENCY_BUCKET_US
+#define SLOTS			CONFIG_BT_GATT_THROUGHPUT_LATENCY_SLOTS
+#define WRITE_CNT		20
+#define STRESS_WRITES		2000
+#define COMPLETER_STACK_SIZE	1024
+#define COMPLETER_PRIO		K_PRIO_PREEMPT(5)
+
+/* Simulated connection object. Only its address is used. */
+static u8_t fake_conn;
+static struct bt_gatt_throughput throughput = {
+	.conn = (struct bt_conn *)&fake_conn,
+	.char_handle = 0x10,
+};
+static u8_t payload[20];
+
+static bt_gatt_complete_func_t complete_func;
+/* User data of the writes in flight, completed in order. */
+static void *pending[SLOTS];
+static u32_t pending_wr;
+static u32_t pending_rd;
+static int write_err;
+/* Another sender's write, made while the next write is in progress. */
+static bool concurrent_write;
+
+static K_SEM_DEFINE(in_flight, 0, SLOTS);
+/* Keeps the packets in flight within the tracked send timestamps. */
+static K_SEM_DEFINE(slots_free, SLOTS, SLOTS);
+static K_SEM_DEFINE(completer_done, 0, 1);
+static K_THREAD_STACK_DEFINE(completer_stack, COMPLETER_STACK_SIZE);
+static struct k_thread completer_thread;
+
+int __wrap_bt_gatt_write_without_response_cb(struct bt_conn *conn,
+					     u16_t handle, const void *data,
+					     u16_t length, bool sign,
+					     bt_gatt_complete_func_t func,
+					     void *user_data)
+{
+	int err = write_err;
+
+	complete_func = func;
+
+	if (concurrent_write) {
+		concurrent_write = false;
+		write_err = 0;
+		zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+						       sizeof(payload)),
+			      0, NULL);
+	}
+
+	if (!err) {
+		pending[pending_wr++ % SLOTS] = user_data;
+	}
+
+	return err;
+}
+
+static void write_complete(void)
+{
+	complete_func(throughput.conn, pending[pending_rd++ % SLOTS]);
+}
+
+static void test_setup(void)
+{
+	write_err = 0;
+	concurrent_write = false;
+	pending_wr = 0;
+	pending_rd = 0;
+	bt_gatt_throughput_latency_reset();
+}
+
+static void test_percentiles(void)
+{
+	struct bt_gatt_throughput_latency lat;
+
+	for (int i = 0; i < WRITE_CNT; i++) {
+		zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+						       sizeof(payload)),
+			      0, NULL);
+	}
+
+	/* Packets complete in order, each one bucket later than the
+	 * previous one:
+	 */
+	for (int i = 0; i < WRITE_CNT; i++) {
+		k_busy_wait(BUCKET_US);
+		write_complete();
+	}
+
+	bt_gatt_throughput_latency_get(&lat);
+
+	TC_PRINT("count  p50[us]  p90[us]  p99[us]  max[us]\n");
+	TC_PRINT("%5u  %7u  %7u  %7u  %7u\n", lat.count, lat.p50, lat.p90,
+		 lat.p99, lat.max);
+
+	zassert_equal(lat.count, WRITE_CNT, NULL);
+	zassert_true(lat.p50 <= lat.p90, NULL);
+	zassert_true(lat.p90 <= lat.p99, NULL);
+	zassert_true(lat.p99 <= lat.max, NULL);
+	zassert_true(lat.max >= WRITE_CNT * BUCKET_US, "max %u", lat.max);
+
+	bt_gatt_throughput_latency_reset();
+	bt_gatt_throughput_latency_get(&lat);
+	zassert_equal(lat.count, 0, NULL);
+	zassert_equal(lat.max, 0, NULL);
+}
+
+static void test_abort(void)
+{
+	struct bt_gatt_throughput_latency lat;
+
+	/* A packet the stack refused must not shift the packets that follow:
+	 */
+	write_err = -ENOMEM;
+	zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+					       sizeof(payload)),
+		      -ENOMEM, NULL);
+
+	write_err = 0;
+	zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+					       sizeof(payload)),
+		      0, NULL);
+	write_complete();
+
+	bt_gatt_throughput_latency_get(&lat);
+	zassert_equal(lat.count, 1, NULL);
+}
+
+static void test_abort_concurrent(void)
+{
+	struct bt_gatt_throughput_latency lat;
+
+	/* Another sender takes the next sequence number while a write
+	 * fails. The failed write must only release its own slot:
+	 */
+	write_err = -ENOMEM;
+	concurrent_write = true;
+	zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+					       sizeof(payload)),
+		      -ENOMEM, NULL);
+
+	zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+					       sizeof(payload)),
+		      0, NULL);
+	write_complete();
+	write_complete();
+
+	bt_gatt_throughput_latency_get(&lat);
+	zassert_equal(lat.count, 2, "%u samples", lat.count);
+}
+
+static void completer(void *p1, void *p2, void *p3)
+{
+	for (int i = 0; i < STRESS_WRITES; i++) {
+		k_sem_take(&in_flight, K_FOREVER);
+		write_complete();
+		k_sem_give(&slots_free);
+	}
+
+	k_sem_give(&completer_done);
+}
+
+static void test_concurrent_completion(void)
+{
+	struct bt_gatt_throughput_latency lat;
+
+	/* Complete the packets from another thread, as the Bluetooth stack
+	 * does, while new packets are sent:
+	 */
+	k_thread_create(&completer_thread, completer_stack,
+			K_THREAD_STACK_SIZEOF(completer_stack), completer,
+			NULL, NULL, NULL, COMPLETER_PRIO, 0, K_NO_WAIT);
+
+	for (int i = 0; i < STRESS_WRITES; i++) {
+		k_sem_take(&slots_free, K_FOREVER);
+		zassert_equal(bt_gatt_throughput_write(&throughput, payload,
+						       sizeof(payload)),
+			      0, NULL);
+		k_sem_give(&in_flight);
+	}
+
+	zassert_equal(k_sem_take(&completer_done, K_SECONDS(10)), 0,
+		      "Completions not done");
+
+	bt_gatt_throughput_latency_get(&lat);
+	zassert_equal(lat.count, STRESS_WRITES, "%u samples", lat.count);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(throughput_tests,
+			 ztest_unit_test_setup_teardown(test_percentiles,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_abort,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_abort_concurrent,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(
+				 test_concurrent_completion, test_setup,
+				 unit_test_noop)
+			 );
+
+	ztest_run_test_suite(throughput_tests);
+}